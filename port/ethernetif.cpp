@@ -7,6 +7,11 @@
  
 #include <pbuf.h>
 #include <etharp.h>
+#include <netif/rxring.h>
+#include <netif/txring.h>
+#include <netif/rxpoll.h>
+#include <netif/ethernet.h>
+#include <lwip/tcpip.h>
 #include <stm32h750xx.h>
 #include "pmc_loader.h"
 #include "pins.h"
@@ -20,9 +25,28 @@ uint8_t mac_address[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
 
 static dma_tx_descriptor tx_desc[8] __attribute__((aligned(4), __section__(".eth")));
 static dma_rx_descriptor rx_desc[8] __attribute__((aligned(4), __section__(".eth")));
-static uint8_t eth_tx_buffer[8][1532] __attribute__((aligned(4), __section__(".eth")));
-static uint8_t eth_rx_buffer[8][1532] __attribute__((aligned(4), __section__(".eth")));
-static uint8_t eth_tx_index, eth_rx_index;
+// more RX buffers than descriptors: the surplus can be held by the stack
+// while the descriptors stay armed (see rxring.c)
+#define ETH_RX_BUF_NUM  16
+static uint8_t eth_rx_buffer[ETH_RX_BUF_NUM][1532] __attribute__((aligned(4), __section__(".eth")));
+static rxring eth_rx_ring;
+static rxring_buf eth_rx_bufs[ETH_RX_BUF_NUM];
+// buffer currently armed in each RX descriptor
+static rxring_buf *eth_rx_slot[8];
+static uint8_t eth_rx_index;
+// pbufs referenced by the TX descriptors until the DMA is done with them
+static pbuf *eth_tx_pbufs[8];
+static txring eth_tx_ring;
+// frames the DMA cannot send in place are copied here: the lwIP heap is
+// the C library heap, which may be located in DTCM
+#define ETH_TX_COPY_NUM 4
+static uint8_t eth_tx_copy_buffer[ETH_TX_COPY_NUM][1532] __attribute__((aligned(4), __section__(".eth")));
+static pbuf_custom eth_tx_copy_pbuf[ETH_TX_COPY_NUM];
+// set by txring_output() (tcpip thread), cleared by txring_reclaim()
+static volatile uint8_t eth_tx_copy_busy[ETH_TX_COPY_NUM];
+// frames handled per poll before the interrupt is re-enabled
+#define ETH_RX_BUDGET   8
+static rxpoll eth_rxpoll;
 uint8_t eth_load_buffer[1532];
 uint16_t eth_load_len[8];
 
@@ -34,54 +58,121 @@ bool phy_auto_neg     = 0,
      phy_link_pre     = 0;
 
 OS::TEventFlag eth_irq_request;
-static OS::TMutex tx_mutex;
+#if !LWIP_TCPIP_CORE_LOCKING
+// signalled by the tcpip thread once it has taken the last RX batch
+static OS::TEventFlag eth_rx_handoff;
+// only used by the ethernet process
+static bool eth_rx_handoff_pending;
+#endif
 netif NetIF;
 
 void lan8740_init();
 
 //---------------------------------------------------------------------------
 
-static err_t ethernetif_output(struct netif *, struct pbuf *p)
+//                               TX descriptor ring backend
+
+static void eth_tx_desc_fill(txring *, u16_t idx, const void *data, u16_t len, u16_t frame_len, u8_t flags)
 {
-    struct pbuf *q;
-    int l = 0;
-    uint8_t *buffer = (uint8_t *)&eth_tx_buffer[eth_tx_index];
-    if(tx_mutex.try_lock(netif_BLOCK_TIMEOUT))
+#if (__DCACHE_PRESENT == 1U)
+    // pbufs live in cacheable RAM: write the segment back before the DMA reads it
+    if(SCB->CCR & SCB_CCR_DC_Msk)
     {
-        for(q = p; q != NULL; q = q->next)
-        {
-            memcpy((uint8_t *)&buffer[l], q->payload, q->len);
-            l = l + q->len;
-        }
+        uint32_t addr = (uint32_t)data & ~31UL;
+        SCB_CleanDCache_by_Addr((uint32_t *)addr, len + ((uint32_t)data - addr));
+    }
+#endif
+    tx_desc[idx].tdes0 = (uint32_t)data;
+    tx_desc[idx].tdes1 = 0;
+    tx_desc[idx].tdes2 = ((flags & TXRING_LAST) ? ETH_TDES2_IOC : 0) | (len & 0x00003FFF);
+    tx_desc[idx].tdes3 = ((flags & TXRING_FIRST) ? ETH_TDES3_FD : 0) |
+                         ((flags & TXRING_LAST) ? ETH_TDES3_LD : 0) |
+                         (frame_len & 0x00007FFF);
+}
+
+static void eth_tx_start(txring *, u16_t first, u16_t num)
+{
+    // hand the descriptors over back to front, so the DMA never
+    // starts on a partially owned frame
+    while(num > 0)
+    {
+        num--;
+        tx_desc[(first + num) % 8].tdes3 |= ETH_TDES3_OWN;
+    }
+    __DSB();
+    // clear TBU flag to resume processing
+    ETH->DMACSR = ETH_DMACSR_TBU;
+    // instruct the DMA to poll the transmit descriptor list
+    ETH->DMACTDTPR = 0;
+}
+
+static int eth_tx_desc_done(txring *, u16_t idx)
+{
+    return (tx_desc[idx].tdes3 & ETH_TDES3_OWN) == 0;
+}
 
-        tx_desc[eth_tx_index].tdes0 = (uint32_t)&eth_tx_buffer[eth_tx_index];
-        tx_desc[eth_tx_index].tdes2 = ETH_TDES2_IOC | l;
-        tx_desc[eth_tx_index].tdes3 = ETH_TDES3_OWN | ETH_TDES3_FD | ETH_TDES3_LD | (l & 0x00007FFF);
-        __DSB();
-        // clear TBU flag to resume processing
-        ETH->DMACSR = ETH_DMACSR_TBU;
-        // instruct the DMA to poll the transmit descriptor list
-        ETH->DMACTDTPR = 0;
-        if(++eth_tx_index >= 8)
+static int eth_tx_dma_ok(txring *, const void *data, u16_t len)
+{
+    // the Ethernet DMA cannot reach ITCM and DTCM
+    uint32_t start = (uint32_t)data;
+    uint32_t end = start + len;
+    if(start < 0x00010000UL)
+        return 0;
+    if((end > 0x20000000UL) && (start < 0x20020000UL))
+        return 0;
+    return 1;
+}
+
+static void eth_tx_copy_free(pbuf *p)
+{
+    eth_tx_copy_busy[(pbuf_custom *)p - eth_tx_copy_pbuf] = 0;
+}
+
+static pbuf *eth_tx_alloc(txring *, u16_t len)
+{
+    if(len > sizeof(eth_tx_copy_buffer[0]))
+        return NULL;
+    for(uint8_t i = 0; i < ETH_TX_COPY_NUM; i++)
+    {
+        if(!eth_tx_copy_busy[i])
         {
-            eth_tx_index = 0;
+            eth_tx_copy_busy[i] = 1;
+            eth_tx_copy_pbuf[i].custom_free_function = eth_tx_copy_free;
+            return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &eth_tx_copy_pbuf[i],
+                                       eth_tx_copy_buffer[i], sizeof(eth_tx_copy_buffer[i]));
         }
-        while((tx_desc[eth_tx_index].tdes3 & ETH_TDES3_OWN) != 0)
-        {}
-        print("packet transmitted\r\n");
-        tx_mutex.unlock();
     }
-    return ERR_OK;
+    return NULL;
 }
+
+static const txring_ops eth_txring_ops =
+{
+    eth_tx_desc_fill,
+    eth_tx_start,
+    eth_tx_desc_done,
+    eth_tx_dma_ok,
+    eth_tx_alloc
+};
+
 //---------------------------------------------------------------------------
 
-void ethernetif_input()
-{   
-    struct pbuf *p = NULL;
-    struct pbuf *q = NULL;
-    uint16_t len = 0;
-    uint8_t *buffer;
+static err_t ethernetif_output(struct netif *, struct pbuf *p)
+{
+    // map the pbuf segments to descriptors, never wait for the DMA:
+    // a full ring is reported as ERR_MEM and the stack retries later
+    return txring_output(&eth_tx_ring, p);
+}
+//---------------------------------------------------------------------------
 
+// release frames the DMA has transmitted (TI is acknowledged by the ISR)
+void ethernetif_tx_reclaim()
+{
+    txring_reclaim(&eth_tx_ring);
+}
+//---------------------------------------------------------------------------
+
+void ethernetif_link_check()
+{
     if(netif_is_link_up(&NetIF) != phy_link)
     {
         if(phy_link)
@@ -89,58 +180,122 @@ void ethernetif_input()
         else
             netif_set_link_down(&NetIF);
     }
-    
-    // buffer is available
-    if(!(rx_desc[eth_rx_index].rdes3 & ETH_RDES3_OWN))
+}
+//---------------------------------------------------------------------------
+
+//                               RX polling backend
+
+static void eth_rx_irq_enable(rxpoll *, u8_t enable)
+{
+    if(enable)
+    {
+        // RI is latched: frames received since the last acknowledge
+        // raise the interrupt right away
+        OS::TCritSect cs;
+        ETH->DMACIER |= ETH_DMACIER_RIE;
+    }
+    else
+    {
+        OS::TCritSect cs;
+        ETH->DMACIER &= ~ETH_DMACIER_RIE;
+        ETH->DMACSR = ETH_DMACSR_RI | ETH_DMACSR_NIS;
+    }
+}
+
+static int eth_rx_frame(rxpoll *, pbuf **p)
+{
+    uint16_t len = 0;
+
+    *p = NULL;
+    // no buffer available
+    if(rx_desc[eth_rx_index].rdes3 & ETH_RDES3_OWN)
+    {
+        return 0;
+    }
+    // first and last descriptor
+    if((rx_desc[eth_rx_index].rdes3 & ETH_RDES3_FD) && (rx_desc[eth_rx_index].rdes3 & ETH_RDES3_LD))
     {
-        // first and last descriptor
-        if((rx_desc[eth_rx_index].rdes3 & ETH_RDES3_FD) && (rx_desc[eth_rx_index].rdes3 & ETH_RDES3_LD))
+        // no error
+        if(!(rx_desc[eth_rx_index].rdes3 & ETH_RDES3_ES))
         {
-            // no error
-            if(!(rx_desc[eth_rx_index].rdes3 & ETH_RDES3_ES))
+            // frame length
+            len = (rx_desc[eth_rx_index].rdes3 & ETH_RDES3_PL) - 4;
+            
+            if(len > 0)
             {
-                buffer = (uint8_t *)&eth_rx_buffer[eth_rx_index];
-                // frame length
-                len = (rx_desc[eth_rx_index].rdes3 & ETH_RDES3_PL) - 4;
-                
-                if(len > 0)
-                {
-                    p = pbuf_alloc(PBUF_RAW, len,PBUF_POOL);
-                }
-                if(p != NULL)
-                {
-                    for(q = p; q != NULL; q = q->next)
-                    {
-                        memcpy((uint8_t *)q->payload, (uint8_t *)buffer, q->len);
-                    }
-                }
-                err_t err = NetIF.input(p, &NetIF);
-                if (err != ERR_OK)
-                {
-                    LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-                    pbuf_free(p);
-                }
+                // pass the DMA buffer up as is, the slot gets a spare buffer
+                // (or the frame is copied if the stack holds all of them)
+                *p = rxring_input(&eth_rx_ring, &eth_rx_slot[eth_rx_index], len);
             }
-            else eth_es_err++;
         }
-        else eth_fd_ld_err++;
-        rx_desc[eth_rx_index].rdes0 = (uint32_t)(&eth_rx_buffer[eth_rx_index]);
-        rx_desc[eth_rx_index].rdes3 = ETH_RDES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
-        if(++eth_rx_index >= 8)
-        {
-            eth_rx_index = 0;
-        }
-        print("packet received\r\n");
+        else eth_es_err++;
+    }
+    else eth_fd_ld_err++;
+    rx_desc[eth_rx_index].rdes0 = (uint32_t)eth_rx_slot[eth_rx_index]->payload;
+    rx_desc[eth_rx_index].rdes3 = ETH_RDES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
+    if(++eth_rx_index >= 8)
+    {
+        eth_rx_index = 0;
     }
-    // clear RBU flag to resume processing, clear RI and NIS
-    ETH->DMACSR = ETH_DMACSR_RBU | ETH_DMACSR_RI | ETH_DMACSR_NIS;
+    print("packet received\r\n");
+    // clear RBU flag to resume processing
+    ETH->DMACSR = ETH_DMACSR_RBU;
     // instruct the DMA to poll the receive descriptor list
     ETH->DMACRDTPR = 0;
-    
-    // enable DMA interrupts
-    ETH->DMACIER = ETH_DMACIER_NIE | ETH_DMACIER_RIE;
+    return 1;
+}
+
+#if !LWIP_TCPIP_CORE_LOCKING
+static void eth_rx_handoff_done(void *)
+{
+    eth_rx_handoff.signal();
+}
+#endif
+
+static void eth_rx_input(rxpoll *, pbuf **frames, u16_t num)
+{
+#if LWIP_TCPIP_CORE_LOCKING
+    // one lock for the whole batch instead of one tcpip message per frame
+    LOCK_TCPIP_CORE();
+    for(u16_t i = 0; i < num; i++)
+    {
+        if(ethernet_input(frames[i], &NetIF) != ERR_OK)
+        {
+            pbuf_free(frames[i]);
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+#else
+    // one tcpip message for the whole batch instead of one per frame
+    for(u16_t i = 0; i < num; i++)
+    {
+        frames[i]->batch = (i + 1 < num) ? frames[i + 1] : NULL;
+    }
+    if(tcpip_input_batch(frames[0], &NetIF) != ERR_OK)
+    {
+        LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+        for(u16_t i = 0; i < num; i++)
+        {
+            pbuf_free(frames[i]);
+        }
+    }
+    else
+    {
+        // queued behind the batch: runs once the tcpip thread has taken it
+        eth_rx_handoff.clear();
+        eth_rx_handoff_pending = tcpip_try_callback(eth_rx_handoff_done, NULL) == ERR_OK;
+    }
+#endif
 }
 
+static const rxpoll_ops eth_rxpoll_ops =
+{
+    eth_rx_irq_enable,
+    eth_rx_frame,
+    eth_rx_input
+};
+//---------------------------------------------------------------------------
+
 #include    <lwip/timeouts.h>
 void arp_timer(void *)
 {
@@ -379,16 +534,19 @@ err_t ethernetif_init(struct netif *netif)
         tx_desc[index].tdes2 = 0;
         tx_desc[index].tdes3 = 0;
     }
-    eth_tx_index = 0;
+    txring_init(&eth_tx_ring, &eth_txring_ops, NULL, eth_tx_pbufs, 8);
     
+    rxring_init(&eth_rx_ring, eth_rx_bufs, &eth_rx_buffer[0][0], ETH_RX_BUF_NUM, sizeof(eth_rx_buffer[0]));
     for(index = 0; index < 8; index++)
     {
-        rx_desc[index].rdes0 = (uint32_t)(&eth_rx_buffer[index]);
+        eth_rx_slot[index] = rxring_buf_get(&eth_rx_ring);
+        rx_desc[index].rdes0 = (uint32_t)eth_rx_slot[index]->payload;
         rx_desc[index].rdes1 = 0;
         rx_desc[index].rdes2 = 0;
         rx_desc[index].rdes3 = ETH_RDES3_OWN | ETH_RDES3_IOC | ETH_RDES3_BUF1V;
     }
     eth_rx_index = 0;
+    rxpoll_init(&eth_rxpoll, &eth_rxpoll_ops, NULL, netif, ETH_RX_BUDGET);
     
     // start location of the TX descriptor
     ETH->DMACTDLAR = (uint32_t)&tx_desc[0];
@@ -407,7 +565,7 @@ err_t ethernetif_init(struct netif *netif)
     sys_timeout(ARP_TMR_INTERVAL, arp_timer, NULL);
     
     // enable DMA interrupts
-    ETH->DMACIER = ETH_DMACIER_NIE | ETH_DMACIER_RIE;
+    ETH->DMACIER = ETH_DMACIER_NIE | ETH_DMACIER_RIE | ETH_DMACIER_TIE;
 
     return ERR_OK;
     
@@ -542,38 +700,30 @@ void lan8740_status()
     phy_link_pre = phy_link;
 }
 
-//---------------------------------------------------------------------------
-//
-//                               Ethernet command
-// 
-//
-void eth_tx_buffer_init()
-{
-    uint8_t i;
-    uint16_t cnt;
-    
-    for(i = 0; i < 8; i++)
-    {
-        for(cnt = 0; cnt < 1532; cnt++)
-        {
-            if(cnt < 256) eth_tx_buffer[i][cnt] = i;
-            else eth_tx_buffer[i][cnt] = 0;
-        }
-    }
-}
-
 //---------------------------------------------------------------------------
 
 
 extern "C" void ETH_IRQHandler(void)
 {
-    // disable normal interrupt
-    ETH->DMACIER &= ~ETH_DMACIER_NIE;
-
     OS::TISRW ISR;
     
-    eth_irq_request.signal_isr();
+    uint32_t status = ETH->DMACSR;
+    bool wake = false;
     
+    // mask and acknowledge RX, the thread polls the ring until it is empty
+    if((status & ETH_DMACSR_RI) && (ETH->DMACIER & ETH_DMACIER_RIE))
+    {
+        wake = rxpoll_irq(&eth_rxpoll);
+    }
+    if(status & ETH_DMACSR_TI)
+    {
+        ETH->DMACSR = ETH_DMACSR_TI | ETH_DMACSR_NIS;
+        wake = true;
+    }
+    if(wake)
+    {
+        eth_irq_request.signal_isr();
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -588,7 +738,33 @@ template<> void TEthernetProc::exec()
         
         eth_irq_request.wait();
         print("eth_irq\r\n");
-        ethernetif_input();
+        ethernetif_tx_reclaim();
+        ethernetif_link_check();
+        // drain the RX ring in batches of ETH_RX_BUDGET frames, the RX
+        // interrupt stays masked until it is empty
+        while(rxpoll_poll(&eth_rxpoll))
+        {
+            ethernetif_tx_reclaim();
+#if !LWIP_TCPIP_CORE_LOCKING
+            // more frames pending: block only until the tcpip thread has
+            // taken the batch. Sleeping a whole tick here capped receive at
+            // ETH_RX_BUDGET frames per tick (8000 frames/s at a 1 kHz tick,
+            // about 5 Mbit/s of minimum size frames) and overflowed the
+            // 8 descriptor ring; now the stack's own speed is the limit.
+            // The tick only remains as a back-off when the tcpip mbox is full.
+            if(eth_rx_handoff_pending)
+            {
+                eth_rx_handoff_pending = false;
+                eth_rx_handoff.wait(1);
+            }
+            else
+            {
+                OS::sleep(1);
+            }
+#endif
+            // with LWIP_TCPIP_CORE_LOCKING the batch has been processed by
+            // this thread already, so continue with the next one right away
+        }
     }
 }
 }
@@ -47,6 +47,12 @@
  */
 #define LWIP_NETIF_LINK_CALLBACK    1
 
+/**
+ * LWIP_TCPIP_INPUT_BATCH==1: without core locking, the Ethernet driver
+ * passes each RX batch to the tcpip thread in one message
+ */
+#define LWIP_TCPIP_INPUT_BATCH      (!LWIP_TCPIP_CORE_LOCKING)
+
 // port has it's own mutexes
 #define LWIP_COMPAT_MUTEX           0
 
@@ -0,0 +1,327 @@
+/**
+ * @file
+ * lwiperf host harness for the unix port
+ *
+ * Runs the lwIP stack on the host with lwiperf (iperf 2 compatible) on top
+ * of one of the host interfaces:
+ * - in-memory pipe (-l): a forked server process, each side with its own
+ *   stack, connected back to back by a socket pair;
+ * - TAP device (-t) or AF_PACKET socket (-i): talk to a real iperf;
+ * - pcap replay (-r): feed a capture into the stack as fast as possible.
+ * Prints the lwiperf reports and the lwIP statistics at exit.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "lwip/opt.h"
+#include "lwip/init.h"
+#include "lwip/tcpip.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+#include "lwip/stats.h"
+#include "lwip/apps/lwiperf.h"
+
+#include "netif/hostif.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+enum harness_mode {
+  MODE_PIPE,
+  MODE_TAP,
+  MODE_PACKET,
+  MODE_PCAP
+};
+
+static sys_sem_t done_sem;
+static volatile sig_atomic_t interrupted;
+
+static void
+usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [mode] [options]\n"
+          "modes:\n"
+          "  -l            in-memory pipe to a forked server process (default)\n"
+          "  -t [tapname]  TAP device\n"
+          "  -i ifname     AF_PACKET socket on an existing interface\n"
+          "  -r in.pcap    replay a capture into the stack\n"
+          "options:\n"
+          "  -a addr       IPv4 address (default 192.168.0.2, pipe: client 10.0.0.2,\n"
+          "                server 10.0.0.1)\n"
+          "  -m mask       netmask (default 255.255.255.0)\n"
+          "  -g gw         gateway\n"
+          "  -d            use DHCP\n"
+          "  -c server     run an lwiperf client against 'server' instead of a server\n"
+          "  -w out.pcap   record transmitted frames (pcap mode)\n"
+          "  -R            replay with capture timing (pcap mode)\n"
+          "  -n loops      replay the capture n more times (pcap mode)\n"
+          "  -T seconds    stop after this time (0: run until done/interrupted)\n",
+          prog);
+  exit(2);
+}
+
+static void
+on_signal(int sig)
+{
+  LWIP_UNUSED_ARG(sig);
+  interrupted = 1;
+}
+
+static void
+tcpip_init_done(void *arg)
+{
+  sys_sem_signal((sys_sem_t *)arg);
+}
+
+static void
+lwiperf_report(void *arg, enum lwiperf_report_type report_type,
+               const ip_addr_t *local_addr, u16_t local_port,
+               const ip_addr_t *remote_addr, u16_t remote_port,
+               u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+  int client = (arg != NULL);
+  char local[IPADDR_STRLEN_MAX], remote[IPADDR_STRLEN_MAX];
+
+  printf("lwiperf %s report %d: %s:%u -> %s:%u, %lu bytes in %lu ms, %lu kbit/s\n",
+         client ? "client" : "server", (int)report_type,
+         ipaddr_ntoa_r(local_addr, local, sizeof(local)), local_port,
+         ipaddr_ntoa_r(remote_addr, remote, sizeof(remote)), remote_port,
+         (unsigned long)bytes_transferred, (unsigned long)ms_duration,
+         (unsigned long)bandwidth_kbitpsec);
+  if (client || (report_type != LWIPERF_TCP_DONE_SERVER)) {
+    sys_sem_signal(&done_sem);
+  }
+}
+
+static void
+print_hostif_stats(const char *name, const struct hostif_stats *s)
+{
+  printf("%s: rx %lu frames in %lu batches (%lu dropped), tx %lu frames (%lu busy, %lu errors)\n",
+         name, (unsigned long)s->rx_frames, (unsigned long)s->rx_batches,
+         (unsigned long)s->rx_nomem, (unsigned long)s->tx_frames, (unsigned long)s->tx_busy,
+         (unsigned long)s->tx_errors);
+}
+
+static void
+add_netif(struct netif *netif, void *state, netif_init_fn init,
+          const char *addr, const char *mask, const char *gw, int dhcp)
+{
+  ip4_addr_t ip, nm, gwip;
+
+  ip4_addr_set_zero(&ip);
+  ip4_addr_set_zero(&nm);
+  ip4_addr_set_zero(&gwip);
+  if (!dhcp) {
+    if (!ip4addr_aton(addr, &ip) || !ip4addr_aton(mask, &nm) ||
+        ((gw != NULL) && !ip4addr_aton(gw, &gwip))) {
+      fprintf(stderr, "invalid address configuration\n");
+      exit(2);
+    }
+  }
+  LOCK_TCPIP_CORE();
+  if (netif_add(netif, &ip, &nm, &gwip, state, init, tcpip_input) == NULL) {
+    UNLOCK_TCPIP_CORE();
+    fprintf(stderr, "netif_add failed\n");
+    exit(1);
+  }
+#if LWIP_IPV6
+  netif_create_ip6_linklocal_address(netif, 1);
+#endif
+  netif_set_up(netif);
+#if LWIP_DHCP
+  if (dhcp) {
+    dhcp_start(netif);
+  }
+#endif
+  UNLOCK_TCPIP_CORE();
+}
+
+int
+main(int argc, char **argv)
+{
+  enum harness_mode mode = MODE_PIPE;
+  const char *device = NULL, *addr = NULL, *mask = "255.255.255.0", *gw = NULL;
+  const char *client_to = NULL, *out_file = NULL;
+  struct netif netif;
+  struct fdif fdif;
+  struct pcapif pcapif;
+  pid_t server_pid = 0;
+  int pipe_fds[2];
+  unsigned long run_time = 0;
+  unsigned long loops = 0;
+  struct timespec t0, t1;
+  int dhcp = 0, realtime = 0, opt;
+  sys_sem_t init_sem;
+  double elapsed;
+
+  while ((opt = getopt(argc, argv, "lt::i:r:a:m:g:dc:w:Rn:T:h")) != -1) {
+    switch (opt) {
+      case 'l': mode = MODE_PIPE; break;
+      case 't': mode = MODE_TAP; device = optarg; break;
+      case 'i': mode = MODE_PACKET; device = optarg; break;
+      case 'r': mode = MODE_PCAP; device = optarg; break;
+      case 'a': addr = optarg; break;
+      case 'm': mask = optarg; break;
+      case 'g': gw = optarg; break;
+      case 'd': dhcp = 1; break;
+      case 'c': client_to = optarg; break;
+      case 'w': out_file = optarg; break;
+      case 'R': realtime = 1; break;
+      case 'n': loops = strtoul(optarg, NULL, 0); break;
+      case 'T': run_time = strtoul(optarg, NULL, 0); break;
+      default: usage(argv[0]);
+    }
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  memset(&fdif, 0, sizeof(fdif));
+  if (mode == MODE_PIPE) {
+    /* fork before any thread exists: the server gets a stack of its own */
+    if (pipeif_socketpair(pipe_fds) < 0) {
+      perror("socketpair");
+      return 1;
+    }
+    server_pid = fork();
+    if (server_pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (server_pid == 0) {
+      close(pipe_fds[0]);
+      fdif.fd = pipe_fds[1];
+      addr = "10.0.0.1";
+      client_to = NULL;
+    } else {
+      close(pipe_fds[1]);
+      fdif.fd = pipe_fds[0];
+      addr = "10.0.0.2";
+      client_to = "10.0.0.1";
+    }
+  }
+
+  sys_sem_new(&init_sem, 0);
+  sys_sem_new(&done_sem, 0);
+  tcpip_init(tcpip_init_done, &init_sem);
+  sys_arch_sem_wait(&init_sem, 0);
+  sys_sem_free(&init_sem);
+
+  memset(&netif, 0, sizeof(netif));
+  memset(&pcapif, 0, sizeof(pcapif));
+
+  switch (mode) {
+    case MODE_PIPE:
+      add_netif(&netif, &fdif, pipeif_init, addr, mask, NULL, 0);
+      break;
+    case MODE_TAP:
+    case MODE_PACKET:
+      fdif.device = device;
+      add_netif(&netif, &fdif, (mode == MODE_TAP) ? tapif_init : packetif_init,
+                addr ? addr : "192.168.0.2", mask, gw, dhcp);
+      break;
+    case MODE_PCAP:
+      pcapif.in_file = device;
+      pcapif.out_file = out_file;
+      pcapif.realtime = realtime;
+      pcapif.loops = (u32_t)loops;
+      add_netif(&netif, &pcapif, pcapif_init, addr ? addr : "192.168.0.2", mask, gw, dhcp);
+      break;
+    default:
+      break;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  LOCK_TCPIP_CORE();
+  netif_set_default(&netif);
+  if (client_to != NULL) {
+    ip_addr_t server;
+    if (!ipaddr_aton(client_to, &server)) {
+      UNLOCK_TCPIP_CORE();
+      usage(argv[0]);
+    }
+    lwiperf_start_tcp_client_default(&server, lwiperf_report, &netif);
+  } else if (mode != MODE_PCAP) {
+    lwiperf_start_tcp_server_default(lwiperf_report, NULL);
+  }
+  UNLOCK_TCPIP_CORE();
+
+  /* wait for: client done, replay done, time limit or ^C */
+  for (;;) {
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    if (interrupted || ((run_time != 0) && (elapsed >= (double)run_time))) {
+      break;
+    }
+    if ((mode == MODE_PCAP) && pcapif.replay_done) {
+      break;
+    }
+    if (client_to != NULL) {
+      if (sys_arch_sem_wait(&done_sem, 100) != SYS_ARCH_TIMEOUT) {
+        break;
+      }
+    } else {
+      usleep(100 * 1000);
+    }
+  }
+
+  if (server_pid > 0) {
+    /* let the server see the FIN and print its side first */
+    usleep(200 * 1000);
+    kill(server_pid, SIGTERM);
+    waitpid(server_pid, NULL, 0);
+  }
+  printf("%sran for %.3f s\n", (mode == MODE_PIPE) ? (server_pid ? "client " : "server ") : "",
+         elapsed);
+  switch (mode) {
+    case MODE_PIPE:
+      print_hostif_stats(server_pid ? "pipe client" : "pipe server", &fdif.stats);
+      break;
+    case MODE_PCAP:
+      print_hostif_stats("pcap", &pcapif.stats);
+      if (elapsed > 0) {
+        printf("replayed %.0f frames/s\n", (double)pcapif.stats.rx_frames / elapsed);
+      }
+      break;
+    default:
+      print_hostif_stats(device ? device : "tap", &fdif.stats);
+      break;
+  }
+  LOCK_TCPIP_CORE();
+  stats_display();
+  UNLOCK_TCPIP_CORE();
+  fflush(NULL);
+  return 0;
+}
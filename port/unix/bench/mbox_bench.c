@@ -0,0 +1,283 @@
+/**
+ * @file
+ * sys_mbox microbenchmark: lock-free MPSC mailbox vs. mutex/condvar channel
+ *
+ * 1..8 producer threads post to one consumer (like application threads
+ * posting to tcpip_thread). Reports throughput and post->fetch latency
+ * percentiles for both the mpsc_mbox and a classic mutex+condvar bounded
+ * queue, which is how sys_mbox is usually built on OS primitives.
+ *
+ * Usage: mbox_bench [messages per producer] [mailbox size] [max producers]
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "../mpsc_mbox.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_PRODUCERS    8
+/* every n-th message carries a latency sample */
+#define SAMPLE_INTERVAL  16
+
+/* baseline: bounded queue guarded by one mutex, two condvars */
+struct lock_mbox {
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+  void **q;
+  size_t size, head, tail, used;
+};
+
+struct bench_msg {
+  unsigned producer;
+  unsigned seq;
+  uint64_t sent_ns;
+};
+
+struct bench {
+  int lockfree;
+  struct mpsc_mbox mpsc;
+  struct lock_mbox lock;
+  unsigned producers;
+  unsigned count;
+  struct bench_msg *msgs[MAX_PRODUCERS];
+  uint64_t *lat;
+  size_t num_lat;
+  int errors;
+};
+
+static uint64_t
+now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void
+lock_mbox_init(struct lock_mbox *mb, size_t size)
+{
+  pthread_mutex_init(&mb->lock, NULL);
+  pthread_cond_init(&mb->not_empty, NULL);
+  pthread_cond_init(&mb->not_full, NULL);
+  mb->q = (void **)calloc(size, sizeof(void *));
+  mb->size = size;
+  mb->head = mb->tail = mb->used = 0;
+}
+
+static void
+lock_mbox_free(struct lock_mbox *mb)
+{
+  free(mb->q);
+  pthread_cond_destroy(&mb->not_full);
+  pthread_cond_destroy(&mb->not_empty);
+  pthread_mutex_destroy(&mb->lock);
+}
+
+static void
+lock_mbox_post(struct lock_mbox *mb, void *msg)
+{
+  pthread_mutex_lock(&mb->lock);
+  while (mb->used == mb->size) {
+    pthread_cond_wait(&mb->not_full, &mb->lock);
+  }
+  mb->q[mb->head] = msg;
+  mb->head = (mb->head + 1) % mb->size;
+  mb->used++;
+  pthread_cond_signal(&mb->not_empty);
+  pthread_mutex_unlock(&mb->lock);
+}
+
+static void *
+lock_mbox_fetch(struct lock_mbox *mb)
+{
+  void *msg;
+  pthread_mutex_lock(&mb->lock);
+  while (mb->used == 0) {
+    pthread_cond_wait(&mb->not_empty, &mb->lock);
+  }
+  msg = mb->q[mb->tail];
+  mb->tail = (mb->tail + 1) % mb->size;
+  mb->used--;
+  pthread_cond_signal(&mb->not_full);
+  pthread_mutex_unlock(&mb->lock);
+  return msg;
+}
+
+struct producer_arg {
+  struct bench *b;
+  unsigned id;
+};
+
+static void *
+producer_thread(void *arg)
+{
+  struct producer_arg *pa = (struct producer_arg *)arg;
+  struct bench *b = pa->b;
+  unsigned i;
+
+  for (i = 0; i < b->count; i++) {
+    struct bench_msg *m = &b->msgs[pa->id][i];
+    m->sent_ns = ((i % SAMPLE_INTERVAL) == 0) ? now_ns() : 0;
+    if (b->lockfree) {
+      mpsc_mbox_post(&b->mpsc, m);
+    } else {
+      lock_mbox_post(&b->lock, m);
+    }
+  }
+  return NULL;
+}
+
+/* consumer: checks per-producer FIFO order and collects latency samples */
+static void
+consume(struct bench *b)
+{
+  unsigned next[MAX_PRODUCERS];
+  unsigned long total = (unsigned long)b->producers * b->count, i;
+
+  memset(next, 0, sizeof(next));
+  for (i = 0; i < total; i++) {
+    struct bench_msg *m;
+    if (b->lockfree) {
+      void *msg;
+      mpsc_mbox_fetch(&b->mpsc, &msg, 0);
+      m = (struct bench_msg *)msg;
+    } else {
+      m = (struct bench_msg *)lock_mbox_fetch(&b->lock);
+    }
+    if (m->seq != next[m->producer]) {
+      b->errors++;
+    }
+    next[m->producer] = m->seq + 1;
+    if (m->sent_ns != 0) {
+      b->lat[b->num_lat++] = now_ns() - m->sent_ns;
+    }
+  }
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int
+run(int lockfree, unsigned producers, unsigned count, int size)
+{
+  struct bench b;
+  pthread_t th[MAX_PRODUCERS];
+  struct producer_arg pa[MAX_PRODUCERS];
+  uint64_t start, elapsed;
+  unsigned p, i;
+  double mps;
+
+  memset(&b, 0, sizeof(b));
+  b.lockfree = lockfree;
+  b.producers = producers;
+  b.count = count;
+  b.lat = (uint64_t *)malloc(sizeof(uint64_t) * ((size_t)producers * count / SAMPLE_INTERVAL + producers));
+  for (p = 0; p < producers; p++) {
+    b.msgs[p] = (struct bench_msg *)malloc(sizeof(struct bench_msg) * count);
+    for (i = 0; i < count; i++) {
+      b.msgs[p][i].producer = p;
+      b.msgs[p][i].seq = i;
+    }
+  }
+  if (lockfree) {
+    if (mpsc_mbox_init(&b.mpsc, size) != 0) {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+  } else {
+    lock_mbox_init(&b.lock, (size_t)size);
+  }
+
+  start = now_ns();
+  for (p = 0; p < producers; p++) {
+    pa[p].b = &b;
+    pa[p].id = p;
+    pthread_create(&th[p], NULL, producer_thread, &pa[p]);
+  }
+  consume(&b);
+  for (p = 0; p < producers; p++) {
+    pthread_join(th[p], NULL);
+  }
+  elapsed = now_ns() - start;
+
+  qsort(b.lat, b.num_lat, sizeof(uint64_t), cmp_u64);
+  mps = (double)producers * count / ((double)elapsed / 1e9);
+  printf("%-9s %2u producers: %8.2f Mmsg/s  latency p50 %7.2f us  p99 %8.2f us  max %9.2f us%s\n",
+         lockfree ? "mpsc_mbox" : "mutex", producers, mps / 1e6,
+         b.lat[b.num_lat / 2] / 1e3, b.lat[b.num_lat * 99 / 100] / 1e3,
+         b.lat[b.num_lat - 1] / 1e3, b.errors ? "  ORDER ERRORS" : "");
+
+  if (lockfree) {
+    mpsc_mbox_free(&b.mpsc);
+  } else {
+    lock_mbox_free(&b.lock);
+  }
+  for (p = 0; p < producers; p++) {
+    free(b.msgs[p]);
+  }
+  free(b.lat);
+  return b.errors;
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned count = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 0) : 200000;
+  int size = (argc > 2) ? atoi(argv[2]) : MPSC_MBOX_DEFAULT_SIZE;
+  unsigned max_producers = (argc > 3) ? (unsigned)strtoul(argv[3], NULL, 0) : MAX_PRODUCERS;
+  unsigned producers;
+  int errors = 0;
+
+  if (count < SAMPLE_INTERVAL) {
+    count = SAMPLE_INTERVAL;
+  }
+  if (size <= 0) {
+    size = MPSC_MBOX_DEFAULT_SIZE;
+  }
+  if ((max_producers == 0) || (max_producers > MAX_PRODUCERS)) {
+    max_producers = MAX_PRODUCERS;
+  }
+  printf("%u messages per producer, mailbox size %d\n", count, size);
+  for (producers = 1; producers <= max_producers; producers *= 2) {
+    errors += run(0, producers, count, size);
+    errors += run(1, producers, count, size);
+  }
+  return errors ? 1 : 0;
+}
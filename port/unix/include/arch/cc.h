@@ -0,0 +1,55 @@
+/**
+ * @file
+ * Compiler/platform definitions for the unix (Linux host) port
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_ARCH_CC_H
+#define LWIP_ARCH_CC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* use the host's struct timeval and errno values */
+#define LWIP_TIMEVAL_PRIVATE    0
+#include <sys/time.h>
+
+#define LWIP_ERRNO_STDINCLUDE   1
+
+#define LWIP_RAND()             ((u32_t)random())
+
+#define LWIP_PLATFORM_DIAG(x)   do { printf x; fflush(stdout); } while (0)
+#define LWIP_PLATFORM_ASSERT(x) do { fprintf(stderr, "Assertion \"%s\" failed at line %d in %s\n", \
+                                       x, __LINE__, __FILE__); fflush(NULL); abort(); } while (0)
+
+typedef int sys_prot_t;
+
+#endif /* LWIP_ARCH_CC_H */
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * lwIP options for the unix (Linux host) port
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_LWIPOPTS_H
+#define LWIP_HDR_LWIPOPTS_H
+
+/* Threads, locking */
+#define NO_SYS                          0
+#define SYS_LIGHTWEIGHT_PROT            1
+#define LWIP_TCPIP_CORE_LOCKING         1
+#define LWIP_TCPIP_INPUT_BATCH          1
+/* spin-then-block core lock: off by default, it only pays off on multi-core
+   hosts with short lock holds (build with -DLWIP_TCPIP_CORE_LOCK_SPIN=1) */
+#ifndef LWIP_TCPIP_CORE_LOCK_SPIN
+#define LWIP_TCPIP_CORE_LOCK_SPIN       0
+#endif
+#define LWIP_TCPIP_CORE_LOCK_SPIN_MAX   200
+#if defined(__x86_64__) || defined(__i386__)
+#define LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE() __asm__ volatile("yield")
+#endif
+/* nanoseconds, wraps every 4 s: fine for hold times */
+#define LWIP_TCPIP_CORE_LOCK_CLOCK()    sys_jiffies()
+#define TCPIP_MBOX_SIZE                 1024
+#define DEFAULT_RAW_RECVMBOX_SIZE       256
+#define DEFAULT_UDP_RECVMBOX_SIZE       256
+#define DEFAULT_TCP_RECVMBOX_SIZE       256
+#define LWIP_NETCONN_RECVQ              1
+#define DEFAULT_ACCEPTMBOX_SIZE         64
+#define TCPIP_THREAD_STACKSIZE          0
+#define DEFAULT_THREAD_STACKSIZE        0
+
+void sys_mark_tcpip_thread(void);
+#define LWIP_MARK_TCPIP_THREAD()        sys_mark_tcpip_thread()
+void sys_check_core_locking(void);
+#define LWIP_ASSERT_CORE_LOCKED()       sys_check_core_locking()
+
+/* Memory: sized for benchmarking, not for footprint */
+#define MEM_ALIGNMENT                   8
+#define MEM_SIZE                        (4 * 1024 * 1024)
+#define MEMP_NUM_PBUF                   1024
+#define MEMP_NUM_TCP_PCB                64
+#define MEMP_NUM_TCP_SEG                2048
+#define MEMP_NUM_TCPIP_MSG_INPKT        1024
+#define MEMP_NUM_NETBUF                 256
+#define MEMP_NUM_NETCONN                64
+#define PBUF_POOL_SIZE                  4096
+#define PBUF_POOL_BUFSIZE               1536
+
+/* Protocols */
+#define LWIP_IPV4                       1
+#define LWIP_IPV6                       1
+/* pointers are 64 bit on the host: ip6_frag cannot overlay its helper */
+#define IPV6_FRAG_COPYHEADER            1
+#define LWIP_ARP                        1
+#define LWIP_ICMP                       1
+#define LWIP_UDP                        1
+#define LWIP_TCP                        1
+#define LWIP_DHCP                       1
+#define LWIP_IGMP                       1
+#define LWIP_RAW                        1
+
+/* TCP tuned for throughput on a host link */
+#define TCP_MSS                         1460
+#define LWIP_WND_SCALE                  1
+#define TCP_RCV_SCALE                   4
+#define TCP_WND                         (512 * 1024)
+#define TCP_SND_BUF                     (512 * 1024)
+#define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF / TCP_MSS)
+#define TCP_SNDLOWAT                    (32 * TCP_MSS)
+#define TCP_QUEUE_OOSEQ                 1
+
+/* APIs; the host's own socket names must stay usable in applications */
+#define LWIP_NETCONN                    1
+#define LWIP_SOCKET                     1
+#define LWIP_SOCKET_EPOLL               1
+#define LWIP_SOCKET_EPOLL_INSTANCES     8
+#define LWIP_SOCKET_PBUF_LOAN           1
+#define MEMP_NUM_EPOLL_ITEM             256
+#define LWIP_COMPAT_SOCKETS             0
+#define LWIP_POSIX_SOCKETS_IO_NAMES     0
+#define LWIP_NETCONN_SEM_PER_THREAD     0
+#define LWIP_NETIF_API                  1
+#define LWIP_NETIF_STATUS_CALLBACK      1
+#define LWIP_NETIF_LINK_CALLBACK        1
+#define LWIP_SO_RCVTIMEO                1
+#define LWIP_SO_SNDTIMEO                1
+
+/* Statistics are the point of this port */
+#define LWIP_STATS                      1
+#define LWIP_STATS_LARGE                1
+#define LWIP_STATS_DISPLAY              1
+#define MIB2_STATS                      1
+
+#endif /* LWIP_HDR_LWIPOPTS_H */
@@ -0,0 +1,297 @@
+/**
+ * @file
+ * Bounded lock-free MPSC mailbox for the unix port
+ *
+ * sys_mbox traffic is many-to-one: application threads (and drivers) post,
+ * only tcpip_thread (or a netconn owner) fetches. This ring exploits that:
+ * - posting is one CAS on the shared head plus a release store into the
+ *   slot, no mutex;
+ * - fetching is a plain load/store on consumer-owned state (behind a
+ *   test-and-set flag that only spins if two threads fetch at once);
+ * - sleeping/waking goes through an eventcount on a futex, so a post only
+ *   enters the kernel when the consumer actually sleeps.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "mpsc_mbox.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static int
+futex_wait(atomic_uint *addr, unsigned val, const struct timespec *rel)
+{
+  return (int)syscall(SYS_futex, (unsigned *)addr, FUTEX_WAIT_PRIVATE, val, rel, NULL, 0);
+}
+
+static void
+futex_wake(atomic_uint *addr, int num)
+{
+  syscall(SYS_futex, (unsigned *)addr, FUTEX_WAKE_PRIVATE, num, NULL, NULL, 0);
+}
+
+static uint64_t
+mono_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+void
+eventcount_init(struct eventcount *ec)
+{
+  atomic_init(&ec->state, 0);
+}
+
+/** Announce a waiter. The caller must re-check its condition afterwards and
+ * then either give up (nothing to undo) or call eventcount_wait() with the
+ * returned key. */
+unsigned
+eventcount_prepare_wait(struct eventcount *ec)
+{
+  unsigned key = atomic_fetch_or(&ec->state, EVENTCOUNT_WAITERS) | EVENTCOUNT_WAITERS;
+  /* order the announcement before the caller's condition re-check */
+  atomic_thread_fence(memory_order_seq_cst);
+  return key;
+}
+
+/** Sleep until notified after eventcount_prepare_wait() returned 'key'.
+ * @return 0 if woken (or already notified), -1 on timeout */
+int
+eventcount_wait(struct eventcount *ec, unsigned key, uint32_t timeout_ms)
+{
+  if (timeout_ms == 0) {
+    while (atomic_load(&ec->state) == key) {
+      futex_wait(&ec->state, key, NULL);
+    }
+  } else {
+    uint64_t end = mono_ms() + timeout_ms;
+    while (atomic_load(&ec->state) == key) {
+      uint64_t now = mono_ms();
+      struct timespec rel;
+      if (now >= end) {
+        return -1;
+      }
+      rel.tv_sec = (time_t)((end - now) / 1000);
+      rel.tv_nsec = (long)((end - now) % 1000) * 1000000L;
+      futex_wait(&ec->state, key, &rel);
+    }
+  }
+  return 0;
+}
+
+/** Wake everybody waiting; costs a fence and a load if nobody waits.
+ * The waiter flag is cleared by the first notifier, so further notifies
+ * stay cheap until a thread announces itself again. */
+void
+eventcount_notify(struct eventcount *ec)
+{
+  unsigned state;
+
+  /* pairs with the fence in eventcount_prepare_wait(): either the waiter
+     sees our state change, or we see its announcement */
+  atomic_thread_fence(memory_order_seq_cst);
+  state = atomic_load_explicit(&ec->state, memory_order_relaxed);
+  while (state & EVENTCOUNT_WAITERS) {
+    /* new epoch, nobody announced for it yet */
+    if (atomic_compare_exchange_weak(&ec->state, &state,
+        (state + EVENTCOUNT_EPOCH_INC) & ~EVENTCOUNT_WAITERS)) {
+      futex_wake(&ec->state, INT_MAX);
+      break;
+    }
+  }
+}
+
+/**
+ * Create a mailbox with at least 'size' slots (rounded up to a power of two).
+ * @return 0 on success, -1 if out of memory
+ */
+int
+mpsc_mbox_init(struct mpsc_mbox *mb, int size)
+{
+  size_t num = 1, i;
+
+  if (size <= 0) {
+    size = MPSC_MBOX_DEFAULT_SIZE;
+  }
+  while (num < (size_t)size) {
+    num <<= 1;
+  }
+  mb->slots = (struct mpsc_mbox_slot *)calloc(num, sizeof(struct mpsc_mbox_slot));
+  if (mb->slots == NULL) {
+    return -1;
+  }
+  for (i = 0; i < num; i++) {
+    atomic_init(&mb->slots[i].seq, i);
+  }
+  mb->mask = num - 1;
+  atomic_init(&mb->head, 0);
+  mb->tail = 0;
+  atomic_flag_clear(&mb->consumer);
+  eventcount_init(&mb->not_empty);
+  eventcount_init(&mb->not_full);
+  return 0;
+}
+
+void
+mpsc_mbox_free(struct mpsc_mbox *mb)
+{
+  free(mb->slots);
+  mb->slots = NULL;
+}
+
+/**
+ * Post without blocking, safe from any number of threads.
+ * @return 0 on success, -1 if the mailbox is full
+ */
+int
+mpsc_mbox_trypost(struct mpsc_mbox *mb, void *msg)
+{
+  struct mpsc_mbox_slot *slot;
+  size_t pos = atomic_load_explicit(&mb->head, memory_order_relaxed);
+
+  for (;;) {
+    size_t seq;
+    intptr_t dif;
+    slot = &mb->slots[pos & mb->mask];
+    seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    dif = (intptr_t)seq - (intptr_t)pos;
+    if (dif == 0) {
+      /* slot is free for this lap: try to claim it */
+      if (atomic_compare_exchange_weak_explicit(&mb->head, &pos, pos + 1,
+          memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+      /* pos was reloaded by the failed CAS */
+    } else if (dif < 0) {
+      /* the consumer has not freed this slot yet */
+      return -1;
+    } else {
+      pos = atomic_load_explicit(&mb->head, memory_order_relaxed);
+    }
+  }
+  slot->msg = msg;
+  /* publish: the consumer waits for seq == pos + 1 */
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+  eventcount_notify(&mb->not_empty);
+  return 0;
+}
+
+/** Post, sleeping while the mailbox is full */
+void
+mpsc_mbox_post(struct mpsc_mbox *mb, void *msg)
+{
+  while (mpsc_mbox_trypost(mb, msg) != 0) {
+    unsigned key = eventcount_prepare_wait(&mb->not_full);
+    if (mpsc_mbox_trypost(mb, msg) == 0) {
+      return;
+    }
+    eventcount_wait(&mb->not_full, key, 0);
+  }
+}
+
+/**
+ * Fetch without blocking.
+ * @return 0 if a message was fetched, -1 if the mailbox is empty
+ */
+int
+mpsc_mbox_tryfetch(struct mpsc_mbox *mb, void **msg)
+{
+  struct mpsc_mbox_slot *slot;
+  size_t seq;
+
+  /* normally there is one consumer and this never spins, but lwIP allows
+     several threads to read the same netconn */
+  while (atomic_flag_test_and_set_explicit(&mb->consumer, memory_order_acquire)) {
+    sched_yield();
+  }
+  slot = &mb->slots[mb->tail & mb->mask];
+  seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+  if (seq != mb->tail + 1) {
+    atomic_flag_clear_explicit(&mb->consumer, memory_order_release);
+    return -1;
+  }
+  *msg = slot->msg;
+  /* hand the slot back to producers for the next lap */
+  atomic_store_explicit(&slot->seq, mb->tail + mb->mask + 1, memory_order_release);
+  mb->tail++;
+  atomic_flag_clear_explicit(&mb->consumer, memory_order_release);
+  /* let blocked producers run only once there is room for a burst, instead
+     of ping-ponging one slot at a time */
+  if ((atomic_load_explicit(&mb->head, memory_order_relaxed) - mb->tail) <= (mb->mask >> 1)) {
+    eventcount_notify(&mb->not_full);
+  }
+  return 0;
+}
+
+/**
+ * Fetch, sleeping up to 'timeout_ms' (0: forever) for a message.
+ * @return milliseconds waited, or MPSC_MBOX_TIMEOUT
+ */
+uint32_t
+mpsc_mbox_fetch(struct mpsc_mbox *mb, void **msg, uint32_t timeout_ms)
+{
+  uint64_t start;
+
+  if (mpsc_mbox_tryfetch(mb, msg) == 0) {
+    return 0;
+  }
+  start = mono_ms();
+  for (;;) {
+    unsigned key = eventcount_prepare_wait(&mb->not_empty);
+    uint32_t left = 0;
+    if (mpsc_mbox_tryfetch(mb, msg) == 0) {
+      break;
+    }
+    if (timeout_ms != 0) {
+      uint64_t waited = mono_ms() - start;
+      if (waited >= timeout_ms) {
+        return MPSC_MBOX_TIMEOUT;
+      }
+      left = (uint32_t)(timeout_ms - waited);
+    }
+    eventcount_wait(&mb->not_empty, key, left);
+    if (mpsc_mbox_tryfetch(mb, msg) == 0) {
+      break;
+    }
+  }
+  return (uint32_t)(mono_ms() - start);
+}
@@ -0,0 +1,111 @@
+/**
+ * @file
+ * Bounded lock-free MPSC mailbox for the unix port
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_UNIX_MPSC_MBOX_H
+#define LWIP_HDR_UNIX_MPSC_MBOX_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Cache line size used to keep producer and consumer state apart */
+#define MPSC_MBOX_CACHELINE 64
+
+/** Default number of slots when the mailbox is created with size <= 0 */
+#define MPSC_MBOX_DEFAULT_SIZE 128
+
+/** Returned by mpsc_mbox_fetch() on timeout */
+#define MPSC_MBOX_TIMEOUT 0xffffffffUL
+
+/** eventcount state: bit 0 flags announced waiters, the rest is the epoch */
+#define EVENTCOUNT_WAITERS   1U
+#define EVENTCOUNT_EPOCH_INC 2U
+
+/**
+ * Eventcount: lets a thread sleep until "something changed" without the
+ * signalling side taking a lock or doing a syscall when nobody sleeps.
+ * A waiter announces itself (prepare), re-checks its condition and only
+ * then sleeps on the state it saw; notifiers bump the epoch and wake the
+ * futex only if a waiter is announced.
+ */
+struct eventcount {
+  atomic_uint state;
+};
+
+/** One ring slot; 'seq' tells producers/consumer whose turn it is */
+struct mpsc_mbox_slot {
+  atomic_size_t seq;
+  void *msg;
+};
+
+/**
+ * Bounded multi-producer/single-consumer mailbox (Vyukov ring).
+ * Producers claim a slot with one CAS on 'head'; the consumer owns 'tail'
+ * (guarded by a test-and-set flag in case two threads fetch at once).
+ */
+struct mpsc_mbox {
+  struct mpsc_mbox_slot *slots;
+  size_t mask;
+  /** consumer waits here for messages */
+  struct eventcount not_empty;
+  /** blocking producers wait here for free slots */
+  struct eventcount not_full;
+  /** producer position */
+  _Alignas(MPSC_MBOX_CACHELINE) atomic_size_t head;
+  /** consumer position */
+  _Alignas(MPSC_MBOX_CACHELINE) size_t tail;
+  atomic_flag consumer;
+};
+
+int  mpsc_mbox_init(struct mpsc_mbox *mb, int size);
+void mpsc_mbox_free(struct mpsc_mbox *mb);
+int  mpsc_mbox_trypost(struct mpsc_mbox *mb, void *msg);
+void mpsc_mbox_post(struct mpsc_mbox *mb, void *msg);
+int  mpsc_mbox_tryfetch(struct mpsc_mbox *mb, void **msg);
+uint32_t mpsc_mbox_fetch(struct mpsc_mbox *mb, void **msg, uint32_t timeout_ms);
+
+void     eventcount_init(struct eventcount *ec);
+unsigned eventcount_prepare_wait(struct eventcount *ec);
+int      eventcount_wait(struct eventcount *ec, unsigned key, uint32_t timeout_ms);
+void     eventcount_notify(struct eventcount *ec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_UNIX_MPSC_MBOX_H */
@@ -0,0 +1,349 @@
+/**
+ * @file
+ * TAP device, AF_PACKET socket and in-memory pipe network interfaces for
+ * the unix port
+ *
+ * All are file descriptors carrying whole Ethernet frames, so they share
+ * one driver: a receive thread that reads frames straight into pool pbufs
+ * (no bounce buffer) and passes them to tcpip_thread in batches, and a
+ * linkoutput that writes a pbuf chain with a single writev().
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "hostif.h"
+
+#include "lwip/sys.h"
+#include "lwip/snmp.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/if_tun.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/** More pbuf segments than this are sent through a bounce buffer */
+#define FDIF_MAX_IOV 16
+
+/** Milliseconds to wait for room in a full host TX queue before giving up */
+#define FDIF_TX_POLL_TIMEOUT 10
+
+/** Read one frame into a pool pbuf.
+ * @return 1 frame read, 0 nothing left to read, -1 frame dropped */
+static int
+fdif_read_frame(struct fdif *fdif, struct pbuf **frame)
+{
+  struct iovec iov[FDIF_MAX_IOV];
+  struct sockaddr_ll sll;
+  struct msghdr msg;
+  struct pbuf *p, *q;
+  u8_t scratch[HOSTIF_MAX_FRAME];
+  int num_iov = 0;
+  ssize_t len;
+
+  p = pbuf_alloc(PBUF_RAW, HOSTIF_MAX_FRAME, PBUF_POOL);
+  if (p == NULL) {
+    iov[0].iov_base = scratch;
+    iov[0].iov_len = sizeof(scratch);
+    num_iov = 1;
+  } else {
+    for (q = p; (q != NULL) && (num_iov < FDIF_MAX_IOV); q = q->next) {
+      iov[num_iov].iov_base = q->payload;
+      iov[num_iov].iov_len = q->len;
+      num_iov++;
+    }
+  }
+  memset(&msg, 0, sizeof(msg));
+  if (fdif->is_packet) {
+    /* need the packet type to skip our own transmissions */
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (size_t)num_iov;
+    msg.msg_name = &sll;
+    msg.msg_namelen = sizeof(sll);
+    len = recvmsg(fdif->fd, &msg, MSG_DONTWAIT);
+  } else {
+    /* TAP fd is non-blocking */
+    len = readv(fdif->fd, iov, num_iov);
+  }
+  if (len <= 0) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    return 0;
+  }
+  if (p == NULL) {
+    fdif->stats.rx_nomem++;
+    return -1;
+  }
+  if ((fdif->is_packet && (sll.sll_pkttype == PACKET_OUTGOING)) ||
+      (len < SIZEOF_ETH_HDR) || (msg.msg_flags & MSG_TRUNC)) {
+    /* our own transmissions echoed by AF_PACKET, runts, giants */
+    pbuf_free(p);
+    return -1;
+  }
+  pbuf_realloc(p, (pbuf_len_t)len);
+  *frame = p;
+  return 1;
+}
+
+static void
+fdif_rx_thread(void *arg)
+{
+  struct netif *netif = (struct netif *)arg;
+  struct fdif *fdif = (struct fdif *)netif->state;
+  struct pbuf *frames[HOSTIF_RX_BATCH];
+
+  for (;;) {
+    struct pollfd pfd;
+    int num = 0;
+
+    pfd.fd = fdif->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("fdif: poll");
+      return;
+    }
+    /* drain what is queued (up to the batch size) before waking the stack */
+    while (num < HOSTIF_RX_BATCH) {
+      int ret = fdif_read_frame(fdif, &frames[num]);
+      if (ret == 0) {
+        break;
+      } else if (ret > 0) {
+        MIB2_STATS_NETIF_ADD(netif, ifinoctets, frames[num]->tot_len);
+        num++;
+      }
+    }
+    if (num > 0) {
+      hostif_input(netif, frames, num, &fdif->stats);
+    }
+  }
+}
+
+static err_t
+fdif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct fdif *fdif = (struct fdif *)netif->state;
+  struct iovec iov[FDIF_MAX_IOV];
+  u8_t bounce[HOSTIF_MAX_FRAME];
+  struct pbuf *q;
+  int num_iov = 0;
+  int waited = 0;
+  int err;
+  ssize_t ret;
+
+  for (q = p; (q != NULL) && (num_iov < FDIF_MAX_IOV); q = q->next) {
+    iov[num_iov].iov_base = q->payload;
+    iov[num_iov].iov_len = q->len;
+    num_iov++;
+  }
+  if (q != NULL) {
+    /* too fragmented for one writev */
+    if (p->tot_len > sizeof(bounce)) {
+      fdif->stats.tx_errors++;
+      return ERR_BUF;
+    }
+    iov[0].iov_base = bounce;
+    iov[0].iov_len = pbuf_copy_partial(p, bounce, p->tot_len, 0);
+    num_iov = 1;
+  }
+  for (;;) {
+    ret = writev(fdif->fd, iov, num_iov);
+    err = (ret < 0) ? errno : 0;
+    if (err == EINTR) {
+      continue;
+    }
+    if (((err == EAGAIN) || (err == EWOULDBLOCK)) && !waited) {
+      /* the host queue is full: wait for room once and retry */
+      struct pollfd pfd;
+      fdif->stats.tx_busy++;
+      waited = 1;
+      pfd.fd = fdif->fd;
+      pfd.events = POLLOUT;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, FDIF_TX_POLL_TIMEOUT) > 0) {
+        continue;
+      }
+    }
+    break;
+  }
+  if ((err == EAGAIN) || (err == EWOULDBLOCK)) {
+    /* still full: not an I/O error, the stack may retry later */
+    MIB2_STATS_NETIF_INC(netif, ifoutdiscards);
+    return ERR_MEM;
+  }
+  if (ret != (ssize_t)p->tot_len) {
+    fdif->stats.tx_errors++;
+    MIB2_STATS_NETIF_INC(netif, ifoutdiscards);
+    return ERR_IF;
+  }
+  fdif->stats.tx_frames++;
+  MIB2_STATS_NETIF_ADD(netif, ifoutoctets, p->tot_len);
+  return ERR_OK;
+}
+
+static err_t
+fdif_start(struct netif *netif, char name0, char name1)
+{
+  hostif_init_ethernet(netif, name0, name1);
+  netif->linkoutput = fdif_linkoutput;
+  sys_thread_new("fdif_rx", fdif_rx_thread, netif, 0, 0);
+  return ERR_OK;
+}
+
+/**
+ * netif init function for a TAP device. netif->state must point to a
+ * struct fdif whose 'device' names the TAP interface to create or attach
+ * to (NULL lets the kernel choose). The host side must be configured
+ * (address, link up) separately, see README.
+ */
+err_t
+tapif_init(struct netif *netif)
+{
+  struct fdif *fdif = (struct fdif *)netif->state;
+  struct ifreq ifr;
+
+  LWIP_ERROR("tapif_init: no state", fdif != NULL, return ERR_ARG;);
+  fdif->is_packet = 0;
+  fdif->fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fdif->fd < 0) {
+    perror("tapif: open /dev/net/tun");
+    return ERR_IF;
+  }
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+  if (fdif->device != NULL) {
+    strncpy(ifr.ifr_name, fdif->device, IFNAMSIZ - 1);
+  }
+  if (ioctl(fdif->fd, TUNSETIFF, (void *)&ifr) < 0) {
+    perror("tapif: TUNSETIFF");
+    close(fdif->fd);
+    return ERR_IF;
+  }
+  return fdif_start(netif, 't', 'p');
+}
+
+/**
+ * netif init function for an AF_PACKET socket bound to an existing host
+ * interface ('device' in the struct fdif passed as netif->state). The
+ * interface is put into promiscuous mode since lwIP uses its own MAC.
+ */
+err_t
+packetif_init(struct netif *netif)
+{
+  struct fdif *fdif = (struct fdif *)netif->state;
+  struct sockaddr_ll sll;
+  struct packet_mreq mreq;
+  unsigned ifindex;
+
+  LWIP_ERROR("packetif_init: no device", (fdif != NULL) && (fdif->device != NULL), return ERR_ARG;);
+  ifindex = if_nametoindex(fdif->device);
+  if (ifindex == 0) {
+    perror("packetif: if_nametoindex");
+    return ERR_IF;
+  }
+  fdif->is_packet = 1;
+  fdif->fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, PP_HTONS(ETH_P_ALL));
+  if (fdif->fd < 0) {
+    perror("packetif: socket");
+    return ERR_IF;
+  }
+  memset(&sll, 0, sizeof(sll));
+  sll.sll_family = AF_PACKET;
+  sll.sll_protocol = PP_HTONS(ETH_P_ALL);
+  sll.sll_ifindex = (int)ifindex;
+  if (bind(fdif->fd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+    perror("packetif: bind");
+    close(fdif->fd);
+    return ERR_IF;
+  }
+  memset(&mreq, 0, sizeof(mreq));
+  mreq.mr_ifindex = (int)ifindex;
+  mreq.mr_type = PACKET_MR_PROMISC;
+  if (setsockopt(fdif->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+    perror("packetif: PACKET_MR_PROMISC");
+  }
+  return fdif_start(netif, 'p', 'k');
+}
+
+/**
+ * Create an in-memory Ethernet "wire": a pair of connected sockets that
+ * preserve frame boundaries. Give one end to pipeif_init() in this process
+ * and the other to a second process (fork()) running its own stack, to
+ * measure two lwIP instances back to back without TAP devices or root.
+ * @return 0 on success, -1 on error (errno set)
+ */
+int
+pipeif_socketpair(int fds[2])
+{
+  int bufsize = 4 * 1024 * 1024;
+  int i;
+
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+    return -1;
+  }
+  for (i = 0; i < 2; i++) {
+    setsockopt(fds[i], SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+    setsockopt(fds[i], SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+  }
+  return 0;
+}
+
+/**
+ * netif init function for one end of an in-memory pipe. netif->state must
+ * point to a struct fdif whose 'fd' is one end of pipeif_socketpair().
+ */
+err_t
+pipeif_init(struct netif *netif)
+{
+  struct fdif *fdif = (struct fdif *)netif->state;
+  int flags;
+
+  LWIP_ERROR("pipeif_init: no socket", (fdif != NULL) && (fdif->fd >= 0), return ERR_ARG;);
+  fdif->is_packet = 0;
+  flags = fcntl(fdif->fd, F_GETFL);
+  fcntl(fdif->fd, F_SETFL, flags | O_NONBLOCK);
+  return fdif_start(netif, 'p', 'i');
+}
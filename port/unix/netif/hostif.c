@@ -0,0 +1,107 @@
+/**
+ * @file
+ * Helpers shared by the host network interfaces of the unix port
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "hostif.h"
+
+#include "lwip/etharp.h"
+#include "lwip/ethip6.h"
+#include "lwip/snmp.h"
+#include "lwip/tcpip.h"
+#include "netif/ethernet.h"
+
+#include <stdlib.h>
+
+/**
+ * Common netif setup for the Ethernet-like host interfaces: random locally
+ * administered MAC, ARP/ND output, 1500 byte MTU.
+ */
+void
+hostif_init_ethernet(struct netif *netif, char name0, char name1)
+{
+  u32_t r = LWIP_RAND();
+
+  netif->name[0] = name0;
+  netif->name[1] = name1;
+#if LWIP_IPV4
+  netif->output = etharp_output;
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+  netif->output_ip6 = ethip6_output;
+#endif /* LWIP_IPV6 */
+  netif->mtu = 1500;
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  netif->hwaddr[0] = 0x02; /* locally administered, unicast */
+  netif->hwaddr[1] = 0x00;
+  netif->hwaddr[2] = (u8_t)(r >> 24);
+  netif->hwaddr[3] = (u8_t)(r >> 16);
+  netif->hwaddr[4] = (u8_t)(r >> 8);
+  netif->hwaddr[5] = (u8_t)r;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET |
+                 NETIF_FLAG_IGMP | NETIF_FLAG_MLD6 | NETIF_FLAG_LINK_UP;
+  MIB2_INIT_NETIF(netif, snmp_ifType_ethernet_csmacd, 1000000000);
+}
+
+/**
+ * Pass received frames to the stack: one tcpip message for all of them
+ * when batching is available, one per frame otherwise.
+ */
+void
+hostif_input(struct netif *netif, struct pbuf **frames, int num, struct hostif_stats *stats)
+{
+  int i;
+
+  stats->rx_frames += (u32_t)num;
+  stats->rx_batches++;
+#if LWIP_TCPIP_INPUT_BATCH
+  if ((netif->input == tcpip_input) && (num > 1)) {
+    for (i = 0; i < num - 1; i++) {
+      frames[i]->batch = frames[i + 1];
+    }
+    if (tcpip_input_batch(frames[0], netif) != ERR_OK) {
+      for (i = 0; i < num; i++) {
+        frames[i]->batch = NULL;
+        pbuf_free(frames[i]);
+      }
+      stats->rx_nomem += (u32_t)num;
+    }
+    return;
+  }
+#endif /* LWIP_TCPIP_INPUT_BATCH */
+  for (i = 0; i < num; i++) {
+    if (netif->input(frames[i], netif) != ERR_OK) {
+      pbuf_free(frames[i]);
+      stats->rx_nomem++;
+    }
+  }
+}
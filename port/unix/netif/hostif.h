@@ -0,0 +1,113 @@
+/**
+ * @file
+ * Host network interfaces for the unix (Linux host) port
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_UNIX_HOSTIF_H
+#define LWIP_HDR_UNIX_HOSTIF_H
+
+#include "lwip/opt.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/ethernet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of frames an RX thread passes to the stack at once */
+#ifndef HOSTIF_RX_BATCH
+#define HOSTIF_RX_BATCH 32
+#endif
+
+/** Largest Ethernet frame handled (without FCS, with one VLAN tag) */
+#define HOSTIF_MAX_FRAME 1518
+
+/** Per-interface counters, maintained without locking by the owning threads */
+struct hostif_stats {
+  u32_t rx_frames;
+  u32_t rx_batches;
+  u32_t rx_nomem;
+  u32_t tx_frames;
+  /** frames that found the host queue full (not counted as errors) */
+  u32_t tx_busy;
+  u32_t tx_errors;
+};
+
+/**
+ * File descriptor based Ethernet interface (TAP device, AF_PACKET socket or
+ * in-memory pipe), passed as 'state' to netif_add() with tapif_init(),
+ * packetif_init() or pipeif_init().
+ * A receive thread reads frames straight into pool pbufs and hands them to
+ * the stack in batches; transmit writes the pbuf chain with one writev().
+ */
+struct fdif {
+  /** host device: TAP name to create/attach, or interface for AF_PACKET */
+  const char *device;
+  /** for pipeif_init(): one end of pipeif_socketpair(), else set by init */
+  int fd;
+  int is_packet;
+  struct hostif_stats stats;
+};
+
+/**
+ * pcap file interface: replays frames from 'in_file' into the stack and
+ * records transmitted frames to 'out_file' (either may be NULL).
+ */
+struct pcapif {
+  const char *in_file;
+  const char *out_file;
+  /** honour the capture timestamps instead of replaying as fast as possible */
+  int realtime;
+  /** number of times to replay the file (0: once) */
+  u32_t loops;
+  /** set once the replay thread has injected the whole file */
+  volatile int replay_done;
+  void *out;
+  struct hostif_stats stats;
+};
+
+err_t tapif_init(struct netif *netif);
+err_t packetif_init(struct netif *netif);
+err_t pcapif_init(struct netif *netif);
+err_t pipeif_init(struct netif *netif);
+int   pipeif_socketpair(int fds[2]);
+
+/* shared by the drivers above */
+void  hostif_init_ethernet(struct netif *netif, char name0, char name1);
+void  hostif_input(struct netif *netif, struct pbuf **frames, int num, struct hostif_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_UNIX_HOSTIF_H */
@@ -0,0 +1,262 @@
+/**
+ * @file
+ * pcap file network interface for the unix port
+ *
+ * Replays the frames of a capture file into the stack and records what the
+ * stack transmits into another capture file. Replay applies backpressure
+ * (it waits for free pool pbufs instead of dropping), so a run over the same
+ * file is reproducible, which makes this the tool for profiling the input
+ * path without any network in the loop.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "hostif.h"
+
+#include "lwip/sys.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PCAP_MAGIC_US      0xa1b2c3d4UL
+#define PCAP_MAGIC_NS      0xa1b23c4dUL
+#define PCAP_LINKTYPE_ETH  1
+
+struct pcap_file_hdr {
+  u32_t magic;
+  u16_t version_major;
+  u16_t version_minor;
+  s32_t thiszone;
+  u32_t sigfigs;
+  u32_t snaplen;
+  u32_t network;
+};
+
+struct pcap_rec_hdr {
+  u32_t ts_sec;
+  u32_t ts_frac;
+  u32_t incl_len;
+  u32_t orig_len;
+};
+
+static u32_t
+pcap_swap32(u32_t v, int swap)
+{
+  return swap ? (((v & 0xff) << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) | (v >> 24)) : v;
+}
+
+/* Read one record into a pool pbuf chain, waiting for pbufs if necessary.
+ * @return 1 frame read, 0 end of file, -1 record skipped */
+static int
+pcapif_read_frame(FILE *f, int swap, u64_t *ts_ns, int ns, struct pbuf **frame)
+{
+  struct pcap_rec_hdr rec;
+  struct pbuf *p, *q;
+  u32_t len;
+
+  if (fread(&rec, sizeof(rec), 1, f) != 1) {
+    return 0;
+  }
+  len = pcap_swap32(rec.incl_len, swap);
+  *ts_ns = (u64_t)pcap_swap32(rec.ts_sec, swap) * 1000000000ULL +
+           (u64_t)pcap_swap32(rec.ts_frac, swap) * (ns ? 1 : 1000);
+  if ((len < SIZEOF_ETH_HDR) || (len > HOSTIF_MAX_FRAME)) {
+    fseek(f, (long)len, SEEK_CUR);
+    return -1;
+  }
+  while ((p = pbuf_alloc(PBUF_RAW, (pbuf_len_t)len, PBUF_POOL)) == NULL) {
+    /* the stack is behind: wait instead of dropping */
+    usleep(100);
+  }
+  for (q = p; q != NULL; q = q->next) {
+    if (fread(q->payload, 1, q->len, f) != q->len) {
+      pbuf_free(p);
+      return 0;
+    }
+  }
+  *frame = p;
+  return 1;
+}
+
+static u64_t
+pcapif_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64_t)ts.tv_sec * 1000000000ULL + (u64_t)ts.tv_nsec;
+}
+
+static void
+pcapif_replay_thread(void *arg)
+{
+  struct netif *netif = (struct netif *)arg;
+  struct pcapif *pcapif = (struct pcapif *)netif->state;
+  struct pbuf *frames[HOSTIF_RX_BATCH];
+  struct pcap_file_hdr fh;
+  u32_t loop = 0;
+  FILE *f;
+
+  f = fopen(pcapif->in_file, "rb");
+  if (f == NULL) {
+    perror("pcapif: open input");
+    pcapif->replay_done = 1;
+    return;
+  }
+  if ((fread(&fh, sizeof(fh), 1, f) != 1) ||
+      ((fh.magic != PCAP_MAGIC_US) && (fh.magic != PCAP_MAGIC_NS) &&
+       (pcap_swap32(fh.magic, 1) != PCAP_MAGIC_US) && (pcap_swap32(fh.magic, 1) != PCAP_MAGIC_NS))) {
+    fprintf(stderr, "pcapif: %s is not a pcap file\n", pcapif->in_file);
+    fclose(f);
+    pcapif->replay_done = 1;
+    return;
+  }
+
+  /* frames for a netif that is not up yet would just be dropped */
+  while (!netif_is_up(netif) || !netif_is_link_up(netif)) {
+    usleep(1000);
+  }
+
+  do {
+    int swap = (fh.magic != PCAP_MAGIC_US) && (fh.magic != PCAP_MAGIC_NS);
+    int ns = (pcap_swap32(fh.magic, swap) == PCAP_MAGIC_NS);
+    u64_t first_ts = 0, start = pcapif_now_ns();
+    int num = 0, ret, first = 1;
+
+    fseek(f, sizeof(fh), SEEK_SET);
+    for (;;) {
+      u64_t ts;
+      ret = pcapif_read_frame(f, swap, &ts, ns, &frames[num]);
+      if (ret == 0) {
+        break;
+      } else if (ret < 0) {
+        continue;
+      }
+      if (pcapif->realtime) {
+        u64_t now;
+        if (first) {
+          first_ts = ts;
+          first = 0;
+        }
+        now = pcapif_now_ns() - start;
+        if ((ts - first_ts) > now) {
+          /* deliver what we have before sleeping */
+          if (num > 0) {
+            hostif_input(netif, frames, num, &pcapif->stats);
+            frames[0] = frames[num];
+            num = 0;
+          }
+          usleep((useconds_t)((ts - first_ts - now) / 1000));
+        }
+      }
+      num++;
+      if (num == HOSTIF_RX_BATCH) {
+        hostif_input(netif, frames, num, &pcapif->stats);
+        num = 0;
+      }
+    }
+    if (num > 0) {
+      hostif_input(netif, frames, num, &pcapif->stats);
+    }
+  } while (loop++ < pcapif->loops);
+
+  fclose(f);
+  pcapif->replay_done = 1;
+}
+
+static err_t
+pcapif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct pcapif *pcapif = (struct pcapif *)netif->state;
+  FILE *out = (FILE *)pcapif->out;
+  struct pcap_rec_hdr rec;
+  struct timeval tv;
+  struct pbuf *q;
+
+  pcapif->stats.tx_frames++;
+  if (out == NULL) {
+    return ERR_OK;
+  }
+  gettimeofday(&tv, NULL);
+  rec.ts_sec = (u32_t)tv.tv_sec;
+  rec.ts_frac = (u32_t)tv.tv_usec;
+  rec.incl_len = rec.orig_len = p->tot_len;
+  fwrite(&rec, sizeof(rec), 1, out);
+  for (q = p; q != NULL; q = q->next) {
+    fwrite(q->payload, 1, q->len, out);
+  }
+  if (fflush(out) != 0) {
+    pcapif->stats.tx_errors++;
+    return ERR_IF;
+  }
+  return ERR_OK;
+}
+
+/**
+ * netif init function for a pcap file interface, netif->state must point
+ * to a struct pcapif. Replay starts as soon as the netif is added.
+ */
+err_t
+pcapif_init(struct netif *netif)
+{
+  struct pcapif *pcapif = (struct pcapif *)netif->state;
+
+  LWIP_ERROR("pcapif_init: no state", pcapif != NULL, return ERR_ARG;);
+  hostif_init_ethernet(netif, 'p', 'c');
+  netif->linkoutput = pcapif_linkoutput;
+  pcapif->replay_done = 0;
+  pcapif->out = NULL;
+
+  if (pcapif->out_file != NULL) {
+    struct pcap_file_hdr fh;
+    FILE *out = fopen(pcapif->out_file, "wb");
+    if (out == NULL) {
+      perror("pcapif: open output");
+      return ERR_IF;
+    }
+    fh.magic = PCAP_MAGIC_US;
+    fh.version_major = 2;
+    fh.version_minor = 4;
+    fh.thiszone = 0;
+    fh.sigfigs = 0;
+    fh.snaplen = 65535;
+    fh.network = PCAP_LINKTYPE_ETH;
+    fwrite(&fh, sizeof(fh), 1, out);
+    pcapif->out = out;
+  }
+  if (pcapif->in_file != NULL) {
+    sys_thread_new("pcapif_replay", pcapif_replay_thread, netif, 0, 0);
+  } else {
+    pcapif->replay_done = 1;
+  }
+  return ERR_OK;
+}
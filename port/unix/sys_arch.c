@@ -0,0 +1,399 @@
+/**
+ * @file
+ * sys_arch for the unix (Linux host) port: pthreads, futexes and
+ * CLOCK_MONOTONIC
+ *
+ * Mailboxes are lock-free MPSC rings (see mpsc_mbox.c), semaphores are a
+ * counter plus an eventcount, so posting/signalling only enters the kernel
+ * when somebody actually sleeps. Mutexes are plain pthread mutexes.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/stats.h"
+#include "lwip/tcpip.h"
+
+#include "mpsc_mbox.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct sys_sem {
+  atomic_uint count;
+  struct eventcount ec;
+};
+
+struct sys_mutex {
+  pthread_mutex_t mutex;
+};
+
+struct sys_mbox {
+  struct mpsc_mbox mb;
+};
+
+struct sys_thread {
+  pthread_t pthread;
+  lwip_thread_fn function;
+  void *arg;
+};
+
+static struct timespec sys_start;
+
+static pthread_mutex_t sys_prot_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static pthread_t tcpip_thread_id;
+static int tcpip_thread_marked;
+#if LWIP_TCPIP_CORE_LOCKING
+static pthread_t core_lock_holder;
+static int core_locked;
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+
+static u64_t
+sys_ms_since(const struct timespec *start)
+{
+  struct timespec ts;
+  s64_t ns;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  ns = (s64_t)(ts.tv_sec - start->tv_sec) * 1000000000LL + (ts.tv_nsec - start->tv_nsec);
+  return (u64_t)(ns / 1000000);
+}
+
+void
+sys_init(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &sys_start);
+}
+
+u32_t
+sys_now(void)
+{
+  return (u32_t)sys_ms_since(&sys_start);
+}
+
+u32_t
+sys_jiffies(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u32_t)(ts.tv_sec * 1000000000L + ts.tv_nsec);
+}
+
+/* Threads */
+
+static void *
+sys_thread_main(void *arg)
+{
+  struct sys_thread *t = (struct sys_thread *)arg;
+  t->function(t->arg);
+  return NULL;
+}
+
+sys_thread_t
+sys_thread_new(const char *name, lwip_thread_fn function, void *arg, int stacksize, int prio)
+{
+  struct sys_thread *t;
+  pthread_attr_t attr;
+  int ret;
+  LWIP_UNUSED_ARG(prio);
+
+  t = (struct sys_thread *)malloc(sizeof(struct sys_thread));
+  LWIP_ASSERT("sys_thread_new: out of memory", t != NULL);
+  t->function = function;
+  t->arg = arg;
+
+  pthread_attr_init(&attr);
+  if (stacksize > PTHREAD_STACK_MIN) {
+    pthread_attr_setstacksize(&attr, (size_t)stacksize);
+  }
+  ret = pthread_create(&t->pthread, &attr, sys_thread_main, t);
+  pthread_attr_destroy(&attr);
+  LWIP_ASSERT("sys_thread_new: pthread_create failed", ret == 0);
+  if (name != NULL) {
+    char pname[16];
+    strncpy(pname, name, sizeof(pname) - 1);
+    pname[sizeof(pname) - 1] = 0;
+    pthread_setname_np(t->pthread, pname);
+  }
+  return t;
+}
+
+/* Core locking checks */
+
+void
+sys_mark_tcpip_thread(void)
+{
+  tcpip_thread_id = pthread_self();
+  tcpip_thread_marked = 1;
+}
+
+#if LWIP_TCPIP_CORE_LOCKING
+void
+sys_lock_tcpip_core(void)
+{
+#if LWIP_TCPIP_CORE_LOCK_SPIN
+  tcpip_core_lock();
+#else /* LWIP_TCPIP_CORE_LOCK_SPIN */
+  sys_mutex_lock(&lock_tcpip_core);
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN */
+  core_lock_holder = pthread_self();
+  core_locked = 1;
+}
+
+void
+sys_unlock_tcpip_core(void)
+{
+  core_locked = 0;
+#if LWIP_TCPIP_CORE_LOCK_SPIN
+  tcpip_core_unlock();
+#else /* LWIP_TCPIP_CORE_LOCK_SPIN */
+  sys_mutex_unlock(&lock_tcpip_core);
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN */
+}
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+
+void
+sys_check_core_locking(void)
+{
+  if (!tcpip_thread_marked) {
+    /* tcpip_init() has not started the stack yet */
+    return;
+  }
+#if LWIP_TCPIP_CORE_LOCKING
+  LWIP_ASSERT("Function called without core lock",
+              core_locked && pthread_equal(core_lock_holder, pthread_self()));
+#else /* LWIP_TCPIP_CORE_LOCKING */
+  LWIP_ASSERT("Function called from wrong thread",
+              pthread_equal(tcpip_thread_id, pthread_self()));
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+}
+
+/* Lightweight protection: one recursive mutex */
+
+sys_prot_t
+sys_arch_protect(void)
+{
+  pthread_mutex_lock(&sys_prot_mutex);
+  return 0;
+}
+
+void
+sys_arch_unprotect(sys_prot_t pval)
+{
+  LWIP_UNUSED_ARG(pval);
+  pthread_mutex_unlock(&sys_prot_mutex);
+}
+
+/* Mutexes */
+
+err_t
+sys_mutex_new(sys_mutex_t *mutex)
+{
+  struct sys_mutex *m = (struct sys_mutex *)malloc(sizeof(struct sys_mutex));
+  if (m == NULL) {
+    SYS_STATS_INC(mutex.err);
+    return ERR_MEM;
+  }
+  pthread_mutex_init(&m->mutex, NULL);
+  SYS_STATS_INC_USED(mutex);
+  *mutex = m;
+  return ERR_OK;
+}
+
+void
+sys_mutex_lock(sys_mutex_t *mutex)
+{
+  pthread_mutex_lock(&(*mutex)->mutex);
+}
+
+err_t
+sys_mutex_trylock(sys_mutex_t *mutex)
+{
+  return (pthread_mutex_trylock(&(*mutex)->mutex) == 0) ? ERR_OK : ERR_WOULDBLOCK;
+}
+
+void
+sys_mutex_unlock(sys_mutex_t *mutex)
+{
+  pthread_mutex_unlock(&(*mutex)->mutex);
+}
+
+void
+sys_mutex_free(sys_mutex_t *mutex)
+{
+  pthread_mutex_destroy(&(*mutex)->mutex);
+  free(*mutex);
+  SYS_STATS_DEC(mutex.used);
+  *mutex = NULL;
+}
+
+/* Semaphores */
+
+err_t
+sys_sem_new(sys_sem_t *sem, u8_t count)
+{
+  struct sys_sem *s = (struct sys_sem *)malloc(sizeof(struct sys_sem));
+  if (s == NULL) {
+    SYS_STATS_INC(sem.err);
+    return ERR_MEM;
+  }
+  atomic_init(&s->count, count);
+  eventcount_init(&s->ec);
+  SYS_STATS_INC_USED(sem);
+  *sem = s;
+  return ERR_OK;
+}
+
+static int
+sys_sem_trywait(struct sys_sem *s)
+{
+  unsigned count = atomic_load(&s->count);
+  while (count != 0) {
+    if (atomic_compare_exchange_weak(&s->count, &count, count - 1)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void
+sys_sem_signal(sys_sem_t *sem)
+{
+  struct sys_sem *s = *sem;
+  atomic_fetch_add(&s->count, 1);
+  eventcount_notify(&s->ec);
+}
+
+u32_t
+sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
+{
+  struct sys_sem *s = *sem;
+  struct timespec start;
+
+  if (sys_sem_trywait(s)) {
+    return 0;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (;;) {
+    unsigned key = eventcount_prepare_wait(&s->ec);
+    u32_t left = 0;
+    if (sys_sem_trywait(s)) {
+      break;
+    }
+    if (timeout != 0) {
+      u64_t waited = sys_ms_since(&start);
+      if (waited >= timeout) {
+        return SYS_ARCH_TIMEOUT;
+      }
+      left = (u32_t)(timeout - waited);
+    }
+    eventcount_wait(&s->ec, key, left);
+  }
+  return (u32_t)sys_ms_since(&start);
+}
+
+void
+sys_sem_free(sys_sem_t *sem)
+{
+  free(*sem);
+  SYS_STATS_DEC(sem.used);
+  *sem = NULL;
+}
+
+/* Mailboxes */
+
+err_t
+sys_mbox_new(sys_mbox_t *mbox, int size)
+{
+  struct sys_mbox *m = (struct sys_mbox *)malloc(sizeof(struct sys_mbox));
+  if ((m == NULL) || (mpsc_mbox_init(&m->mb, size) != 0)) {
+    free(m);
+    SYS_STATS_INC(mbox.err);
+    return ERR_MEM;
+  }
+  SYS_STATS_INC_USED(mbox);
+  *mbox = m;
+  return ERR_OK;
+}
+
+void
+sys_mbox_free(sys_mbox_t *mbox)
+{
+  mpsc_mbox_free(&(*mbox)->mb);
+  free(*mbox);
+  SYS_STATS_DEC(mbox.used);
+  *mbox = NULL;
+}
+
+void
+sys_mbox_post(sys_mbox_t *mbox, void *msg)
+{
+  mpsc_mbox_post(&(*mbox)->mb, msg);
+}
+
+err_t
+sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
+{
+  if (mpsc_mbox_trypost(&(*mbox)->mb, msg) != 0) {
+    SYS_STATS_INC(mbox.err);
+    return ERR_MEM;
+  }
+  return ERR_OK;
+}
+
+err_t
+sys_mbox_trypost_fromisr(sys_mbox_t *mbox, void *msg)
+{
+  return sys_mbox_trypost(mbox, msg);
+}
+
+u32_t
+sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+  void *dummy;
+  return mpsc_mbox_fetch(&(*mbox)->mb, (msg != NULL) ? msg : &dummy, timeout);
+}
+
+u32_t
+sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
+{
+  void *dummy;
+  if (mpsc_mbox_tryfetch(&(*mbox)->mb, (msg != NULL) ? msg : &dummy) != 0) {
+    return SYS_MBOX_EMPTY;
+  }
+  return 0;
+}
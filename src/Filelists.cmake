@@ -34,13 +34,16 @@ endif ("${LWIP_VERSION_RC}" STREQUAL "LWIP_RC_RELEASE")
 set(lwipcore_SRCS
     ${LWIP_DIR}/src/core/init.c
     ${LWIP_DIR}/src/core/def.c
+    ${LWIP_DIR}/src/core/bpf.c
     ${LWIP_DIR}/src/core/dns.c
+    ${LWIP_DIR}/src/core/flowhash.c
     ${LWIP_DIR}/src/core/inet_chksum.c
     ${LWIP_DIR}/src/core/ip.c
     ${LWIP_DIR}/src/core/mem.c
     ${LWIP_DIR}/src/core/memp.c
     ${LWIP_DIR}/src/core/netif.c
     ${LWIP_DIR}/src/core/pbuf.c
+    ${LWIP_DIR}/src/core/port_alloc.c
     ${LWIP_DIR}/src/core/raw.c
     ${LWIP_DIR}/src/core/stats.c
     ${LWIP_DIR}/src/core/sys.c
@@ -61,6 +64,7 @@ set(lwipcore4_SRCS
     ${LWIP_DIR}/src/core/ipv4/igmp.c
     ${LWIP_DIR}/src/core/ipv4/ip4_frag.c
     ${LWIP_DIR}/src/core/ipv4/ip4.c
+    ${LWIP_DIR}/src/core/ipv4/ip4_route.c
     ${LWIP_DIR}/src/core/ipv4/ip4_addr.c
 )
 set(lwipcore6_SRCS
@@ -93,6 +97,9 @@ set(lwipnetif_SRCS
     ${LWIP_DIR}/src/netif/ethernet.c
     ${LWIP_DIR}/src/netif/bridgeif.c
     ${LWIP_DIR}/src/netif/bridgeif_fdb.c
+    ${LWIP_DIR}/src/netif/rxpoll.c
+    ${LWIP_DIR}/src/netif/rxring.c
+    ${LWIP_DIR}/src/netif/txring.c
     ${LWIP_DIR}/src/netif/slipif.c
 )
 
@@ -32,13 +32,16 @@
 # COREFILES, CORE4FILES: The minimum set of files needed for lwIP.
 COREFILES=$(LWIPDIR)/core/init.c \
 	$(LWIPDIR)/core/def.c \
+	$(LWIPDIR)/core/bpf.c \
 	$(LWIPDIR)/core/dns.c \
+	$(LWIPDIR)/core/flowhash.c \
 	$(LWIPDIR)/core/inet_chksum.c \
 	$(LWIPDIR)/core/ip.c \
 	$(LWIPDIR)/core/mem.c \
 	$(LWIPDIR)/core/memp.c \
 	$(LWIPDIR)/core/netif.c \
 	$(LWIPDIR)/core/pbuf.c \
+	$(LWIPDIR)/core/port_alloc.c \
 	$(LWIPDIR)/core/raw.c \
 	$(LWIPDIR)/core/stats.c \
 	$(LWIPDIR)/core/sys.c \
@@ -58,6 +61,7 @@ CORE4FILES=$(LWIPDIR)/core/ipv4/autoip.c \
 	$(LWIPDIR)/core/ipv4/igmp.c \
 	$(LWIPDIR)/core/ipv4/ip4_frag.c \
 	$(LWIPDIR)/core/ipv4/ip4.c \
+	$(LWIPDIR)/core/ipv4/ip4_route.c \
 	$(LWIPDIR)/core/ipv4/ip4_addr.c
 
 CORE6FILES=$(LWIPDIR)/core/ipv6/dhcp6.c \
@@ -85,6 +89,9 @@ APIFILES=$(LWIPDIR)/api/api_lib.c \
 NETIFFILES=$(LWIPDIR)/netif/ethernet.c \
 	$(LWIPDIR)/netif/bridgeif.c \
 	$(LWIPDIR)/netif/bridgeif_fdb.c \
+	$(LWIPDIR)/netif/rxpoll.c \
+	$(LWIPDIR)/netif/rxring.c \
+	$(LWIPDIR)/netif/txring.c \
 	$(LWIPDIR)/netif/slipif.c
 
 # SIXLOWPAN: 6LoWPAN
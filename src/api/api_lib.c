@@ -92,12 +92,12 @@
 #endif /* TCP_LISTEN_BACKLOG */
 
 #if LWIP_NETCONN_FULLDUPLEX
-#define NETCONN_RECVMBOX_WAITABLE(conn) (sys_mbox_valid(&(conn)->recvmbox) && (((conn)->flags & NETCONN_FLAG_MBOXINVALID) == 0))
+#define NETCONN_RECVMBOX_WAITABLE(conn) (netconn_recvmbox_valid(&(conn)->recvmbox) && (((conn)->flags & NETCONN_FLAG_MBOXINVALID) == 0))
 #define NETCONN_ACCEPTMBOX_WAITABLE(conn) (sys_mbox_valid(&(conn)->acceptmbox) && (((conn)->flags & (NETCONN_FLAG_MBOXCLOSED|NETCONN_FLAG_MBOXINVALID)) == 0))
 #define NETCONN_MBOX_WAITING_INC(conn) SYS_ARCH_INC(conn->mbox_threads_waiting, 1)
 #define NETCONN_MBOX_WAITING_DEC(conn) SYS_ARCH_DEC(conn->mbox_threads_waiting, 1)
 #else /* LWIP_NETCONN_FULLDUPLEX */
-#define NETCONN_RECVMBOX_WAITABLE(conn)   sys_mbox_valid(&(conn)->recvmbox)
+#define NETCONN_RECVMBOX_WAITABLE(conn)   netconn_recvmbox_valid(&(conn)->recvmbox)
 #define NETCONN_ACCEPTMBOX_WAITABLE(conn) (sys_mbox_valid(&(conn)->acceptmbox) && (((conn)->flags & NETCONN_FLAG_MBOXCLOSED) == 0))
 #define NETCONN_MBOX_WAITING_INC(conn)
 #define NETCONN_MBOX_WAITING_DEC(conn)
@@ -127,6 +127,9 @@ netconn_apimsg(tcpip_callback_fn fn, struct api_msg *apimsg)
 #if LWIP_NETCONN_SEM_PER_THREAD
   apimsg->op_completed_sem = LWIP_NETCONN_THREAD_SEM_GET();
 #endif /* LWIP_NETCONN_SEM_PER_THREAD */
+#if LWIP_NETCONN_ASYNC
+  apimsg->async = NULL;
+#endif /* LWIP_NETCONN_ASYNC */
 
   err = tcpip_send_msg_wait_sem(fn, apimsg, LWIP_API_MSG_SEM(apimsg));
   if (err == ERR_OK) {
@@ -161,7 +164,7 @@ netconn_new_with_proto_and_callback(enum netconn_type t, u8_t proto, netconn_cal
     err = netconn_apimsg(lwip_netconn_do_newconn, &API_MSG_VAR_REF(msg));
     if (err != ERR_OK) {
       LWIP_ASSERT("freeing conn without freeing pcb", conn->pcb.tcp == NULL);
-      LWIP_ASSERT("conn has no recvmbox", sys_mbox_valid(&conn->recvmbox));
+      LWIP_ASSERT("conn has no recvmbox", netconn_recvmbox_valid(&conn->recvmbox));
 #if LWIP_TCP
       LWIP_ASSERT("conn->acceptmbox shouldn't exist", !sys_mbox_valid(&conn->acceptmbox));
 #endif /* LWIP_TCP */
@@ -169,7 +172,7 @@ netconn_new_with_proto_and_callback(enum netconn_type t, u8_t proto, netconn_cal
       LWIP_ASSERT("conn has no op_completed", sys_sem_valid(&conn->op_completed));
       sys_sem_free(&conn->op_completed);
 #endif /* !LWIP_NETCONN_SEM_PER_THREAD */
-      sys_mbox_free(&conn->recvmbox);
+      netconn_recvmbox_free(&conn->recvmbox);
       memp_free(MEMP_NETCONN, conn);
       API_MSG_VAR_FREE(msg);
       return NULL;
@@ -579,7 +582,7 @@ static err_t
 netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
 {
   void *buf = NULL;
-  u16_t len;
+  pbuf_len_t len;
 
   LWIP_ERROR("netconn_recv: invalid pointer", (new_buf != NULL), return ERR_ARG;);
   *new_buf = NULL;
@@ -597,7 +600,7 @@ netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
   NETCONN_MBOX_WAITING_INC(conn);
   if (netconn_is_nonblocking(conn) || (apiflags & NETCONN_DONTBLOCK) ||
       (conn->flags & NETCONN_FLAG_MBOXCLOSED) || (conn->pending_err != ERR_OK)) {
-    if (sys_arch_mbox_tryfetch(&conn->recvmbox, &buf) == SYS_ARCH_TIMEOUT) {
+    if (netconn_recvmbox_tryfetch(&conn->recvmbox, &buf) == SYS_ARCH_TIMEOUT) {
       err_t err;
       NETCONN_MBOX_WAITING_DEC(conn);
       err = netconn_err(conn);
@@ -612,12 +615,12 @@ netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
     }
   } else {
 #if LWIP_SO_RCVTIMEO
-    if (sys_arch_mbox_fetch(&conn->recvmbox, &buf, conn->recv_timeout) == SYS_ARCH_TIMEOUT) {
+    if (netconn_recvmbox_fetch(&conn->recvmbox, &buf, conn->recv_timeout) == SYS_ARCH_TIMEOUT) {
       NETCONN_MBOX_WAITING_DEC(conn);
       return ERR_TIMEOUT;
     }
 #else
-    sys_arch_mbox_fetch(&conn->recvmbox, &buf, 0);
+    netconn_recvmbox_fetch(&conn->recvmbox, &buf, 0);
 #endif /* LWIP_SO_RCVTIMEO*/
   }
   NETCONN_MBOX_WAITING_DEC(conn);
@@ -663,9 +666,9 @@ netconn_recv_data(struct netconn *conn, void **new_buf, u8_t apiflags)
   SYS_ARCH_DEC(conn->recv_avail, len);
 #endif /* LWIP_SO_RCVBUF */
   /* Register event with callback */
-  API_EVENT(conn, NETCONN_EVT_RCVMINUS, len);
+  API_EVENT(conn, NETCONN_EVT_RCVMINUS, (u16_t)LWIP_MIN(len, 0xffff));
 
-  LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_recv_data: received %p, len=%"U16_F"\n", buf, len));
+  LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_recv_data: received %p, len=%"U32_F"\n", buf, (u32_t)len));
 
   *new_buf = buf;
   /* don't set conn->last_err: it's only ERR_OK, anyway */
@@ -734,7 +737,7 @@ netconn_recv_data_tcp(struct netconn *conn, struct pbuf **new_buf, u8_t apiflags
   buf = *new_buf;
   if (!(apiflags & NETCONN_NOAUTORCVD)) {
     /* Let the stack know that we have taken the data. */
-    u16_t len = buf ? buf->tot_len : 1;
+    size_t len = buf ? (size_t)buf->tot_len : 1;
     /* don't care for the return value of lwip_netconn_do_recv */
     /* @todo: this should really be fixed, e.g. by retrying in poll on error */
     netconn_tcp_recvd_msg(conn, len,  &API_VAR_REF(msg));
@@ -956,6 +959,50 @@ netconn_send(struct netconn *conn, struct netbuf *buf)
   return err;
 }
 
+/**
+ * @ingroup netconn_udp
+ * Send several datagrams over a UDP or RAW netconn with a single call into
+ * tcpip_thread (one core lock or one message for all of them), each netbuf
+ * with its own destination as for netconn_send()/netconn_sendto().
+ * Sending stops at the first datagram that fails.
+ *
+ * @param conn the UDP or RAW netconn over which to send data
+ * @param bufs array of netbufs to send
+ * @param num number of netbufs in 'bufs'
+ * @param sent receives the number of datagrams sent (may be NULL)
+ * @return ERR_OK if all were sent, else the error of the first one that failed
+ */
+err_t
+netconn_send_batch(struct netconn *conn, struct netbuf **bufs, u16_t num, u16_t *sent)
+{
+  API_MSG_VAR_DECLARE(msg);
+  err_t err;
+
+  if (sent != NULL) {
+    *sent = 0;
+  }
+  LWIP_ERROR("netconn_send_batch: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_send_batch: invalid bufs", (bufs != NULL) || (num == 0), return ERR_ARG;);
+  if (num == 0) {
+    return ERR_OK;
+  }
+
+  LWIP_DEBUGF(API_LIB_DEBUG, ("netconn_send_batch: sending %"U16_F" datagrams\n", num));
+
+  API_MSG_VAR_ALLOC(msg);
+  API_MSG_VAR_REF(msg).conn = conn;
+  API_MSG_VAR_REF(msg).msg.bb.bufs = bufs;
+  API_MSG_VAR_REF(msg).msg.bb.num = num;
+  API_MSG_VAR_REF(msg).msg.bb.sent = 0;
+  err = netconn_apimsg(lwip_netconn_do_send_batch, &API_MSG_VAR_REF(msg));
+  if (sent != NULL) {
+    *sent = API_MSG_VAR_REF(msg).msg.bb.sent;
+  }
+  API_MSG_VAR_FREE(msg);
+
+  return err;
+}
+
 /**
  * @ingroup netconn_tcp
  * Send data over a TCP netconn.
@@ -1165,6 +1212,207 @@ netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx)
   return netconn_close_shutdown(conn, (u8_t)((shut_rx ? NETCONN_SHUT_RD : 0) | (shut_tx ? NETCONN_SHUT_WR : 0)));
 }
 
+#if LWIP_NETCONN_ASYNC
+/**
+ * Allocate an asynchronous operation for a netconn.
+ *
+ * @return the new operation or NULL if MEMP_NUM_NETCONN_ASYNC is exhausted
+ */
+static struct netconn_async *
+netconn_async_alloc(struct netconn *conn, u8_t type, netconn_async_fn fn, void *arg)
+{
+  struct netconn_async *op = (struct netconn_async *)memp_malloc(MEMP_NETCONN_ASYNC);
+  if (op != NULL) {
+    op->msg.conn = conn;
+    op->msg.err = ERR_OK;
+    op->msg.async = op;
+    op->fn = fn;
+    op->arg = arg;
+    op->type = type;
+  }
+  return op;
+}
+
+/**
+ * Pass an asynchronous operation to tcpip_thread without waiting for it.
+ * On error, the operation is freed and its callback is not called.
+ */
+static err_t
+netconn_async_submit(tcpip_callback_fn fn, struct netconn_async *op)
+{
+  err_t err = tcpip_try_callback(fn, &op->msg);
+  if (err != ERR_OK) {
+    memp_free(MEMP_NETCONN_ASYNC, op);
+  }
+  return err;
+}
+
+/**
+ * @ingroup netconn_common
+ * Connect a netconn to a specific remote IP address and port without
+ * blocking. Like netconn_connect(), but the result is passed to 'fn'
+ * (called from tcpip_thread) once the connection is established or failed.
+ * The netconn's nonblocking flag is ignored.
+ *
+ * @param conn the netconn to connect
+ * @param addr the remote IP address to connect to (copied)
+ * @param port the remote port to connect to (no used for RAW)
+ * @param fn completion callback
+ * @param arg argument passed to fn
+ * @return ERR_OK if the connect has been submitted (fn will be called exactly
+ *         once), another err_t if not (fn will not be called)
+ */
+err_t
+netconn_connect_async(struct netconn *conn, const ip_addr_t *addr, u16_t port,
+                      netconn_async_fn fn, void *arg)
+{
+  struct netconn_async *op;
+
+  LWIP_ERROR("netconn_connect_async: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_connect_async: invalid fn", (fn != NULL), return ERR_ARG;);
+
+#if LWIP_IPV4
+  /* Don't propagate NULL pointer (IP_ADDR_ANY alias) to subsequent functions */
+  if (addr == NULL) {
+    addr = IP4_ADDR_ANY;
+  }
+#endif /* LWIP_IPV4 */
+
+  op = netconn_async_alloc(conn, NETCONN_ASYNC_CONNECT, fn, arg);
+  if (op == NULL) {
+    return ERR_MEM;
+  }
+  ip_addr_copy(op->addr, *addr);
+  op->msg.msg.bc.ipaddr = API_MSG_VAR_REF(&op->addr);
+  op->msg.msg.bc.port = port;
+  return netconn_async_submit(lwip_netconn_do_connect, op);
+}
+
+/**
+ * @ingroup netconn_tcp
+ * Send data over a TCP netconn without blocking. Like netconn_write(), but
+ * the call returns at once and 'fn' (called from tcpip_thread) gets the
+ * result and the number of bytes written once all data has been enqueued,
+ * which may be less than 'size' on error or SO_SNDTIMEO timeout.
+ * The netconn's nonblocking flag is ignored.
+ *
+ * @param conn the TCP netconn over which to send data
+ * @param dataptr pointer to the application buffer that contains the data to send;
+ *        without NETCONN_COPY, it must stay valid until the data is acknowledged
+ *        by the remote host, otherwise until fn is called
+ * @param size size of the application data to send
+ * @param apiflags combination of following flags :
+ * - NETCONN_COPY: data will be copied into memory belonging to the stack
+ * - NETCONN_MORE: for TCP connection, PSH flag will be set on last segment sent
+ * @param fn completion callback
+ * @param arg argument passed to fn
+ * @return ERR_OK if the write has been submitted (fn will be called exactly
+ *         once), another err_t if not (fn will not be called)
+ */
+err_t
+netconn_write_async(struct netconn *conn, const void *dataptr, size_t size,
+                    u8_t apiflags, netconn_async_fn fn, void *arg)
+{
+  struct netconn_async *op;
+
+  LWIP_ERROR("netconn_write_async: invalid conn",  (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_write_async: invalid conn->type",  (NETCONNTYPE_GROUP(conn->type) == NETCONN_TCP), return ERR_VAL;);
+  LWIP_ERROR("netconn_write_async: invalid fn", (fn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_write_async: invalid apiflags",
+             (apiflags & ~(NETCONN_COPY | NETCONN_MORE)) == 0, return ERR_VAL;);
+  /* this is required by the socket layer (cannot send full size_t range) */
+  LWIP_ERROR("netconn_write_async: invalid size", (size != 0) && (size <= SSIZE_MAX), return ERR_VAL;);
+
+  op = netconn_async_alloc(conn, NETCONN_ASYNC_WRITE, fn, arg);
+  if (op == NULL) {
+    return ERR_MEM;
+  }
+  op->vector.ptr = dataptr;
+  op->vector.len = size;
+  op->msg.msg.w.vector = &op->vector;
+  op->msg.msg.w.vector_cnt = 1;
+  op->msg.msg.w.vector_off = 0;
+  op->msg.msg.w.apiflags = apiflags;
+  op->msg.msg.w.len = size;
+  op->msg.msg.w.offset = 0;
+#if LWIP_SO_SNDTIMEO
+  if (conn->send_timeout != 0) {
+    op->msg.msg.w.time_started = sys_now();
+  } else {
+    op->msg.msg.w.time_started = 0;
+  }
+#endif /* LWIP_SO_SNDTIMEO */
+  return netconn_async_submit(lwip_netconn_do_write, op);
+}
+
+/**
+ * @ingroup netconn_common
+ * Receive data from a netconn without blocking: 'fn' is called from
+ * tcpip_thread with the next pbuf (TCP) or netbuf (UDP/RAW) as soon as
+ * one is available. The callee owns the data and must free it. For TCP, the
+ * receive window is updated before fn is called and a closed connection is
+ * reported as ERR_CLSD with data == NULL.
+ * Only one receive can be pending per netconn; a pending receive completes
+ * with ERR_CLSD when the netconn is closed for receiving or deleted.
+ *
+ * @param conn the netconn from which to receive data
+ * @param fn completion callback
+ * @param arg argument passed to fn
+ * @return ERR_OK if the receive has been submitted (fn will be called exactly
+ *         once), another err_t if not (fn will not be called)
+ */
+err_t
+netconn_recv_async(struct netconn *conn, netconn_async_fn fn, void *arg)
+{
+  struct netconn_async *op;
+
+  LWIP_ERROR("netconn_recv_async: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_recv_async: invalid fn", (fn != NULL), return ERR_ARG;);
+
+  op = netconn_async_alloc(conn, NETCONN_ASYNC_RECV, fn, arg);
+  if (op == NULL) {
+    return ERR_MEM;
+  }
+  return netconn_async_submit(lwip_netconn_do_recv_async, op);
+}
+
+/**
+ * @ingroup netconn_tcp
+ * Close a TCP netconn (doesn't delete it) without blocking. Like
+ * netconn_close(), but the result is passed to 'fn' (called from
+ * tcpip_thread). The netconn may only be deleted after fn has been called.
+ *
+ * @param conn the TCP netconn to close
+ * @param fn completion callback
+ * @param arg argument passed to fn
+ * @return ERR_OK if the close has been submitted (fn will be called exactly
+ *         once), another err_t if not (fn will not be called)
+ */
+err_t
+netconn_close_async(struct netconn *conn, netconn_async_fn fn, void *arg)
+{
+  struct netconn_async *op;
+
+  LWIP_ERROR("netconn_close_async: invalid conn", (conn != NULL), return ERR_ARG;);
+  LWIP_ERROR("netconn_close_async: invalid fn", (fn != NULL), return ERR_ARG;);
+
+  op = netconn_async_alloc(conn, NETCONN_ASYNC_CLOSE, fn, arg);
+  if (op == NULL) {
+    return ERR_MEM;
+  }
+#if LWIP_TCP
+  op->msg.msg.sd.shut = NETCONN_SHUT_RDWR;
+#if LWIP_SO_SNDTIMEO || LWIP_SO_LINGER
+  op->msg.msg.sd.time_started = sys_now();
+#else /* LWIP_SO_SNDTIMEO || LWIP_SO_LINGER */
+  op->msg.msg.sd.polls_left =
+    ((LWIP_TCP_CLOSE_TIMEOUT_MS_DEFAULT + TCP_SLOW_INTERVAL - 1) / TCP_SLOW_INTERVAL) + 1;
+#endif /* LWIP_SO_SNDTIMEO || LWIP_SO_LINGER */
+#endif /* LWIP_TCP */
+  return netconn_async_submit(lwip_netconn_do_close, op);
+}
+#endif /* LWIP_NETCONN_ASYNC */
+
 #if LWIP_IGMP || (LWIP_IPV6 && LWIP_IPV6_MLD)
 /**
  * @ingroup netconn_udp
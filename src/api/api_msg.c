@@ -49,6 +49,7 @@
 #include "lwip/raw.h"
 
 #include "lwip/memp.h"
+#include "lwip/mem.h"
 #include "lwip/igmp.h"
 #include "lwip/dns.h"
 #include "lwip/mld6.h"
@@ -67,8 +68,10 @@
 
 #if LWIP_NETCONN_FULLDUPLEX
 #define NETCONN_MBOX_VALID(conn, mbox) (sys_mbox_valid(mbox) && ((conn->flags & NETCONN_FLAG_MBOXINVALID) == 0))
+#define NETCONN_RECVMBOX_VALID(conn)   (netconn_recvmbox_valid(&(conn)->recvmbox) && ((conn->flags & NETCONN_FLAG_MBOXINVALID) == 0))
 #else
 #define NETCONN_MBOX_VALID(conn, mbox) sys_mbox_valid(mbox)
+#define NETCONN_RECVMBOX_VALID(conn)   netconn_recvmbox_valid(&(conn)->recvmbox)
 #endif
 
 /* forward declarations */
@@ -86,10 +89,23 @@ static err_t lwip_netconn_do_close_internal(struct netconn *conn  WRITE_DELAYED_
 
 static void netconn_drain(struct netconn *conn);
 
+#if LWIP_NETCONN_ASYNC
+static void lwip_netconn_op_completed(struct api_msg *msg);
+static void netconn_recv_async_poll(struct netconn *conn);
+static void netconn_recv_async_abort(struct netconn *conn);
+/* asynchronous messages always need to be completed, even with core locking */
+#define NETCONN_ASYNC_ACK(m)  do { if (NETCONN_MSG_IS_ASYNC(m)) { lwip_netconn_op_completed(m); } } while(0)
+#else /* LWIP_NETCONN_ASYNC */
+#define lwip_netconn_op_completed(m)  sys_sem_signal(LWIP_API_MSG_SEM(m))
+#define netconn_recv_async_poll(conn)
+#define netconn_recv_async_abort(conn)
+#define NETCONN_ASYNC_ACK(m)
+#endif /* LWIP_NETCONN_ASYNC */
+
 #if LWIP_TCPIP_CORE_LOCKING
-#define TCPIP_APIMSG_ACK(m)
+#define TCPIP_APIMSG_ACK(m)   NETCONN_ASYNC_ACK(m)
 #else /* LWIP_TCPIP_CORE_LOCKING */
-#define TCPIP_APIMSG_ACK(m)   do { sys_sem_signal(LWIP_API_MSG_SEM(m)); } while(0)
+#define TCPIP_APIMSG_ACK(m)   do { lwip_netconn_op_completed(m); } while(0)
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
 #if LWIP_NETCONN_FULLDUPLEX
@@ -166,7 +182,7 @@ recv_raw(void *arg, struct raw_pcb *pcb, struct pbuf *p,
   LWIP_UNUSED_ARG(addr);
   conn = (struct netconn *)arg;
 
-  if ((conn != NULL) && NETCONN_MBOX_VALID(conn, &conn->recvmbox)) {
+  if ((conn != NULL) && NETCONN_RECVMBOX_VALID(conn)) {
 #if LWIP_SO_RCVBUF
     int recv_avail;
     SYS_ARCH_GET(conn->recv_avail, recv_avail);
@@ -190,7 +206,7 @@ recv_raw(void *arg, struct raw_pcb *pcb, struct pbuf *p,
       buf->port = pcb->protocol;
 
       len = q->tot_len;
-      if (sys_mbox_trypost(&conn->recvmbox, buf) != ERR_OK) {
+      if (netconn_recvmbox_trypost(&conn->recvmbox, buf) != ERR_OK) {
         netbuf_delete(buf);
         return 0;
       } else {
@@ -199,6 +215,7 @@ recv_raw(void *arg, struct raw_pcb *pcb, struct pbuf *p,
 #endif /* LWIP_SO_RCVBUF */
         /* Register event with callback */
         API_EVENT(conn, NETCONN_EVT_RCVPLUS, len);
+        netconn_recv_async_poll(conn);
       }
     }
   }
@@ -239,10 +256,10 @@ recv_udp(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 
 #if LWIP_SO_RCVBUF
   SYS_ARCH_GET(conn->recv_avail, recv_avail);
-  if (!NETCONN_MBOX_VALID(conn, &conn->recvmbox) ||
+  if (!NETCONN_RECVMBOX_VALID(conn) ||
       ((recv_avail + (int)(p->tot_len)) > conn->recv_bufsize)) {
 #else  /* LWIP_SO_RCVBUF */
-  if (!NETCONN_MBOX_VALID(conn, &conn->recvmbox)) {
+  if (!NETCONN_RECVMBOX_VALID(conn)) {
 #endif /* LWIP_SO_RCVBUF */
     pbuf_free(p);
     return;
@@ -268,8 +285,8 @@ recv_udp(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 #endif /* LWIP_NETBUF_RECVINFO */
   }
 
-  len = p->tot_len;
-  if (sys_mbox_trypost(&conn->recvmbox, buf) != ERR_OK) {
+  len = (u16_t)p->tot_len;
+  if (netconn_recvmbox_trypost(&conn->recvmbox, buf) != ERR_OK) {
     netbuf_delete(buf);
     return;
   } else {
@@ -278,6 +295,7 @@ recv_udp(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 #endif /* LWIP_SO_RCVBUF */
     /* Register event with callback */
     API_EVENT(conn, NETCONN_EVT_RCVPLUS, len);
+    netconn_recv_async_poll(conn);
   }
 }
 #endif /* LWIP_UDP */
@@ -308,10 +326,10 @@ recv_tcp(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
   }
   LWIP_ASSERT("recv_tcp: recv for wrong pcb!", conn->pcb.tcp == pcb);
 
-  if (!NETCONN_MBOX_VALID(conn, &conn->recvmbox)) {
+  if (!NETCONN_RECVMBOX_VALID(conn)) {
     /* recvmbox already deleted */
     if (p != NULL) {
-      tcp_recved(pcb, p->tot_len);
+      tcp_recved(pcb, (u16_t)p->tot_len);
       pbuf_free(p);
     }
     return ERR_OK;
@@ -322,13 +340,13 @@ recv_tcp(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 
   if (p != NULL) {
     msg = p;
-    len = p->tot_len;
+    len = (u16_t)p->tot_len;
   } else {
     msg = LWIP_CONST_CAST(void *, &netconn_closed);
     len = 0;
   }
 
-  if (sys_mbox_trypost(&conn->recvmbox, msg) != ERR_OK) {
+  if (netconn_recvmbox_trypost(&conn->recvmbox, msg) != ERR_OK) {
     /* don't deallocate p: it is presented to us later again from tcp_fasttmr! */
     return ERR_MEM;
   } else {
@@ -337,6 +355,7 @@ recv_tcp(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 #endif /* LWIP_SO_RCVBUF */
     /* Register event with callback */
     API_EVENT(conn, NETCONN_EVT_RCVPLUS, len);
+    netconn_recv_async_poll(conn);
   }
 
   return ERR_OK;
@@ -463,9 +482,10 @@ err_tcp(void *arg, err_t err)
 
   mbox_msg = lwip_netconn_err_to_msg(err);
   /* pass error message to recvmbox to wake up pending recv */
-  if (NETCONN_MBOX_VALID(conn, &conn->recvmbox)) {
+  if (NETCONN_RECVMBOX_VALID(conn)) {
     /* use trypost to prevent deadlock */
-    sys_mbox_trypost(&conn->recvmbox, mbox_msg);
+    netconn_recvmbox_trypost(&conn->recvmbox, mbox_msg);
+    netconn_recv_async_poll(conn);
   }
   /* pass error message to acceptmbox to wake up pending accept */
   if (NETCONN_MBOX_VALID(conn, &conn->acceptmbox)) {
@@ -481,7 +501,7 @@ err_tcp(void *arg, err_t err)
     SET_NONBLOCKING_CONNECT(conn, 0);
 
     if (!was_nonblocking_connect) {
-      sys_sem_t *op_completed_sem;
+      struct api_msg *op_completed;
       /* set error return code */
       LWIP_ASSERT("conn->current_msg != NULL", conn->current_msg != NULL);
       if (old_state == NETCONN_CLOSE) {
@@ -491,11 +511,12 @@ err_tcp(void *arg, err_t err)
         /* Write and connect fail */
         conn->current_msg->err = err;
       }
-      op_completed_sem = LWIP_API_MSG_SEM(conn->current_msg);
-      LWIP_ASSERT("inavlid op_completed_sem", sys_sem_valid(op_completed_sem));
+      op_completed = conn->current_msg;
+      LWIP_ASSERT("inavlid op_completed_sem", NETCONN_MSG_IS_ASYNC(op_completed) ||
+                  sys_sem_valid(LWIP_API_MSG_SEM(op_completed)));
       conn->current_msg = NULL;
       /* wake up the waiting task */
-      sys_sem_signal(op_completed_sem);
+      lwip_netconn_op_completed(op_completed);
     } else {
       /* @todo: test what happens for error on nonblocking connect */
     }
@@ -586,8 +607,8 @@ accept_function(void *arg, struct tcp_pcb *newpcb, err_t err)
     /* remove reference from to the pcb from this netconn */
     newconn->pcb.tcp = NULL;
     /* no need to drain since we know the recvmbox is empty. */
-    sys_mbox_free(&newconn->recvmbox);
-    sys_mbox_set_invalid(&newconn->recvmbox);
+    netconn_recvmbox_free(&newconn->recvmbox);
+    netconn_recvmbox_set_invalid(&newconn->recvmbox);
     netconn_free(newconn);
     return ERR_MEM;
   } else {
@@ -742,12 +763,12 @@ netconn_alloc(enum netconn_type t, netconn_callback callback)
       goto free_and_return;
   }
 
-  if (sys_mbox_new(&conn->recvmbox, size) != ERR_OK) {
+  if (netconn_recvmbox_new(&conn->recvmbox, size) != ERR_OK) {
     goto free_and_return;
   }
 #if !LWIP_NETCONN_SEM_PER_THREAD
   if (sys_sem_new(&conn->op_completed, 0) != ERR_OK) {
-    sys_mbox_free(&conn->recvmbox);
+    netconn_recvmbox_free(&conn->recvmbox);
     goto free_and_return;
   }
 #endif
@@ -801,7 +822,7 @@ netconn_free(struct netconn *conn)
 #endif /* LWIP_NETCONN_FULLDUPLEX */
 
   LWIP_ASSERT("recvmbox must be deallocated before calling this function",
-              !sys_mbox_valid(&conn->recvmbox));
+              !netconn_recvmbox_valid(&conn->recvmbox));
 #if LWIP_TCP
   LWIP_ASSERT("acceptmbox must be deallocated before calling this function",
               !sys_mbox_valid(&conn->acceptmbox));
@@ -815,6 +836,141 @@ netconn_free(struct netconn *conn)
   memp_free(MEMP_NETCONN, conn);
 }
 
+#if LWIP_NETCONN_RECVQ
+/**
+ * Allocate the receive queue of a netconn.
+ *
+ * @param q the queue to initialize
+ * @param size number of entries (DEFAULT_xxx_RECVMBOX_SIZE)
+ * @return ERR_OK or ERR_MEM
+ */
+err_t
+netconn_recvq_new(struct netconn_recvq *q, int size)
+{
+  LWIP_ERROR("netconn_recvq_new: invalid size", (size > 0) && (size <= 0xFFFF),
+             q->items = NULL; return ERR_VAL;);
+
+  q->items = (void **)mem_malloc((mem_size_t)(sizeof(void *) * (size_t)size));
+  if (q->items == NULL) {
+    return ERR_MEM;
+  }
+  if (sys_sem_new(&q->sem, 0) != ERR_OK) {
+    mem_free(q->items);
+    q->items = NULL;
+    return ERR_MEM;
+  }
+  q->size = (u16_t)size;
+  q->first = 0;
+  q->count = 0;
+  q->waiting = 0;
+  return ERR_OK;
+}
+
+/**
+ * Free the receive queue of a netconn. Entries still queued are not freed
+ * (see netconn_drain()).
+ */
+void
+netconn_recvq_free(struct netconn_recvq *q)
+{
+  LWIP_ASSERT("netconn_recvq_free: invalid queue", q->items != NULL);
+  sys_sem_free(&q->sem);
+  mem_free(q->items);
+}
+
+/**
+ * Append an entry to the receive queue of a netconn. The semaphore is only
+ * signalled if a thread waits for the queue to become non-empty.
+ *
+ * @return ERR_OK or ERR_MEM if the queue is full
+ */
+err_t
+netconn_recvq_trypost(struct netconn_recvq *q, void *msg)
+{
+  u16_t idx;
+  u8_t wake = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  if (q->count >= q->size) {
+    SYS_ARCH_UNPROTECT(lev);
+    return ERR_MEM;
+  }
+  /* first + count can exceed 0xFFFF for sizes above 32767 */
+  idx = (u16_t)(((u32_t)q->first + q->count) % q->size);
+  q->items[idx] = msg;
+  q->count++;
+  if ((q->count == 1) && (q->waiting > 0)) {
+    /* empty -> non-empty with a waiter: wake one, it passes on the rest */
+    wake = 1;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  if (wake) {
+    sys_sem_signal(&q->sem);
+  }
+  return ERR_OK;
+}
+
+/**
+ * Take the oldest entry from the receive queue of a netconn.
+ *
+ * @param q the queue
+ * @param msg receives the entry
+ * @param timeout like for sys_arch_mbox_fetch() (0 waits forever)
+ * @param block 0 to return SYS_MBOX_EMPTY at once if the queue is empty
+ * @return 0 on success, SYS_ARCH_TIMEOUT (== SYS_MBOX_EMPTY) if no entry
+ *         was received
+ */
+u32_t
+netconn_recvq_fetch(struct netconn_recvq *q, void **msg, u32_t timeout, u8_t block)
+{
+  u32_t waited = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  for (;;) {
+    u32_t ret;
+
+    SYS_ARCH_PROTECT(lev);
+    if (q->count > 0) {
+      u8_t wake;
+      *msg = q->items[q->first];
+      q->first++;
+      if (q->first == q->size) {
+        q->first = 0;
+      }
+      q->count--;
+      /* more queued for another waiter (woken once per burst only)? */
+      wake = (q->count > 0) && (q->waiting > 0);
+      SYS_ARCH_UNPROTECT(lev);
+      if (wake) {
+        sys_sem_signal(&q->sem);
+      }
+      return 0;
+    }
+    if (!block || ((timeout != 0) && (waited >= timeout))) {
+      SYS_ARCH_UNPROTECT(lev);
+      return SYS_ARCH_TIMEOUT;
+    }
+    q->waiting++;
+    SYS_ARCH_UNPROTECT(lev);
+
+    ret = sys_arch_sem_wait(&q->sem, (timeout != 0) ? (timeout - waited) : 0);
+
+    SYS_ARCH_PROTECT(lev);
+    q->waiting--;
+    SYS_ARCH_UNPROTECT(lev);
+    if (ret == SYS_ARCH_TIMEOUT) {
+      /* check once more below, but don't wait again */
+      waited = timeout;
+    } else if (timeout != 0) {
+      /* woken without an entry left for us: wait for the rest of the time */
+      waited += LWIP_MAX(ret, 1);
+    }
+  }
+}
+#endif /* LWIP_NETCONN_RECVQ */
+
 /**
  * Delete rcvmbox and acceptmbox of a netconn and free the left-over data in
  * these mboxes
@@ -828,6 +984,8 @@ netconn_drain(struct netconn *conn)
 {
   void *mem;
 
+  netconn_recv_async_abort(conn);
+
   /* This runs when mbox and netconn are marked as closed,
      so we don't need to lock against rx packets */
 #if LWIP_NETCONN_FULLDUPLEX
@@ -835,8 +993,8 @@ netconn_drain(struct netconn *conn)
 #endif /* LWIP_NETCONN_FULLDUPLEX */
 
   /* Delete and drain the recvmbox. */
-  if (sys_mbox_valid(&conn->recvmbox)) {
-    while (sys_mbox_tryfetch(&conn->recvmbox, &mem) != SYS_MBOX_EMPTY) {
+  if (netconn_recvmbox_valid(&conn->recvmbox)) {
+    while (netconn_recvmbox_tryfetch(&conn->recvmbox, &mem) != SYS_MBOX_EMPTY) {
 #if LWIP_NETCONN_FULLDUPLEX
       if (!lwip_netconn_is_deallocated_msg(mem))
 #endif /* LWIP_NETCONN_FULLDUPLEX */
@@ -854,8 +1012,8 @@ netconn_drain(struct netconn *conn)
         }
       }
     }
-    sys_mbox_free(&conn->recvmbox);
-    sys_mbox_set_invalid(&conn->recvmbox);
+    netconn_recvmbox_free(&conn->recvmbox);
+    netconn_recvmbox_set_invalid(&conn->recvmbox);
   }
 
   /* Delete and drain the acceptmbox. */
@@ -896,11 +1054,12 @@ netconn_mark_mbox_invalid(struct netconn *conn)
 
   /* Prevent new calls/threads from reading from the mbox */
   conn->flags |= NETCONN_FLAG_MBOXINVALID;
+  netconn_recv_async_abort(conn);
 
   SYS_ARCH_LOCKED(num_waiting = conn->mbox_threads_waiting);
   for (i = 0; i < num_waiting; i++) {
-    if (sys_mbox_valid_val(conn->recvmbox)) {
-      sys_mbox_trypost(&conn->recvmbox, msg);
+    if (netconn_recvmbox_valid_val(conn->recvmbox)) {
+      netconn_recvmbox_trypost(&conn->recvmbox, msg);
     } else {
       sys_mbox_trypost(&conn->acceptmbox, msg);
     }
@@ -1055,7 +1214,7 @@ lwip_netconn_do_close_internal(struct netconn *conn  WRITE_DELAYED_PARAM)
   }
   if (close_finished) {
     /* Closing done (succeeded, non-memory error, nonblocking error or timeout) */
-    sys_sem_t *op_completed_sem = LWIP_API_MSG_SEM(conn->current_msg);
+    struct api_msg *op_completed = conn->current_msg;
     conn->current_msg->err = err;
     conn->current_msg = NULL;
     conn->state = NETCONN_NONE;
@@ -1079,7 +1238,7 @@ lwip_netconn_do_close_internal(struct netconn *conn  WRITE_DELAYED_PARAM)
 #endif
     {
       /* wake up the application task */
-      sys_sem_signal(op_completed_sem);
+      lwip_netconn_op_completed(op_completed);
     }
     return ERR_OK;
   }
@@ -1123,13 +1282,13 @@ lwip_netconn_do_delconn(void *m)
     if ((state == NETCONN_WRITE) ||
         ((state == NETCONN_CONNECT) && !IN_NONBLOCKING_CONNECT(msg->conn))) {
       /* close requested, abort running write/connect */
-      sys_sem_t *op_completed_sem;
+      struct api_msg *op_completed;
       LWIP_ASSERT("msg->conn->current_msg != NULL", msg->conn->current_msg != NULL);
-      op_completed_sem = LWIP_API_MSG_SEM(msg->conn->current_msg);
+      op_completed = msg->conn->current_msg;
       msg->conn->current_msg->err = ERR_CLSD;
       msg->conn->current_msg = NULL;
       msg->conn->state = NETCONN_NONE;
-      sys_sem_signal(op_completed_sem);
+      lwip_netconn_op_completed(op_completed);
     }
   }
 #else /* LWIP_NETCONN_FULLDUPLEX */
@@ -1302,7 +1461,7 @@ lwip_netconn_do_connected(void *arg, struct tcp_pcb *pcb, err_t err)
 {
   struct netconn *conn;
   int was_blocking;
-  sys_sem_t *op_completed_sem = NULL;
+  struct api_msg *op_completed = NULL;
 
   LWIP_UNUSED_ARG(pcb);
 
@@ -1318,7 +1477,7 @@ lwip_netconn_do_connected(void *arg, struct tcp_pcb *pcb, err_t err)
 
   if (conn->current_msg != NULL) {
     conn->current_msg->err = err;
-    op_completed_sem = LWIP_API_MSG_SEM(conn->current_msg);
+    op_completed = conn->current_msg;
   }
   if ((NETCONNTYPE_GROUP(conn->type) == NETCONN_TCP) && (err == ERR_OK)) {
     setup_tcp(conn);
@@ -1326,14 +1485,14 @@ lwip_netconn_do_connected(void *arg, struct tcp_pcb *pcb, err_t err)
   was_blocking = !IN_NONBLOCKING_CONNECT(conn);
   SET_NONBLOCKING_CONNECT(conn, 0);
   LWIP_ASSERT("blocking connect state error",
-              (was_blocking && op_completed_sem != NULL) ||
-              (!was_blocking && op_completed_sem == NULL));
+              (was_blocking && op_completed != NULL) ||
+              (!was_blocking && op_completed == NULL));
   conn->current_msg = NULL;
   conn->state = NETCONN_NONE;
   API_EVENT(conn, NETCONN_EVT_SENDPLUS, 0);
 
   if (was_blocking) {
-    sys_sem_signal(op_completed_sem);
+    lwip_netconn_op_completed(op_completed);
   }
   return ERR_OK;
 }
@@ -1379,7 +1538,8 @@ lwip_netconn_do_connect(void *m)
           err = tcp_connect(msg->conn->pcb.tcp, API_EXPR_REF(msg->msg.bc.ipaddr),
                             msg->msg.bc.port, lwip_netconn_do_connected);
           if (err == ERR_OK) {
-            u8_t non_blocking = netconn_is_nonblocking(msg->conn);
+            /* asynchronous connects complete through their callback instead */
+            u8_t non_blocking = netconn_is_nonblocking(msg->conn) && !NETCONN_MSG_IS_ASYNC(msg);
             msg->conn->state = NETCONN_CONNECT;
             SET_NONBLOCKING_CONNECT(msg->conn, non_blocking);
             if (non_blocking) {
@@ -1389,11 +1549,13 @@ lwip_netconn_do_connect(void *m)
               /* sys_sem_signal() is called from lwip_netconn_do_connected (or err_tcp()),
                  when the connection is established! */
 #if LWIP_TCPIP_CORE_LOCKING
-              LWIP_ASSERT("state!", msg->conn->state == NETCONN_CONNECT);
-              UNLOCK_TCPIP_CORE();
-              sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
-              LOCK_TCPIP_CORE();
-              LWIP_ASSERT("state!", msg->conn->state != NETCONN_CONNECT);
+              if (!NETCONN_MSG_IS_ASYNC(msg)) {
+                LWIP_ASSERT("state!", msg->conn->state == NETCONN_CONNECT);
+                UNLOCK_TCPIP_CORE();
+                sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
+                LOCK_TCPIP_CORE();
+                LWIP_ASSERT("state!", msg->conn->state != NETCONN_CONNECT);
+              }
 #endif /* LWIP_TCPIP_CORE_LOCKING */
               return;
             }
@@ -1483,10 +1645,10 @@ lwip_netconn_do_listen(void *m)
             /* in this case, the old pcb is still allocated */
           } else {
             /* delete the recvmbox and allocate the acceptmbox */
-            if (sys_mbox_valid(&msg->conn->recvmbox)) {
+            if (netconn_recvmbox_valid(&msg->conn->recvmbox)) {
               /** @todo: should we drain the recvmbox here? */
-              sys_mbox_free(&msg->conn->recvmbox);
-              sys_mbox_set_invalid(&msg->conn->recvmbox);
+              netconn_recvmbox_free(&msg->conn->recvmbox);
+              netconn_recvmbox_set_invalid(&msg->conn->recvmbox);
             }
             err = ERR_OK;
             if (!sys_mbox_valid(&msg->conn->acceptmbox)) {
@@ -1528,40 +1690,38 @@ lwip_netconn_do_listen(void *m)
  *
  * @param m the api_msg pointing to the connection
  */
-void
-lwip_netconn_do_send(void *m)
+static err_t
+lwip_netconn_send_netbuf(struct netconn *conn, struct netbuf *buf)
 {
-  struct api_msg *msg = (struct api_msg *)m;
-
-  err_t err = netconn_err(msg->conn);
+  err_t err = netconn_err(conn);
   if (err == ERR_OK) {
-    if (msg->conn->pcb.tcp != NULL) {
-      switch (NETCONNTYPE_GROUP(msg->conn->type)) {
+    if (conn->pcb.tcp != NULL) {
+      switch (NETCONNTYPE_GROUP(conn->type)) {
 #if LWIP_RAW
         case NETCONN_RAW:
-          if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = raw_send(msg->conn->pcb.raw, msg->msg.b->p);
+          if (ip_addr_isany(&buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = raw_send(conn->pcb.raw, buf->p);
           } else {
-            err = raw_sendto(msg->conn->pcb.raw, msg->msg.b->p, &msg->msg.b->addr);
+            err = raw_sendto(conn->pcb.raw, buf->p, &buf->addr);
           }
           break;
 #endif
 #if LWIP_UDP
         case NETCONN_UDP:
 #if LWIP_CHECKSUM_ON_COPY
-          if (ip_addr_isany(&msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = udp_send_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-                                  msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
+          if (ip_addr_isany(&buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = udp_send_chksum(conn->pcb.udp, buf->p,
+                                  buf->flags & NETBUF_FLAG_CHKSUM, buf->toport_chksum);
           } else {
-            err = udp_sendto_chksum(msg->conn->pcb.udp, msg->msg.b->p,
-                                    &msg->msg.b->addr, msg->msg.b->port,
-                                    msg->msg.b->flags & NETBUF_FLAG_CHKSUM, msg->msg.b->toport_chksum);
+            err = udp_sendto_chksum(conn->pcb.udp, buf->p,
+                                    &buf->addr, buf->port,
+                                    buf->flags & NETBUF_FLAG_CHKSUM, buf->toport_chksum);
           }
 #else /* LWIP_CHECKSUM_ON_COPY */
-          if (ip_addr_isany_val(msg->msg.b->addr) || IP_IS_ANY_TYPE_VAL(msg->msg.b->addr)) {
-            err = udp_send(msg->conn->pcb.udp, msg->msg.b->p);
+          if (ip_addr_isany_val(buf->addr) || IP_IS_ANY_TYPE_VAL(buf->addr)) {
+            err = udp_send(conn->pcb.udp, buf->p);
           } else {
-            err = udp_sendto(msg->conn->pcb.udp, msg->msg.b->p, &msg->msg.b->addr, msg->msg.b->port);
+            err = udp_sendto(conn->pcb.udp, buf->p, &buf->addr, buf->port);
           }
 #endif /* LWIP_CHECKSUM_ON_COPY */
           break;
@@ -1574,6 +1734,38 @@ lwip_netconn_do_send(void *m)
       err = ERR_CONN;
     }
   }
+  return err;
+}
+
+void
+lwip_netconn_do_send(void *m)
+{
+  struct api_msg *msg = (struct api_msg *)m;
+
+  msg->err = lwip_netconn_send_netbuf(msg->conn, msg->msg.b);
+  TCPIP_APIMSG_ACK(msg);
+}
+
+/**
+ * Send several netbufs on a UDP or raw connection, stopping at the first
+ * one that fails. Called from netconn_send_batch
+ *
+ * @param m the api_msg pointing to the connection
+ */
+void
+lwip_netconn_do_send_batch(void *m)
+{
+  struct api_msg *msg = (struct api_msg *)m;
+  err_t err = ERR_OK;
+  u16_t i;
+
+  for (i = 0; i < msg->msg.bb.num; i++) {
+    err = lwip_netconn_send_netbuf(msg->conn, msg->msg.bb.bufs[i]);
+    if (err != ERR_OK) {
+      break;
+    }
+  }
+  msg->msg.bb.sent = i;
   msg->err = err;
   TCPIP_APIMSG_ACK(msg);
 }
@@ -1604,6 +1796,151 @@ lwip_netconn_do_recv(void *m)
   TCPIP_APIMSG_ACK(msg);
 }
 
+#if LWIP_NETCONN_ASYNC
+/**
+ * Free an asynchronous operation and call its completion callback.
+ * The operation is freed first so the callback can submit the next one.
+ */
+static void
+netconn_async_done(struct netconn_async *op, err_t err, void *data, size_t len)
+{
+  struct netconn *conn = op->msg.conn;
+  netconn_async_fn fn = op->fn;
+  void *arg = op->arg;
+
+  memp_free(MEMP_NETCONN_ASYNC, op);
+  fn(conn, err, data, len, arg);
+}
+
+/**
+ * Report a finished api_msg: wake up the application thread blocked in
+ * netconn_apimsg() or, for asynchronous operations, call the completion
+ * callback.
+ *
+ * @param msg the finished api_msg, msg->err holds its result
+ */
+static void
+lwip_netconn_op_completed(struct api_msg *msg)
+{
+  struct netconn_async *op = msg->async;
+
+  if (op == NULL) {
+    sys_sem_signal(LWIP_API_MSG_SEM(msg));
+    return;
+  }
+  LWIP_ASSERT("op->msg == msg", &op->msg == msg);
+  netconn_async_done(op, msg->err, NULL,
+                     (op->type == NETCONN_ASYNC_WRITE) ? msg->msg.w.offset : 0);
+}
+
+/**
+ * Complete a pending netconn_recv_async() if the recvmbox holds an item.
+ * Does the same accounting as netconn_recv_data() (and netconn_recv_data_tcp()
+ * without NETCONN_NOAUTORCVD).
+ */
+static void
+netconn_recv_async_poll(struct netconn *conn)
+{
+  struct netconn_async *op = conn->recv_async;
+  void *buf;
+  err_t err = ERR_OK;
+  pbuf_len_t len = 0;
+
+  if ((op == NULL) || !NETCONN_RECVMBOX_VALID(conn)) {
+    return;
+  }
+  if (netconn_recvmbox_tryfetch(&conn->recvmbox, &buf) == SYS_ARCH_TIMEOUT) {
+    return;
+  }
+  conn->recv_async = NULL;
+
+#if LWIP_TCP
+  if (NETCONNTYPE_GROUP(conn->type) == NETCONN_TCP) {
+    if (lwip_netconn_is_err_msg(buf, &err)) {
+      /* FIN or connection error: nothing is received after this */
+      buf = NULL;
+      conn->flags |= NETCONN_FLAG_MBOXCLOSED;
+    } else {
+      len = ((struct pbuf *)buf)->tot_len;
+    }
+    if ((conn->pcb.tcp != NULL) && (err != ERR_OK || len != 0)) {
+      /* the FIN took one byte of the window, too */
+      u32_t remaining = (len != 0) ? len : 1;
+      do {
+        u16_t recved = (u16_t)((remaining > 0xffff) ? 0xffff : remaining);
+        tcp_recved(conn->pcb.tcp, recved);
+        remaining -= recved;
+      } while (remaining != 0);
+    }
+  } else
+#endif /* LWIP_TCP */
+  {
+    len = netbuf_len((struct netbuf *)buf);
+  }
+
+#if LWIP_SO_RCVBUF
+  SYS_ARCH_DEC(conn->recv_avail, len);
+#endif /* LWIP_SO_RCVBUF */
+  API_EVENT(conn, NETCONN_EVT_RCVMINUS, (u16_t)LWIP_MIN(len, 0xffff));
+
+  netconn_async_done(op, err, buf, len);
+}
+
+/**
+ * Complete a pending netconn_recv_async() with ERR_CLSD since the recvmbox
+ * is going away.
+ */
+static void
+netconn_recv_async_abort(struct netconn *conn)
+{
+  struct netconn_async *op = conn->recv_async;
+
+  if (op != NULL) {
+    conn->recv_async = NULL;
+    netconn_async_done(op, ERR_CLSD, NULL, 0);
+  }
+}
+
+/**
+ * Start an asynchronous receive: deliver the next queued item right away or
+ * leave the operation pending until the recv callback queues one.
+ * Called from netconn_recv_async
+ *
+ * @param m the api_msg of a struct netconn_async
+ */
+void
+lwip_netconn_do_recv_async(void *m)
+{
+  struct api_msg *msg = (struct api_msg *)m;
+  struct netconn *conn = msg->conn;
+  err_t err;
+
+  LWIP_ASSERT("async recv without async op", NETCONN_MSG_IS_ASYNC(msg));
+  if (conn->recv_async != NULL) {
+    err = ERR_INPROGRESS;
+  } else if (!NETCONN_RECVMBOX_VALID(conn)) {
+    err = netconn_err(conn);
+    if (err == ERR_OK) {
+      err = ERR_CONN;
+    }
+  } else {
+    conn->recv_async = msg->async;
+    netconn_recv_async_poll(conn);
+    if ((conn->recv_async == NULL) || !(conn->flags & NETCONN_FLAG_MBOXCLOSED)) {
+      /* delivered or waiting for data */
+      return;
+    }
+    /* nothing more will arrive */
+    conn->recv_async = NULL;
+    err = netconn_err(conn);
+    if (err == ERR_OK) {
+      err = ERR_CLSD;
+    }
+  }
+  netconn_async_done(msg->async, err, NULL, 0);
+}
+#endif /* LWIP_NETCONN_ASYNC */
+
 #if TCP_LISTEN_BACKLOG
 /** Indicate that a TCP pcb has been accepted
  * Called from netconn_accept
@@ -1657,7 +1994,9 @@ lwip_netconn_do_writemore(struct netconn *conn  WRITE_DELAYED_PARAM)
   LWIP_ASSERT("conn->current_msg->msg.w.vector_cnt > 0", conn->current_msg->msg.w.vector_cnt > 0);
 
   apiflags = conn->current_msg->msg.w.apiflags;
-  dontblock = netconn_is_nonblocking(conn) || (apiflags & NETCONN_DONTBLOCK);
+  /* asynchronous writes complete through their callback: no need to return early */
+  dontblock = (netconn_is_nonblocking(conn) && !NETCONN_MSG_IS_ASYNC(conn->current_msg)) ||
+              (apiflags & NETCONN_DONTBLOCK);
 
 #if LWIP_SO_SNDTIMEO
   if ((conn->send_timeout != 0) &&
@@ -1783,7 +2122,7 @@ err_mem:
   if (write_finished) {
     /* everything was written: set back connection state
        and back to application task */
-    sys_sem_t *op_completed_sem = LWIP_API_MSG_SEM(conn->current_msg);
+    struct api_msg *op_completed = conn->current_msg;
     conn->current_msg->err = err;
     conn->current_msg = NULL;
     conn->state = NETCONN_NONE;
@@ -1791,7 +2130,7 @@ err_mem:
     if (delayed)
 #endif
     {
-      sys_sem_signal(op_completed_sem);
+      lwip_netconn_op_completed(op_completed);
     }
   }
 #if LWIP_TCPIP_CORE_LOCKING
@@ -1829,11 +2168,16 @@ lwip_netconn_do_write(void *m)
         msg->conn->current_msg = msg;
 #if LWIP_TCPIP_CORE_LOCKING
         if (lwip_netconn_do_writemore(msg->conn, 0) != ERR_OK) {
-          LWIP_ASSERT("state!", msg->conn->state == NETCONN_WRITE);
-          UNLOCK_TCPIP_CORE();
-          sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
-          LOCK_TCPIP_CORE();
-          LWIP_ASSERT("state!", msg->conn->state != NETCONN_WRITE);
+          if (!NETCONN_MSG_IS_ASYNC(msg)) {
+            LWIP_ASSERT("state!", msg->conn->state == NETCONN_WRITE);
+            UNLOCK_TCPIP_CORE();
+            sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
+            LOCK_TCPIP_CORE();
+            LWIP_ASSERT("state!", msg->conn->state != NETCONN_WRITE);
+          }
+        } else {
+          /* written at once: not ACKed by lwip_netconn_do_writemore */
+          NETCONN_ASYNC_ACK(msg);
         }
 #else /* LWIP_TCPIP_CORE_LOCKING */
         lwip_netconn_do_writemore(msg->conn);
@@ -1950,14 +2294,14 @@ lwip_netconn_do_close(void *m)
 #if LWIP_NETCONN_FULLDUPLEX
       if (msg->msg.sd.shut & NETCONN_SHUT_WR) {
         /* close requested, abort running write */
-        sys_sem_t *write_completed_sem;
+        struct api_msg *write_completed;
         LWIP_ASSERT("msg->conn->current_msg != NULL", msg->conn->current_msg != NULL);
-        write_completed_sem = LWIP_API_MSG_SEM(msg->conn->current_msg);
+        write_completed = msg->conn->current_msg;
         msg->conn->current_msg->err = ERR_CLSD;
         msg->conn->current_msg = NULL;
         msg->conn->state = NETCONN_NONE;
         state = NETCONN_NONE;
-        sys_sem_signal(write_completed_sem);
+        lwip_netconn_op_completed(write_completed);
       } else {
         LWIP_ASSERT("msg->msg.sd.shut == NETCONN_SHUT_RD", msg->msg.sd.shut == NETCONN_SHUT_RD);
         /* In this case, let the write continue and do not interfere with
@@ -1983,11 +2327,16 @@ lwip_netconn_do_close(void *m)
       msg->conn->current_msg = msg;
 #if LWIP_TCPIP_CORE_LOCKING
       if (lwip_netconn_do_close_internal(msg->conn, 0) != ERR_OK) {
-        LWIP_ASSERT("state!", msg->conn->state == NETCONN_CLOSE);
-        UNLOCK_TCPIP_CORE();
-        sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
-        LOCK_TCPIP_CORE();
-        LWIP_ASSERT("state!", msg->conn->state == NETCONN_NONE);
+        if (!NETCONN_MSG_IS_ASYNC(msg)) {
+          LWIP_ASSERT("state!", msg->conn->state == NETCONN_CLOSE);
+          UNLOCK_TCPIP_CORE();
+          sys_arch_sem_wait(LWIP_API_MSG_SEM(msg), 0);
+          LOCK_TCPIP_CORE();
+          LWIP_ASSERT("state!", msg->conn->state == NETCONN_NONE);
+        }
+      } else {
+        /* closed at once: not ACKed by lwip_netconn_do_close_internal */
+        NETCONN_ASYNC_ACK(msg);
       }
 #else /* LWIP_TCPIP_CORE_LOCKING */
       lwip_netconn_do_close_internal(msg->conn);
@@ -203,7 +203,7 @@ netbuf_data(struct netbuf *buf, void **dataptr, u16_t *len)
     return ERR_BUF;
   }
   *dataptr = buf->ptr->payload;
-  *len = buf->ptr->len;
+  *len = (u16_t)buf->ptr->len;
   return ERR_OK;
 }
 
@@ -259,6 +259,13 @@ static void lwip_socket_drop_registered_mld6_memberships(int s);
 /** The global array of available sockets */
 static struct lwip_sock sockets[NUM_SOCKETS];
 
+#if LWIP_SOCKET_EPOLL
+/** epoll file descriptors follow the sockets' */
+#define LWIP_EPOLL_FD_BASE    (LWIP_SOCKET_OFFSET + NUM_SOCKETS)
+#define LWIP_EPOLL_IS_FD(fd)  (((fd) >= LWIP_EPOLL_FD_BASE) && \
+                               ((fd) < LWIP_EPOLL_FD_BASE + LWIP_SOCKET_EPOLL_INSTANCES))
+#endif /* LWIP_SOCKET_EPOLL */
+
 #if LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL
 #if LWIP_TCPIP_CORE_LOCKING
 /* protect the select_cb_list using core lock */
@@ -291,6 +298,11 @@ static void select_check_waiters(int s, int has_recvevent, int has_sendevent, in
 #else
 #define DEFAULT_SOCKET_EVENTCB NULL
 #endif
+#if LWIP_SOCKET_EPOLL
+static void lwip_epoll_notify(struct lwip_sock *sock, u32_t events);
+static void lwip_epoll_sock_close(struct lwip_sock *sock);
+static int lwip_epoll_close(int epfd);
+#endif /* LWIP_SOCKET_EPOLL */
 #if !LWIP_TCPIP_CORE_LOCKING
 static void lwip_getsockopt_callback(void *arg);
 static void lwip_setsockopt_callback(void *arg);
@@ -530,6 +542,9 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].sendevent  = (NETCONNTYPE_GROUP(newconn->type) == NETCONN_TCP ? (accepted != 0) : 1);
       sockets[i].errevent   = 0;
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
+#if LWIP_SOCKET_EPOLL
+      LWIP_ASSERT("sockets[i].epitems == NULL", sockets[i].epitems == NULL);
+#endif /* LWIP_SOCKET_EPOLL */
       return i + LWIP_SOCKET_OFFSET;
     }
     SYS_ARCH_UNPROTECT(lev);
@@ -777,6 +792,12 @@ lwip_close(int s)
 
   LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_close(%d)\n", s));
 
+#if LWIP_SOCKET_EPOLL
+  if (LWIP_EPOLL_IS_FD(s)) {
+    return lwip_epoll_close(s);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   sock = get_socket(s);
   if (!sock) {
     return -1;
@@ -804,6 +825,11 @@ lwip_close(int s)
     return -1;
   }
 
+#if LWIP_SOCKET_EPOLL
+  /* like on linux, closing a socket removes it from all epoll instances */
+  lwip_epoll_sock_close(sock);
+#endif /* LWIP_SOCKET_EPOLL */
+
   free_socket(sock, is_tcp);
   set_errno(0);
   return 0;
@@ -970,7 +996,7 @@ lwip_recv_tcp(struct lwip_sock *sock, void *mem, size_t len, int flags)
                                 p->tot_len, (int)recv_left, (int)recvd));
 
     if (recv_left > p->tot_len) {
-      copylen = p->tot_len;
+      copylen = (u16_t)p->tot_len;
     } else {
       copylen = (u16_t)recv_left;
     }
@@ -1118,7 +1144,7 @@ lwip_recvfrom_udp_raw(struct lwip_sock *sock, int flags, struct msghdr *msg, u16
     LWIP_ASSERT("buf != NULL", buf != NULL);
     sock->lastdata.netbuf = buf;
   }
-  buflen = buf->p->tot_len;
+  buflen = (u16_t)buf->p->tot_len;
   LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvfrom_udp_raw: buflen=%"U16_F"\n", buflen));
 
   copied = 0;
@@ -1277,25 +1303,19 @@ lwip_recv(int s, void *mem, size_t len, int flags)
   return lwip_recvfrom(s, mem, len, flags, NULL, NULL);
 }
 
-ssize_t
-lwip_recvmsg(int s, struct msghdr *message, int flags)
+/* Helper function for lwip_recvmsg() and lwip_recvmmsg(): receive into one
+ * msghdr from an already referenced socket (no done_socket() here).
+ */
+static ssize_t
+lwip_recvmsg_sock(struct lwip_sock *sock, struct msghdr *message, int flags, int s)
 {
-  struct lwip_sock *sock;
   int i;
   ssize_t buflen;
 
-  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmsg(%d, message=%p, flags=0x%x)\n", s, (void *)message, flags));
-  LWIP_ERROR("lwip_recvmsg: invalid message pointer", message != NULL, return ERR_ARG;);
-  LWIP_ERROR("lwip_recvmsg: unsupported flags", (flags & ~(MSG_PEEK|MSG_DONTWAIT)) == 0,
-             set_errno(EOPNOTSUPP); return -1;);
+  LWIP_UNUSED_ARG(s);
 
   if ((message->msg_iovlen <= 0) || (message->msg_iovlen > IOV_MAX)) {
-    set_errno(EMSGSIZE);
-    return -1;
-  }
-
-  sock = get_socket(s);
-  if (!sock) {
+    sock_set_errno(sock, EMSGSIZE);
     return -1;
   }
 
@@ -1306,7 +1326,6 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
         ((size_t)(ssize_t)message->msg_iov[i].iov_len != message->msg_iov[i].iov_len) ||
         ((ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len) <= 0)) {
       sock_set_errno(sock, err_to_errno(ERR_VAL));
-      done_socket(sock);
       return -1;
     }
     buflen = (ssize_t)(buflen + (ssize_t)message->msg_iov[i].iov_len);
@@ -1342,11 +1361,9 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
       sock_set_errno(sock, 0);
     }
     /* " If the socket is connected, the msg_name and msg_namelen members shall be ignored." */
-    done_socket(sock);
     return buflen;
 #else /* LWIP_TCP */
     sock_set_errno(sock, err_to_errno(ERR_ARG));
-    done_socket(sock);
     return -1;
 #endif /* LWIP_TCP */
   }
@@ -1360,7 +1377,6 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
       LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmsg[UDP/RAW](%d): buf == NULL, error is \"%s\"!\n",
                                   s, lwip_strerr(err)));
       sock_set_errno(sock, err_to_errno(err));
-      done_socket(sock);
       return -1;
     }
     if (datagram_len > buflen) {
@@ -1368,9 +1384,186 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
     }
 
     sock_set_errno(sock, 0);
-    done_socket(sock);
     return (int)datagram_len;
   }
+#else /* LWIP_UDP || LWIP_RAW */
+  sock_set_errno(sock, err_to_errno(ERR_ARG));
+  return -1;
+#endif /* LWIP_UDP || LWIP_RAW */
+}
+
+ssize_t
+lwip_recvmsg(int s, struct msghdr *message, int flags)
+{
+  struct lwip_sock *sock;
+  ssize_t ret;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmsg(%d, message=%p, flags=0x%x)\n", s, (void *)message, flags));
+  LWIP_ERROR("lwip_recvmsg: invalid message pointer", message != NULL, return ERR_ARG;);
+  LWIP_ERROR("lwip_recvmsg: unsupported flags", (flags & ~(MSG_PEEK|MSG_DONTWAIT)) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  ret = lwip_recvmsg_sock(sock, message, flags, s);
+  done_socket(sock);
+  return ret;
+}
+
+/**
+ * Receive up to 'vlen' messages with one socket lookup. With MSG_WAITFORONE,
+ * only the first message may block. If 'timeout' is given, it is checked
+ * after each received message (as on Linux, it does not bound the wait for
+ * the first one).
+ * Returns the number of messages received (each with msg_len set), or -1 if
+ * the first one failed.
+ */
+int
+lwip_recvmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+              struct timeval *timeout)
+{
+  struct lwip_sock *sock;
+  unsigned int i;
+  u32_t start = 0;
+  u32_t timeout_ms = 0;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvmmsg(%d, msgvec=%p, vlen=%u, flags=0x%x)\n", s, (void *)msgvec, vlen, flags));
+  LWIP_ERROR("lwip_recvmmsg: unsupported flags", (flags & ~(MSG_PEEK|MSG_DONTWAIT|MSG_WAITFORONE)) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  LWIP_ERROR("lwip_recvmmsg: invalid msgvec", (msgvec != NULL) || (vlen == 0),
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+
+  if (timeout != NULL) {
+    LWIP_ERROR("lwip_recvmmsg: invalid timeout", (timeout->tv_sec >= 0) && (timeout->tv_usec >= 0),
+               sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+    start = sys_now();
+    timeout_ms = (u32_t)((timeout->tv_sec * 1000) + ((timeout->tv_usec + 999) / 1000));
+  }
+
+  for (i = 0; i < vlen; i++) {
+    ssize_t ret = lwip_recvmsg_sock(sock, &msgvec[i].msg_hdr, flags & ~MSG_WAITFORONE, s);
+    if (ret < 0) {
+      break;
+    }
+    msgvec[i].msg_len = (unsigned int)ret;
+    if (flags & MSG_WAITFORONE) {
+      /* got one, don't block for the rest */
+      flags |= MSG_DONTWAIT;
+    }
+    if ((timeout != NULL) && ((u32_t)(sys_now() - start) >= timeout_ms)) {
+      i++;
+      break;
+    }
+  }
+  if (i > 0) {
+    /* the error of the message that ended the batch is reported by the next call */
+    sock_set_errno(sock, 0);
+  }
+  done_socket(sock);
+  return ((i > 0) || (vlen == 0)) ? (int)i : -1;
+}
+
+#if LWIP_SOCKET_PBUF_LOAN
+/**
+ * @ingroup socket
+ * Zero-copy receive: instead of copying into a buffer, lend the received
+ * pbuf chain to the caller, who may parse it in place and must pass it to
+ * lwip_recv_pbuf_free() when done (unchanged, i.e. with the same tot_len).
+ * TCP: returns all data of the next received segment(s) still buffered
+ * (any part left over by a previous recv() included); the receive window is
+ * opened again by lwip_recv_pbuf_free().
+ * UDP/RAW: returns one datagram.
+ *
+ * @param s socket to receive from
+ * @param p receives the pbuf chain (NULL if nothing is returned)
+ * @param flags MSG_DONTWAIT or 0 (MSG_PEEK is not supported)
+ * @param from optional sender address, as for lwip_recvfrom()
+ * @param fromlen optional length of 'from', as for lwip_recvfrom()
+ * @return number of bytes in 'p', 0 on TCP end of stream, -1 on error
+ */
+ssize_t
+lwip_recvfrom_pbuf(int s, struct pbuf **p, int flags,
+                   struct sockaddr *from, socklen_t *fromlen)
+{
+  struct lwip_sock *sock;
+  u8_t apiflags;
+  err_t err;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvfrom_pbuf(%d, p=%p, flags=0x%x)\n", s, (void *)p, flags));
+  LWIP_ERROR("lwip_recvfrom_pbuf: invalid pbuf pointer", p != NULL, set_errno(EINVAL); return -1;);
+  *p = NULL;
+  LWIP_ERROR("lwip_recvfrom_pbuf: unsupported flags", (flags & ~MSG_DONTWAIT) == 0,
+             set_errno(EOPNOTSUPP); return -1;);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+  apiflags = (flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0;
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+#if LWIP_TCP
+    struct pbuf *q = sock->lastdata.pbuf;
+    if (q != NULL) {
+      /* lend what is left over from the last recv operation */
+      sock->lastdata.pbuf = NULL;
+    } else {
+      /* window is updated when the pbuf is returned */
+      err = netconn_recv_tcp_pbuf_flags(sock->conn, &q, (u8_t)(apiflags | NETCONN_NOAUTORCVD));
+      if (err != ERR_OK) {
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvfrom_pbuf(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+        sock_set_errno(sock, err_to_errno(err));
+        done_socket(sock);
+        return (err == ERR_CLSD) ? 0 : -1;
+      }
+      LWIP_ASSERT("q != NULL", q != NULL);
+    }
+    *p = q;
+    lwip_recv_tcp_from(sock, from, fromlen, "lwip_recvfrom_pbuf", s, q->tot_len);
+    sock_set_errno(sock, 0);
+    done_socket(sock);
+    return q->tot_len;
+#else /* LWIP_TCP */
+    sock_set_errno(sock, err_to_errno(ERR_ARG));
+    done_socket(sock);
+    return -1;
+#endif /* LWIP_TCP */
+  }
+  /* else, UDP and RAW NETCONNs */
+#if LWIP_UDP || LWIP_RAW
+  {
+    struct netbuf *buf = sock->lastdata.netbuf;
+    if (buf != NULL) {
+      /* datagram left over from a MSG_PEEK */
+      sock->lastdata.netbuf = NULL;
+    } else {
+      err = netconn_recv_udp_raw_netbuf_flags(sock->conn, &buf, apiflags);
+      if (err != ERR_OK) {
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recvfrom_pbuf(%d): error is \"%s\"!\n", s, lwip_strerr(err)));
+        sock_set_errno(sock, err_to_errno(err));
+        done_socket(sock);
+        return -1;
+      }
+      LWIP_ASSERT("buf != NULL", buf != NULL);
+    }
+    if (from && fromlen) {
+      lwip_sock_make_addr(sock->conn, netbuf_fromaddr(buf), netbuf_fromport(buf), from, fromlen);
+    }
+    /* keep the pbuf, free only the netbuf around it */
+    *p = buf->p;
+    buf->p = buf->ptr = NULL;
+    netbuf_delete(buf);
+    sock_set_errno(sock, 0);
+    done_socket(sock);
+    return (*p)->tot_len;
+  }
 #else /* LWIP_UDP || LWIP_RAW */
   sock_set_errno(sock, err_to_errno(ERR_ARG));
   done_socket(sock);
@@ -1378,6 +1571,45 @@ lwip_recvmsg(int s, struct msghdr *message, int flags)
 #endif /* LWIP_UDP || LWIP_RAW */
 }
 
+/**
+ * @ingroup socket
+ * Give back a pbuf chain received by lwip_recvfrom_pbuf(). For TCP, this
+ * opens the receive window by the pbuf's length.
+ * The pbuf is freed even if the socket has been closed in the meantime.
+ *
+ * @param s socket the pbuf was received from
+ * @param p pbuf chain returned by lwip_recvfrom_pbuf()
+ * @return 0 on success, -1 on error
+ */
+int
+lwip_recv_pbuf_free(int s, struct pbuf *p)
+{
+  struct lwip_sock *sock;
+  pbuf_len_t len;
+
+  LWIP_ERROR("lwip_recv_pbuf_free: invalid pbuf", p != NULL, set_errno(EINVAL); return -1;);
+  len = p->tot_len;
+  pbuf_free(p);
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+#if LWIP_TCP
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    /* like lwip_recv_tcp(): lwip_netconn_do_recv() opens the window in
+       u16_t sized steps */
+    netconn_tcp_recvd(sock->conn, (size_t)len);
+  }
+#else
+  LWIP_UNUSED_ARG(len);
+#endif /* LWIP_TCP */
+  sock_set_errno(sock, 0);
+  done_socket(sock);
+  return 0;
+}
+#endif /* LWIP_SOCKET_PBUF_LOAN */
+
 ssize_t
 lwip_send(int s, const void *data, size_t size, int flags)
 {
@@ -1418,6 +1650,103 @@ lwip_send(int s, const void *data, size_t size, int flags)
   return (err == ERR_OK ? (ssize_t)written : -1);
 }
 
+#if LWIP_UDP || LWIP_RAW
+/* Helper function for lwip_sendmsg() and lwip_sendmmsg(): build the netbuf
+ * (payload and destination) for one datagram from a msghdr.
+ * Returns 0 or an errno value; 'chain_buf' must be netbuf_free()d either way.
+ */
+static int
+lwip_sendmsg_netbuf(const struct msghdr *msg, struct netbuf *chain_buf, ssize_t *size)
+{
+  int i;
+
+  /* initialize chain buffer with destination */
+  memset(chain_buf, 0, sizeof(struct netbuf));
+  *size = 0;
+
+  LWIP_ERROR("lwip_sendmsg: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
+             IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)),
+             return err_to_errno(ERR_ARG););
+
+  if (msg->msg_name) {
+    u16_t remote_port;
+    SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &chain_buf->addr, remote_port);
+    netbuf_fromport(chain_buf) = remote_port;
+  }
+#if LWIP_NETIF_TX_SINGLE_PBUF
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    *size += msg->msg_iov[i].iov_len;
+    if ((msg->msg_iov[i].iov_len > INT_MAX) || (*size < (int)msg->msg_iov[i].iov_len)) {
+      /* overflow */
+      return EMSGSIZE;
+    }
+  }
+  if (*size > 0xFFFF) {
+    /* overflow */
+    return EMSGSIZE;
+  }
+  /* Allocate a new netbuf and copy the data into it. */
+  if (netbuf_alloc(chain_buf, (u16_t)*size) == NULL) {
+    return err_to_errno(ERR_MEM);
+  } else {
+    /* flatten the IO vectors */
+    size_t offset = 0;
+    for (i = 0; i < msg->msg_iovlen; i++) {
+      MEMCPY(&((u8_t *)chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+      offset += msg->msg_iov[i].iov_len;
+    }
+#if LWIP_CHECKSUM_ON_COPY
+    {
+      /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
+      u16_t chksum = ~inet_chksum_pbuf(chain_buf->p);
+      netbuf_set_chksum(chain_buf, chksum);
+    }
+#endif /* LWIP_CHECKSUM_ON_COPY */
+  }
+#else /* LWIP_NETIF_TX_SINGLE_PBUF */
+  /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
+     manually to avoid having to allocate, chain, and delete a netbuf for each iov */
+  for (i = 0; i < msg->msg_iovlen; i++) {
+    struct pbuf *p;
+    if (msg->msg_iov[i].iov_len > 0xFFFF) {
+      /* overflow */
+      return EMSGSIZE;
+    }
+    p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
+    if (p == NULL) {
+      /* let netbuf_free() cleanup chain_buf */
+      return err_to_errno(ERR_MEM);
+    }
+    p->payload = msg->msg_iov[i].iov_base;
+    p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
+    /* netbuf empty, add new pbuf */
+    if (chain_buf->p == NULL) {
+      chain_buf->p = chain_buf->ptr = p;
+      /* add pbuf to existing pbuf chain */
+    } else {
+      if (chain_buf->p->tot_len + p->len > 0xffff) {
+        /* overflow */
+        pbuf_free(p);
+        return EMSGSIZE;
+      }
+      pbuf_cat(chain_buf->p, p);
+    }
+  }
+  /* save size of total chain */
+  *size = netbuf_len(chain_buf);
+#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+
+#if LWIP_IPV4 && LWIP_IPV6
+  /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
+  if (IP_IS_V6_VAL(chain_buf->addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&chain_buf->addr))) {
+    unmap_ipv4_mapped_ipv6(ip_2_ip4(&chain_buf->addr), ip_2_ip6(&chain_buf->addr));
+    IP_SET_TYPE_VAL(chain_buf->addr, IPADDR_TYPE_V4);
+  }
+#endif /* LWIP_IPV4 && LWIP_IPV6 */
+  return 0;
+}
+#endif /* LWIP_UDP || LWIP_RAW */
+
 ssize_t
 lwip_sendmsg(int s, const struct msghdr *msg, int flags)
 {
@@ -1468,113 +1797,117 @@ lwip_sendmsg(int s, const struct msghdr *msg, int flags)
 #if LWIP_UDP || LWIP_RAW
   {
     struct netbuf chain_buf;
-    int i;
     ssize_t size = 0;
+    int errval;
 
     LWIP_UNUSED_ARG(flags);
-    LWIP_ERROR("lwip_sendmsg: invalid msghdr name", (((msg->msg_name == NULL) && (msg->msg_namelen == 0)) ||
-               IS_SOCK_ADDR_LEN_VALID(msg->msg_namelen)),
-               sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
-
-    /* initialize chain buffer with destination */
-    memset(&chain_buf, 0, sizeof(struct netbuf));
-    if (msg->msg_name) {
-      u16_t remote_port;
-      SOCKADDR_TO_IPADDR_PORT((const struct sockaddr *)msg->msg_name, &chain_buf.addr, remote_port);
-      netbuf_fromport(&chain_buf) = remote_port;
-    }
-#if LWIP_NETIF_TX_SINGLE_PBUF
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      size += msg->msg_iov[i].iov_len;
-      if ((msg->msg_iov[i].iov_len > INT_MAX) || (size < (int)msg->msg_iov[i].iov_len)) {
-        /* overflow */
-        goto sendmsg_emsgsize;
-      }
-    }
-    if (size > 0xFFFF) {
-      /* overflow */
-      goto sendmsg_emsgsize;
+    errval = lwip_sendmsg_netbuf(msg, &chain_buf, &size);
+    if (errval == 0) {
+      /* send the data */
+      err = netconn_send(sock->conn, &chain_buf);
+      errval = err_to_errno(err);
     }
-    /* Allocate a new netbuf and copy the data into it. */
-    if (netbuf_alloc(&chain_buf, (u16_t)size) == NULL) {
-      err = ERR_MEM;
-    } else {
-      /* flatten the IO vectors */
-      size_t offset = 0;
-      for (i = 0; i < msg->msg_iovlen; i++) {
-        MEMCPY(&((u8_t *)chain_buf.p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
-        offset += msg->msg_iov[i].iov_len;
-      }
-#if LWIP_CHECKSUM_ON_COPY
-      {
-        /* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
-        u16_t chksum = ~inet_chksum_pbuf(chain_buf.p);
-        netbuf_set_chksum(&chain_buf, chksum);
+
+    /* deallocated the buffer */
+    netbuf_free(&chain_buf);
+
+    sock_set_errno(sock, errval);
+    done_socket(sock);
+    return (errval == 0 ? size : -1);
+  }
+#else /* LWIP_UDP || LWIP_RAW */
+  sock_set_errno(sock, err_to_errno(ERR_ARG));
+  done_socket(sock);
+  return -1;
+#endif /* LWIP_UDP || LWIP_RAW */
+}
+
+/**
+ * Send up to 'vlen' messages. For UDP and RAW sockets, the datagrams are
+ * passed to tcpip_thread in batches of LWIP_SOCKET_MMSG_BATCH, each batch
+ * with one core lock or message; TCP sockets send one message after the other.
+ * Returns the number of messages sent (each with msg_len set), or -1 if the
+ * first one failed.
+ */
+int
+lwip_sendmmsg(int s, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  struct lwip_sock *sock;
+  unsigned int done = 0;
+  int errval = 0;
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_sendmmsg(%d, msgvec=%p, vlen=%u, flags=0x%x)\n", s, (void *)msgvec, vlen, flags));
+
+  sock = get_socket(s);
+  if (!sock) {
+    return -1;
+  }
+
+  LWIP_ERROR("lwip_sendmmsg: invalid msgvec", (msgvec != NULL) || (vlen == 0),
+             sock_set_errno(sock, err_to_errno(ERR_ARG)); done_socket(sock); return -1;);
+  LWIP_ERROR("lwip_sendmmsg: unsupported flags", (flags & ~(MSG_DONTWAIT | MSG_MORE)) == 0,
+             sock_set_errno(sock, EOPNOTSUPP); done_socket(sock); return -1;);
+
+  if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+    done_socket(sock);
+    for (done = 0; done < vlen; done++) {
+      ssize_t ret = lwip_sendmsg(s, &msgvec[done].msg_hdr, flags);
+      if (ret < 0) {
+        break;
       }
-#endif /* LWIP_CHECKSUM_ON_COPY */
-      err = ERR_OK;
+      msgvec[done].msg_len = (unsigned int)ret;
     }
-#else /* LWIP_NETIF_TX_SINGLE_PBUF */
-    /* create a chained netbuf from the IO vectors. NOTE: we assemble a pbuf chain
-       manually to avoid having to allocate, chain, and delete a netbuf for each iov */
-    for (i = 0; i < msg->msg_iovlen; i++) {
-      struct pbuf *p;
-      if (msg->msg_iov[i].iov_len > 0xFFFF) {
-        /* overflow */
-        goto sendmsg_emsgsize;
+    return ((done > 0) || (vlen == 0)) ? (int)done : -1;
+  }
+  /* else, UDP and RAW NETCONNs */
+#if LWIP_UDP || LWIP_RAW
+  while ((done < vlen) && (errval == 0)) {
+    struct netbuf bufs[LWIP_SOCKET_MMSG_BATCH];
+    struct netbuf *bufp[LWIP_SOCKET_MMSG_BATCH];
+    ssize_t sizes[LWIP_SOCKET_MMSG_BATCH];
+    u16_t num, sent, i;
+
+    /* build a batch of netbufs, up to the first message that is invalid */
+    for (num = 0; (num < LWIP_SOCKET_MMSG_BATCH) && (done + num < vlen); num++) {
+      const struct msghdr *msg = &msgvec[done + num].msg_hdr;
+      if (msg->msg_iov == NULL) {
+        errval = err_to_errno(ERR_ARG);
+        break;
       }
-      p = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_REF);
-      if (p == NULL) {
-        err = ERR_MEM; /* let netbuf_delete() cleanup chain_buf */
+      if ((msg->msg_iovlen <= 0) || (msg->msg_iovlen > IOV_MAX)) {
+        errval = EMSGSIZE;
         break;
       }
-      p->payload = msg->msg_iov[i].iov_base;
-      p->len = p->tot_len = (u16_t)msg->msg_iov[i].iov_len;
-      /* netbuf empty, add new pbuf */
-      if (chain_buf.p == NULL) {
-        chain_buf.p = chain_buf.ptr = p;
-        /* add pbuf to existing pbuf chain */
-      } else {
-        if (chain_buf.p->tot_len + p->len > 0xffff) {
-          /* overflow */
-          pbuf_free(p);
-          goto sendmsg_emsgsize;
-        }
-        pbuf_cat(chain_buf.p, p);
+      errval = lwip_sendmsg_netbuf(msg, &bufs[num], &sizes[num]);
+      if (errval != 0) {
+        netbuf_free(&bufs[num]);
+        break;
       }
+      bufp[num] = &bufs[num];
     }
-    /* save size of total chain */
-    if (err == ERR_OK) {
-      size = netbuf_len(&chain_buf);
-    }
-#endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
-    if (err == ERR_OK) {
-#if LWIP_IPV4 && LWIP_IPV6
-      /* Dual-stack: Unmap IPv4 mapped IPv6 addresses */
-      if (IP_IS_V6_VAL(chain_buf.addr) && ip6_addr_isipv4mappedipv6(ip_2_ip6(&chain_buf.addr))) {
-        unmap_ipv4_mapped_ipv6(ip_2_ip4(&chain_buf.addr), ip_2_ip6(&chain_buf.addr));
-        IP_SET_TYPE_VAL(chain_buf.addr, IPADDR_TYPE_V4);
+    sent = 0;
+    if (num > 0) {
+      err_t err = netconn_send_batch(sock->conn, bufp, num, &sent);
+      if (err != ERR_OK) {
+        errval = err_to_errno(err);
       }
-#endif /* LWIP_IPV4 && LWIP_IPV6 */
-
-      /* send the data */
-      err = netconn_send(sock->conn, &chain_buf);
     }
-
-    /* deallocated the buffer */
-    netbuf_free(&chain_buf);
-
-    sock_set_errno(sock, err_to_errno(err));
-    done_socket(sock);
-    return (err == ERR_OK ? size : -1);
-sendmsg_emsgsize:
-    sock_set_errno(sock, EMSGSIZE);
-    netbuf_free(&chain_buf);
-    done_socket(sock);
-    return -1;
+    for (i = 0; i < num; i++) {
+      if (i < sent) {
+        msgvec[done + i].msg_len = (unsigned int)sizes[i];
+      }
+      netbuf_free(&bufs[i]);
+    }
+    done += sent;
   }
+
+  /* the error of the message that ended the batch is reported by the next call */
+  sock_set_errno(sock, (done > 0) ? 0 : errval);
+  done_socket(sock);
+  return ((done > 0) || (vlen == 0)) ? (int)done : -1;
 #else /* LWIP_UDP || LWIP_RAW */
+  LWIP_UNUSED_ARG(errval);
   sock_set_errno(sock, err_to_errno(ERR_ARG));
   done_socket(sock);
   return -1;
@@ -2478,6 +2811,9 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
 {
   int s, check_waiters;
   struct lwip_sock *sock;
+#if LWIP_SOCKET_EPOLL
+  u32_t epoll_events = 0;
+#endif /* LWIP_SOCKET_EPOLL */
   SYS_ARCH_DECL_PROTECT(lev);
 
   LWIP_UNUSED_ARG(len);
@@ -2522,6 +2858,9 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       if (sock->rcvevent > 1) {
         check_waiters = 0;
       }
+#if LWIP_SOCKET_EPOLL
+      epoll_events = EPOLLIN;
+#endif /* LWIP_SOCKET_EPOLL */
       break;
     case NETCONN_EVT_RCVMINUS:
       sock->rcvevent--;
@@ -2532,6 +2871,9 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
         check_waiters = 0;
       }
       sock->sendevent = 1;
+#if LWIP_SOCKET_EPOLL
+      epoll_events = EPOLLOUT;
+#endif /* LWIP_SOCKET_EPOLL */
       break;
     case NETCONN_EVT_SENDMINUS:
       sock->sendevent = 0;
@@ -2539,6 +2881,9 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
     case NETCONN_EVT_ERROR:
       sock->errevent = 1;
+#if LWIP_SOCKET_EPOLL
+      epoll_events = EPOLLERR;
+#endif /* LWIP_SOCKET_EPOLL */
       break;
     default:
       LWIP_ASSERT("unknown event", 0);
@@ -2557,6 +2902,13 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
   } else {
     SYS_ARCH_UNPROTECT(lev);
   }
+#if LWIP_SOCKET_EPOLL
+  /* unlike select waiters, epoll is notified of every new event (not only
+     of the first one) so that edge triggered registrations see new data */
+  if ((epoll_events != 0) && (sock->epitems != NULL)) {
+    lwip_epoll_notify(sock, epoll_events);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
   done_socket(sock);
 }
 
@@ -2648,6 +3000,440 @@ again:
 }
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
 
+#if LWIP_SOCKET_EPOLL
+/*
+ * epoll: each (instance, socket) registration is a struct lwip_epitem, linked
+ * into the socket's list. event_callback() appends the registrations
+ * interested in a new event to their instance's ready list and wakes up the
+ * waiters; lwip_epoll_wait() only looks at that list and re-checks the
+ * socket's current state for each entry. Level triggered entries stay on the
+ * list as long as they report something, edge triggered ones are removed
+ * once reported and come back with the next event.
+ *
+ * Synchronization is the same as for select_cb_list: the core lock with
+ * LWIP_TCPIP_CORE_LOCKING (held by event_callback() for the events that
+ * matter here), SYS_ARCH_PROTECT otherwise.
+ */
+
+/** epoll instances, their file descriptors follow the sockets' */
+static struct lwip_epoll epolls[LWIP_SOCKET_EPOLL_INSTANCES];
+
+/** Events that can be reported for a registration (0 if disabled) */
+#define LWIP_EPOLL_INTEREST(epi) ((epi)->disabled ? 0 : \
+  (((epi)->events & (EPOLLIN | EPOLLOUT)) | EPOLLERR | EPOLLHUP))
+
+/** Map an epoll file descriptor to its instance */
+static struct lwip_epoll *
+get_epoll(int epfd)
+{
+  struct lwip_epoll *ep;
+
+  if (!LWIP_EPOLL_IS_FD(epfd)) {
+    set_errno(EBADF);
+    return NULL;
+  }
+  ep = &epolls[epfd - LWIP_EPOLL_FD_BASE];
+  if (!ep->used) {
+    set_errno(EBADF);
+    return NULL;
+  }
+  return ep;
+}
+
+/** Current events of a socket (level) */
+static u32_t
+lwip_epoll_sock_events(struct lwip_sock *sock)
+{
+  u32_t events = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  if ((sock->lastdata.pbuf != NULL) || (sock->rcvevent > 0)) {
+    events |= EPOLLIN;
+  }
+  if (sock->sendevent != 0) {
+    events |= EPOLLOUT;
+  }
+  if (sock->errevent != 0) {
+    events |= EPOLLERR;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  return events;
+}
+
+/** Append a registration to the ready list of its instance (if not on it) */
+static void
+lwip_epoll_ready_add(struct lwip_epitem *epi)
+{
+  struct lwip_epoll *ep = epi->ep;
+
+  if (!epi->ready) {
+    epi->ready = 1;
+    epi->rdy_next = NULL;
+    epi->rdy_prev = ep->rdy_tail;
+    if (ep->rdy_tail != NULL) {
+      ep->rdy_tail->rdy_next = epi;
+    } else {
+      ep->rdy_head = epi;
+    }
+    ep->rdy_tail = epi;
+  }
+}
+
+/** Take a registration off the ready list of its instance (if on it) */
+static void
+lwip_epoll_ready_remove(struct lwip_epitem *epi)
+{
+  struct lwip_epoll *ep = epi->ep;
+
+  if (epi->ready) {
+    if (epi->rdy_prev != NULL) {
+      epi->rdy_prev->rdy_next = epi->rdy_next;
+    } else {
+      ep->rdy_head = epi->rdy_next;
+    }
+    if (epi->rdy_next != NULL) {
+      epi->rdy_next->rdy_prev = epi->rdy_prev;
+    } else {
+      ep->rdy_tail = epi->rdy_prev;
+    }
+    epi->ready = 0;
+  }
+}
+
+/** Wake up one thread waiting on an instance */
+static void
+lwip_epoll_wake(struct lwip_epoll *ep)
+{
+  if ((ep->waiting > 0) && !ep->sem_signalled) {
+    ep->sem_signalled = 1;
+    sys_sem_signal(&ep->sem);
+  }
+}
+
+/**
+ * Called by event_callback() for a socket with epoll registrations:
+ * queue the registrations interested in 'events' and wake up waiters.
+ */
+static void
+lwip_epoll_notify(struct lwip_sock *sock, u32_t events)
+{
+  struct lwip_epitem *epi;
+#if !LWIP_TCPIP_CORE_LOCKING
+  SYS_ARCH_DECL_PROTECT(lev);
+#endif /* !LWIP_TCPIP_CORE_LOCKING */
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+#if !LWIP_TCPIP_CORE_LOCKING
+  SYS_ARCH_PROTECT(lev);
+#endif /* !LWIP_TCPIP_CORE_LOCKING */
+  for (epi = sock->epitems; epi != NULL; epi = epi->sock_next) {
+    if ((LWIP_EPOLL_INTEREST(epi) & events) != 0) {
+      lwip_epoll_ready_add(epi);
+      lwip_epoll_wake(epi->ep);
+    }
+  }
+#if !LWIP_TCPIP_CORE_LOCKING
+  SYS_ARCH_UNPROTECT(lev);
+#endif /* !LWIP_TCPIP_CORE_LOCKING */
+}
+
+/** Remove a closed socket from all epoll instances */
+static void
+lwip_epoll_sock_close(struct lwip_sock *sock)
+{
+  struct lwip_epitem *epi;
+  LWIP_SOCKET_SELECT_DECL_PROTECT(lev);
+
+  LWIP_SOCKET_SELECT_PROTECT(lev);
+  while (sock->epitems != NULL) {
+    epi = sock->epitems;
+    sock->epitems = epi->sock_next;
+    lwip_epoll_ready_remove(epi);
+    memp_free(MEMP_EPOLL_ITEM, epi);
+  }
+  LWIP_SOCKET_SELECT_UNPROTECT(lev);
+}
+
+/**
+ * Report up to 'maxevents' events from the ready list of an instance.
+ * Only the entries that were on the list on entry are looked at, so level
+ * triggered entries re-appended here are not reported twice.
+ */
+static int
+lwip_epoll_harvest(struct lwip_epoll *ep, struct epoll_event *events, int maxevents)
+{
+  struct lwip_epitem *epi, *last = ep->rdy_tail;
+  int n = 0;
+  u32_t revents;
+
+  while ((n < maxevents) && ((epi = ep->rdy_head) != NULL)) {
+    revents = lwip_epoll_sock_events(epi->sock) & LWIP_EPOLL_INTEREST(epi);
+    lwip_epoll_ready_remove(epi);
+    if (revents != 0) {
+      events[n].events = revents;
+      events[n].data = epi->data;
+      n++;
+      if ((epi->events & EPOLLONESHOT) != 0) {
+        epi->disabled = 1;
+      } else if ((epi->events & EPOLLET) == 0) {
+        /* level triggered: stays ready until its events are gone */
+        lwip_epoll_ready_add(epi);
+      }
+    }
+    if (epi == last) {
+      break;
+    }
+  }
+  return n;
+}
+
+/**
+ * @ingroup socket
+ * Create an epoll instance (see @ref LWIP_SOCKET_EPOLL).
+ * @param size ignored, must be > 0 (as on linux)
+ * @return the instance's file descriptor, -1 on error (errno set).
+ *         Close it with lwip_close().
+ */
+int
+lwip_epoll_create(int size)
+{
+  int i;
+  LWIP_SOCKET_SELECT_DECL_PROTECT(lev);
+
+  LWIP_ERROR("lwip_epoll_create: invalid size", size > 0, set_errno(EINVAL); return -1;);
+
+  LWIP_SOCKET_SELECT_PROTECT(lev);
+  for (i = 0; i < LWIP_SOCKET_EPOLL_INSTANCES; i++) {
+    if (!epolls[i].used) {
+      epolls[i].used = 1;
+      break;
+    }
+  }
+  LWIP_SOCKET_SELECT_UNPROTECT(lev);
+  if (i == LWIP_SOCKET_EPOLL_INSTANCES) {
+    set_errno(EMFILE);
+    return -1;
+  }
+
+  epolls[i].rdy_head = epolls[i].rdy_tail = NULL;
+  epolls[i].waiting = 0;
+  epolls[i].sem_signalled = 0;
+  if (sys_sem_new(&epolls[i].sem, 0) != ERR_OK) {
+    epolls[i].used = 0;
+    set_errno(ENOMEM);
+    return -1;
+  }
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_create() -> %d\n", LWIP_EPOLL_FD_BASE + i));
+  return LWIP_EPOLL_FD_BASE + i;
+}
+
+/** lwip_close() for an epoll file descriptor */
+static int
+lwip_epoll_close(int epfd)
+{
+  struct lwip_epoll *ep;
+  struct lwip_epitem **pepi, *epi;
+  int i;
+  LWIP_SOCKET_SELECT_DECL_PROTECT(lev);
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+
+  LWIP_SOCKET_SELECT_PROTECT(lev);
+  if (ep->waiting > 0) {
+    LWIP_SOCKET_SELECT_UNPROTECT(lev);
+    set_errno(EBUSY);
+    return -1;
+  }
+  /* closing is rare: walk the sockets instead of keeping a per-instance list */
+  for (i = 0; i < NUM_SOCKETS; i++) {
+    pepi = &sockets[i].epitems;
+    while (*pepi != NULL) {
+      epi = *pepi;
+      if (epi->ep == ep) {
+        *pepi = epi->sock_next;
+        memp_free(MEMP_EPOLL_ITEM, epi);
+      } else {
+        pepi = &epi->sock_next;
+      }
+    }
+  }
+  ep->rdy_head = ep->rdy_tail = NULL;
+  LWIP_SOCKET_SELECT_UNPROTECT(lev);
+
+  /* nothing can signal it any more */
+  sys_sem_free(&ep->sem);
+  ep->used = 0;
+  return 0;
+}
+
+/**
+ * @ingroup socket
+ * Add, change or remove the registration of a socket with an epoll instance.
+ * @param epfd the epoll instance
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD or EPOLL_CTL_DEL
+ * @param fd the socket
+ * @param event events to report (EPOLLIN, EPOLLOUT, optionally with
+ *        EPOLLET or EPOLLONESHOT; EPOLLERR is always reported) and the
+ *        data to return with them; unused for EPOLL_CTL_DEL
+ * @return 0 on success, -1 on error (errno set)
+ */
+int
+lwip_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+  struct lwip_epoll *ep;
+  struct lwip_sock *sock;
+  struct lwip_epitem **pepi, *epi, *newepi = NULL, *freeepi = NULL;
+  int err = 0;
+  LWIP_SOCKET_SELECT_DECL_PROTECT(lev);
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_ctl(%d, %d, %d)\n", epfd, op, fd));
+  LWIP_ERROR("lwip_epoll_ctl: invalid op", (op == EPOLL_CTL_ADD) || (op == EPOLL_CTL_MOD) ||
+             (op == EPOLL_CTL_DEL), set_errno(EINVAL); return -1;);
+  LWIP_ERROR("lwip_epoll_ctl: invalid event", (op == EPOLL_CTL_DEL) || (event != NULL),
+             set_errno(EFAULT); return -1;);
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  sock = get_socket(fd);
+  if (sock == NULL) {
+    return -1;
+  }
+  if (op == EPOLL_CTL_ADD) {
+    newepi = (struct lwip_epitem *)memp_malloc(MEMP_EPOLL_ITEM);
+    if (newepi == NULL) {
+      done_socket(sock);
+      set_errno(ENOMEM);
+      return -1;
+    }
+  }
+
+  LWIP_SOCKET_SELECT_PROTECT(lev);
+  for (pepi = &sock->epitems; *pepi != NULL; pepi = &(*pepi)->sock_next) {
+    if ((*pepi)->ep == ep) {
+      break;
+    }
+  }
+  epi = *pepi;
+  if (op == EPOLL_CTL_ADD) {
+    if (epi != NULL) {
+      err = EEXIST;
+      freeepi = newepi;
+    } else {
+      epi = newepi;
+      memset(epi, 0, sizeof(struct lwip_epitem));
+      epi->ep = ep;
+      epi->sock = sock;
+      epi->sock_next = sock->epitems;
+      sock->epitems = epi;
+    }
+  } else if (epi == NULL) {
+    err = ENOENT;
+  } else if (op == EPOLL_CTL_DEL) {
+    *pepi = epi->sock_next;
+    lwip_epoll_ready_remove(epi);
+    freeepi = epi;
+  }
+  if ((err == 0) && (op != EPOLL_CTL_DEL)) {
+    epi->events = event->events;
+    epi->data = event->data;
+    epi->disabled = 0;
+    /* report what is pending already, for edge triggered entries, too */
+    if ((lwip_epoll_sock_events(sock) & LWIP_EPOLL_INTEREST(epi)) != 0) {
+      lwip_epoll_ready_add(epi);
+      lwip_epoll_wake(ep);
+    }
+  }
+  LWIP_SOCKET_SELECT_UNPROTECT(lev);
+
+  if (freeepi != NULL) {
+    memp_free(MEMP_EPOLL_ITEM, freeepi);
+  }
+  done_socket(sock);
+  if (err != 0) {
+    set_errno(err);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @ingroup socket
+ * Wait for events on the sockets registered with an epoll instance.
+ * @param epfd the epoll instance
+ * @param events where to store the events
+ * @param maxevents size of 'events' (> 0)
+ * @param timeout in milliseconds, -1 to wait forever, 0 to not wait
+ * @return number of events stored, 0 on timeout, -1 on error (errno set)
+ */
+int
+lwip_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+  struct lwip_epoll *ep;
+  u32_t start = 0, elapsed, msectimeout, waitres;
+  int n;
+  LWIP_SOCKET_SELECT_DECL_PROTECT(lev);
+
+  LWIP_ERROR("lwip_epoll_wait: invalid events", (events != NULL) && (maxevents > 0),
+             set_errno(EINVAL); return -1;);
+
+  ep = get_epoll(epfd);
+  if (ep == NULL) {
+    return -1;
+  }
+  if (timeout > 0) {
+    start = sys_now();
+  }
+
+  for (;;) {
+    msectimeout = 0;
+    if (timeout > 0) {
+      elapsed = sys_now() - start;
+      if (elapsed >= (u32_t)timeout) {
+        timeout = 0;
+      } else {
+        msectimeout = (u32_t)timeout - elapsed;
+      }
+    }
+
+    LWIP_SOCKET_SELECT_PROTECT(lev);
+    n = lwip_epoll_harvest(ep, events, maxevents);
+    if ((n > 0) || (timeout == 0)) {
+      if (ep->rdy_head != NULL) {
+        /* more to report: pass it on to the next waiter */
+        lwip_epoll_wake(ep);
+      }
+      LWIP_SOCKET_SELECT_UNPROTECT(lev);
+      break;
+    }
+    ep->waiting++;
+    LWIP_SOCKET_SELECT_UNPROTECT(lev);
+
+    waitres = sys_arch_sem_wait(&ep->sem, msectimeout);
+
+    LWIP_SOCKET_SELECT_PROTECT(lev);
+    ep->waiting--;
+    if (waitres != SYS_ARCH_TIMEOUT) {
+      ep->sem_signalled = 0;
+    }
+    LWIP_SOCKET_SELECT_UNPROTECT(lev);
+    if (waitres == SYS_ARCH_TIMEOUT) {
+      /* check once more, then return */
+      timeout = 0;
+    }
+  }
+
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_epoll_wait(%d) -> %d\n", epfd, n));
+  return n;
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 /**
  * Close one end of a full-duplex connection.
  */
@@ -2869,6 +3655,8 @@ lwip_sockopt_to_ipopt(int optname)
     return SOF_KEEPALIVE;
   case SO_REUSEADDR:
     return SOF_REUSEADDR;
+  case SO_REUSEPORT:
+    return SOF_REUSEPORT;
   default:
     LWIP_ASSERT("Unknown socket option", 0);
     return 0;
@@ -2919,6 +3707,7 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
         case SO_KEEPALIVE:
 #if SO_REUSE
         case SO_REUSEADDR:
+        case SO_REUSEPORT:
 #endif /* SO_REUSE */
           if ((optname == SO_BROADCAST) &&
               (NETCONNTYPE_GROUP(sock->conn->type) != NETCONN_UDP)) {
@@ -3327,6 +4116,7 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
         case SO_KEEPALIVE:
 #if SO_REUSE
         case SO_REUSEADDR:
+        case SO_REUSEPORT:
 #endif /* SO_REUSE */
           if ((optname == SO_BROADCAST) &&
               (NETCONNTYPE_GROUP(sock->conn->type) != NETCONN_UDP)) {
@@ -3418,6 +4208,52 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
           }
           break;
 #endif /* LWIP_UDP */
+#if LWIP_SO_ATTACH_FILTER
+        case SO_ATTACH_FILTER:
+        case SO_DETACH_FILTER: {
+          const struct lwip_bpf_insn *insns = NULL;
+          u16_t len = 0;
+          err_t filter_err;
+
+          if (optname == SO_ATTACH_FILTER) {
+            const struct sock_fprog *fprog;
+            LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB(sock, optlen, struct sock_fprog);
+            fprog = (const struct sock_fprog *)optval;
+            if ((fprog->filter == NULL) || (fprog->len == 0)) {
+              done_socket(sock);
+              return EINVAL;
+            }
+            /* struct sock_filter has the layout of struct lwip_bpf_insn;
+               the program is copied bytewise before it is used */
+            LWIP_ASSERT("sock_filter layout", sizeof(struct sock_filter) == sizeof(struct lwip_bpf_insn));
+            insns = (const struct lwip_bpf_insn *)(const void *)fprog->filter;
+            len = fprog->len;
+          } else if ((sock->conn == NULL) || (sock->conn->pcb.tcp == NULL)) {
+            done_socket(sock);
+            return EINVAL;
+          }
+
+          switch (NETCONNTYPE_GROUP(netconn_type(sock->conn))) {
+#if LWIP_UDP
+            case NETCONN_UDP:
+              filter_err = udp_attach_filter(sock->conn->pcb.udp, insns, len);
+              break;
+#endif /* LWIP_UDP */
+#if LWIP_RAW
+            case NETCONN_RAW:
+              filter_err = raw_attach_filter(sock->conn->pcb.raw, insns, len);
+              break;
+#endif /* LWIP_RAW */
+            default:
+              done_socket(sock);
+              return ENOPROTOOPT;
+          }
+          if (filter_err != ERR_OK) {
+            err = err_to_errno(filter_err);
+          }
+        }
+        break;
+#endif /* LWIP_SO_ATTACH_FILTER */
         case SO_BINDTODEVICE: {
           const struct ifreq *iface;
           struct netif *n = NULL;
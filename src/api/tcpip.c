@@ -44,6 +44,7 @@
 #include "lwip/sys.h"
 #include "lwip/memp.h"
 #include "lwip/mem.h"
+#include "lwip/stats.h"
 #include "lwip/init.h"
 #include "lwip/ip.h"
 #include "lwip/pbuf.h"
@@ -65,7 +66,83 @@ static sys_mbox_t tcpip_mbox;
 sys_mutex_t lock_tcpip_core;
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
+#if LWIP_TCPIP_CORE_LOCK_SPIN
+/** Moving average (x16) of the polls recent waiters needed to get the core
+ * lock. Only written with the lock held; waiters read it unlocked, a stale
+ * value only changes how long they spin. */
+static u32_t tcpip_core_spin_avg;
+#if CORELOCK_STATS
+/** When the current owner took the lock (LWIP_TCPIP_CORE_LOCK_CLOCK()) */
+static u32_t tcpip_core_lock_time;
+#endif /* CORELOCK_STATS */
+
+/**
+ * Lock the core mutex, spinning for a while before blocking when it is
+ * taken (see @ref LWIP_TCPIP_CORE_LOCK_SPIN). This is LOCK_TCPIP_CORE()
+ * unless the port defines it differently.
+ * The number of polls adapts like glibc's adaptive mutexes: twice the
+ * recent average plus a few, limited to LWIP_TCPIP_CORE_LOCK_SPIN_MAX, so
+ * waiters keep spinning as long as the lock is usually released quickly
+ * and fall back to blocking soon when it is not.
+ */
+void
+tcpip_core_lock(void)
+{
+  u32_t max_spin, spin;
+
+  if (sys_mutex_trylock(&lock_tcpip_core) != ERR_OK) {
+    max_spin = LWIP_MIN(LWIP_TCPIP_CORE_LOCK_SPIN_MAX, (tcpip_core_spin_avg / 8) + 10);
+    for (spin = 1; ; spin++) {
+      if (spin > max_spin) {
+        sys_mutex_lock(&lock_tcpip_core);
+        CORELOCK_STATS_INC(blocked);
+        break;
+      }
+      LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE();
+      if (sys_mutex_trylock(&lock_tcpip_core) == ERR_OK) {
+        CORELOCK_STATS_INC(spun);
+        break;
+      }
+    }
+    /* avg += (spin - avg) / 16, kept scaled by 16 */
+    tcpip_core_spin_avg = tcpip_core_spin_avg + spin - (tcpip_core_spin_avg / 16);
+    CORELOCK_STATS_INC(contended);
+  }
+  CORELOCK_STATS_INC(acquired);
+#if CORELOCK_STATS
+  tcpip_core_lock_time = LWIP_TCPIP_CORE_LOCK_CLOCK();
+#endif /* CORELOCK_STATS */
+}
+
+/**
+ * Unlock the core mutex locked by tcpip_core_lock(). This is
+ * UNLOCK_TCPIP_CORE() unless the port defines it differently.
+ */
+void
+tcpip_core_unlock(void)
+{
+#if CORELOCK_STATS
+  u32_t held = (u32_t)(LWIP_TCPIP_CORE_LOCK_CLOCK() - tcpip_core_lock_time);
+  u32_t t = held;
+  int bucket = 0;
+
+  while ((t != 0) && (bucket < STATS_CORELOCK_HOLD_BUCKETS - 1)) {
+    t >>= 1;
+    bucket++;
+  }
+  CORELOCK_STATS_INC(hold[bucket]);
+  if (held > lwip_stats.corelock.hold_max) {
+    lwip_stats.corelock.hold_max = held;
+  }
+#endif /* CORELOCK_STATS */
+  sys_mutex_unlock(&lock_tcpip_core);
+}
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN */
+
 static void tcpip_thread_handle_msg(struct tcpip_msg *msg);
+#if LWIP_TCPIP_INPUT_BATCH
+static void tcpip_inpkt_batch_input(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 
 #if !LWIP_TIMERS
 /* wait for a message with timers disabled (e.g. pass a timer-check trigger into tcpip_thread) */
@@ -176,6 +253,14 @@ tcpip_thread_handle_msg(struct tcpip_msg *msg)
       }
       memp_free(MEMP_TCPIP_MSG_INPKT, msg);
       break;
+#if LWIP_TCPIP_INPUT_BATCH
+    case TCPIP_MSG_INPKT_BATCH:
+      LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET BATCH %p\n", (void *)msg));
+      /* the whole list is processed before timeouts get a chance to run */
+      tcpip_inpkt_batch_input(msg->msg.inp.p, msg->msg.inp.netif, msg->msg.inp.input_fn);
+      memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+      break;
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 #endif /* !LWIP_TCPIP_CORE_LOCKING_INPUT */
 
 #if LWIP_TCPIP_TIMEOUT && LWIP_TIMERS
@@ -290,6 +375,89 @@ tcpip_input(struct pbuf *p, struct netif *inp)
     return tcpip_inpkt(p, inp, ip_input);
 }
 
+#if LWIP_TCPIP_INPUT_BATCH
+/* Feed every packet of a batch list to input_fn, freeing those it rejects */
+static void
+tcpip_inpkt_batch_input(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
+{
+  while (p != NULL) {
+    struct pbuf *q = p;
+    p = p->batch;
+    q->batch = NULL;
+    if (input_fn(q, inp) != ERR_OK) {
+      pbuf_free(q);
+    }
+  }
+}
+
+/**
+ * Pass a list of received packets to tcpip_thread for input processing
+ * using a single message.
+ *
+ * @param p the first received packet, further packets are linked via p->batch
+ * @param inp the network interface on which the packets were received
+ * @param input_fn input function to call for each packet
+ * @return ERR_OK if the stack took over all packets (packets rejected by
+ *         input_fn are freed by the stack), another err_t if none was taken
+ *         over and the caller still owns the whole list
+ */
+err_t
+tcpip_inpkt_batch(struct pbuf *p, struct netif *inp, netif_input_fn input_fn)
+{
+#if LWIP_TCPIP_CORE_LOCKING_INPUT
+  LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_inpkt_batch: PACKET BATCH %p/%p\n", (void *)p, (void *)inp));
+  LOCK_TCPIP_CORE();
+  tcpip_inpkt_batch_input(p, inp, input_fn);
+  UNLOCK_TCPIP_CORE();
+  return ERR_OK;
+#else /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+  struct tcpip_msg *msg;
+
+  LWIP_ASSERT("Invalid mbox", sys_mbox_valid_val(tcpip_mbox));
+
+  msg = (struct tcpip_msg *)memp_malloc(MEMP_TCPIP_MSG_INPKT);
+  if (msg == NULL) {
+    return ERR_MEM;
+  }
+
+  msg->type = TCPIP_MSG_INPKT_BATCH;
+  msg->msg.inp.p = p;
+  msg->msg.inp.netif = inp;
+  msg->msg.inp.input_fn = input_fn;
+  if (sys_mbox_trypost(&tcpip_mbox, msg) != ERR_OK) {
+    memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+    return ERR_MEM;
+  }
+  return ERR_OK;
+#endif /* LWIP_TCPIP_CORE_LOCKING_INPUT */
+}
+
+/**
+ * @ingroup lwip_os
+ * Pass a list of received packets to tcpip_thread for input processing with
+ * ethernet_input or ip_input (see tcpip_input()). All packets are delivered
+ * in one message, so the mbox traffic and thread wakeups are cut by the
+ * length of the list.
+ *
+ * @param p the first received packet, further packets are linked via p->batch
+ *          (the list is terminated by a NULL batch pointer)
+ * @param inp the network interface on which the packets were received
+ * @return ERR_OK if the stack took over all packets, another err_t if the
+ *         caller still owns the whole list
+ */
+err_t
+tcpip_input_batch(struct pbuf *p, struct netif *inp)
+{
+  LWIP_ERROR("tcpip_input_batch: invalid pbuf", p != NULL, return ERR_ARG;);
+#if LWIP_ETHERNET
+  if (inp->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) {
+    return tcpip_inpkt_batch(p, inp, ethernet_input);
+  } else
+#endif /* LWIP_ETHERNET */
+    return tcpip_inpkt_batch(p, inp, ip_input);
+}
+#endif /* LWIP_TCPIP_INPUT_BATCH */
+
 /**
  * @ingroup lwip_os
  * Call a specific function in the thread context of
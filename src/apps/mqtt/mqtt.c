@@ -838,12 +838,13 @@ out_disconnect:
 static mqtt_connection_status_t
 mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
 {
-  u16_t in_offset = 0;
+  struct pbuf_iter it;
   u32_t msg_rem_len = 0;
   u8_t fixed_hdr_idx = 0;
   u8_t b = 0;
 
-  while (p->tot_len > in_offset) {
+  pbuf_iter_init(&it, p, 0);
+  while (pbuf_iter_left(&it) > 0) {
     /* We ALWAYS parse the header here first. Even if the header was not
        included in this segment, we re-parse it here by buffering it in
        client->rx_buffer. client->msg_idx keeps track of this. */
@@ -855,7 +856,7 @@ mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
       } else {
         /* parse header from this pbuf and save it in client->rx_buffer in case
            it comes in segmented */
-        b = pbuf_get_at(p, in_offset++);
+        pbuf_iter_read_u8(&it, &b);
         client->rx_buffer[client->msg_idx++] = b;
       }
       fixed_hdr_idx++;
@@ -887,18 +888,17 @@ mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
       cpy_start = (client->msg_idx - fixed_hdr_idx) % (MQTT_VAR_HEADER_BUFFER_LEN - fixed_hdr_idx) + fixed_hdr_idx;
 
       /* Allow to copy the lesser one of available length in input data or bytes remaining in message */
-      cpy_len = (u16_t)LWIP_MIN((u16_t)(p->tot_len - in_offset), msg_rem_len);
+      cpy_len = (u16_t)LWIP_MIN(pbuf_iter_left(&it), msg_rem_len);
 
       /* Limit to available space in buffer */
       buffer_space = MQTT_VAR_HEADER_BUFFER_LEN - cpy_start;
       if (cpy_len > buffer_space) {
         cpy_len = buffer_space;
       }
-      pbuf_copy_partial(p, client->rx_buffer + cpy_start, cpy_len, in_offset);
+      pbuf_iter_read(&it, client->rx_buffer + cpy_start, cpy_len);
 
       /* Advance get and put indexes  */
       client->msg_idx += cpy_len;
-      in_offset += cpy_len;
       msg_rem_len -= cpy_len;
 
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_parse_incoming: msg_idx: %"U32_F", cpy_len: %"U16_F", remaining %"U32_F"\n", client->msg_idx, cpy_len, msg_rem_len));
@@ -50,7 +50,7 @@ snmp_pbuf_stream_init(struct snmp_pbuf_stream *pbuf_stream, struct pbuf *p, u16_
   pbuf_stream->length = length;
   pbuf_stream->pbuf   = p;
 
-  return ERR_OK;
+  return pbuf_iter_init(&pbuf_stream->iter, p, offset);
 }
 
 err_t
@@ -60,7 +60,7 @@ snmp_pbuf_stream_read(struct snmp_pbuf_stream *pbuf_stream, u8_t *data)
     return ERR_BUF;
   }
 
-  if (pbuf_copy_partial(pbuf_stream->pbuf, data, 1, pbuf_stream->offset) == 0) {
+  if (pbuf_iter_read_u8(&pbuf_stream->iter, data) != ERR_OK) {
     return ERR_BUF;
   }
 
@@ -79,12 +79,26 @@ snmp_pbuf_stream_write(struct snmp_pbuf_stream *pbuf_stream, u8_t data)
 err_t
 snmp_pbuf_stream_writebuf(struct snmp_pbuf_stream *pbuf_stream, const void *buf, u16_t buf_len)
 {
-  if (pbuf_stream->length < buf_len) {
+  const u8_t *src = (const u8_t *)buf;
+  u16_t left = buf_len;
+
+  if ((pbuf_stream->length < buf_len) || (pbuf_iter_left(&pbuf_stream->iter) < buf_len)) {
     return ERR_BUF;
   }
 
-  if (pbuf_take_at(pbuf_stream->pbuf, buf, buf_len, pbuf_stream->offset) != ERR_OK) {
-    return ERR_BUF;
+  /* copy at the cursor instead of pbuf_take_at(), which walks the chain
+     from its head on every call */
+  while (left > 0) {
+    pbuf_len_t span_len;
+    u16_t chunk_len;
+    const void *span = pbuf_iter_span(&pbuf_stream->iter, &span_len);
+
+    LWIP_ASSERT("span != NULL", span != NULL);
+    chunk_len = (u16_t)LWIP_MIN(left, span_len);
+    MEMCPY(LWIP_CONST_CAST(void *, span), src, chunk_len);
+    pbuf_iter_skip(&pbuf_stream->iter, chunk_len);
+    src  += chunk_len;
+    left -= chunk_len;
   }
 
   pbuf_stream->offset += buf_len;
@@ -109,21 +123,22 @@ snmp_pbuf_stream_writeto(struct snmp_pbuf_stream *pbuf_stream, struct snmp_pbuf_
   }
 
   while (len > 0) {
+    pbuf_len_t span_len;
     u16_t chunk_len;
     err_t err;
-    u16_t target_offset;
-    struct pbuf *pbuf = pbuf_skip(pbuf_stream->pbuf, pbuf_stream->offset, &target_offset);
+    const void *chunk = pbuf_iter_span(&pbuf_stream->iter, &span_len);
 
-    if ((pbuf == NULL) || (pbuf->len == 0)) {
+    if (chunk == NULL) {
       return ERR_BUF;
     }
 
-    chunk_len = LWIP_MIN(len, pbuf->len);
-    err = snmp_pbuf_stream_writebuf(target_pbuf_stream, &((u8_t *)pbuf->payload)[target_offset], chunk_len);
+    chunk_len = (u16_t)LWIP_MIN(len, span_len);
+    err = snmp_pbuf_stream_writebuf(target_pbuf_stream, chunk, chunk_len);
     if (err != ERR_OK) {
       return err;
     }
 
+    pbuf_iter_skip(&pbuf_stream->iter, chunk_len);
     pbuf_stream->offset   += chunk_len;
     pbuf_stream->length   -= chunk_len;
     len -= chunk_len;
@@ -140,6 +155,9 @@ snmp_pbuf_stream_seek(struct snmp_pbuf_stream *pbuf_stream, s32_t offset)
     return ERR_ARG;
   }
 
+  if (pbuf_iter_skip(&pbuf_stream->iter, (u16_t)offset) != ERR_OK) {
+    return ERR_ARG;
+  }
   pbuf_stream->offset += (u16_t)offset;
   pbuf_stream->length -= (u16_t)offset;
 
@@ -53,6 +53,8 @@ struct snmp_pbuf_stream {
   struct pbuf *pbuf;
   u16_t offset;
   u16_t length;
+  /* read/write cursor kept in sync with offset (avoids rescanning the chain) */
+  struct pbuf_iter iter;
 };
 
 err_t snmp_pbuf_stream_init(struct snmp_pbuf_stream *pbuf_stream, struct pbuf *p, u16_t offset, u16_t length);
@@ -0,0 +1,432 @@
+/**
+ * @file
+ * Classic BPF packet filter
+ *
+ * @defgroup bpf Socket filters
+ * @ingroup infrastructure
+ * Classic BPF (as used by tcpdump and SO_ATTACH_FILTER) receive filters
+ * for raw and UDP pcbs.
+ *
+ * A program is validated and copied when it is attached and then runs in
+ * raw_input()/udp_input() on every packet matching the pcb, before the
+ * recv callback is called. A return value of 0 drops the packet, anything
+ * else passes it on unchanged (programs cannot truncate packets here).
+ * Raw pcbs see the packet from the IP header on, UDP pcbs from the UDP
+ * header on. Loads beyond the end of the packet drop it.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "lwip/opt.h"
+
+#if LWIP_SO_ATTACH_FILTER /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/bpf.h"
+#include "lwip/def.h"
+#include "lwip/mem.h"
+
+#include <string.h>
+
+/** Load 'size' bytes (big endian) from offset 'off' of the packet.
+ * @return 0 if the packet is too short */
+static int
+bpf_load(const struct pbuf *p, u32_t off, u8_t size, u32_t *val)
+{
+  u8_t buf[4];
+  const u8_t *data;
+  u8_t i;
+
+  if ((off > p->tot_len) || (size > p->tot_len - off)) {
+    return 0;
+  }
+  if (off + size <= p->len) {
+    /* headers are usually in the first pbuf */
+    data = (const u8_t *)p->payload + off;
+  } else {
+    if (pbuf_copy_partial(p, buf, size, (pbuf_len_t)off) != size) {
+      return 0;
+    }
+    data = buf;
+  }
+  *val = 0;
+  for (i = 0; i < size; i++) {
+    *val = (*val << 8) | data[i];
+  }
+  return 1;
+}
+
+/**
+ * @ingroup bpf
+ * Check that a program only uses known instructions, only jumps forward
+ * to instructions inside the program, only accesses valid scratch memory,
+ * does not divide by a constant 0 and ends with a return.
+ *
+ * @param insns the instructions
+ * @param len number of instructions
+ * @return 1 if the program is valid, 0 otherwise
+ */
+int
+lwip_bpf_validate(const struct lwip_bpf_insn *insns, u16_t len)
+{
+  u16_t i;
+
+  if ((insns == NULL) || (len == 0) || (len > LWIP_BPF_MAXINSNS)) {
+    return 0;
+  }
+  for (i = 0; i < len; i++) {
+    const struct lwip_bpf_insn *insn = &insns[i];
+    /* number of instructions after this one */
+    u32_t rest = (u32_t)(len - i - 1);
+
+    switch (insn->code) {
+      case BPF_LD | BPF_W | BPF_ABS:
+      case BPF_LD | BPF_H | BPF_ABS:
+      case BPF_LD | BPF_B | BPF_ABS:
+      case BPF_LD | BPF_W | BPF_IND:
+      case BPF_LD | BPF_H | BPF_IND:
+      case BPF_LD | BPF_B | BPF_IND:
+      case BPF_LD | BPF_W | BPF_LEN:
+      case BPF_LD | BPF_IMM:
+      case BPF_LDX | BPF_W | BPF_LEN:
+      case BPF_LDX | BPF_IMM:
+      case BPF_LDX | BPF_B | BPF_MSH:
+      case BPF_ALU | BPF_ADD | BPF_K:
+      case BPF_ALU | BPF_SUB | BPF_K:
+      case BPF_ALU | BPF_MUL | BPF_K:
+      case BPF_ALU | BPF_OR | BPF_K:
+      case BPF_ALU | BPF_AND | BPF_K:
+      case BPF_ALU | BPF_XOR | BPF_K:
+      case BPF_ALU | BPF_ADD | BPF_X:
+      case BPF_ALU | BPF_SUB | BPF_X:
+      case BPF_ALU | BPF_MUL | BPF_X:
+      case BPF_ALU | BPF_DIV | BPF_X:
+      case BPF_ALU | BPF_MOD | BPF_X:
+      case BPF_ALU | BPF_OR | BPF_X:
+      case BPF_ALU | BPF_AND | BPF_X:
+      case BPF_ALU | BPF_LSH | BPF_X:
+      case BPF_ALU | BPF_RSH | BPF_X:
+      case BPF_ALU | BPF_XOR | BPF_X:
+      case BPF_ALU | BPF_NEG:
+      case BPF_MISC | BPF_TAX:
+      case BPF_MISC | BPF_TXA:
+      case BPF_RET | BPF_K:
+      case BPF_RET | BPF_A:
+        break;
+      case BPF_LD | BPF_MEM:
+      case BPF_LDX | BPF_MEM:
+      case BPF_ST:
+      case BPF_STX:
+        if (insn->k >= LWIP_BPF_MEMWORDS) {
+          return 0;
+        }
+        break;
+      case BPF_ALU | BPF_DIV | BPF_K:
+      case BPF_ALU | BPF_MOD | BPF_K:
+        if (insn->k == 0) {
+          return 0;
+        }
+        break;
+      case BPF_ALU | BPF_LSH | BPF_K:
+      case BPF_ALU | BPF_RSH | BPF_K:
+        if (insn->k >= 32) {
+          return 0;
+        }
+        break;
+      case BPF_JMP | BPF_JA:
+        if (insn->k >= rest) {
+          return 0;
+        }
+        break;
+      case BPF_JMP | BPF_JEQ | BPF_K:
+      case BPF_JMP | BPF_JGT | BPF_K:
+      case BPF_JMP | BPF_JGE | BPF_K:
+      case BPF_JMP | BPF_JSET | BPF_K:
+      case BPF_JMP | BPF_JEQ | BPF_X:
+      case BPF_JMP | BPF_JGT | BPF_X:
+      case BPF_JMP | BPF_JGE | BPF_X:
+      case BPF_JMP | BPF_JSET | BPF_X:
+        if ((insn->jt >= rest) || (insn->jf >= rest)) {
+          return 0;
+        }
+        break;
+      default:
+        return 0;
+    }
+  }
+  return BPF_CLASS(insns[len - 1].code) == BPF_RET;
+}
+
+/**
+ * @ingroup bpf
+ * Run a (validated) program on a packet.
+ *
+ * @param prog the program
+ * @param p the packet, p->payload pointing to the first byte the program sees
+ * @return the program's return value: 0 means drop
+ */
+u32_t
+lwip_bpf_filter(const struct lwip_bpf_program *prog, const struct pbuf *p)
+{
+  const struct lwip_bpf_insn *insn;
+  u32_t A = 0, X = 0;
+  u32_t mem[LWIP_BPF_MEMWORDS];
+
+  LWIP_ASSERT("lwip_bpf_filter: invalid program", (prog != NULL) && (prog->insns != NULL));
+  LWIP_ASSERT("lwip_bpf_filter: invalid pbuf", p != NULL);
+
+  memset(mem, 0, sizeof(mem));
+  for (insn = prog->insns; ; insn++) {
+    switch (insn->code) {
+      case BPF_RET | BPF_K:
+        return insn->k;
+      case BPF_RET | BPF_A:
+        return A;
+
+      case BPF_LD | BPF_W | BPF_ABS:
+        if (!bpf_load(p, insn->k, 4, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_H | BPF_ABS:
+        if (!bpf_load(p, insn->k, 2, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_B | BPF_ABS:
+        if (!bpf_load(p, insn->k, 1, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_W | BPF_IND:
+        if ((insn->k > 0xffffffffUL - X) || !bpf_load(p, insn->k + X, 4, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_H | BPF_IND:
+        if ((insn->k > 0xffffffffUL - X) || !bpf_load(p, insn->k + X, 2, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_B | BPF_IND:
+        if ((insn->k > 0xffffffffUL - X) || !bpf_load(p, insn->k + X, 1, &A)) {
+          return 0;
+        }
+        break;
+      case BPF_LD | BPF_W | BPF_LEN:
+        A = p->tot_len;
+        break;
+      case BPF_LD | BPF_IMM:
+        A = insn->k;
+        break;
+      case BPF_LD | BPF_MEM:
+        A = mem[insn->k];
+        break;
+      case BPF_LDX | BPF_W | BPF_LEN:
+        X = p->tot_len;
+        break;
+      case BPF_LDX | BPF_IMM:
+        X = insn->k;
+        break;
+      case BPF_LDX | BPF_MEM:
+        X = mem[insn->k];
+        break;
+      case BPF_LDX | BPF_B | BPF_MSH:
+        /* IPv4 header length */
+        if (!bpf_load(p, insn->k, 1, &X)) {
+          return 0;
+        }
+        X = (X & 0xf) << 2;
+        break;
+      case BPF_ST:
+        mem[insn->k] = A;
+        break;
+      case BPF_STX:
+        mem[insn->k] = X;
+        break;
+
+      case BPF_ALU | BPF_ADD | BPF_K:
+        A += insn->k;
+        break;
+      case BPF_ALU | BPF_SUB | BPF_K:
+        A -= insn->k;
+        break;
+      case BPF_ALU | BPF_MUL | BPF_K:
+        A *= insn->k;
+        break;
+      case BPF_ALU | BPF_DIV | BPF_K:
+        A /= insn->k;
+        break;
+      case BPF_ALU | BPF_MOD | BPF_K:
+        A %= insn->k;
+        break;
+      case BPF_ALU | BPF_OR | BPF_K:
+        A |= insn->k;
+        break;
+      case BPF_ALU | BPF_AND | BPF_K:
+        A &= insn->k;
+        break;
+      case BPF_ALU | BPF_XOR | BPF_K:
+        A ^= insn->k;
+        break;
+      case BPF_ALU | BPF_LSH | BPF_K:
+        A <<= insn->k;
+        break;
+      case BPF_ALU | BPF_RSH | BPF_K:
+        A >>= insn->k;
+        break;
+      case BPF_ALU | BPF_ADD | BPF_X:
+        A += X;
+        break;
+      case BPF_ALU | BPF_SUB | BPF_X:
+        A -= X;
+        break;
+      case BPF_ALU | BPF_MUL | BPF_X:
+        A *= X;
+        break;
+      case BPF_ALU | BPF_DIV | BPF_X:
+        if (X == 0) {
+          return 0;
+        }
+        A /= X;
+        break;
+      case BPF_ALU | BPF_MOD | BPF_X:
+        if (X == 0) {
+          return 0;
+        }
+        A %= X;
+        break;
+      case BPF_ALU | BPF_OR | BPF_X:
+        A |= X;
+        break;
+      case BPF_ALU | BPF_AND | BPF_X:
+        A &= X;
+        break;
+      case BPF_ALU | BPF_XOR | BPF_X:
+        A ^= X;
+        break;
+      case BPF_ALU | BPF_LSH | BPF_X:
+        A = (X < 32) ? (A << X) : 0;
+        break;
+      case BPF_ALU | BPF_RSH | BPF_X:
+        A = (X < 32) ? (A >> X) : 0;
+        break;
+      case BPF_ALU | BPF_NEG:
+        A = 0 - A;
+        break;
+
+      case BPF_JMP | BPF_JA:
+        insn += insn->k;
+        break;
+      case BPF_JMP | BPF_JEQ | BPF_K:
+        insn += (A == insn->k) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JGT | BPF_K:
+        insn += (A > insn->k) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JGE | BPF_K:
+        insn += (A >= insn->k) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JSET | BPF_K:
+        insn += (A & insn->k) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JEQ | BPF_X:
+        insn += (A == X) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JGT | BPF_X:
+        insn += (A > X) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JGE | BPF_X:
+        insn += (A >= X) ? insn->jt : insn->jf;
+        break;
+      case BPF_JMP | BPF_JSET | BPF_X:
+        insn += (A & X) ? insn->jt : insn->jf;
+        break;
+
+      case BPF_MISC | BPF_TAX:
+        X = A;
+        break;
+      case BPF_MISC | BPF_TXA:
+        A = X;
+        break;
+
+      default:
+        /* not reached for validated programs */
+        LWIP_ASSERT("lwip_bpf_filter: invalid instruction", 0);
+        return 0;
+    }
+  }
+}
+
+/**
+ * @ingroup bpf
+ * Replace the program attached through 'slot' (a pcb's filter pointer) by
+ * a validated copy of 'insns'. Passing NULL or 0 instructions detaches and
+ * frees the current program.
+ *
+ * @param slot where the pcb keeps its program
+ * @param insns the instructions (copied, may be freed by the caller)
+ * @param len number of instructions
+ * @return ERR_OK, ERR_VAL if the program is invalid or ERR_MEM
+ */
+err_t
+lwip_bpf_attach(struct lwip_bpf_program **slot, const struct lwip_bpf_insn *insns, u16_t len)
+{
+  struct lwip_bpf_program *prog = NULL;
+
+  LWIP_ASSERT("lwip_bpf_attach: invalid slot", slot != NULL);
+
+  if ((insns != NULL) && (len != 0)) {
+    if (len > LWIP_BPF_MAXINSNS) {
+      return ERR_VAL;
+    }
+    prog = (struct lwip_bpf_program *)mem_malloc((mem_size_t)(sizeof(struct lwip_bpf_program) +
+                                                 len * sizeof(struct lwip_bpf_insn)));
+    if (prog == NULL) {
+      return ERR_MEM;
+    }
+    /* the instructions follow the header in the same allocation; they are
+     * copied before validating so that callers may pass the same layout
+     * declared through another type (struct sock_filter) */
+    prog->len = len;
+    prog->insns = (struct lwip_bpf_insn *)(prog + 1);
+    MEMCPY(prog->insns, insns, len * sizeof(struct lwip_bpf_insn));
+    if (!lwip_bpf_validate(prog->insns, len)) {
+      mem_free(prog);
+      return ERR_VAL;
+    }
+  }
+  if (*slot != NULL) {
+    mem_free(*slot);
+  }
+  *slot = prog;
+  return ERR_OK;
+}
+
+#endif /* LWIP_SO_ATTACH_FILTER */
@@ -650,16 +650,16 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
 static u16_t
 dns_compare_name(const char *query, struct pbuf *p, u16_t start_offset)
 {
-  int n;
-  u16_t response_offset = start_offset;
+  u8_t n;
+  struct pbuf_iter it;
 
+  if (pbuf_iter_init(&it, p, start_offset) != ERR_OK) {
+    return 0xFFFF;
+  }
   do {
-    n = pbuf_try_get_at(p, response_offset);
-    if ((n < 0) || (response_offset == 0xFFFF)) {
-      /* error or overflow */
+    if (pbuf_iter_read_u8(&it, &n) != ERR_OK) {
       return 0xFFFF;
     }
-    response_offset++;
     /** @see RFC 1035 - 4.1.4. Message compression */
     if ((n & 0xc0) == 0xc0) {
       /* Compressed name: cannot be equal since we don't send them */
@@ -667,34 +667,28 @@ dns_compare_name(const char *query, struct pbuf *p, u16_t start_offset)
     } else {
       /* Not compressed name */
       while (n > 0) {
-        int c = pbuf_try_get_at(p, response_offset);
-        if (c < 0) {
-          return 0xFFFF;
-        }
-        if (lwip_tolower((*query)) != lwip_tolower((u8_t)c)) {
+        u8_t c;
+        if (pbuf_iter_read_u8(&it, &c) != ERR_OK) {
           return 0xFFFF;
         }
-        if (response_offset == 0xFFFF) {
-          /* would overflow */
+        if (lwip_tolower((*query)) != lwip_tolower(c)) {
           return 0xFFFF;
         }
-        response_offset++;
         ++query;
         --n;
       }
       ++query;
     }
-    n = pbuf_try_get_at(p, response_offset);
-    if (n < 0) {
+    if (pbuf_iter_peek_u8(&it) < 0) {
       return 0xFFFF;
     }
-  } while (n != 0);
+  } while (pbuf_iter_peek_u8(&it) != 0);
 
-  if (response_offset == 0xFFFF) {
+  if (pbuf_iter_offset(&it) == 0xFFFF) {
     /* would overflow */
     return 0xFFFF;
   }
-  return (u16_t)(response_offset + 1);
+  return (u16_t)(pbuf_iter_offset(&it) + 1);
 }
 
 /**
@@ -707,12 +701,14 @@ dns_compare_name(const char *query, struct pbuf *p, u16_t start_offset)
 static u16_t
 dns_skip_name(struct pbuf *p, u16_t query_idx)
 {
-  int n;
-  u16_t offset = query_idx;
+  u8_t n;
+  struct pbuf_iter it;
 
+  if (pbuf_iter_init(&it, p, query_idx) != ERR_OK) {
+    return 0xFFFF;
+  }
   do {
-    n = pbuf_try_get_at(p, offset++);
-    if ((n < 0) || (offset == 0)) {
+    if (pbuf_iter_read_u8(&it, &n) != ERR_OK) {
       return 0xFFFF;
     }
     /** @see RFC 1035 - 4.1.4. Message compression */
@@ -721,21 +717,20 @@ dns_skip_name(struct pbuf *p, u16_t query_idx)
       break;
     } else {
       /* Not compressed name */
-      if (offset + n >= p->tot_len) {
+      if (pbuf_iter_left(&it) <= n) {
         return 0xFFFF;
       }
-      offset = (u16_t)(offset + n);
+      pbuf_iter_skip(&it, n);
     }
-    n = pbuf_try_get_at(p, offset);
-    if (n < 0) {
+    if (pbuf_iter_peek_u8(&it) < 0) {
       return 0xFFFF;
     }
-  } while (n != 0);
+  } while (pbuf_iter_peek_u8(&it) != 0);
 
-  if (offset == 0xFFFF) {
+  if (pbuf_iter_offset(&it) == 0xFFFF) {
     return 0xFFFF;
   }
-  return (u16_t)(offset + 1);
+  return (u16_t)(pbuf_iter_offset(&it) + 1);
 }
 
 /**
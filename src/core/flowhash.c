@@ -0,0 +1,222 @@
+/**
+ * @file
+ * RSS (Toeplitz) flow hash
+ *
+ * @defgroup flowhash Flow hash
+ * @ingroup infrastructure
+ * Receive-side-scaling style hash over the IP 5-tuple of a packet.
+ *
+ * The hash is the Toeplitz hash used by RSS capable NICs (with the default
+ * key, results match the hashes such hardware reports), so software and
+ * hardware steering agree on which queue/worker a flow belongs to. For TCP
+ * and UDP (and UDP-Lite) the input is source address, destination address,
+ * source port and destination port; for other protocols and for IPv4
+ * fragments only the two addresses are hashed, so all fragments of a
+ * datagram land on the same queue.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "lwip/opt.h"
+
+#include "lwip/flowhash.h"
+#include "lwip/def.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/ip6.h"
+
+#include <string.h>
+
+/** The default RSS key (as used by most NIC drivers, 40 bytes) */
+const u8_t flowhash_default_key[FLOWHASH_KEY_LEN] = {
+  0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+  0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+  0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+  0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+  0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
+/** Largest hash input: two IPv6 addresses plus two ports */
+#define FLOWHASH_MAX_INPUT (2 * 16 + 2 * 2)
+
+/**
+ * @ingroup flowhash
+ * Toeplitz hash of 'len' bytes of 'data'.
+ *
+ * @param key the secret key, must be at least len + 4 bytes long
+ * @param data input bytes (in network byte order)
+ * @param len number of input bytes
+ * @return the 32 bit hash
+ */
+u32_t
+flowhash_toeplitz(const u8_t *key, const u8_t *data, u16_t len)
+{
+  u32_t hash = 0;
+  /* the 32 key bits currently aligned with the input bit */
+  u32_t window = ((u32_t)key[0] << 24) | ((u32_t)key[1] << 16) |
+                 ((u32_t)key[2] << 8) | key[3];
+  u16_t i;
+
+  for (i = 0; i < len; i++) {
+    u8_t next = key[i + 4];
+    u8_t bit;
+    for (bit = 0x80; bit != 0; bit >>= 1) {
+      if (data[i] & bit) {
+        hash ^= window;
+      }
+      window <<= 1;
+      if (next & bit) {
+        window |= 1;
+      }
+    }
+  }
+  return hash;
+}
+
+/**
+ * @ingroup flowhash
+ * Hash a flow given by its addresses and ports, using flowhash_default_key.
+ *
+ * @param src source address
+ * @param dest destination address (must be of the same type as src)
+ * @param sport source port in host byte order (0 to hash the addresses only)
+ * @param dport destination port in host byte order (0 to hash the addresses only)
+ * @return the 32 bit hash
+ */
+u32_t
+flowhash_ip(const ip_addr_t *src, const ip_addr_t *dest, u16_t sport, u16_t dport)
+{
+  u8_t in[FLOWHASH_MAX_INPUT];
+  u16_t len;
+
+  LWIP_ASSERT("flowhash_ip: invalid addresses", (src != NULL) && (dest != NULL));
+  LWIP_ASSERT("flowhash_ip: address type mismatch",
+              IP_GET_TYPE(src) == IP_GET_TYPE(dest));
+
+#if LWIP_IPV6
+  if (IP_IS_V6(src)) {
+    MEMCPY(&in[0], ip_2_ip6(src)->addr, 16);
+    MEMCPY(&in[16], ip_2_ip6(dest)->addr, 16);
+    len = 32;
+  } else
+#endif /* LWIP_IPV6 */
+  {
+#if LWIP_IPV4
+    MEMCPY(&in[0], &ip_2_ip4(src)->addr, 4);
+    MEMCPY(&in[4], &ip_2_ip4(dest)->addr, 4);
+    len = 8;
+#else /* LWIP_IPV4 */
+    return 0;
+#endif /* LWIP_IPV4 */
+  }
+  if ((sport != 0) || (dport != 0)) {
+    in[len++] = (u8_t)(sport >> 8);
+    in[len++] = (u8_t)sport;
+    in[len++] = (u8_t)(dport >> 8);
+    in[len++] = (u8_t)dport;
+  }
+  return flowhash_toeplitz(flowhash_default_key, in, len);
+}
+
+/**
+ * @ingroup flowhash
+ * Hash the flow of a received packet, using flowhash_default_key.
+ * This only reads the packet and can be called before ip_input()
+ * (e.g. by a driver to select a queue or worker).
+ *
+ * @param p the packet, p->payload pointing to the IP header
+ * @return the 32 bit hash or 0 if the packet is not a (valid) IP packet
+ */
+u32_t
+flowhash_pbuf(const struct pbuf *p)
+{
+  u8_t hdr[IP6_HLEN + 4];
+  const u8_t *h;
+  ip_addr_t src, dest;
+  u16_t hlen, sport = 0, dport = 0;
+  u8_t proto;
+  int ports = 1;
+
+  LWIP_ERROR("flowhash_pbuf: invalid pbuf", p != NULL, return 0;);
+
+  if (p->tot_len == 0) {
+    return 0;
+  }
+  h = (const u8_t *)pbuf_get_contiguous(p, hdr, sizeof(hdr),
+                                        (pbuf_len_t)LWIP_MIN(p->tot_len, sizeof(hdr)), 0);
+  if (h == NULL) {
+    return 0;
+  }
+  switch (h[0] >> 4) {
+#if LWIP_IPV4
+    case 4: {
+      const struct ip_hdr *iphdr = (const struct ip_hdr *)h;
+      if (p->tot_len < IP_HLEN) {
+        return 0;
+      }
+      hlen = (u16_t)(IPH_HL_BYTES(iphdr));
+      proto = IPH_PROTO(iphdr);
+      ip_addr_copy_from_ip4(src, iphdr->src);
+      ip_addr_copy_from_ip4(dest, iphdr->dest);
+      if ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) != 0) {
+        /* fragments of one datagram must not be spread */
+        ports = 0;
+      }
+      break;
+    }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+    case 6: {
+      const struct ip6_hdr *ip6hdr = (const struct ip6_hdr *)h;
+      if (p->tot_len < IP6_HLEN) {
+        return 0;
+      }
+      hlen = IP6_HLEN;
+      proto = IP6H_NEXTH(ip6hdr);
+      ip_addr_copy_from_ip6_packed(src, ip6hdr->src);
+      ip_addr_copy_from_ip6_packed(dest, ip6hdr->dest);
+      /* extension headers are not walked: such packets use the 2-tuple */
+      break;
+    }
+#endif /* LWIP_IPV6 */
+    default:
+      return 0;
+  }
+
+  if (ports && ((proto == IP_PROTO_TCP) || (proto == IP_PROTO_UDP) ||
+                (proto == IP_PROTO_UDPLITE))) {
+    u8_t pp[4];
+    if (pbuf_copy_partial(p, pp, sizeof(pp), hlen) == sizeof(pp)) {
+      sport = (u16_t)((pp[0] << 8) | pp[1]);
+      dport = (u16_t)((pp[2] << 8) | pp[3]);
+    }
+  }
+  return flowhash_ip(&src, &dest, sport, dport);
+}
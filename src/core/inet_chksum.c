@@ -255,6 +255,30 @@ lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if LWIP_PBUF_LEN_32BIT
+/* The checksum routines sum up into a u32_t without intermediate folding,
+ * so pbufs bigger than 64 KByte are fed to them in (even sized) chunks. */
+static u16_t
+inet_chksum_pbuf_payload(const struct pbuf *q)
+{
+  const u8_t *dataptr = (const u8_t *)q->payload;
+  pbuf_len_t len = q->len;
+  u32_t acc = 0;
+
+  while (len > 0xFFFE) {
+    acc += LWIP_CHKSUM(dataptr, 0xFFFE);
+    acc = FOLD_U32T(acc);
+    dataptr += 0xFFFE;
+    len -= 0xFFFE;
+  }
+  acc += LWIP_CHKSUM(dataptr, (int)len);
+  acc = FOLD_U32T(acc);
+  return (u16_t)FOLD_U32T(acc);
+}
+#else /* LWIP_PBUF_LEN_32BIT */
+#define inet_chksum_pbuf_payload(q) LWIP_CHKSUM((q)->payload, (q)->len)
+#endif /* LWIP_PBUF_LEN_32BIT */
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t
 inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
@@ -266,7 +290,7 @@ inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
   for (q = p; q != NULL; q = q->next) {
     LWIP_DEBUGF(INET_DEBUG, ("inet_chksum_pseudo(): checksumming pbuf %p (has next %p) \n",
                              (void *)q, (void *)q->next));
-    acc += LWIP_CHKSUM(q->payload, q->len);
+    acc += inet_chksum_pbuf_payload(q);
     /*LWIP_DEBUGF(INET_DEBUG, ("inet_chksum_pseudo(): unwrapped lwip_chksum()=%"X32_F" \n", acc));*/
     /* just executing this next line is probably faster that the if statement needed
        to check whether we really need to execute it, and does no harm */
@@ -407,10 +431,7 @@ inet_cksum_pseudo_partial_base(struct pbuf *p, u8_t proto, u16_t proto_len,
   for (q = p; (q != NULL) && (chksum_len > 0); q = q->next) {
     LWIP_DEBUGF(INET_DEBUG, ("inet_chksum_pseudo(): checksumming pbuf %p (has next %p) \n",
                              (void *)q, (void *)q->next));
-    chklen = q->len;
-    if (chklen > chksum_len) {
-      chklen = chksum_len;
-    }
+    chklen = (u16_t)LWIP_MIN(q->len, chksum_len);
     acc += LWIP_CHKSUM(q->payload, chklen);
     chksum_len = (u16_t)(chksum_len - chklen);
     LWIP_ASSERT("delete me", chksum_len < 0x7fff);
@@ -573,7 +594,7 @@ inet_chksum_pbuf(struct pbuf *p)
 
   acc = 0;
   for (q = p; q != NULL; q = q->next) {
-    acc += LWIP_CHKSUM(q->payload, q->len);
+    acc += inet_chksum_pbuf_payload(q);
     acc = FOLD_U32T(acc);
     if (q->len % 2 != 0) {
       swapped = !swapped;
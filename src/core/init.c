@@ -97,6 +97,9 @@ PACK_STRUCT_END
 #if (!LWIP_UDP && !LWIP_RAW && LWIP_MULTICAST_TX_OPTIONS)
 #error "If you want to use LWIP_MULTICAST_TX_OPTIONS, you have to define LWIP_UDP=1 and/or LWIP_RAW=1 in your lwipopts.h"
 #endif
+#if (!LWIP_UDP && !LWIP_RAW && LWIP_SO_ATTACH_FILTER)
+#error "If you want to use LWIP_SO_ATTACH_FILTER, you have to define LWIP_UDP=1 and/or LWIP_RAW=1 in your lwipopts.h"
+#endif
 #if (!LWIP_UDP && LWIP_DNS)
 #error "If you want to use DNS, you have to define LWIP_UDP=1 in your lwipopts.h"
 #endif
@@ -226,6 +229,22 @@ PACK_STRUCT_END
 #if LWIP_TCPIP_CORE_LOCKING_INPUT && !LWIP_TCPIP_CORE_LOCKING
 #error "When using LWIP_TCPIP_CORE_LOCKING_INPUT, LWIP_TCPIP_CORE_LOCKING must be enabled, too"
 #endif
+#if LWIP_SOCKET && LWIP_SOCKET_EPOLL && !(LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL)
+#error "LWIP_SOCKET_EPOLL needs LWIP_SOCKET_SELECT or LWIP_SOCKET_POLL"
+#endif
+#if (LWIP_NETCONN || LWIP_SOCKET) && LWIP_NETCONN_RECVQ && ((LWIP_RAW && (DEFAULT_RAW_RECVMBOX_SIZE <= 0)) || \
+    (LWIP_UDP && (DEFAULT_UDP_RECVMBOX_SIZE <= 0)) || (LWIP_TCP && (DEFAULT_TCP_RECVMBOX_SIZE <= 0)))
+#error "LWIP_NETCONN_RECVQ needs DEFAULT_RAW/UDP/TCP_RECVMBOX_SIZE > 0 for the enabled protocols"
+#endif
+#if LWIP_IPV4_ROUTE_TABLE && LWIP_SINGLE_NETIF
+#error "LWIP_IPV4_ROUTE_TABLE makes no sense with LWIP_SINGLE_NETIF"
+#endif
+#if LWIP_NETCONN_ASYNC && !LWIP_NETCONN
+#error "If you want to use LWIP_NETCONN_ASYNC, you have to define LWIP_NETCONN=1 in your lwipopts.h"
+#endif
+#if LWIP_TCPIP_CORE_LOCK_SPIN && (NO_SYS || !LWIP_TCPIP_CORE_LOCKING || LWIP_COMPAT_MUTEX)
+#error "LWIP_TCPIP_CORE_LOCK_SPIN needs LWIP_TCPIP_CORE_LOCKING and real mutexes (sys_mutex_trylock())"
+#endif
 #if LWIP_TCP && LWIP_NETIF_TX_SINGLE_PBUF && !TCP_OVERSIZE
 #error "LWIP_NETIF_TX_SINGLE_PBUF needs TCP_OVERSIZE enabled to create single-pbuf TCP packets"
 #endif
@@ -1538,7 +1538,7 @@ dhcp_parse_reply(struct pbuf *p, struct dhcp *dhcp)
   /* start with options field */
   options_idx = DHCP_OPTIONS_OFS;
   /* parse options to the end of the received packet */
-  options_idx_max = p->tot_len;
+  options_idx_max = (u16_t)p->tot_len;
 again:
   q = p;
   while ((q != NULL) && (options_idx >= q->len)) {
@@ -1564,7 +1564,7 @@ again:
       return ERR_BUF;
     }
     /* len byte might be in the next pbuf */
-    if ((offset + 1) < q->len) {
+    if ((pbuf_len_t)(offset + 1) < q->len) {
       len = options[offset + 1];
     } else {
       len = (q->next != NULL ? ((u8_t *)q->next->payload)[0] : 0);
@@ -52,6 +52,7 @@
 #include "lwip/snmp.h"
 #include "lwip/dhcp.h"
 #include "lwip/autoip.h"
+#include "lwip/ip4_route.h"
 #include "lwip/prot/iana.h"
 #include "netif/ethernet.h"
 
@@ -98,12 +99,33 @@ struct etharp_entry {
   ip4_addr_t ipaddr;
   struct netif *netif;
   struct eth_addr ethaddr;
+#if ARP_TABLE_HASH_SIZE
+  /** Next entry in the hash bucket (index + 1, 0: none) */
+  netif_addr_idx_t hnext;
+  /** Neighbours in the list of expiring entries (index + 1, 0: none) */
+  netif_addr_idx_t lru_prev;
+  netif_addr_idx_t lru_next;
+#endif /* ARP_TABLE_HASH_SIZE */
   u16_t ctime;
   u8_t state;
 };
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
+#if ARP_TABLE_HASH_SIZE
+/** Heads of the hash chains of used entries (index + 1, 0: none) */
+static netif_addr_idx_t arp_hash[ARP_TABLE_HASH_SIZE];
+/** Entries below this index are in use */
+static netif_addr_idx_t arp_first_free;
+/** Pending and stable (not static) entries, least recently updated first
+    (index + 1, 0: none). Since ctime grows for all of them alike, this is
+    also sorted by decreasing ctime. */
+static netif_addr_idx_t arp_lru_head, arp_lru_tail;
+
+#define ETHARP_HASH(ipaddr) \
+  ((((u32_t)(ip4_addr_get_u32(ipaddr) * 0x9e3779b1UL)) >> 16) % ARP_TABLE_HASH_SIZE)
+#endif /* ARP_TABLE_HASH_SIZE */
+
 #if !LWIP_NETIF_HWADDRHINT
 static netif_addr_idx_t etharp_cached_entry;
 #endif /* !LWIP_NETIF_HWADDRHINT */
@@ -129,6 +151,128 @@ static netif_addr_idx_t etharp_cached_entry;
 #error "ARP_TABLE_SIZE must fit in an s16_t, you have to reduce it in your lwipopts.h"
 #endif
 
+#if ARP_TABLE_HASH_SIZE
+/** Append an entry to the young end of the LRU list */
+static void
+etharp_lru_append(netif_addr_idx_t i)
+{
+  arp_table[i].lru_prev = arp_lru_tail;
+  arp_table[i].lru_next = 0;
+  if (arp_lru_tail != 0) {
+    arp_table[arp_lru_tail - 1].lru_next = (netif_addr_idx_t)(i + 1);
+  } else {
+    arp_lru_head = (netif_addr_idx_t)(i + 1);
+  }
+  arp_lru_tail = (netif_addr_idx_t)(i + 1);
+}
+
+/** Remove an entry from the LRU list if it is on it */
+static void
+etharp_lru_unlink(netif_addr_idx_t i)
+{
+  if ((arp_table[i].lru_prev == 0) && (arp_lru_head != i + 1)) {
+    /* not on the list (static entry) */
+    return;
+  }
+  if (arp_table[i].lru_prev != 0) {
+    arp_table[arp_table[i].lru_prev - 1].lru_next = arp_table[i].lru_next;
+  } else {
+    arp_lru_head = arp_table[i].lru_next;
+  }
+  if (arp_table[i].lru_next != 0) {
+    arp_table[arp_table[i].lru_next - 1].lru_prev = arp_table[i].lru_prev;
+  } else {
+    arp_lru_tail = arp_table[i].lru_prev;
+  }
+  arp_table[i].lru_prev = 0;
+  arp_table[i].lru_next = 0;
+}
+
+/**
+ * Find the first empty entry, like the linear search does. This only runs
+ * when a new neighbor is added and mostly finds the entry just freed.
+ *
+ * @return the entry's index or ARP_TABLE_SIZE if the table is full
+ */
+static netif_addr_idx_t
+etharp_hash_alloc(void)
+{
+  netif_addr_idx_t i;
+  for (i = arp_first_free; i < ARP_TABLE_SIZE; i++) {
+    if (arp_table[i].state == ETHARP_STATE_EMPTY) {
+      break;
+    }
+  }
+  arp_first_free = i;
+  return i;
+}
+
+/** Insert a new entry (with its IP address set) into its hash bucket and
+    at the young end of the LRU list */
+static void
+etharp_hash_link(netif_addr_idx_t i)
+{
+  netif_addr_idx_t *head = &arp_hash[ETHARP_HASH(&arp_table[i].ipaddr)];
+  arp_table[i].hnext = *head;
+  *head = (netif_addr_idx_t)(i + 1);
+  etharp_lru_append(i);
+}
+
+/** Remove an entry being freed from its hash bucket and the LRU list */
+static void
+etharp_hash_unlink(netif_addr_idx_t i)
+{
+  netif_addr_idx_t *pi = &arp_hash[ETHARP_HASH(&arp_table[i].ipaddr)];
+  while (*pi != 0) {
+    if (*pi == i + 1) {
+      *pi = arp_table[i].hnext;
+      break;
+    }
+    pi = &arp_table[*pi - 1].hnext;
+  }
+  etharp_lru_unlink(i);
+  if (i < arp_first_free) {
+    arp_first_free = i;
+  }
+}
+#endif /* ARP_TABLE_HASH_SIZE */
+
+/**
+ * Find a stable entry for an IP address (and netif with
+ * ETHARP_TABLE_MATCH_NETIF).
+ *
+ * @return the entry's index or ARP_TABLE_SIZE if there is none
+ */
+static netif_addr_idx_t
+etharp_find_stable(const ip4_addr_t *ipaddr, struct netif *netif)
+{
+  netif_addr_idx_t i;
+
+  LWIP_UNUSED_ARG(netif);
+#if ARP_TABLE_HASH_SIZE
+  for (i = arp_hash[ETHARP_HASH(ipaddr)]; i != 0; i = arp_table[i - 1].hnext) {
+    if ((arp_table[i - 1].state >= ETHARP_STATE_STABLE) &&
+#if ETHARP_TABLE_MATCH_NETIF
+        (arp_table[i - 1].netif == netif) &&
+#endif
+        (ip4_addr_cmp(ipaddr, &arp_table[i - 1].ipaddr))) {
+      return (netif_addr_idx_t)(i - 1);
+    }
+  }
+#else /* ARP_TABLE_HASH_SIZE */
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    if ((arp_table[i].state >= ETHARP_STATE_STABLE) &&
+#if ETHARP_TABLE_MATCH_NETIF
+        (arp_table[i].netif == netif) &&
+#endif
+        (ip4_addr_cmp(ipaddr, &arp_table[i].ipaddr))) {
+      return i;
+    }
+  }
+#endif /* ARP_TABLE_HASH_SIZE */
+  return ARP_TABLE_SIZE;
+}
+
 
 static err_t etharp_request_dst(struct netif *netif, const ip4_addr_t *ipaddr, const struct eth_addr *hw_dst_addr);
 static err_t etharp_raw(struct netif *netif,
@@ -176,8 +320,12 @@ etharp_free_entry(int i)
     free_etharp_q(arp_table[i].q);
     arp_table[i].q = NULL;
   }
+#if ARP_TABLE_HASH_SIZE
+  etharp_hash_unlink((netif_addr_idx_t)i);
+#endif /* ARP_TABLE_HASH_SIZE */
   /* recycle entry for re-use */
   arp_table[i].state = ETHARP_STATE_EMPTY;
+  IP4_FORWARD_CACHE_FLUSH();
 #ifdef LWIP_DEBUG
   /* for debugging, clean out the complete entry */
   arp_table[i].ctime = 0;
@@ -231,6 +379,95 @@ etharp_tmr(void)
   }
 }
 
+#if ARP_TABLE_HASH_SIZE
+/**
+ * Search the ARP table for a matching or new entry, using the hash index.
+ * Works like the linear etharp_find_entry() below: the LRU list provides the
+ * entries to recycle in the same order of preference.
+ *
+ * @param ipaddr IP address to find in ARP cache, or to add if not found.
+ * @param flags See @ref etharp_state
+ * @param netif netif related to this address (used for NETIF_HWADDRHINT)
+ *
+ * @return The ARP entry index that matched or is created, ERR_MEM if no
+ * entry is found or could be recycled.
+ */
+static s16_t
+etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
+{
+  netif_addr_idx_t i;
+
+  LWIP_UNUSED_ARG(netif);
+
+  if (ipaddr != NULL) {
+    for (i = arp_hash[ETHARP_HASH(ipaddr)]; i != 0; i = arp_table[i - 1].hnext) {
+      if ((arp_table[i - 1].state != ETHARP_STATE_EMPTY) &&
+          ip4_addr_cmp(ipaddr, &arp_table[i - 1].ipaddr)
+#if ETHARP_TABLE_MATCH_NETIF
+          && ((netif == NULL) || (netif == arp_table[i - 1].netif))
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+         ) {
+        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: found matching entry %d\n", (int)(i - 1)));
+        return (s16_t)(i - 1);
+      }
+    }
+  }
+
+  /* don't create new entry, only search? */
+  if ((flags & ETHARP_FLAG_FIND_ONLY) != 0) {
+    return (s16_t)ERR_MEM;
+  }
+
+  i = etharp_hash_alloc();
+  if (i == ARP_TABLE_SIZE) {
+    netif_addr_idx_t j, old_pending = 0, old_queue = 0;
+
+    if ((flags & ETHARP_FLAG_TRY_HARD) == 0) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: no empty entry found and not allowed to recycle\n"));
+      return (s16_t)ERR_MEM;
+    }
+    /* choose the least destructive entry to recycle, oldest first:
+       a stable entry, else a pending one without, else one with queued packets */
+    for (j = arp_lru_head; j != 0; j = arp_table[j - 1].lru_next) {
+      if (arp_table[j - 1].state >= ETHARP_STATE_STABLE) {
+        /* no queued packets should exist on stable entries */
+        LWIP_ASSERT("arp_table[j - 1].q == NULL", arp_table[j - 1].q == NULL);
+        break;
+      }
+      if (arp_table[j - 1].q == NULL) {
+        if (old_pending == 0) {
+          old_pending = j;
+        }
+      } else if (old_queue == 0) {
+        old_queue = j;
+      }
+    }
+    if (j == 0) {
+      j = (old_pending != 0) ? old_pending : old_queue;
+      if (j == 0) {
+        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: no empty or recyclable entries found\n"));
+        return (s16_t)ERR_MEM;
+      }
+    }
+    LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: recycling entry %d\n", (int)(j - 1)));
+    etharp_free_entry(j - 1);
+    i = etharp_hash_alloc();
+    LWIP_ASSERT("recycled entry is free", i == j - 1);
+  }
+
+  /* IP address given? */
+  if (ipaddr != NULL) {
+    /* set IP address */
+    ip4_addr_copy(arp_table[i].ipaddr, *ipaddr);
+  }
+  arp_table[i].ctime = 0;
+#if ETHARP_TABLE_MATCH_NETIF
+  arp_table[i].netif = netif;
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+  etharp_hash_link(i);
+  return (s16_t)i;
+}
+#else /* ARP_TABLE_HASH_SIZE */
 /**
  * Search the ARP table for a matching or new entry.
  *
@@ -399,6 +636,7 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
 #endif /* ETHARP_TABLE_MATCH_NETIF */
   return (s16_t)i;
 }
+#endif /* ARP_TABLE_HASH_SIZE */
 
 /**
  * Update (or insert) a IP/MAC address pair in the ARP cache.
@@ -422,6 +660,9 @@ static err_t
 etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct eth_addr *ethaddr, u8_t flags)
 {
   s16_t i;
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+  u8_t was_stable;
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
   LWIP_ASSERT("netif->hwaddr_len == ETH_HWADDR_LEN", netif->hwaddr_len == ETH_HWADDR_LEN);
   LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_update_arp_entry: %"U16_F".%"U16_F".%"U16_F".%"U16_F" - %02"X16_F":%02"X16_F":%02"X16_F":%02"X16_F":%02"X16_F":%02"X16_F"\n",
               ip4_addr1_16(ipaddr), ip4_addr2_16(ipaddr), ip4_addr3_16(ipaddr), ip4_addr4_16(ipaddr),
@@ -440,6 +681,9 @@ etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct et
   if (i < 0) {
     return (err_t)i;
   }
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+  was_stable = (arp_table[i].state >= ETHARP_STATE_STABLE);
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
 
 #if ETHARP_SUPPORT_STATIC_ENTRIES
   if (flags & ETHARP_FLAG_STATIC_ENTRY) {
@@ -455,6 +699,14 @@ etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct et
     arp_table[i].state = ETHARP_STATE_STABLE;
   }
 
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+  if (!was_stable || (arp_table[i].netif != netif) ||
+      (memcmp(&arp_table[i].ethaddr, ethaddr, ETH_HWADDR_LEN) != 0)) {
+    /* forwarded flows may have cached the old address, or found no
+       resolved next hop and use etharp_output() until the next flush */
+    IP4_FORWARD_CACHE_FLUSH();
+  }
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
   /* record network interface */
   arp_table[i].netif = netif;
   /* insert in SNMP ARP index tree */
@@ -465,6 +717,16 @@ etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct et
   SMEMCPY(&arp_table[i].ethaddr, ethaddr, ETH_HWADDR_LEN);
   /* reset time stamp */
   arp_table[i].ctime = 0;
+#if ARP_TABLE_HASH_SIZE
+  /* move to the young end of the LRU list; static entries never expire */
+  etharp_lru_unlink((netif_addr_idx_t)i);
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+  if (arp_table[i].state != ETHARP_STATE_STATIC)
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+  {
+    etharp_lru_append((netif_addr_idx_t)i);
+  }
+#endif /* ARP_TABLE_HASH_SIZE */
   /* this is where we will send out queued packets! */
 #if ARP_QUEUEING
   while (arp_table[i].q != NULL) {
@@ -769,6 +1031,43 @@ etharp_output_to_arp_index(struct netif *netif, struct pbuf *q, netif_addr_idx_t
   return ethernet_output(netif, q, (struct eth_addr *)(netif->hwaddr), &arp_table[arp_idx].ethaddr, ETHTYPE_IP);
 }
 
+/**
+ * Select the next hop for a unicast destination outside the netif's network:
+ * the gateway given by LWIP_HOOK_ETHARP_GET_GW, by the routing table or the
+ * netif's default gateway.
+ *
+ * @return the next hop or NULL if there is no route
+ */
+static const ip4_addr_t *
+etharp_get_gw(struct netif *netif, const ip4_addr_t *ipaddr)
+{
+  const ip4_addr_t *gw;
+
+  LWIP_UNUSED_ARG(gw);
+#ifdef LWIP_HOOK_ETHARP_GET_GW
+  /* For advanced routing, a single default gateway might not be enough, so get
+     the IP address of the gateway to handle the current destination address. */
+  gw = LWIP_HOOK_ETHARP_GET_GW(netif, ipaddr);
+  if (gw != NULL) {
+    return gw;
+  }
+#endif /* LWIP_HOOK_ETHARP_GET_GW */
+#if LWIP_IPV4_ROUTE_TABLE
+  /* next hop of a route via this netif? */
+  gw = ip4_route_table_gw(netif, ipaddr);
+  if (gw != NULL) {
+    return gw;
+  }
+#endif /* LWIP_IPV4_ROUTE_TABLE */
+  /* interface has default gateway? */
+  if (!ip4_addr_isany_val(*netif_ip4_gw(netif))) {
+    /* send to hardware address of default gateway IP address */
+    return netif_ip4_gw(netif);
+  }
+  /* no default gateway available */
+  return NULL;
+}
+
 /**
  * Resolve and fill-in Ethernet address header for outgoing IP packet.
  *
@@ -833,22 +1132,10 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
       if (!ip4_addr_islinklocal(&iphdr->src))
 #endif /* LWIP_AUTOIP */
       {
-#ifdef LWIP_HOOK_ETHARP_GET_GW
-        /* For advanced routing, a single default gateway might not be enough, so get
-           the IP address of the gateway to handle the current destination address. */
-        dst_addr = LWIP_HOOK_ETHARP_GET_GW(netif, ipaddr);
-        if (dst_addr == NULL)
-#endif /* LWIP_HOOK_ETHARP_GET_GW */
-        {
-          /* interface has default gateway? */
-          if (!ip4_addr_isany_val(*netif_ip4_gw(netif))) {
-            /* send to hardware address of default gateway IP address */
-            dst_addr = netif_ip4_gw(netif);
-            /* no default gateway available */
-          } else {
-            /* no route to destination error (default gateway missing) */
-            return ERR_RTE;
-          }
+        dst_addr = etharp_get_gw(netif, ipaddr);
+        if (dst_addr == NULL) {
+          /* no route to destination error (default gateway missing) */
+          return ERR_RTE;
         }
       }
     }
@@ -874,16 +1161,11 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
 
     /* find stable entry: do this here since this is a critical path for
        throughput and etharp_find_entry() is kind of slow */
-    for (i = 0; i < ARP_TABLE_SIZE; i++) {
-      if ((arp_table[i].state >= ETHARP_STATE_STABLE) &&
-#if ETHARP_TABLE_MATCH_NETIF
-          (arp_table[i].netif == netif) &&
-#endif
-          (ip4_addr_cmp(dst_addr, &arp_table[i].ipaddr))) {
-        /* found an existing, stable entry */
-        ETHARP_SET_ADDRHINT(netif, i);
-        return etharp_output_to_arp_index(netif, q, i);
-      }
+    i = etharp_find_stable(dst_addr, netif);
+    if (i < ARP_TABLE_SIZE) {
+      /* found an existing, stable entry */
+      ETHARP_SET_ADDRHINT(netif, i);
+      return etharp_output_to_arp_index(netif, q, i);
     }
     /* no stable entry found, use the (slower) query function:
        queue on destination Ethernet address belonging to ipaddr */
@@ -896,6 +1178,71 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
   return ethernet_output(netif, q, (struct eth_addr *)(netif->hwaddr), dest, ETHTYPE_IP);
 }
 
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+/**
+ * Get the ARP table entry etharp_output() would currently send a unicast
+ * packet to 'ipaddr' through (the next hop's stable entry).
+ * Used by ip4_forward() to fill its flow cache, which is flushed whenever
+ * an entry is freed, changes its address or becomes stable. Like
+ * etharp_output(), this assumes the packet's source address is not
+ * link-local.
+ *
+ * @param netif the netif the packet will be sent on
+ * @param ipaddr the packet's destination address
+ * @param arp_idx receives the index of the next hop's ARP entry
+ * @return ERR_OK if 'arp_idx' was filled, ERR_ARG for non-unicast destinations,
+ *         ERR_RTE if there is no next hop and ERR_VAL if it is not resolved
+ */
+err_t
+etharp_get_nexthop_index(struct netif *netif, const ip4_addr_t *ipaddr, netif_addr_idx_t *arp_idx)
+{
+  const ip4_addr_t *dst_addr = ipaddr;
+  netif_addr_idx_t i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("netif != NULL", netif != NULL);
+  LWIP_ASSERT("ipaddr != NULL", ipaddr != NULL);
+  LWIP_ASSERT("arp_idx != NULL", arp_idx != NULL);
+
+  if (ip4_addr_isbroadcast(ipaddr, netif) || ip4_addr_ismulticast(ipaddr)) {
+    return ERR_ARG;
+  }
+  if (!ip4_addr_netcmp(ipaddr, netif_ip4_addr(netif), netif_ip4_netmask(netif)) &&
+      !ip4_addr_islinklocal(ipaddr)) {
+    dst_addr = etharp_get_gw(netif, ipaddr);
+    if (dst_addr == NULL) {
+      return ERR_RTE;
+    }
+  }
+  i = etharp_find_stable(dst_addr, netif);
+  if (i == ARP_TABLE_SIZE) {
+    return ERR_VAL;
+  }
+  *arp_idx = i;
+  return ERR_OK;
+}
+
+/**
+ * Send a packet to the next hop returned by etharp_get_nexthop_index().
+ * Like etharp_output(), this re-requests the entry before it expires, so
+ * that flows using it don't stall when it would age out.
+ *
+ * @param netif the netif the packet is sent on
+ * @param q the packet (p->payload points to the IP header)
+ * @param arp_idx index returned by etharp_get_nexthop_index() (the forward
+ *        flow cache holding it must not have been flushed since)
+ * @return the result of ethernet_output()
+ */
+err_t
+etharp_output_to_index(struct netif *netif, struct pbuf *q, netif_addr_idx_t arp_idx)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ASSERT("arp_idx < ARP_TABLE_SIZE", arp_idx < ARP_TABLE_SIZE);
+  LWIP_ASSERT("arp_table[arp_idx].netif == netif", arp_table[arp_idx].netif == netif);
+  return etharp_output_to_arp_index(netif, q, arp_idx);
+}
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
+
 /**
  * Send an ARP request for the given IP address and/or queue a packet.
  *
@@ -392,7 +392,7 @@ icmp_send_response(struct pbuf *p, u8_t type, u8_t code)
     icmphdr->chksum = 0;
 #if CHECKSUM_GEN_ICMP
     IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP) {
-      icmphdr->chksum = inet_chksum(icmphdr, q->len);
+      icmphdr->chksum = inet_chksum(icmphdr, (u16_t)q->len);
     }
 #endif
     ICMP_STATS_INC(icmp.xmit);
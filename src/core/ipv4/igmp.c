@@ -344,7 +344,7 @@ igmp_input(struct pbuf *p, struct netif *inp, const ip4_addr_t *dest)
 
   /* Now calculate and check the checksum */
   igmp = (struct igmp_msg *)p->payload;
-  if (inet_chksum(igmp, p->len)) {
+  if (inet_chksum(igmp, (u16_t)p->len)) {
     pbuf_free(p);
     IGMP_STATS_INC(igmp.chkerr);
     LWIP_DEBUGF(IGMP_DEBUG, ("igmp_input: checksum error\n"));
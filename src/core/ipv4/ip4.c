@@ -46,6 +46,8 @@
 #include "lwip/def.h"
 #include "lwip/mem.h"
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_route.h"
+#include "lwip/etharp.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/netif.h"
 #include "lwip/icmp.h"
@@ -56,6 +58,7 @@
 #include "lwip/autoip.h"
 #include "lwip/stats.h"
 #include "lwip/prot/iana.h"
+#include "netif/ethernet.h"
 
 #include <string.h>
 
@@ -200,6 +203,13 @@ ip4_route(const ip4_addr_t *dest)
   }
 #endif /* LWIP_NETIF_LOOPBACK && !LWIP_HAVE_LOOPIF */
 
+#if LWIP_IPV4_ROUTE_TABLE
+  netif = ip4_route_table_netif(dest);
+  if (netif != NULL) {
+    return netif;
+  }
+#endif /* LWIP_IPV4_ROUTE_TABLE */
+
 #ifdef LWIP_HOOK_IP4_ROUTE_SRC
   netif = LWIP_HOOK_IP4_ROUTE_SRC(NULL, dest);
   if (netif != NULL) {
@@ -268,11 +278,73 @@ ip4_canforward(struct pbuf *p)
   return 1;
 }
 
+#if IP_FORWARD_FLOW_CACHE_SIZE
+/** Cache the next hop's ARP entry for netifs using etharp_output() */
+#define IP4_FORWARD_CACHE_HWADDR LWIP_ARP
+
+/** ip4_forward_cache_entry.nexthop: not looked up yet */
+#define IP4_FORWARD_NEXTHOP_UNKNOWN 0
+/** ip4_forward_cache_entry.nexthop: not resolved, use etharp_output() */
+#define IP4_FORWARD_NEXTHOP_OUTPUT  1
+/** ip4_forward_cache_entry.nexthop: send via the ARP entry 'arp_idx' */
+#define IP4_FORWARD_NEXTHOP_ARP     2
+
+/** One forwarding decision, valid while 'gen' is the current generation */
+struct ip4_forward_cache_entry {
+  ip4_addr_t dest;
+#if LWIP_IPV4_SRC_ROUTING
+  ip4_addr_t src;
+#endif /* LWIP_IPV4_SRC_ROUTING */
+  struct netif *netif;
+#if IP4_FORWARD_CACHE_HWADDR
+  /** IP4_FORWARD_NEXTHOP_* */
+  u8_t nexthop;
+  netif_addr_idx_t arp_idx;
+#endif /* IP4_FORWARD_CACHE_HWADDR */
+  u16_t gen;
+};
+
+static struct ip4_forward_cache_entry ip4_forward_cache[IP_FORWARD_FLOW_CACHE_SIZE];
+/** Current generation, never 0 so that zeroed entries are invalid */
+static u16_t ip4_forward_cache_gen = 1;
+
+#if LWIP_IPV4_SRC_ROUTING
+#define IP4_FORWARD_CACHE_KEY(src, dest) (ip4_addr_get_u32(dest) ^ ip4_addr_get_u32(src))
+#define IP4_FORWARD_CACHE_MATCH(e, s, d) (ip4_addr_cmp(&(e)->dest, d) && ip4_addr_cmp(&(e)->src, s))
+#else /* LWIP_IPV4_SRC_ROUTING */
+#define IP4_FORWARD_CACHE_KEY(src, dest) ip4_addr_get_u32(dest)
+#define IP4_FORWARD_CACHE_MATCH(e, s, d) ip4_addr_cmp(&(e)->dest, d)
+#endif /* LWIP_IPV4_SRC_ROUTING */
+/* multiplicative hashing, the high bits of the product mix all key bits */
+#define IP4_FORWARD_CACHE_IDX(src, dest) \
+  ((((u32_t)(IP4_FORWARD_CACHE_KEY(src, dest) * 0x9e3779b1UL)) >> 16) % IP_FORWARD_FLOW_CACHE_SIZE)
+
+/**
+ * Invalidate all entries of the forwarding flow cache. Called when a netif,
+ * a route or an ARP entry changes; must also be called by the application
+ * when the decisions of its routing hooks change.
+ */
+void
+ip4_forward_cache_flush(void)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  ip4_forward_cache_gen++;
+  if (ip4_forward_cache_gen == 0) {
+    /* wrapped: make sure no stale entry becomes valid again */
+    memset(ip4_forward_cache, 0, sizeof(ip4_forward_cache));
+    ip4_forward_cache_gen = 1;
+  }
+}
+#endif /* IP_FORWARD_FLOW_CACHE_SIZE */
+
 /**
  * Forwards an IP packet. It finds an appropriate route for the
  * packet, decrements the TTL value of the packet, adjusts the
  * checksum and outputs the packet on the appropriate interface.
  *
+ * With IP_FORWARD_FLOW_CACHE_SIZE, the route (and the next hop's ARP entry
+ * for etharp netifs) of established flows is taken from the flow cache.
+ *
  * @param p the packet to forward (p->payload points to IP header)
  * @param iphdr the IP header of the input packet
  * @param inp the netif on which this packet was received
@@ -281,6 +353,10 @@ static void
 ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
 {
   struct netif *netif;
+  u32_t chksum;
+#if IP_FORWARD_FLOW_CACHE_SIZE
+  struct ip4_forward_cache_entry *entry;
+#endif /* IP_FORWARD_FLOW_CACHE_SIZE */
 
   PERF_START;
   LWIP_UNUSED_ARG(inp);
@@ -297,14 +373,35 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
     goto return_noroute;
   }
 
-  /* Find network interface where to forward this IP packet to. */
-  netif = ip4_route_src(ip4_current_src_addr(), ip4_current_dest_addr());
-  if (netif == NULL) {
-    LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: no forwarding route for %"U16_F".%"U16_F".%"U16_F".%"U16_F" found\n",
-                           ip4_addr1_16(ip4_current_dest_addr()), ip4_addr2_16(ip4_current_dest_addr()),
-                           ip4_addr3_16(ip4_current_dest_addr()), ip4_addr4_16(ip4_current_dest_addr())));
-    /* @todo: send ICMP_DUR_NET? */
-    goto return_noroute;
+#if IP_FORWARD_FLOW_CACHE_SIZE
+  entry = &ip4_forward_cache[IP4_FORWARD_CACHE_IDX(ip4_current_src_addr(), ip4_current_dest_addr())];
+  if ((entry->gen == ip4_forward_cache_gen) &&
+      IP4_FORWARD_CACHE_MATCH(entry, ip4_current_src_addr(), ip4_current_dest_addr())) {
+    IP_STATS_INC(ip.cachehit);
+    netif = entry->netif;
+  } else
+#endif /* IP_FORWARD_FLOW_CACHE_SIZE */
+  {
+    /* Find network interface where to forward this IP packet to. */
+    netif = ip4_route_src(ip4_current_src_addr(), ip4_current_dest_addr());
+    if (netif == NULL) {
+      LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: no forwarding route for %"U16_F".%"U16_F".%"U16_F".%"U16_F" found\n",
+                             ip4_addr1_16(ip4_current_dest_addr()), ip4_addr2_16(ip4_current_dest_addr()),
+                             ip4_addr3_16(ip4_current_dest_addr()), ip4_addr4_16(ip4_current_dest_addr())));
+      /* @todo: send ICMP_DUR_NET? */
+      goto return_noroute;
+    }
+#if IP_FORWARD_FLOW_CACHE_SIZE
+    ip4_addr_copy(entry->dest, *ip4_current_dest_addr());
+#if LWIP_IPV4_SRC_ROUTING
+    ip4_addr_copy(entry->src, *ip4_current_src_addr());
+#endif /* LWIP_IPV4_SRC_ROUTING */
+    entry->netif = netif;
+#if IP4_FORWARD_CACHE_HWADDR
+    entry->nexthop = IP4_FORWARD_NEXTHOP_UNKNOWN;
+#endif /* IP4_FORWARD_CACHE_HWADDR */
+    entry->gen = ip4_forward_cache_gen;
+#endif /* IP_FORWARD_FLOW_CACHE_SIZE */
   }
 #if !IP_FORWARD_ALLOW_TX_ON_RX_NETIF
   /* Do not forward packets onto the same network interface on which
@@ -329,12 +426,12 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
     return;
   }
 
-  /* Incrementally update the IP checksum. */
-  if (IPH_CHKSUM(iphdr) >= PP_HTONS(0xffffU - 0x100)) {
-    IPH_CHKSUM_SET(iphdr, (u16_t)(IPH_CHKSUM(iphdr) + PP_HTONS(0x100) + 1));
-  } else {
-    IPH_CHKSUM_SET(iphdr, (u16_t)(IPH_CHKSUM(iphdr) + PP_HTONS(0x100)));
-  }
+  /* Incrementally update the IP checksum (RFC 1624, eqn. 3):
+     HC' = ~(~HC + ~m + m'), where the TTL/protocol word m' = m - 0x100,
+     so ~m + m' is the constant 0xfeff. */
+  chksum = (u32_t)(u16_t)~lwip_ntohs(IPH_CHKSUM(iphdr)) + 0xfeffUL;
+  chksum = (chksum & 0xffffUL) + (chksum >> 16);
+  IPH_CHKSUM_SET(iphdr, lwip_htons((u16_t)~chksum));
 
   LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: forwarding packet to %"U16_F".%"U16_F".%"U16_F".%"U16_F"\n",
                          ip4_addr1_16(ip4_current_dest_addr()), ip4_addr2_16(ip4_current_dest_addr()),
@@ -361,6 +458,26 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
     }
     return;
   }
+#if IP_FORWARD_FLOW_CACHE_SIZE && IP4_FORWARD_CACHE_HWADDR
+  if ((netif->output == etharp_output)
+#if LWIP_AUTOIP
+      /* etharp_output() never sends these via a router */
+      && !ip4_addr_islinklocal(ip4_current_src_addr())
+#endif /* LWIP_AUTOIP */
+     ) {
+    if (entry->nexthop == IP4_FORWARD_NEXTHOP_UNKNOWN) {
+      /* look the next hop up once: if it is not resolved yet, the cache is
+         flushed when its ARP entry becomes stable */
+      entry->nexthop = (etharp_get_nexthop_index(netif, ip4_current_dest_addr(), &entry->arp_idx) == ERR_OK) ?
+                       IP4_FORWARD_NEXTHOP_ARP : IP4_FORWARD_NEXTHOP_OUTPUT;
+    }
+    if (entry->nexthop == IP4_FORWARD_NEXTHOP_ARP) {
+      /* skip the ARP table lookup, etharp still refreshes the entry */
+      etharp_output_to_index(netif, p, entry->arp_idx);
+      return;
+    }
+  }
+#endif /* IP_FORWARD_FLOW_CACHE_SIZE && IP4_FORWARD_CACHE_HWADDR */
   /* transmit pbuf on chosen interface */
   netif->output(netif, p, ip4_current_dest_addr());
   return;
@@ -899,6 +1016,15 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
       MIB2_STATS_INC(mib2.ipoutdiscards);
       return ERR_BUF;
     }
+#if LWIP_PBUF_LEN_32BIT
+    if (p->tot_len > 0xFFFF) {
+      LWIP_DEBUGF(IP_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("ip4_output: packet too big for IP total length field\n"));
+      pbuf_remove_header(p, ip_hlen);
+      IP_STATS_INC(ip.err);
+      MIB2_STATS_INC(mib2.ipoutdiscards);
+      return ERR_VAL;
+    }
+#endif /* LWIP_PBUF_LEN_32BIT */
 
     iphdr = (struct ip_hdr *)p->payload;
     LWIP_ASSERT("check that first pbuf can hold struct ip_hdr",
@@ -922,7 +1048,7 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
 #if CHECKSUM_GEN_IP_INLINE
     chk_sum += PP_NTOHS(tos | (iphdr->_v_hl << 8));
 #endif /* CHECKSUM_GEN_IP_INLINE */
-    IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+    IPH_LEN_SET(iphdr, lwip_htons((u16_t)p->tot_len));
 #if CHECKSUM_GEN_IP_INLINE
     chk_sum += iphdr->_len;
 #endif /* CHECKSUM_GEN_IP_INLINE */
@@ -108,12 +108,21 @@ PACK_STRUCT_END
 #define IP_ADDRESSES_AND_ID_MATCH(iphdrA, iphdrB)  \
   (ip4_addr_cmp(&(iphdrA)->src, &(iphdrB)->src) && \
    ip4_addr_cmp(&(iphdrA)->dest, &(iphdrB)->dest) && \
-   IPH_ID(iphdrA) == IPH_ID(iphdrB)) ? 1 : 0
+   IPH_ID(iphdrA) == IPH_ID(iphdrB) && \
+   IPH_PROTO(iphdrA) == IPH_PROTO(iphdrB)) ? 1 : 0
 
 /* global variables */
 static struct ip_reassdata *reassdatagrams;
 static u16_t ip_reass_pbufcount;
 
+#if IP_REASS_HASH_SIZE
+/** Datagrams being reassembled, hashed by source, destination, ID and protocol */
+static struct ip_reassdata *reass_hash[IP_REASS_HASH_SIZE];
+
+#define IP_REASS_HASH(iphdr) ((u16_t)((((u32_t)(((iphdr)->src.addr ^ (iphdr)->dest.addr ^ \
+  ((u32_t)IPH_PROTO(iphdr) << 16) ^ IPH_ID(iphdr)) * 0x9e3779b1UL)) >> 16) % IP_REASS_HASH_SIZE))
+#endif /* IP_REASS_HASH_SIZE */
+
 /* function prototypes */
 static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
 static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
@@ -213,9 +222,84 @@ ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *p
   return pbufs_freed;
 }
 
+#if IP_REASS_SOURCE_QUOTA
+/**
+ * Count the pbufs enqueued for datagrams from one source.
+ *
+ * @param src the source address
+ * @return the number of pbufs enqueued
+ */
+static u32_t
+ip_reass_source_pbufs(const ip4_addr_p_t *src)
+{
+  struct ip_reassdata *r;
+  u32_t pbufs = 0;
+
+  for (r = reassdatagrams; r != NULL; r = r->next) {
+    if (ip4_addr_cmp(&r->iphdr.src, src)) {
+      pbufs += r->clen;
+    }
+  }
+  return pbufs;
+}
+
+/**
+ * Check that enqueueing a fragment keeps its source within
+ * IP_REASS_MAX_PBUFS_PER_SOURCE, freeing the oldest other datagrams of the
+ * same source if needed. The datagram 'fraghdr' belongs to is not freed!
+ *
+ * @param fraghdr IP header of the current fragment
+ * @param clen number of pbufs needed to enqueue
+ * @return 1 if the fragment may be enqueued, 0 otherwise
+ */
+static int
+ip_reass_check_source_quota(struct ip_hdr *fraghdr, u16_t clen)
+{
+#if IP_REASS_FREE_OLDEST
+  struct ip_reassdata *r, *oldest, *prev, *oldest_prev;
+  u32_t pbufs;
+#endif /* IP_REASS_FREE_OLDEST */
+
+  if ((u32_t)ip_reass_pbufcount + clen <= IP_REASS_MAX_PBUFS_PER_SOURCE) {
+    /* not even all sources together exceed the quota */
+    return 1;
+  }
+#if IP_REASS_FREE_OLDEST
+  for (;;) {
+    pbufs = clen;
+    oldest = NULL;
+    oldest_prev = NULL;
+    for (r = reassdatagrams, prev = NULL; r != NULL; prev = r, r = r->next) {
+      if (ip4_addr_cmp(&r->iphdr.src, &fraghdr->src)) {
+        pbufs += r->clen;
+        if (!IP_ADDRESSES_AND_ID_MATCH(&r->iphdr, fraghdr)) {
+          /* Not the same datagram as fraghdr */
+          if ((oldest == NULL) || (r->timer <= oldest->timer)) {
+            oldest = r;
+            oldest_prev = prev;
+          }
+        }
+      }
+    }
+    if (pbufs <= IP_REASS_MAX_PBUFS_PER_SOURCE) {
+      return 1;
+    }
+    if (oldest == NULL) {
+      return 0;
+    }
+    ip_reass_free_complete_datagram(oldest, oldest_prev);
+  }
+#else /* IP_REASS_FREE_OLDEST */
+  return (ip_reass_source_pbufs(&fraghdr->src) + clen) <= IP_REASS_MAX_PBUFS_PER_SOURCE;
+#endif /* IP_REASS_FREE_OLDEST */
+}
+#endif /* IP_REASS_SOURCE_QUOTA */
+
 #if IP_REASS_FREE_OLDEST
 /**
  * Free the oldest datagram to make room for enqueueing new fragments.
+ * With IP_REASS_MAX_PBUFS_PER_SOURCE, the oldest datagram of the source
+ * holding the most pbufs is freed.
  * The datagram 'fraghdr' belongs to is not freed!
  *
  * @param fraghdr IP header of the current fragment
@@ -232,6 +316,9 @@ ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
   struct ip_reassdata *r, *oldest, *prev, *oldest_prev;
   int pbufs_freed = 0, pbufs_freed_current;
   int other_datagrams;
+#if IP_REASS_SOURCE_QUOTA
+  u32_t pbufs, oldest_pbufs = 0;
+#endif /* IP_REASS_SOURCE_QUOTA */
 
   /* Free datagrams until being allowed to enqueue 'pbufs_needed' pbufs,
    * but don't free the datagram that 'fraghdr' belongs to! */
@@ -245,6 +332,16 @@ ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
       if (!IP_ADDRESSES_AND_ID_MATCH(&r->iphdr, fraghdr)) {
         /* Not the same datagram as fraghdr */
         other_datagrams++;
+#if IP_REASS_SOURCE_QUOTA
+        pbufs = ip_reass_source_pbufs(&r->iphdr.src);
+        if ((oldest == NULL) || (pbufs > oldest_pbufs) ||
+            ((pbufs == oldest_pbufs) && (r->timer <= oldest->timer))) {
+          /* the source holds the most pbufs, older than the previous oldest */
+          oldest = r;
+          oldest_prev = prev;
+          oldest_pbufs = pbufs;
+        }
+#else /* IP_REASS_SOURCE_QUOTA */
         if (oldest == NULL) {
           oldest = r;
           oldest_prev = prev;
@@ -253,6 +350,7 @@ ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
           oldest = r;
           oldest_prev = prev;
         }
+#endif /* IP_REASS_SOURCE_QUOTA */
       }
       if (r->next != NULL) {
         prev = r;
@@ -306,6 +404,13 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
   /* copy the ip header for later tests and input */
   /* @todo: no ip options supported? */
   SMEMCPY(&(ipr->iphdr), fraghdr, IP_HLEN);
+#if IP_REASS_HASH_SIZE
+  {
+    u16_t h = IP_REASS_HASH(fraghdr);
+    ipr->hnext = reass_hash[h];
+    reass_hash[h] = ipr;
+  }
+#endif /* IP_REASS_HASH_SIZE */
   return ipr;
 }
 
@@ -316,6 +421,16 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
 static void
 ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
 {
+#if IP_REASS_HASH_SIZE
+  struct ip_reassdata **link = &reass_hash[IP_REASS_HASH(&ipr->iphdr)];
+
+  while (*link != ipr) {
+    LWIP_ASSERT("datagram not in its hash bucket", *link != NULL);
+    link = &(*link)->hnext;
+  }
+  *link = ipr->hnext;
+#endif /* IP_REASS_HASH_SIZE */
+
   /* dequeue the reass struct  */
   if (reassdatagrams == ipr) {
     /* it was the first in the list */
@@ -333,8 +448,9 @@ ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
 /**
  * Chain a new pbuf into the pbuf list that composes the datagram.  The pbuf list
  * will grow over time as  new pbufs are rx.
- * Also checks that the datagram passes basic continuity checks (if the last
- * fragment was received at least once).
+ * Fragments arriving in order are appended to the last one without walking
+ * the list, and the datagram is known to be complete once the received payload
+ * adds up to the length given by the last fragment.
  * @param ipr points to the reassembly state
  * @param new_p points to the pbuf for the current fragment
  * @param is_last is 1 if this pbuf has MF==0 (ipr->flags not updated yet)
@@ -345,10 +461,9 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
 {
   struct ip_reass_helper *iprh, *iprh_tmp, *iprh_prev = NULL;
   struct pbuf *q;
-  u16_t offset, len;
+  u16_t offset, len, datagram_len;
   u8_t hlen;
   struct ip_hdr *fraghdr;
-  int valid = 1;
 
   /* Extract length and fragment offset from current fragment */
   fraghdr = (struct ip_hdr *)new_p->payload;
@@ -375,119 +490,112 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
     return IP_REASS_VALIDATE_PBUF_DROPPED;
   }
 
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find one with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
-    iprh_tmp = (struct ip_reass_helper *)q->payload;
-    if (iprh->start < iprh_tmp->start) {
-      /* the new pbuf should be inserted before this */
-      iprh->next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
+  /* Fragments must not reach beyond the end of the datagram. */
+  if ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) {
+    if ((iprh->end > ipr->datagram_len) ||
+        (is_last && (iprh->end != ipr->datagram_len))) {
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
+  } else if (is_last && (ipr->max_end > iprh->end)) {
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+
+  if (ipr->p_last == NULL) {
+    /* this is the first fragment we ever received for this ip datagram */
+    ipr->p = new_p;
+    ipr->p_last = new_p;
+  } else if (iprh->start >= ipr->max_end) {
+    /* this is (for now), the fragment with the highest offset and it does
+     * not overlap any other: chain it to the last fragment */
+    ((struct ip_reass_helper *)ipr->p_last->payload)->next_pbuf = new_p;
+    ipr->p_last = new_p;
+  } else {
+    /* Iterate through until we either get to the end of the list (append),
+     * or we find one with a larger offset (insert). */
+    for (q = ipr->p; q != NULL;) {
+      iprh_tmp = (struct ip_reass_helper *)q->payload;
+      if (iprh->start < iprh_tmp->start) {
+        /* the new pbuf should be inserted before this */
+        iprh->next_pbuf = q;
+        if (iprh_prev != NULL) {
+          /* not the fragment with the lowest offset */
 #if IP_REASS_CHECK_OVERLAP
-        if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
-          /* fragment overlaps with previous or following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
+          if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
+            /* fragment overlaps with previous or following, throw away */
+            return IP_REASS_VALIDATE_PBUF_DROPPED;
+          }
 #endif /* IP_REASS_CHECK_OVERLAP */
-        iprh_prev->next_pbuf = new_p;
-        if (iprh_prev->end != iprh->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      } else {
+          iprh_prev->next_pbuf = new_p;
+        } else {
 #if IP_REASS_CHECK_OVERLAP
-        if (iprh->end > iprh_tmp->start) {
-          /* fragment overlaps with following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
+          if (iprh->end > iprh_tmp->start) {
+            /* fragment overlaps with following, throw away */
+            return IP_REASS_VALIDATE_PBUF_DROPPED;
+          }
 #endif /* IP_REASS_CHECK_OVERLAP */
-        /* fragment with the lowest offset */
-        ipr->p = new_p;
-      }
-      break;
-    } else if (iprh->start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
-      return IP_REASS_VALIDATE_PBUF_DROPPED;
+          /* fragment with the lowest offset */
+          ipr->p = new_p;
+        }
+        break;
+      } else if (iprh->start == iprh_tmp->start) {
+        /* received the same datagram twice: no need to keep the datagram */
+        return IP_REASS_VALIDATE_PBUF_DROPPED;
 #if IP_REASS_CHECK_OVERLAP
-    } else if (iprh->start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
-      return IP_REASS_VALIDATE_PBUF_DROPPED;
+      } else if (iprh->start < iprh_tmp->end) {
+        /* overlap: no need to keep the new datagram */
+        return IP_REASS_VALIDATE_PBUF_DROPPED;
 #endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no holes. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
       }
+      q = iprh_tmp->next_pbuf;
+      iprh_prev = iprh_tmp;
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
-
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= iprh->start);
-#endif /* IP_REASS_CHECK_OVERLAP */
+    if (q == NULL) {
+      /* overlapping the last fragment (only if overlap checks are disabled) */
+      LWIP_ASSERT("sanity check", iprh_prev == (struct ip_reass_helper *)ipr->p_last->payload);
       iprh_prev->next_pbuf = new_p;
-      if (iprh_prev->end != iprh->start) {
-        valid = 0;
-      }
-    } else {
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-                  ipr->p == NULL);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
-      ipr->p = new_p;
+      ipr->p_last = new_p;
     }
   }
+  ipr->recv_len = (u16_t)LWIP_MIN(0xFFFF, (u32_t)ipr->recv_len + len);
+  if (iprh->end > ipr->max_end) {
+    ipr->max_end = iprh->end;
+  }
 
   /* At this point, the validation part begins: */
   /* If we already received the last fragment */
   if (is_last || ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0)) {
-    /* and had no holes so far */
-    if (valid) {
-      /* then check if the rest of the fragments is here */
-      /* Check if the queue starts with the first datagram */
-      if ((ipr->p == NULL) || (((struct ip_reass_helper *)ipr->p->payload)->start != 0)) {
-        valid = 0;
-      } else {
-        /* and check that there are no holes after this datagram */
-        iprh_prev = iprh;
-        q = iprh->next_pbuf;
-        while (q != NULL) {
-          iprh = (struct ip_reass_helper *)q->payload;
-          if (iprh_prev->end != iprh->start) {
-            valid = 0;
-            break;
-          }
-          iprh_prev = iprh;
-          q = iprh->next_pbuf;
+    datagram_len = is_last ? iprh->end : ipr->datagram_len;
+    if (ipr->recv_len >= datagram_len) {
+#if IP_REASS_CHECK_OVERLAP
+      /* fragments neither overlap nor reach beyond the last one, so they
+       * cover the whole datagram */
+      LWIP_ASSERT("sanity check", ((struct ip_reass_helper *)ipr->p->payload)->start == 0);
+      LWIP_ASSERT("sanity check", ipr->p != ipr->p_last);
+      return IP_REASS_VALIDATE_TELEGRAM_FINISHED;
+#else /* IP_REASS_CHECK_OVERLAP */
+      u16_t covered;
+      /* check that the fragments have no holes: fragments may overlap, so
+       * compare against the largest end seen so far, not the previous one */
+      iprh_prev = (struct ip_reass_helper *)ipr->p->payload;
+      if (iprh_prev->start != 0) {
+        return IP_REASS_VALIDATE_PBUF_QUEUED;
+      }
+      covered = iprh_prev->end;
+      for (q = iprh_prev->next_pbuf; q != NULL; q = iprh_tmp->next_pbuf) {
+        iprh_tmp = (struct ip_reass_helper *)q->payload;
+        if (covered < iprh_tmp->start) {
+          return IP_REASS_VALIDATE_PBUF_QUEUED;
         }
-        /* if still valid, all fragments are received
-         * (because to the MF==0 already arrived */
-        if (valid) {
-          LWIP_ASSERT("sanity check", ipr->p != NULL);
-          LWIP_ASSERT("sanity check",
-                      ((struct ip_reass_helper *)ipr->p->payload) != iprh);
-          LWIP_ASSERT("validate_datagram:next_pbuf!=NULL",
-                      iprh->next_pbuf == NULL);
+        if (iprh_tmp->end > covered) {
+          covered = iprh_tmp->end;
         }
       }
+      return IP_REASS_VALIDATE_TELEGRAM_FINISHED;
+#endif /* IP_REASS_CHECK_OVERLAP */
     }
-    /* If valid is 0 here, there are some fragments missing in the middle
+    /* If the datagram is not complete here, there are some fragments missing
      * (since MF == 0 has already arrived). Such datagrams simply time out if
      * no more fragments are received... */
-    return valid ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
   }
   /* If we come here, not all fragments were received, yet! */
   return IP_REASS_VALIDATE_PBUF_QUEUED; /* not yet valid! */
@@ -533,6 +641,15 @@ ip4_reass(struct pbuf *p)
 
   /* Check if we are allowed to enqueue more datagrams. */
   clen = pbuf_clen(p);
+#if IP_REASS_SOURCE_QUOTA
+  if (!ip_reass_check_source_quota(fraghdr, clen)) {
+    /* This source already has too many pbufs enqueued */
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: source quota exceeded: clen=%d, MAX=%d\n",
+                                 clen, IP_REASS_MAX_PBUFS_PER_SOURCE));
+    IPFRAG_STATS_INC(ip_frag.memerr);
+    goto nullreturn;
+  }
+#endif /* IP_REASS_SOURCE_QUOTA */
   if ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
 #if IP_REASS_FREE_OLDEST
     if (!ip_reass_remove_oldest_datagram(fraghdr, clen) ||
@@ -549,9 +666,12 @@ ip4_reass(struct pbuf *p)
     }
   }
 
-  /* Look for the datagram the fragment belongs to in the current datagram queue,
-   * remembering the previous in the queue for later dequeueing. */
+  /* Look for the datagram the fragment belongs to in the current datagram queue. */
+#if IP_REASS_HASH_SIZE
+  for (ipr = reass_hash[IP_REASS_HASH(fraghdr)]; ipr != NULL; ipr = ipr->hnext) {
+#else /* IP_REASS_HASH_SIZE */
   for (ipr = reassdatagrams; ipr != NULL; ipr = ipr->next) {
+#endif /* IP_REASS_HASH_SIZE */
     /* Check if the incoming fragment matches the one currently present
        in the reassembly buffer. If so, we proceed with copying the
        fragment into the buffer. */
@@ -605,6 +725,9 @@ ip4_reass(struct pbuf *p)
      the number of fragments that may be enqueued at any one time
      (overflow checked by testing against IP_REASS_MAX_PBUFS) */
   ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
+#if IP_REASS_SOURCE_QUOTA
+  ipr->clen = (u16_t)(ipr->clen + clen);
+#endif /* IP_REASS_SOURCE_QUOTA */
   if (is_last) {
     u16_t datagram_len = (u16_t)(offset + len);
     ipr->datagram_len = datagram_len;
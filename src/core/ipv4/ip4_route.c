@@ -0,0 +1,380 @@
+/**
+ * @file
+ * IPv4 routing table
+ *
+ * @defgroup ip4_route Routing table
+ * @ingroup ip4
+ * Static IPv4 routes with longest-prefix-match lookup.
+ *
+ * ip4_route() consults this table after the directly connected networks of
+ * all netifs and before the LWIP_HOOK_IP4_ROUTE hooks and the default netif;
+ * etharp_output() uses the gateway of the matching route as next hop.
+ * Several routes may exist for one prefix (e.g. one per uplink); the one with
+ * the lowest metric whose netif is up, has link and has an address is used,
+ * so traffic fails over when an uplink goes down.
+ *
+ * Routes are kept in a path-compressed binary trie, so a lookup visits at
+ * most 33 nodes regardless of the number of routes. Routes come from
+ * MEMP_NUM_IP4_ROUTE, trie nodes from MEMP_NUM_IP4_ROUTE_NODE.
+ * All functions must be called with the core locked (from tcpip_thread or
+ * with LOCK_TCPIP_CORE()).
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip4_route.h"
+#include "lwip/ip4.h"
+#include "lwip/def.h"
+#include "lwip/memp.h"
+
+#include <string.h>
+
+/** netmask (host byte order) of a prefix length */
+#define IP4_ROUTE_MASK(len)       (((len) == 0) ? 0 : (0xffffffffUL << (32 - (len))))
+/** bit 'pos' (0 being the most significant) of an address in host byte order */
+#define IP4_ROUTE_BIT(addr, pos)  (((addr) >> (31 - (pos))) & 1)
+/** a route can only be used if its netif could send right now */
+#define IP4_ROUTE_USABLE(rt)      (netif_is_up((rt)->netif) && netif_is_link_up((rt)->netif) && \
+                                   !ip4_addr_isany_val(*netif_ip4_addr((rt)->netif)))
+
+static struct ip4_route_node *ip4_route_root;
+
+/** Number of leading bits 'a' and 'b' have in common, at most 'max' */
+static u8_t
+ip4_route_common_len(u32_t a, u32_t b, u8_t max)
+{
+  u32_t diff = a ^ b;
+  u8_t len = 0;
+
+  while ((len < max) && ((diff & 0x80000000UL) == 0)) {
+    diff <<= 1;
+    len++;
+  }
+  return len;
+}
+
+static struct ip4_route_node *
+ip4_route_node_new(u32_t prefix, u8_t prefix_len)
+{
+  struct ip4_route_node *node = (struct ip4_route_node *)memp_malloc(MEMP_IP4_ROUTE_NODE);
+  if (node != NULL) {
+    memset(node, 0, sizeof(struct ip4_route_node));
+    node->prefix = prefix;
+    node->prefix_len = prefix_len;
+  }
+  return node;
+}
+
+/**
+ * Find the trie node of a prefix, inserting it if it does not exist yet.
+ * Inserting takes one node, or two if a branch node is needed where the new
+ * prefix and an existing one diverge.
+ *
+ * @return the node or NULL if out of memory
+ */
+static struct ip4_route_node *
+ip4_route_node_get(u32_t prefix, u8_t prefix_len)
+{
+  struct ip4_route_node **pn = &ip4_route_root;
+  struct ip4_route_node *n, *node, *branch;
+  u8_t common;
+
+  while ((n = *pn) != NULL) {
+    common = ip4_route_common_len(n->prefix, prefix, LWIP_MIN(n->prefix_len, prefix_len));
+    if (common == n->prefix_len) {
+      if (n->prefix_len == prefix_len) {
+        return n;
+      }
+      /* n covers the prefix: go down */
+      pn = &n->child[IP4_ROUTE_BIT(prefix, n->prefix_len)];
+      continue;
+    }
+    /* the prefixes diverge inside n: n moves below a new node */
+    node = ip4_route_node_new(prefix, prefix_len);
+    if (node == NULL) {
+      return NULL;
+    }
+    if (common == prefix_len) {
+      /* the new prefix covers n */
+      node->child[IP4_ROUTE_BIT(n->prefix, prefix_len)] = n;
+      *pn = node;
+      return node;
+    }
+    branch = ip4_route_node_new(prefix & IP4_ROUTE_MASK(common), common);
+    if (branch == NULL) {
+      memp_free(MEMP_IP4_ROUTE_NODE, node);
+      return NULL;
+    }
+    branch->child[IP4_ROUTE_BIT(prefix, common)] = node;
+    branch->child[IP4_ROUTE_BIT(n->prefix, common)] = n;
+    *pn = branch;
+    return node;
+  }
+  node = ip4_route_node_new(prefix, prefix_len);
+  *pn = node;
+  return node;
+}
+
+/** Find the trie node of a prefix without inserting it */
+static struct ip4_route_node *
+ip4_route_node_find(u32_t prefix, u8_t prefix_len)
+{
+  struct ip4_route_node *n = ip4_route_root;
+
+  while ((n != NULL) && (n->prefix_len <= prefix_len) &&
+         (((prefix ^ n->prefix) & IP4_ROUTE_MASK(n->prefix_len)) == 0)) {
+    if (n->prefix_len == prefix_len) {
+      return n;
+    }
+    n = n->child[IP4_ROUTE_BIT(prefix, n->prefix_len)];
+  }
+  return NULL;
+}
+
+/**
+ * Remove the routes via 'netif' (if not NULL) below 'n' and free nodes that
+ * are not needed any more: nodes without routes are only kept to branch.
+ *
+ * @return what to link in place of 'n'
+ */
+static struct ip4_route_node *
+ip4_route_node_prune(struct ip4_route_node *n, const struct netif *netif)
+{
+  struct ip4_route_node *child;
+
+  if (n == NULL) {
+    return NULL;
+  }
+  if (netif != NULL) {
+    struct ip4_route_entry **prt = &n->routes;
+    while (*prt != NULL) {
+      struct ip4_route_entry *rt = *prt;
+      if (rt->netif == netif) {
+        *prt = rt->next;
+        memp_free(MEMP_IP4_ROUTE, rt);
+      } else {
+        prt = &rt->next;
+      }
+    }
+  }
+  n->child[0] = ip4_route_node_prune(n->child[0], netif);
+  n->child[1] = ip4_route_node_prune(n->child[1], netif);
+  if ((n->routes != NULL) || ((n->child[0] != NULL) && (n->child[1] != NULL))) {
+    return n;
+  }
+  child = (n->child[0] != NULL) ? n->child[0] : n->child[1];
+  memp_free(MEMP_IP4_ROUTE_NODE, n);
+  return child;
+}
+
+/**
+ * Longest prefix match: the first usable route of the longest prefix
+ * covering 'dest' that has one.
+ *
+ * @param dest destination address
+ * @param netif only consider routes via this netif (NULL for all)
+ */
+static struct ip4_route_entry *
+ip4_route_lookup(const ip4_addr_t *dest, const struct netif *netif)
+{
+  u32_t addr = lwip_ntohl(ip4_addr_get_u32(dest));
+  struct ip4_route_node *n = ip4_route_root;
+  struct ip4_route_entry *best = NULL;
+
+  while ((n != NULL) && (((addr ^ n->prefix) & IP4_ROUTE_MASK(n->prefix_len)) == 0)) {
+    struct ip4_route_entry *rt;
+    for (rt = n->routes; rt != NULL; rt = rt->next) {
+      if (((netif == NULL) || (rt->netif == netif)) && IP4_ROUTE_USABLE(rt)) {
+        best = rt;
+        break;
+      }
+    }
+    if (n->prefix_len == 32) {
+      break;
+    }
+    n = n->child[IP4_ROUTE_BIT(addr, n->prefix_len)];
+  }
+  return best;
+}
+
+/**
+ * @ingroup ip4_route
+ * Add a route. Host bits of 'prefix' beyond 'prefix_len' are ignored.
+ *
+ * @param prefix destination network (NULL for the default route)
+ * @param prefix_len length of the network prefix (0..32)
+ * @param gw next hop; NULL or IP4_ADDR_ANY if the network is on-link
+ * @param netif netif to send through
+ * @param metric preference among routes for the same prefix, lower wins
+ * @return ERR_OK on success, ERR_VAL if the route exists already,
+ *         ERR_MEM if MEMP_NUM_IP4_ROUTE/MEMP_NUM_IP4_ROUTE_NODE are exhausted
+ */
+err_t
+ip4_route_add(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw,
+              struct netif *netif, u16_t metric)
+{
+  struct ip4_route_node *node;
+  struct ip4_route_entry *rt, **prt;
+  u32_t net;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip4_route_add: invalid prefix_len", prefix_len <= 32, return ERR_VAL;);
+  LWIP_ERROR("ip4_route_add: invalid netif", netif != NULL, return ERR_ARG;);
+
+  if (gw == NULL) {
+    gw = IP4_ADDR_ANY4;
+  }
+  net = (prefix != NULL) ? (lwip_ntohl(ip4_addr_get_u32(prefix)) & IP4_ROUTE_MASK(prefix_len)) : 0;
+  node = ip4_route_node_get(net, prefix_len);
+  if (node == NULL) {
+    return ERR_MEM;
+  }
+  for (rt = node->routes; rt != NULL; rt = rt->next) {
+    if ((rt->netif == netif) && ip4_addr_cmp(&rt->gw, gw)) {
+      return ERR_VAL;
+    }
+  }
+  rt = (struct ip4_route_entry *)memp_malloc(MEMP_IP4_ROUTE);
+  if (rt == NULL) {
+    /* drop the node again if it was just inserted */
+    ip4_route_root = ip4_route_node_prune(ip4_route_root, NULL);
+    return ERR_MEM;
+  }
+  ip4_addr_copy(rt->gw, *gw);
+  rt->netif = netif;
+  rt->metric = metric;
+  /* keep sorted by metric, older routes first on equal metric */
+  prt = &node->routes;
+  while ((*prt != NULL) && ((*prt)->metric <= metric)) {
+    prt = &(*prt)->next;
+  }
+  rt->next = *prt;
+  *prt = rt;
+  IP4_FORWARD_CACHE_FLUSH();
+  return ERR_OK;
+}
+
+/**
+ * @ingroup ip4_route
+ * Remove routes for a prefix.
+ *
+ * @param prefix destination network (NULL for the default route)
+ * @param prefix_len length of the network prefix (0..32)
+ * @param gw only remove routes via this next hop (NULL for any)
+ * @param netif only remove routes via this netif (NULL for any)
+ * @return ERR_OK if at least one route was removed, ERR_VAL otherwise
+ */
+err_t
+ip4_route_remove(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw,
+                 struct netif *netif)
+{
+  struct ip4_route_node *node;
+  struct ip4_route_entry **prt;
+  u32_t net;
+  u8_t removed = 0;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip4_route_remove: invalid prefix_len", prefix_len <= 32, return ERR_VAL;);
+
+  net = (prefix != NULL) ? (lwip_ntohl(ip4_addr_get_u32(prefix)) & IP4_ROUTE_MASK(prefix_len)) : 0;
+  node = ip4_route_node_find(net, prefix_len);
+  if (node == NULL) {
+    return ERR_VAL;
+  }
+  prt = &node->routes;
+  while (*prt != NULL) {
+    struct ip4_route_entry *rt = *prt;
+    if (((gw == NULL) || ip4_addr_cmp(&rt->gw, gw)) && ((netif == NULL) || (rt->netif == netif))) {
+      *prt = rt->next;
+      memp_free(MEMP_IP4_ROUTE, rt);
+      removed = 1;
+    } else {
+      prt = &rt->next;
+    }
+  }
+  if (!removed) {
+    return ERR_VAL;
+  }
+  if (node->routes == NULL) {
+    ip4_route_root = ip4_route_node_prune(ip4_route_root, NULL);
+  }
+  IP4_FORWARD_CACHE_FLUSH();
+  return ERR_OK;
+}
+
+/**
+ * Find the netif to send to 'dest' through, according to the routing table.
+ * Called by ip4_route().
+ *
+ * @return the netif of the best usable route or NULL if there is none
+ */
+struct netif *
+ip4_route_table_netif(const ip4_addr_t *dest)
+{
+  struct ip4_route_entry *rt = ip4_route_lookup(dest, NULL);
+  return (rt != NULL) ? rt->netif : NULL;
+}
+
+/**
+ * Get the next hop for sending to 'dest' on 'netif'. Called by
+ * etharp_output() for destinations outside the netif's network.
+ *
+ * @return the gateway of the best usable route via 'netif', 'dest' itself for
+ *         an on-link route or NULL if there is no such route
+ */
+const ip4_addr_t *
+ip4_route_table_gw(const struct netif *netif, const ip4_addr_t *dest)
+{
+  struct ip4_route_entry *rt = ip4_route_lookup(dest, netif);
+  if (rt == NULL) {
+    return NULL;
+  }
+  if (ip4_addr_isany_val(rt->gw)) {
+    return dest;
+  }
+  return &rt->gw;
+}
+
+/**
+ * Remove all routes via a netif that is being removed.
+ * Called by netif_remove().
+ */
+void
+ip4_route_table_netif_removed(const struct netif *netif)
+{
+  ip4_route_root = ip4_route_node_prune(ip4_route_root, netif);
+  IP4_FORWARD_CACHE_FLUSH();
+}
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE */
@@ -101,7 +101,7 @@ icmp6_input(struct pbuf *p, struct netif *inp)
 
 #if CHECKSUM_CHECK_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_ICMP6) {
-    if (ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, p->tot_len, ip6_current_src_addr(),
+    if (ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, (u16_t)p->tot_len, ip6_current_src_addr(),
                           ip6_current_dest_addr()) != 0) {
       /* Checksum failed */
       pbuf_free(p);
@@ -185,7 +185,7 @@ icmp6_input(struct pbuf *p, struct netif *inp)
 #if CHECKSUM_GEN_ICMP6
     IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_GEN_ICMP6) {
       ((struct icmp6_echo_hdr *)(r->payload))->chksum = ip6_chksum_pseudo(r,
-          IP6_NEXTH_ICMP6, r->tot_len, reply_src, ip6_current_src_addr());
+          IP6_NEXTH_ICMP6, (u16_t)r->tot_len, reply_src, ip6_current_src_addr());
     }
 #endif /* CHECKSUM_GEN_ICMP6 */
 
@@ -412,7 +412,7 @@ icmp6_send_response_with_addrs_and_netif(struct pbuf *p, u8_t code, u32_t data,
   icmp6hdr->chksum = 0;
 #if CHECKSUM_GEN_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP6) {
-    icmp6hdr->chksum = ip6_chksum_pseudo(q, IP6_NEXTH_ICMP6, q->tot_len,
+    icmp6hdr->chksum = ip6_chksum_pseudo(q, IP6_NEXTH_ICMP6, (u16_t)q->tot_len,
       reply_src, reply_dest);
   }
 #endif /* CHECKSUM_GEN_ICMP6 */
@@ -549,7 +549,7 @@ ip6_input(struct pbuf *p, struct netif *inp)
         ("IPv6 header (len %"U16_F") does not fit in first pbuf (len %"U16_F"), IP packet dropped.\n",
             (u16_t)IP6_HLEN, p->len));
     }
-    if ((IP6H_PLEN(ip6hdr) + IP6_HLEN) > p->tot_len) {
+    if ((pbuf_len_t)(IP6H_PLEN(ip6hdr) + IP6_HLEN) > p->tot_len) {
       LWIP_DEBUGF(IP6_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
         ("IPv6 (plen %"U16_F") is longer than pbuf (len %"U16_F"), IP packet dropped.\n",
             (u16_t)(IP6H_PLEN(ip6hdr) + IP6_HLEN), p->tot_len));
@@ -1202,6 +1202,14 @@ ip6_output_if_src(struct pbuf *p, const ip6_addr_t *src, const ip6_addr_t *dest,
       IP6_STATS_INC(ip6.err);
       return ERR_BUF;
     }
+#if LWIP_PBUF_LEN_32BIT
+    if (p->tot_len > 0xFFFF + IP6_HLEN) {
+      LWIP_DEBUGF(IP6_DEBUG | LWIP_DBG_LEVEL_SERIOUS, ("ip6_output: packet too big for IPv6 payload length field\n"));
+      pbuf_remove_header(p, IP6_HLEN);
+      IP6_STATS_INC(ip6.err);
+      return ERR_VAL;
+    }
+#endif /* LWIP_PBUF_LEN_32BIT */
 
     ip6hdr = (struct ip6_hdr *)p->payload;
     LWIP_ASSERT("check that first pbuf can hold struct ip6_hdr",
@@ -74,7 +74,12 @@
 /* The number of bytes we need to "borrow" from (i.e., overwrite in) the header
  * that precedes the fragment header for reassembly pruposes. */
 #define IPV6_FRAG_REQROOM ((s16_t)(sizeof(struct ip6_reass_helper) - IP6_FRAG_HLEN))
-#endif
+/* The number of bytes to hide in front of the data of every fragment but the
+ * first one when chaining them together. */
+#define IPV6_FRAG_HIDE_LEN ((u16_t)(IP6_FRAG_HLEN + LWIP_MAX(IPV6_FRAG_REQROOM, 0)))
+#else /* IPV6_FRAG_COPYHEADER */
+#define IPV6_FRAG_HIDE_LEN IP6_FRAG_HLEN
+#endif /* IPV6_FRAG_COPYHEADER */
 
 #define IP_REASS_FLAG_LASTFRAG 0x01
 
@@ -102,6 +107,10 @@ PACK_STRUCT_END
 /* static variables */
 static struct ip6_reassdata *reassdatagrams;
 static u16_t ip6_reass_pbufcount;
+#if IP_REASS_HASH_SIZE
+/* datagrams being reassembled, hashed by (identification, source, destination) */
+static struct ip6_reassdata *reass6_hash[IP_REASS_HASH_SIZE];
+#endif /* IP_REASS_HASH_SIZE */
 
 /* Forward declarations. */
 static void ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr);
@@ -109,6 +118,82 @@ static void ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr);
 static void ip6_reass_remove_oldest_datagram(struct ip6_reassdata *ipr, int pbufs_needed);
 #endif /* IP_REASS_FREE_OLDEST */
 
+#if IP_REASS_HASH_SIZE
+/** Hash bucket of a datagram, computed from the fragment identification
+ * and the source and destination addresses (zones are left out). */
+static u16_t
+ip6_reass_hash(u32_t id, const ip6_addr_p_t *src, const ip6_addr_p_t *dest)
+{
+  u32_t h = id;
+  h ^= src->addr[0] ^ src->addr[1] ^ src->addr[2] ^ src->addr[3];
+  h ^= dest->addr[0] ^ dest->addr[1] ^ dest->addr[2] ^ dest->addr[3];
+  return (u16_t)((((u32_t)(h * 0x9e3779b1UL)) >> 16) % IP_REASS_HASH_SIZE);
+}
+#endif /* IP_REASS_HASH_SIZE */
+
+/**
+ * Unchain a datagram from the list of datagrams being reassembled (and from
+ * the lookup hash). The datagram itself is not freed.
+ *
+ * @param ipr datagram to dequeue
+ */
+static void
+ip6_reass_dequeue_datagram(struct ip6_reassdata *ipr)
+{
+  struct ip6_reassdata **pp;
+
+#if IP_REASS_HASH_SIZE
+  for (pp = &reass6_hash[ip6_reass_hash(ipr->identification, &IPV6_FRAG_SRC(ipr), &IPV6_FRAG_DEST(ipr))];
+       *pp != NULL; pp = &(*pp)->hnext) {
+    if (*pp == ipr) {
+      *pp = ipr->hnext;
+      break;
+    }
+  }
+#endif /* IP_REASS_HASH_SIZE */
+  for (pp = &reassdatagrams; *pp != NULL; pp = &(*pp)->next) {
+    if (*pp == ipr) {
+      *pp = ipr->next;
+      break;
+    }
+  }
+}
+
+/**
+ * Check whether the fragments of a datagram cover it completely. Only called
+ * once the last fragment has been received and the received lengths add up.
+ *
+ * @param ipr datagram to check
+ * @return 1 if all fragments have been received, 0 if there are holes
+ */
+static int
+ip6_reass_is_complete(const struct ip6_reassdata *ipr)
+{
+#if IP_REASS_CHECK_OVERLAP
+  /* fragments neither overlap nor reach beyond the last one, so they
+   * cover the whole datagram */
+  LWIP_ASSERT("sanity check", ((struct ip6_reass_helper *)ipr->p->payload)->start == 0);
+  return 1;
+#else /* IP_REASS_CHECK_OVERLAP */
+  const struct ip6_reass_helper *iprh_prev, *iprh;
+  struct pbuf *q;
+
+  /* check that the fragments have no holes */
+  iprh_prev = (const struct ip6_reass_helper *)ipr->p->payload;
+  if (iprh_prev->start != 0) {
+    return 0;
+  }
+  for (q = iprh_prev->next_pbuf; q != NULL; q = iprh->next_pbuf) {
+    iprh = (const struct ip6_reass_helper *)q->payload;
+    if (iprh_prev->end < iprh->start) {
+      return 0;
+    }
+    iprh_prev = iprh;
+  }
+  return 1;
+#endif /* IP_REASS_CHECK_OVERLAP */
+}
+
 void
 ip6_reass_tmr(void)
 {
@@ -147,12 +232,14 @@ ip6_reass_tmr(void)
 static void
 ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr)
 {
-  struct ip6_reassdata *prev;
   u16_t pbufs_freed = 0;
   u16_t clen;
   struct pbuf *p;
   struct ip6_reass_helper *iprh;
 
+  /* First, unchain the struct ip6_reassdata while its addresses are valid. */
+  ip6_reass_dequeue_datagram(ipr);
+
 #if LWIP_ICMP6
   iprh = (struct ip6_reass_helper *)ipr->p->payload;
   if (iprh->start == 0) {
@@ -186,7 +273,7 @@ ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr)
   }
 #endif /* LWIP_ICMP6 */
 
-  /* First, free all received pbufs.  The individual pbufs need to be released
+  /* Then, free all received pbufs.  The individual pbufs need to be released
      separately as they have not yet been chained */
   p = ipr->p;
   while (p != NULL) {
@@ -201,21 +288,6 @@ ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr)
     pbuf_free(pcur);
   }
 
-  /* Then, unchain the struct ip6_reassdata from the list and free it. */
-  if (ipr == reassdatagrams) {
-    reassdatagrams = ipr->next;
-  } else {
-    prev = reassdatagrams;
-    while (prev != NULL) {
-      if (prev->next == ipr) {
-        break;
-      }
-      prev = prev->next;
-    }
-    if (prev != NULL) {
-      prev->next = ipr->next;
-    }
-  }
   memp_free(MEMP_IP6_REASSDATA, ipr);
 
   /* Finally, update number of pbufs in reassembly queue */
@@ -271,13 +343,12 @@ ip6_reass_remove_oldest_datagram(struct ip6_reassdata *ipr, int pbufs_needed)
 struct pbuf *
 ip6_reass(struct pbuf *p)
 {
-  struct ip6_reassdata *ipr, *ipr_prev;
+  struct ip6_reassdata *ipr;
   struct ip6_reass_helper *iprh, *iprh_tmp, *iprh_prev=NULL;
   struct ip6_frag_hdr *frag_hdr;
   u16_t offset, len, start, end;
   ptrdiff_t hdrdiff;
   u16_t clen;
-  u8_t valid = 1;
   struct pbuf *q, *next_pbuf;
 
   IP6_FRAG_STATS_INC(ip6_frag.recv);
@@ -313,9 +384,14 @@ ip6_reass(struct pbuf *p)
     goto nullreturn;
   }
 
-  /* Look for the datagram the fragment belongs to in the current datagram queue,
-   * remembering the previous in the queue for later dequeueing. */
-  for (ipr = reassdatagrams, ipr_prev = NULL; ipr != NULL; ipr = ipr->next) {
+  /* Look for the datagram the fragment belongs to in the current datagram queue. */
+#if IP_REASS_HASH_SIZE
+  for (ipr = reass6_hash[ip6_reass_hash(frag_hdr->_identification, &ip6_current_header()->src,
+                                        &ip6_current_header()->dest)];
+       ipr != NULL; ipr = ipr->hnext) {
+#else /* IP_REASS_HASH_SIZE */
+  for (ipr = reassdatagrams; ipr != NULL; ipr = ipr->next) {
+#endif /* IP_REASS_HASH_SIZE */
     /* Check if the incoming fragment matches the one currently present
        in the reassembly buffer. If so, we proceed with copying the
        fragment into the buffer. */
@@ -325,7 +401,6 @@ ip6_reass(struct pbuf *p)
       IP6_FRAG_STATS_INC(ip6_frag.cachehit);
       break;
     }
-    ipr_prev = ipr;
   }
 
   if (ipr == NULL) {
@@ -336,14 +411,7 @@ ip6_reass(struct pbuf *p)
       /* Make room and try again. */
       ip6_reass_remove_oldest_datagram(ipr, clen);
       ipr = (struct ip6_reassdata *)memp_malloc(MEMP_IP6_REASSDATA);
-      if (ipr != NULL) {
-        /* re-search ipr_prev since it might have been removed */
-        for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-          if (ipr_prev->next == ipr) {
-            break;
-          }
-        }
-      } else
+      if (ipr == NULL)
 #endif /* IP_REASS_FREE_OLDEST */
       {
         IP6_FRAG_STATS_INC(ip6_frag.memerr);
@@ -357,6 +425,14 @@ ip6_reass(struct pbuf *p)
     /* enqueue the new structure to the front of the list */
     ipr->next = reassdatagrams;
     reassdatagrams = ipr;
+#if IP_REASS_HASH_SIZE
+    {
+      u16_t h = ip6_reass_hash(frag_hdr->_identification, &ip6_current_header()->src,
+                               &ip6_current_header()->dest);
+      ipr->hnext = reass6_hash[h];
+      reass6_hash[h] = ipr;
+    }
+#endif /* IP_REASS_HASH_SIZE */
 
     /* Use the current IPv6 header for src/dest address reference.
      * Eventually, we will replace it when we get the first fragment
@@ -388,20 +464,13 @@ ip6_reass(struct pbuf *p)
   if ((ip6_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
 #if IP_REASS_FREE_OLDEST
     ip6_reass_remove_oldest_datagram(ipr, clen);
-    if ((ip6_reass_pbufcount + clen) <= IP_REASS_MAX_PBUFS) {
-      /* re-search ipr_prev since it might have been removed */
-      for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-        if (ipr_prev->next == ipr) {
-          break;
-        }
-      }
-    } else
+    if ((ip6_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS)
 #endif /* IP_REASS_FREE_OLDEST */
     {
       /* @todo: send ICMPv6 time exceeded here? */
       /* drop this pbuf */
       IP6_FRAG_STATS_INC(ip6_frag.memerr);
-      goto nullreturn;
+      goto nullreturn_ipr;
     }
   }
 
@@ -427,84 +496,84 @@ ip6_reass(struct pbuf *p)
   next_pbuf = NULL;
   end = (u16_t)(start + len);
 
+  /* Fragments must not reach beyond the end of the datagram. */
+  if (ipr->datagram_len != 0) {
+    if ((end > ipr->datagram_len) ||
+        (((offset & IP6_FRAG_MORE_FLAG) == 0) && (end != ipr->datagram_len))) {
+      IP6_FRAG_STATS_INC(ip6_frag.proterr);
+      goto nullreturn;
+    }
+  } else if (((offset & IP6_FRAG_MORE_FLAG) == 0) && (ipr->p_last != NULL) &&
+             (((struct ip6_reass_helper *)ipr->p_last->payload)->end > end)) {
+    IP6_FRAG_STATS_INC(ip6_frag.proterr);
+    goto nullreturn;
+  }
+
   /* find the right place to insert this pbuf */
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find on with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
-    iprh_tmp = (struct ip6_reass_helper*)q->payload;
-    if (start < iprh_tmp->start) {
+  if (ipr->p_last == NULL) {
+    /* this is the first fragment we ever received for this ip datagram */
+    ipr->p = p;
+    ipr->p_last = p;
+  } else if (start >= ((struct ip6_reass_helper *)ipr->p_last->payload)->end) {
+    /* this is (for now), the fragment with the highest offset:
+     * chain it to the last fragment without walking the list */
+    ((struct ip6_reass_helper *)ipr->p_last->payload)->next_pbuf = p;
+    ipr->p_last = p;
+  } else {
+    /* Iterate through until we either get to the end of the list (append),
+     * or we find on with a larger offset (insert). */
+    for (q = ipr->p; q != NULL;) {
+      iprh_tmp = (struct ip6_reass_helper*)q->payload;
+      if (start < iprh_tmp->start) {
 #if IP_REASS_CHECK_OVERLAP
-      if (end > iprh_tmp->start) {
-        /* fragment overlaps with following, throw away */
-        IP6_FRAG_STATS_INC(ip6_frag.proterr);
-        goto nullreturn;
-      }
-      if (iprh_prev != NULL) {
-        if (start < iprh_prev->end) {
-          /* fragment overlaps with previous, throw away */
+        if (end > iprh_tmp->start) {
+          /* fragment overlaps with following, throw away */
           IP6_FRAG_STATS_INC(ip6_frag.proterr);
           goto nullreturn;
         }
-      }
+        if (iprh_prev != NULL) {
+          if (start < iprh_prev->end) {
+            /* fragment overlaps with previous, throw away */
+            IP6_FRAG_STATS_INC(ip6_frag.proterr);
+            goto nullreturn;
+          }
+        }
 #endif /* IP_REASS_CHECK_OVERLAP */
-      /* the new pbuf should be inserted before this */
-      next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
-        iprh_prev->next_pbuf = p;
-      } else {
-        /* fragment with the lowest offset */
-        ipr->p = p;
-      }
-      break;
-    } else if (start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
-      goto nullreturn;
+        /* the new pbuf should be inserted before this */
+        next_pbuf = q;
+        if (iprh_prev != NULL) {
+          /* not the fragment with the lowest offset */
+          iprh_prev->next_pbuf = p;
+        } else {
+          /* fragment with the lowest offset */
+          ipr->p = p;
+        }
+        break;
+      } else if (start == iprh_tmp->start) {
+        /* received the same datagram twice: no need to keep the datagram */
+        goto nullreturn;
 #if IP_REASS_CHECK_OVERLAP
-    } else if (start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
-      IP6_FRAG_STATS_INC(ip6_frag.proterr);
-      goto nullreturn;
+      } else if (start < iprh_tmp->end) {
+        /* overlap: no need to keep the new datagram */
+        IP6_FRAG_STATS_INC(ip6_frag.proterr);
+        goto nullreturn;
 #endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no gaps. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
       }
+      q = iprh_tmp->next_pbuf;
+      iprh_prev = iprh_tmp;
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
-
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= start);
-#endif /* IP_REASS_CHECK_OVERLAP */
+    if (q == NULL) {
+      /* overlapping the last fragment (only if overlap checks are disabled) */
+      LWIP_ASSERT("sanity check", iprh_prev == (struct ip6_reass_helper *)ipr->p_last->payload);
       iprh_prev->next_pbuf = p;
-      if (iprh_prev->end != start) {
-        valid = 0;
-      }
-    } else {
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-        ipr->p == NULL);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
-      ipr->p = p;
+      ipr->p_last = p;
     }
   }
 
   /* Track the current number of pbufs current 'in-flight', in order to limit
   the number of fragments that may be enqueued at any one time */
   ip6_reass_pbufcount = (u16_t)(ip6_reass_pbufcount + clen);
+  ipr->recv_len = (u16_t)LWIP_MIN(0xFFFF, (u32_t)ipr->recv_len + len);
 
   /* Remember IPv6 header if this is the first fragment. */
   if (start == 0) {
@@ -527,51 +596,41 @@ ip6_reass(struct pbuf *p)
     ipr->datagram_len = iprh->end;
   }
 
-  /* Additional validity tests: we have received first and last fragment. */
-  iprh_tmp = (struct ip6_reass_helper*)ipr->p->payload;
-  if (iprh_tmp->start != 0) {
-    valid = 0;
-  }
-  if (ipr->datagram_len == 0) {
-    valid = 0;
-  }
-
-  /* Final validity test: no gaps between current and last fragment. */
-  iprh_prev = iprh;
-  q = iprh->next_pbuf;
-  while ((q != NULL) && valid) {
-    iprh = (struct ip6_reass_helper*)q->payload;
-    if (iprh_prev->end != iprh->start) {
-      valid = 0;
-      break;
-    }
-    iprh_prev = iprh;
-    q = iprh->next_pbuf;
-  }
-
-  if (valid) {
+  /* The datagram is complete once the last fragment has been received and
+   * the fragments add up to its length. */
+  if ((ipr->datagram_len != 0) && (ipr->recv_len >= ipr->datagram_len) &&
+      ip6_reass_is_complete(ipr)) {
     /* All fragments have been received */
     struct ip6_hdr* iphdr_ptr;
+    struct pbuf *last;
+
+    /* unlink the datagram before its header is moved */
+    ip6_reass_dequeue_datagram(ipr);
 
-    /* chain together the pbufs contained within the ip6_reassdata list. */
+    /* chain together the pbufs contained within the ip6_reassdata list.
+     * 'last' is the last pbuf of the chain so far, so that chaining does
+     * not walk the growing chain for every fragment. */
+    for (last = ipr->p; last->next != NULL; last = last->next) {
+      /* find the last pbuf of the first fragment */
+    }
     iprh = (struct ip6_reass_helper*) ipr->p->payload;
     while (iprh != NULL) {
       next_pbuf = iprh->next_pbuf;
       if (next_pbuf != NULL) {
+        u8_t hdrerr;
         /* Save next helper struct (will be hidden in next step). */
         iprh_tmp = (struct ip6_reass_helper*)next_pbuf->payload;
 
-        /* hide the fragment header for every succeeding fragment */
-        pbuf_remove_header(next_pbuf, IP6_FRAG_HLEN);
-#if IPV6_FRAG_COPYHEADER
-        if (IPV6_FRAG_REQROOM > 0) {
-          /* hide the extra bytes borrowed from ip6_hdr for struct ip6_reass_helper */
-          u8_t hdrerr = pbuf_remove_header(next_pbuf, IPV6_FRAG_REQROOM);
-          LWIP_UNUSED_ARG(hdrerr); /* in case of LWIP_NOASSERT */
-          LWIP_ASSERT("no room for struct ip6_reass_helper", hdrerr == 0);
+        /* hide the fragment header for every succeeding fragment, together
+         * with the extra bytes borrowed for struct ip6_reass_helper */
+        hdrerr = pbuf_remove_header(next_pbuf, IPV6_FRAG_HIDE_LEN);
+        LWIP_UNUSED_ARG(hdrerr); /* in case of LWIP_NOASSERT */
+        LWIP_ASSERT("no room for struct ip6_reass_helper", hdrerr == 0);
+        /* append it without walking the chain built so far */
+        last->next = next_pbuf;
+        for (last = next_pbuf; last->next != NULL; last = last->next) {
+          /* find the last pbuf of this fragment */
         }
-#endif
-        pbuf_cat(ipr->p, next_pbuf);
       }
       else {
         iprh_tmp = NULL;
@@ -597,6 +656,18 @@ ip6_reass(struct pbuf *p)
     }
 #endif
 
+    /* Fix up the total lengths of the chain in one pass. */
+    {
+      u32_t tot_len = 0;
+      for (q = p; q != NULL; q = q->next) {
+        tot_len += q->len;
+      }
+      for (q = p; q != NULL; q = q->next) {
+        q->tot_len = (pbuf_len_t)tot_len;
+        tot_len -= q->len;
+      }
+    }
+
     /* We need to get rid of the fragment header itself, which is somewhere in
      * the middle of the packet (but still in the first pbuf of the chain).
      * Getting rid of the header is required by RFC 2460 Sec. 4.5 and necessary
@@ -635,14 +706,6 @@ ip6_reass(struct pbuf *p)
     }
 
     /* release the resources allocated for the fragment queue entry */
-    if (reassdatagrams == ipr) {
-      /* it was the first in the list */
-      reassdatagrams = ipr->next;
-    } else {
-      /* it wasn't the first, so it must have a valid 'prev' */
-      LWIP_ASSERT("sanity check linked list", ipr_prev != NULL);
-      ipr_prev->next = ipr->next;
-    }
     memp_free(MEMP_IP6_REASSDATA, ipr);
 
     /* adjust the number of pbufs currently queued for reassembly. */
@@ -663,6 +726,13 @@ ip6_reass(struct pbuf *p)
   /* the datagram is not (yet?) reassembled completely */
   return NULL;
 
+nullreturn_ipr:
+  if (ipr->p == NULL) {
+    /* dropped the first fragment of a new datagram: remove the empty entry, too */
+    ip6_reass_dequeue_datagram(ipr);
+    memp_free(MEMP_IP6_REASSDATA, ipr);
+  }
+
 nullreturn:
   IP6_FRAG_STATS_INC(ip6_frag.drop);
   pbuf_free(p);
@@ -735,6 +805,9 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
   u16_t fragment_offset = 0;
   u16_t last;
   u16_t poff = IP6_HLEN;
+#if !LWIP_NETIF_TX_SINGLE_PBUF
+  u16_t plen;
+#endif
 
   identification++;
 
@@ -786,17 +859,16 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
     ip6hdr = (struct ip6_hdr *)rambuf->payload;
     frag_hdr = (struct ip6_frag_hdr *)((u8_t*)rambuf->payload + IP6_HLEN);
 
-    /* Can just adjust p directly for needed offset. */
-    p->payload = (u8_t *)p->payload + poff;
-    p->len = (u16_t)(p->len - poff);
-    p->tot_len = (u16_t)(p->tot_len - poff);
-
     left_to_copy = cop;
     while (left_to_copy) {
       struct pbuf_custom_ref *pcr;
-      newpbuflen = (left_to_copy < p->len) ? left_to_copy : p->len;
+      /* p is left untouched: the data to reference starts at poff in it */
+      LWIP_ASSERT("p->len >= poff", p->len >= poff);
+      plen = (u16_t)(p->len - poff);
+      newpbuflen = LWIP_MIN(left_to_copy, plen);
       /* Is this pbuf already empty? */
       if (!newpbuflen) {
+        poff = 0;
         p = p->next;
         continue;
       }
@@ -807,7 +879,8 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
         return ERR_MEM;
       }
       /* Mirror this pbuf, although we might not need all of it. */
-      newpbuf = pbuf_alloced_custom(PBUF_RAW, newpbuflen, PBUF_REF, &pcr->pc, p->payload, newpbuflen);
+      newpbuf = pbuf_alloced_custom(PBUF_RAW, newpbuflen, PBUF_REF, &pcr->pc,
+                                    (u8_t *)p->payload + poff, newpbuflen);
       if (newpbuf == NULL) {
         ip6_frag_free_pbuf_custom_ref(pcr);
         pbuf_free(rambuf);
@@ -824,10 +897,11 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
       pbuf_cat(rambuf, newpbuf);
       left_to_copy = (u16_t)(left_to_copy - newpbuflen);
       if (left_to_copy) {
+        poff = 0;
         p = p->next;
       }
     }
-    poff = newpbuflen;
+    poff = (u16_t)(poff + newpbuflen);
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
     /* Set headers */
@@ -603,7 +603,7 @@ mld6_send(struct netif *netif, struct mld_group *group, u8_t type)
 
 #if CHECKSUM_GEN_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP6) {
-    mld_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, p->len,
+    mld_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, (u16_t)p->len,
       src_addr, &(group->group_address));
   }
 #endif /* CHECKSUM_GEN_ICMP6 */
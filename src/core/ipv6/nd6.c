@@ -72,6 +72,9 @@
 #if LWIP_IPV6_DUP_DETECT_ATTEMPTS > IP6_ADDR_TENTATIVE_COUNT_MASK
 #error LWIP_IPV6_DUP_DETECT_ATTEMPTS > IP6_ADDR_TENTATIVE_COUNT_MASK
 #endif
+#if (LWIP_ND6_NUM_NEIGHBORS > 0x7fff) || (LWIP_ND6_NUM_DESTINATIONS > 0x7fff)
+#error LWIP_ND6_NUM_NEIGHBORS and LWIP_ND6_NUM_DESTINATIONS must be <= 0x7fff
+#endif
 
 /* Router tables. */
 struct nd6_neighbor_cache_entry neighbor_cache[LWIP_ND6_NUM_NEIGHBORS];
@@ -79,12 +82,37 @@ struct nd6_destination_cache_entry destination_cache[LWIP_ND6_NUM_DESTINATIONS];
 struct nd6_prefix_list_entry prefix_list[LWIP_ND6_NUM_PREFIXES];
 struct nd6_router_list_entry default_router_list[LWIP_ND6_NUM_ROUTERS];
 
+#if LWIP_ND6_CACHE_HASH_SIZE
+/** Hash chain and LRU list links of one cache entry.
+ * Links are entry index + 1, 0 ends a list. */
+struct nd6_hash_link {
+  u16_t hnext;
+  u16_t lru_prev;
+  u16_t lru_next;
+};
+
+/** Address index of the neighbor or destination cache */
+struct nd6_hash_table {
+  u16_t bucket[LWIP_ND6_CACHE_HASH_SIZE];
+  /* least recently used entry first */
+  u16_t lru_head;
+  u16_t lru_tail;
+  /* no empty entry below this index */
+  u16_t first_free;
+};
+
+static struct nd6_hash_link nd6_neighbor_links[LWIP_ND6_NUM_NEIGHBORS];
+static struct nd6_hash_link nd6_destination_links[LWIP_ND6_NUM_DESTINATIONS];
+static struct nd6_hash_table nd6_neighbor_hash;
+static struct nd6_hash_table nd6_destination_hash;
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+
 /* Default values, can be updated by a RA message. */
 u32_t reachable_time = LWIP_ND6_REACHABLE_TIME;
 u32_t retrans_timer = LWIP_ND6_RETRANS_TIMER; /* @todo implement this value in timer */
 
 /* Index for cache entries. */
-static u8_t nd6_cached_neighbor_index;
+static s16_t nd6_cached_neighbor_index;
 static netif_addr_idx_t nd6_cached_destination_index;
 
 /* Multicast address holder. */
@@ -104,19 +132,21 @@ union ra_options {
 static union ra_options nd6_ra_buffer;
 
 /* Forward declarations. */
-static s8_t nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr);
-static s8_t nd6_new_neighbor_cache_entry(void);
-static void nd6_free_neighbor_cache_entry(s8_t i);
+static s16_t nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr);
+static s16_t nd6_new_neighbor_cache_entry(void);
+static void nd6_free_neighbor_cache_entry(s16_t i);
+static void nd6_neighbor_set_addr(s16_t i, const ip6_addr_t *ip6addr);
 static s16_t nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr);
 static s16_t nd6_new_destination_cache_entry(void);
+static void nd6_destination_set_addr(s16_t i, const ip6_addr_t *ip6addr);
 static int nd6_is_prefix_in_netif(const ip6_addr_t *ip6addr, struct netif *netif);
 static s8_t nd6_select_router(const ip6_addr_t *ip6addr, struct netif *netif);
 static s8_t nd6_get_router(const ip6_addr_t *router_addr, struct netif *netif);
 static s8_t nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif);
 static s8_t nd6_get_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif);
 static s8_t nd6_new_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif);
-static s8_t nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif);
-static err_t nd6_queue_packet(s8_t neighbor_index, struct pbuf *q);
+static s16_t nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif);
+static err_t nd6_queue_packet(s16_t neighbor_index, struct pbuf *q);
 
 #define ND6_SEND_FLAG_MULTICAST_DEST 0x01
 #define ND6_SEND_FLAG_ALLNODES_DEST 0x02
@@ -133,7 +163,7 @@ static void nd6_free_q(struct nd6_q_entry *q);
 #else /* LWIP_ND6_QUEUEING */
 #define nd6_free_q(q) pbuf_free(q)
 #endif /* LWIP_ND6_QUEUEING */
-static void nd6_send_q(s8_t i);
+static void nd6_send_q(s16_t i);
 
 
 /**
@@ -287,7 +317,7 @@ void
 nd6_input(struct pbuf *p, struct netif *inp)
 {
   u8_t msg_type;
-  s8_t i;
+  s16_t i;
   s16_t dest_idx;
 
   ND6_STATS_INC(nd6.recv);
@@ -340,7 +370,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
             !ip6_addr_isduplicated(netif_ip6_addr_state(inp, i)) &&
             ip6_addr_cmp(&target_address, netif_ip6_addr(inp, i))) {
           /* We are using a duplicate address. */
-          nd6_duplicate_addr_detected(inp, i);
+          nd6_duplicate_addr_detected(inp, (s8_t)i);
 
           pbuf_free(p);
           return;
@@ -497,7 +527,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
           nd6_send_na(inp, netif_ip6_addr(inp, i), ND6_FLAG_OVERRIDE | ND6_SEND_FLAG_ALLNODES_DEST);
           if (ip6_addr_istentative(netif_ip6_addr_state(inp, i))) {
             /* We shouldn't use this address either. */
-            nd6_duplicate_addr_detected(inp, i);
+            nd6_duplicate_addr_detected(inp, (s8_t)i);
           }
         }
       }
@@ -537,7 +567,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
         }
         neighbor_cache[i].netif = inp;
         MEMCPY(neighbor_cache[i].lladdr, lladdr_opt->addr, inp->hwaddr_len);
-        ip6_addr_set(&(neighbor_cache[i].next_hop_address), ip6_current_src_addr());
+        nd6_neighbor_set_addr(i, ip6_current_src_addr());
 
         /* Receiving a message does not prove reachability: only in one direction.
          * Delay probe in case we get confirmation of reachability from upper layer (TCP). */
@@ -665,7 +695,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
           option_len = sizeof(nd6_ra_buffer);
         }
         buffer = (u8_t*)&nd6_ra_buffer;
-        option_len = pbuf_copy_partial(p, &nd6_ra_buffer, option_len, offset);
+        option_len = (u16_t)pbuf_copy_partial(p, &nd6_ra_buffer, option_len, offset);
       }
       option_type = buffer[0];
       switch (option_type) {
@@ -871,7 +901,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
           if (i >= 0) {
             neighbor_cache[i].netif = inp;
             MEMCPY(neighbor_cache[i].lladdr, lladdr_opt->addr, inp->hwaddr_len);
-            ip6_addr_copy(neighbor_cache[i].next_hop_address, target_address);
+            nd6_neighbor_set_addr(i, &target_address);
 
             /* Receiving a message does not prove reachability: only in one direction.
              * Delay probe in case we get confirmation of reachability from upper layer (TCP). */
@@ -958,7 +988,7 @@ lenerr_drop_free_return:
 void
 nd6_tmr(void)
 {
-  s8_t i;
+  s16_t i;
   struct netif *netif;
 
   /* Process neighbor entries. */
@@ -1030,11 +1060,11 @@ nd6_tmr(void)
       if (default_router_list[i].invalidation_timer <= ND6_TMR_INTERVAL / 1000) {
         /* No more than 1 second remaining. Clear this entry. Also clear any of
          * its destination cache entries, as per RFC 4861 Sec. 5.3 and 6.3.5. */
-        s8_t j;
+        s16_t j;
         for (j = 0; j < LWIP_ND6_NUM_DESTINATIONS; j++) {
           if (ip6_addr_cmp(&destination_cache[j].next_hop_addr,
                &default_router_list[i].neighbor_entry->next_hop_address)) {
-             ip6_addr_set_any(&destination_cache[j].destination_addr);
+             nd6_destination_set_addr(j, IP6_ADDR_ANY6);
           }
         }
         default_router_list[i].neighbor_entry->isrouter = 0;
@@ -1231,7 +1261,7 @@ nd6_send_ns(struct netif *netif, const ip6_addr_t *target_addr, u8_t flags)
 
 #if CHECKSUM_GEN_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP6) {
-    ns_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, p->len, src_addr,
+    ns_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, (u16_t)p->len, src_addr,
       target_addr);
   }
 #endif /* CHECKSUM_GEN_ICMP6 */
@@ -1307,7 +1337,7 @@ nd6_send_na(struct netif *netif, const ip6_addr_t *target_addr, u8_t flags)
 
 #if CHECKSUM_GEN_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP6) {
-    na_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, p->len, src_addr,
+    na_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, (u16_t)p->len, src_addr,
       dest_addr);
   }
 #endif /* CHECKSUM_GEN_ICMP6 */
@@ -1374,7 +1404,7 @@ nd6_send_rs(struct netif *netif)
 
 #if CHECKSUM_GEN_ICMP6
   IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_ICMP6) {
-    rs_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, p->len, src_addr,
+    rs_hdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, (u16_t)p->len, src_addr,
       &multicast_address);
   }
 #endif /* CHECKSUM_GEN_ICMP6 */
@@ -1390,6 +1420,92 @@ nd6_send_rs(struct netif *netif)
 }
 #endif /* LWIP_IPV6_SEND_ROUTER_SOLICIT */
 
+#if LWIP_ND6_CACHE_HASH_SIZE
+/** Hash bucket of an IPv6 address */
+static u16_t
+nd6_hash_addr(const ip6_addr_t *ip6addr)
+{
+  u32_t key = ip6addr->addr[0] ^ ip6addr->addr[1] ^ ip6addr->addr[2] ^ ip6addr->addr[3];
+  return (u16_t)((((u32_t)(key * 0x9e3779b1UL)) >> 16) % LWIP_ND6_CACHE_HASH_SIZE);
+}
+
+/** Append an entry to the tail (most recently used end) of an LRU list */
+static void
+nd6_lru_append(struct nd6_hash_table *table, struct nd6_hash_link *links, u16_t i)
+{
+  links[i].lru_prev = table->lru_tail;
+  links[i].lru_next = 0;
+  if (table->lru_tail != 0) {
+    links[table->lru_tail - 1].lru_next = (u16_t)(i + 1);
+  } else {
+    table->lru_head = (u16_t)(i + 1);
+  }
+  table->lru_tail = (u16_t)(i + 1);
+}
+
+/** Take an entry off an LRU list */
+static void
+nd6_lru_unlink(struct nd6_hash_table *table, struct nd6_hash_link *links, u16_t i)
+{
+  if (links[i].lru_prev != 0) {
+    links[links[i].lru_prev - 1].lru_next = links[i].lru_next;
+  } else {
+    table->lru_head = links[i].lru_next;
+  }
+  if (links[i].lru_next != 0) {
+    links[links[i].lru_next - 1].lru_prev = links[i].lru_prev;
+  } else {
+    table->lru_tail = links[i].lru_prev;
+  }
+  links[i].lru_prev = 0;
+  links[i].lru_next = 0;
+}
+
+/** Insert an entry into its hash bucket and make it the most recently used */
+static void
+nd6_hash_link(struct nd6_hash_table *table, struct nd6_hash_link *links, u16_t i, const ip6_addr_t *ip6addr)
+{
+  u16_t h = nd6_hash_addr(ip6addr);
+
+  links[i].hnext = table->bucket[h];
+  table->bucket[h] = (u16_t)(i + 1);
+  nd6_lru_append(table, links, i);
+}
+
+/** Remove an entry from its hash bucket and the LRU list, if it is linked */
+static void
+nd6_hash_unlink(struct nd6_hash_table *table, struct nd6_hash_link *links, u16_t i, const ip6_addr_t *ip6addr)
+{
+  u16_t *link = &table->bucket[nd6_hash_addr(ip6addr)];
+
+  while (*link != 0) {
+    if (*link == i + 1) {
+      *link = links[i].hnext;
+      links[i].hnext = 0;
+      nd6_lru_unlink(table, links, i);
+      break;
+    }
+    link = &links[*link - 1].hnext;
+  }
+  if (i < table->first_free) {
+    table->first_free = i;
+  }
+}
+
+/** Mark a linked entry as the most recently used one */
+static void
+nd6_hash_touch(struct nd6_hash_table *table, struct nd6_hash_link *links, u16_t i)
+{
+  if ((table->lru_tail == i + 1) ||
+      ((links[i].lru_prev == 0) && (table->lru_head != i + 1))) {
+    /* already the most recent, or not in the cache */
+    return;
+  }
+  nd6_lru_unlink(table, links, i);
+  nd6_lru_append(table, links, i);
+}
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+
 /**
  * Search for a neighbor cache entry
  *
@@ -1397,18 +1513,82 @@ nd6_send_rs(struct netif *netif)
  * @return The neighbor cache entry index that matched, -1 if no
  * entry is found
  */
-static s8_t
+static s16_t
 nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr)
 {
-  s8_t i;
+#if LWIP_ND6_CACHE_HASH_SIZE
+  u16_t n;
+  for (n = nd6_neighbor_hash.bucket[nd6_hash_addr(ip6addr)]; n != 0; n = nd6_neighbor_links[n - 1].hnext) {
+    if (ip6_addr_cmp(ip6addr, &(neighbor_cache[n - 1].next_hop_address))) {
+      return (s16_t)(n - 1);
+    }
+  }
+#else /* LWIP_ND6_CACHE_HASH_SIZE */
+  s16_t i;
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
     if (ip6_addr_cmp(ip6addr, &(neighbor_cache[i].next_hop_address))) {
       return i;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
   return -1;
 }
 
+#if LWIP_ND6_CACHE_HASH_SIZE
+/**
+ * Create a new neighbor cache entry.
+ *
+ * If no unused entry is found, the least recently used entry that is not a
+ * router is recycled, preferring entries that are not incomplete, then
+ * incomplete entries without queued packets.
+ *
+ * @return The neighbor cache entry index that was created, -1 if no
+ * entry could be created
+ */
+static s16_t
+nd6_new_neighbor_cache_entry(void)
+{
+  s16_t i;
+  s16_t incomplete = -1;
+  s16_t queued = -1;
+  u16_t n;
+
+  /* First, try to find an empty entry. */
+  for (i = (s16_t)nd6_neighbor_hash.first_free; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
+    if (neighbor_cache[i].state == ND6_NO_ENTRY) {
+      nd6_neighbor_hash.first_free = (u16_t)i;
+      return i;
+    }
+  }
+  nd6_neighbor_hash.first_free = LWIP_ND6_NUM_NEIGHBORS;
+
+  /* We need to recycle an entry. in general, do not recycle if it is a router. */
+  for (n = nd6_neighbor_hash.lru_head; n != 0; n = nd6_neighbor_links[n - 1].lru_next) {
+    i = (s16_t)(n - 1);
+    if (neighbor_cache[i].isrouter) {
+      continue;
+    }
+    if (neighbor_cache[i].state != ND6_INCOMPLETE) {
+      nd6_free_neighbor_cache_entry(i);
+      return i;
+    }
+    if (neighbor_cache[i].q == NULL) {
+      if (incomplete < 0) {
+        incomplete = i;
+      }
+    } else if (queued < 0) {
+      queued = i;
+    }
+  }
+  if (incomplete < 0) {
+    incomplete = queued;
+  }
+  if (incomplete >= 0) {
+    nd6_free_neighbor_cache_entry(incomplete);
+  }
+  return incomplete;
+}
+#else /* LWIP_ND6_CACHE_HASH_SIZE */
 /**
  * Create a new neighbor cache entry.
  *
@@ -1418,11 +1598,11 @@ nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr)
  * @return The neighbor cache entry index that was created, -1 if no
  * entry could be created
  */
-static s8_t
+static s16_t
 nd6_new_neighbor_cache_entry(void)
 {
-  s8_t i;
-  s8_t j;
+  s16_t i;
+  s16_t j;
   u32_t time;
 
 
@@ -1518,6 +1698,7 @@ nd6_new_neighbor_cache_entry(void)
   /* No more entries to try. */
   return -1;
 }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
 
 /**
  * Will free any resources associated with a neighbor cache
@@ -1526,7 +1707,7 @@ nd6_new_neighbor_cache_entry(void)
  * @param i the neighbor cache entry index to free
  */
 static void
-nd6_free_neighbor_cache_entry(s8_t i)
+nd6_free_neighbor_cache_entry(s16_t i)
 {
   if ((i < 0) || (i >= LWIP_ND6_NUM_NEIGHBORS)) {
     return;
@@ -1536,6 +1717,11 @@ nd6_free_neighbor_cache_entry(s8_t i)
     return;
   }
 
+#if LWIP_ND6_CACHE_HASH_SIZE
+  nd6_hash_unlink(&nd6_neighbor_hash, nd6_neighbor_links, (u16_t)i,
+                  &(neighbor_cache[i].next_hop_address));
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+
   /* Free any queued packets. */
   if (neighbor_cache[i].q != NULL) {
     nd6_free_q(neighbor_cache[i].q);
@@ -1549,6 +1735,21 @@ nd6_free_neighbor_cache_entry(s8_t i)
   ip6_addr_set_zero(&(neighbor_cache[i].next_hop_address));
 }
 
+/**
+ * Set the address of a newly created neighbor cache entry.
+ *
+ * @param i the neighbor cache entry index
+ * @param ip6addr the IPv6 address of the neighbor
+ */
+static void
+nd6_neighbor_set_addr(s16_t i, const ip6_addr_t *ip6addr)
+{
+  ip6_addr_set(&(neighbor_cache[i].next_hop_address), ip6addr);
+#if LWIP_ND6_CACHE_HASH_SIZE
+  nd6_hash_link(&nd6_neighbor_hash, nd6_neighbor_links, (u16_t)i, ip6addr);
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+}
+
 /**
  * Search for a destination cache entry
  *
@@ -1559,6 +1760,17 @@ nd6_free_neighbor_cache_entry(s8_t i)
 static s16_t
 nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr)
 {
+#if LWIP_ND6_CACHE_HASH_SIZE
+  u16_t n;
+
+  IP6_ADDR_ZONECHECK(ip6addr);
+
+  for (n = nd6_destination_hash.bucket[nd6_hash_addr(ip6addr)]; n != 0; n = nd6_destination_links[n - 1].hnext) {
+    if (ip6_addr_cmp(ip6addr, &(destination_cache[n - 1].destination_addr))) {
+      return (s16_t)(n - 1);
+    }
+  }
+#else /* LWIP_ND6_CACHE_HASH_SIZE */
   s16_t i;
 
   IP6_ADDR_ZONECHECK(ip6addr);
@@ -1568,6 +1780,7 @@ nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr)
       return i;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
   return -1;
 }
 
@@ -1582,6 +1795,22 @@ static s16_t
 nd6_new_destination_cache_entry(void)
 {
   s16_t i, j;
+#if LWIP_ND6_CACHE_HASH_SIZE
+
+  /* Find an empty entry. */
+  for (i = (s16_t)nd6_destination_hash.first_free; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
+    if (ip6_addr_isany(&(destination_cache[i].destination_addr))) {
+      nd6_destination_hash.first_free = (u16_t)i;
+      return i;
+    }
+  }
+  nd6_destination_hash.first_free = LWIP_ND6_NUM_DESTINATIONS;
+
+  /* Recycle the least recently used entry; nd6_destination_set_addr()
+   * unlinks it when it gets its new address. */
+  j = (s16_t)(nd6_destination_hash.lru_head - 1);
+  LWIP_ASSERT("full destination cache must be on LRU list", j >= 0);
+#else /* LWIP_ND6_CACHE_HASH_SIZE */
   u32_t age;
 
   /* Find an empty entry. */
@@ -1597,12 +1826,38 @@ nd6_new_destination_cache_entry(void)
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
     if (destination_cache[i].age > age) {
       j = i;
+      age = destination_cache[i].age;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
 
   return j;
 }
 
+/**
+ * Set or clear the address of a destination cache entry.
+ *
+ * @param i the destination cache entry index
+ * @param ip6addr the IPv6 address of the destination, IP6_ADDR_ANY6 to
+ *        free the entry
+ */
+static void
+nd6_destination_set_addr(s16_t i, const ip6_addr_t *ip6addr)
+{
+#if LWIP_ND6_CACHE_HASH_SIZE
+  if (!ip6_addr_isany(&(destination_cache[i].destination_addr))) {
+    nd6_hash_unlink(&nd6_destination_hash, nd6_destination_links, (u16_t)i,
+                    &(destination_cache[i].destination_addr));
+  }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+  ip6_addr_set(&(destination_cache[i].destination_addr), ip6addr);
+#if LWIP_ND6_CACHE_HASH_SIZE
+  if (!ip6_addr_isany(ip6addr)) {
+    nd6_hash_link(&nd6_destination_hash, nd6_destination_links, (u16_t)i, ip6addr);
+  }
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+}
+
 /**
  * Clear the destination cache.
  *
@@ -1617,6 +1872,10 @@ nd6_clear_destination_cache(void)
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
     ip6_addr_set_any(&destination_cache[i].destination_addr);
   }
+#if LWIP_ND6_CACHE_HASH_SIZE
+  memset(&nd6_destination_hash, 0, sizeof(nd6_destination_hash));
+  memset(nd6_destination_links, 0, sizeof(nd6_destination_links));
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
 }
 
 /**
@@ -1806,7 +2065,7 @@ nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif)
 {
   s8_t router_index;
   s8_t free_router_index;
-  s8_t neighbor_index;
+  s16_t neighbor_index;
 
   IP6_ADDR_ZONECHECK_NETIF(router_addr, netif);
 
@@ -1819,7 +2078,7 @@ nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif)
       /* Could not create neighbor entry for this router. */
       return -1;
     }
-    ip6_addr_set(&(neighbor_cache[neighbor_index].next_hop_address), router_addr);
+    nd6_neighbor_set_addr(neighbor_index, router_addr);
     neighbor_cache[neighbor_index].netif = netif;
     neighbor_cache[neighbor_index].q = NULL;
     neighbor_cache[neighbor_index].state = ND6_INCOMPLETE;
@@ -1920,13 +2179,13 @@ nd6_new_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif)
  *         suitable next hop was found, ERR_MEM if no cache entry
  *         could be created
  */
-static s8_t
+static s16_t
 nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
 {
 #ifdef LWIP_HOOK_ND6_GET_GW
   const ip6_addr_t *next_hop_addr;
 #endif /* LWIP_HOOK_ND6_GET_GW */
-  s8_t i;
+  s16_t i;
   s16_t dst_idx;
 
   IP6_ADDR_ZONECHECK_NETIF(ip6addr, netif);
@@ -1966,7 +2225,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
       }
 
       /* Copy dest address to destination cache. */
-      ip6_addr_set(&(destination_cache[nd6_cached_destination_index].destination_addr), ip6addr);
+      nd6_destination_set_addr(dst_idx, ip6addr);
 
       /* Now find the next hop. is it a neighbor? */
       if (ip6_addr_islinklocal(ip6addr) ||
@@ -1985,7 +2244,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
         i = nd6_select_router(ip6addr, netif);
         if (i < 0) {
           /* No router found. */
-          ip6_addr_set_any(&(destination_cache[nd6_cached_destination_index].destination_addr));
+          nd6_destination_set_addr(dst_idx, IP6_ADDR_ANY6);
           return ERR_RTE;
         }
         destination_cache[nd6_cached_destination_index].pmtu = netif_mtu6(netif); /* Start with netif mtu, correct through ICMPv6 if necessary */
@@ -2024,8 +2283,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
       }
 
       /* Initialize fields. */
-      ip6_addr_copy(neighbor_cache[i].next_hop_address,
-                   destination_cache[nd6_cached_destination_index].next_hop_addr);
+      nd6_neighbor_set_addr(i, &(destination_cache[nd6_cached_destination_index].next_hop_addr));
       neighbor_cache[i].isrouter = 0;
       neighbor_cache[i].netif = netif;
       neighbor_cache[i].state = ND6_INCOMPLETE;
@@ -2036,6 +2294,10 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
 
   /* Reset this destination's age. */
   destination_cache[nd6_cached_destination_index].age = 0;
+#if LWIP_ND6_CACHE_HASH_SIZE
+  nd6_hash_touch(&nd6_destination_hash, nd6_destination_links, nd6_cached_destination_index);
+  nd6_hash_touch(&nd6_neighbor_hash, nd6_neighbor_links, (u16_t)nd6_cached_neighbor_index);
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
 
   return nd6_cached_neighbor_index;
 }
@@ -2048,7 +2310,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
  * @return ERR_OK if succeeded, ERR_MEM if out of memory
  */
 static err_t
-nd6_queue_packet(s8_t neighbor_index, struct pbuf *q)
+nd6_queue_packet(s16_t neighbor_index, struct pbuf *q)
 {
   err_t result = ERR_MEM;
   struct pbuf *p;
@@ -2173,7 +2435,7 @@ nd6_free_q(struct nd6_q_entry *q)
  * @param i the neighbor to send packets to
  */
 static void
-nd6_send_q(s8_t i)
+nd6_send_q(s16_t i)
 {
   struct ip6_hdr *ip6hdr;
   ip6_addr_t dest;
@@ -2246,13 +2508,13 @@ nd6_send_q(s8_t i)
 err_t
 nd6_get_next_hop_addr_or_queue(struct netif *netif, struct pbuf *q, const ip6_addr_t *ip6addr, const u8_t **hwaddrp)
 {
-  s8_t i;
+  s16_t i;
 
   /* Get next hop record. */
   i = nd6_get_next_hop_entry(ip6addr, netif);
   if (i < 0) {
     /* failed to get a next hop neighbor record. */
-    return i;
+    return (err_t)i;
   }
 
   /* Now that we have a destination record, send or queue the packet. */
@@ -2317,7 +2579,7 @@ nd6_get_destination_mtu(const ip6_addr_t *ip6addr, struct netif *netif)
 void
 nd6_reachability_hint(const ip6_addr_t *ip6addr)
 {
-  s8_t i;
+  s16_t i;
   s16_t dst_idx;
 
   /* Find destination in cache. */
@@ -2361,7 +2623,7 @@ nd6_reachability_hint(const ip6_addr_t *ip6addr)
 void
 nd6_cleanup_netif(struct netif *netif)
 {
-  u8_t i;
+  s16_t i;
   s8_t router_index;
   for (i = 0; i < LWIP_ND6_NUM_PREFIXES; i++) {
     if (prefix_list[i].netif == netif) {
@@ -59,6 +59,7 @@
 #include "lwip/priv/tcp_priv.h"
 #include "lwip/altcp.h"
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_route.h"
 #include "lwip/netbuf.h"
 #include "lwip/api.h"
 #include "lwip/priv/tcpip_priv.h"
@@ -92,7 +92,7 @@
 #define PBUF_POOL_BUFSIZE_ALIGNED LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE)
 
 static const struct pbuf *
-pbuf_skip_const(const struct pbuf *in, u16_t in_offset, u16_t *out_offset);
+pbuf_skip_const(const struct pbuf *in, pbuf_len_t in_offset, pbuf_len_t *out_offset);
 
 #if !LWIP_TCP || !TCP_QUEUE_OOSEQ || !PBUF_POOL_FREE_OOSEQ
 #define PBUF_POOL_IS_EMPTY()
@@ -176,7 +176,7 @@ pbuf_pool_is_empty(void)
 
 /* Initialize members of struct pbuf after allocation */
 static void
-pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len, pbuf_type type, u8_t flags)
+pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, pbuf_len_t tot_len, pbuf_len_t len, pbuf_type type, u8_t flags)
 {
   p->next = NULL;
   p->payload = payload;
@@ -186,6 +186,9 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
   p->flags = flags;
   p->ref = 1;
   p->if_idx = NETIF_NO_INDEX;
+#if LWIP_TCPIP_INPUT_BATCH
+  p->batch = NULL;
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 }
 
 /**
@@ -221,11 +224,11 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
  * is the first pbuf of a pbuf chain.
  */
 struct pbuf *
-pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
+pbuf_alloc(pbuf_layer layer, pbuf_len_t length, pbuf_type type)
 {
   struct pbuf *p;
   u16_t offset = (u16_t)layer;
-  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"U16_F")\n", length));
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"PBUF_LEN_F")\n", length));
 
   switch (type) {
     case PBUF_REF: /* fall through */
@@ -234,12 +237,12 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
       break;
     case PBUF_POOL: {
       struct pbuf *q, *last;
-      u16_t rem_len; /* remaining length */
+      pbuf_len_t rem_len; /* remaining length */
       p = NULL;
       last = NULL;
       rem_len = length;
       do {
-        u16_t qlen;
+        pbuf_len_t qlen;
         q = (struct pbuf *)memp_malloc(MEMP_PBUF_POOL);
         if (q == NULL) {
           PBUF_POOL_IS_EMPTY();
@@ -250,7 +253,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
           /* bail out unsuccessfully */
           return NULL;
         }
-        qlen = LWIP_MIN(rem_len, (u16_t)(PBUF_POOL_BUFSIZE_ALIGNED - LWIP_MEM_ALIGN_SIZE(offset)));
+        qlen = LWIP_MIN(rem_len, (pbuf_len_t)(PBUF_POOL_BUFSIZE_ALIGNED - LWIP_MEM_ALIGN_SIZE(offset)));
         pbuf_init_alloced_pbuf(q, LWIP_MEM_ALIGN((void *)((u8_t *)q + SIZEOF_STRUCT_PBUF + offset)),
                                rem_len, qlen, type, 0);
         LWIP_ASSERT("pbuf_alloc: pbuf q->payload properly aligned",
@@ -265,13 +268,13 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
           last->next = q;
         }
         last = q;
-        rem_len = (u16_t)(rem_len - qlen);
+        rem_len = (pbuf_len_t)(rem_len - qlen);
         offset = 0;
       } while (rem_len > 0);
       break;
     }
     case PBUF_RAM: {
-      u16_t payload_len = (u16_t)(LWIP_MEM_ALIGN_SIZE(offset) + LWIP_MEM_ALIGN_SIZE(length));
+      pbuf_len_t payload_len = (pbuf_len_t)(LWIP_MEM_ALIGN_SIZE(offset) + LWIP_MEM_ALIGN_SIZE(length));
       mem_size_t alloc_len = (mem_size_t)(LWIP_MEM_ALIGN_SIZE(SIZEOF_STRUCT_PBUF) + payload_len);
 
       /* bug #50040: Check for integer overflow when calculating alloc_len */
@@ -295,7 +298,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
       LWIP_ASSERT("pbuf_alloc: erroneous type", 0);
       return NULL;
   }
-  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"U16_F") == %p\n", length, (void *)p));
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"PBUF_LEN_F") == %p\n", length, (void *)p));
   return p;
 }
 
@@ -324,7 +327,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
  * @return the allocated pbuf.
  */
 struct pbuf *
-pbuf_alloc_reference(void *payload, u16_t length, pbuf_type type)
+pbuf_alloc_reference(void *payload, pbuf_len_t length, pbuf_type type)
 {
   struct pbuf *p;
   LWIP_ASSERT("invalid pbuf_type", (type == PBUF_REF) || (type == PBUF_ROM));
@@ -360,15 +363,15 @@ pbuf_alloc_reference(void *payload, u16_t length, pbuf_type type)
  *        big enough to hold 'length' plus the header size
  */
 struct pbuf *
-pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf_custom *p,
-                    void *payload_mem, u16_t payload_mem_len)
+pbuf_alloced_custom(pbuf_layer l, pbuf_len_t length, pbuf_type type, struct pbuf_custom *p,
+                    void *payload_mem, pbuf_len_t payload_mem_len)
 {
   u16_t offset = (u16_t)l;
   void *payload;
-  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloced_custom(length=%"U16_F")\n", length));
+  LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloced_custom(length=%"PBUF_LEN_F")\n", length));
 
   if (LWIP_MEM_ALIGN_SIZE(offset) + length > payload_mem_len) {
-    LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloced_custom(length=%"U16_F") buffer too short\n", length));
+    LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloced_custom(length=%"PBUF_LEN_F") buffer too short\n", length));
     return NULL;
   }
 
@@ -399,11 +402,11 @@ pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf_cust
  * @note Despite its name, pbuf_realloc cannot grow the size of a pbuf (chain).
  */
 void
-pbuf_realloc(struct pbuf *p, u16_t new_len)
+pbuf_realloc(struct pbuf *p, pbuf_len_t new_len)
 {
   struct pbuf *q;
-  u16_t rem_len; /* remaining length */
-  u16_t shrink;
+  pbuf_len_t rem_len; /* remaining length */
+  pbuf_len_t shrink;
 
   LWIP_ASSERT("pbuf_realloc: p != NULL", p != NULL);
 
@@ -415,7 +418,7 @@ pbuf_realloc(struct pbuf *p, u16_t new_len)
 
   /* the pbuf chain grows by (new_len - p->tot_len) bytes
    * (which may be negative in case of shrinking) */
-  shrink = (u16_t)(p->tot_len - new_len);
+  shrink = (pbuf_len_t)(p->tot_len - new_len);
 
   /* first, step over any pbufs that should remain in the chain */
   rem_len = new_len;
@@ -423,9 +426,9 @@ pbuf_realloc(struct pbuf *p, u16_t new_len)
   /* should this pbuf be kept? */
   while (rem_len > q->len) {
     /* decrease remaining length by pbuf length */
-    rem_len = (u16_t)(rem_len - q->len);
+    rem_len = (pbuf_len_t)(rem_len - q->len);
     /* decrease total length indicator */
-    q->tot_len = (u16_t)(q->tot_len - shrink);
+    q->tot_len = (pbuf_len_t)(q->tot_len - shrink);
     /* proceed to next pbuf in chain */
     q = q->next;
     LWIP_ASSERT("pbuf_realloc: q != NULL", q != NULL);
@@ -486,7 +489,7 @@ pbuf_add_header_impl(struct pbuf *p, size_t header_size_increment, u8_t force)
 
   increment_magnitude = (u16_t)header_size_increment;
   /* Do not allow tot_len to wrap as a result. */
-  if ((u16_t)(increment_magnitude + p->tot_len) < increment_magnitude) {
+  if ((pbuf_len_t)(increment_magnitude + p->tot_len) < increment_magnitude) {
     return 1;
   }
 
@@ -520,8 +523,8 @@ pbuf_add_header_impl(struct pbuf *p, size_t header_size_increment, u8_t force)
 
   /* modify pbuf fields */
   p->payload = payload;
-  p->len = (u16_t)(p->len + increment_magnitude);
-  p->tot_len = (u16_t)(p->tot_len + increment_magnitude);
+  p->len = (pbuf_len_t)(p->len + increment_magnitude);
+  p->tot_len = (pbuf_len_t)(p->tot_len + increment_magnitude);
 
 
   return 0;
@@ -603,8 +606,8 @@ pbuf_remove_header(struct pbuf *p, size_t header_size_decrement)
   /* increase payload pointer (guarded by length check above) */
   p->payload = (u8_t *)p->payload + header_size_decrement;
   /* modify pbuf length fields */
-  p->len = (u16_t)(p->len - increment_magnitude);
-  p->tot_len = (u16_t)(p->tot_len - increment_magnitude);
+  p->len = (pbuf_len_t)(p->len - increment_magnitude);
+  p->tot_len = (pbuf_len_t)(p->tot_len - increment_magnitude);
 
   LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_remove_header: old %p new %p (%"U16_F")\n",
               (void *)payload, (void *)p->payload, increment_magnitude));
@@ -664,18 +667,18 @@ pbuf_header_force(struct pbuf *p, s16_t header_size_increment)
  * @param size The number of bytes to remove from the beginning of the pbuf list.
  *             While size >= p->len, pbufs are freed.
  *        ATTENTION: this is the opposite direction as @ref pbuf_header, but
- *                   takes an u16_t not s16_t!
+ *                   takes an unsigned size not s16_t!
  * @return the new head pbuf
  */
 struct pbuf *
-pbuf_free_header(struct pbuf *q, u16_t size)
+pbuf_free_header(struct pbuf *q, pbuf_len_t size)
 {
   struct pbuf *p = q;
-  u16_t free_left = size;
+  pbuf_len_t free_left = size;
   while (free_left && p) {
     if (free_left >= p->len) {
       struct pbuf *f = p;
-      free_left = (u16_t)(free_left - p->len);
+      free_left = (pbuf_len_t)(free_left - p->len);
       p = p->next;
       f->next = 0;
       pbuf_free(f);
@@ -860,13 +863,13 @@ pbuf_cat(struct pbuf *h, struct pbuf *t)
   /* proceed to last pbuf of chain */
   for (p = h; p->next != NULL; p = p->next) {
     /* add total length of second chain to all totals of first chain */
-    p->tot_len = (u16_t)(p->tot_len + t->tot_len);
+    p->tot_len = (pbuf_len_t)(p->tot_len + t->tot_len);
   }
   /* { p is last pbuf of first h chain, p->next == NULL } */
   LWIP_ASSERT("p->tot_len == p->len (of last pbuf in chain)", p->tot_len == p->len);
   LWIP_ASSERT("p->next == NULL", p->next == NULL);
   /* add total length of second chain to last pbuf total of first chain */
-  p->tot_len = (u16_t)(p->tot_len + t->tot_len);
+  p->tot_len = (pbuf_len_t)(p->tot_len + t->tot_len);
   /* chain last pbuf of head (p) with first of tail (t) */
   p->next = t;
   /* p->next now references t, but the caller will drop its reference to t,
@@ -920,7 +923,7 @@ pbuf_dechain(struct pbuf *p)
     /* assert tot_len invariant: (p->tot_len == p->len + (p->next? p->next->tot_len: 0) */
     LWIP_ASSERT("p->tot_len == p->len + q->tot_len", q->tot_len == p->tot_len - p->len);
     /* enforce invariant if assertion is disabled */
-    q->tot_len = (u16_t)(p->tot_len - p->len);
+    q->tot_len = (pbuf_len_t)(p->tot_len - p->len);
     /* decouple pbuf from remainder */
     p->next = NULL;
     /* total length of pbuf p is its own length only */
@@ -1023,13 +1026,13 @@ pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from)
  * @param offset offset into the packet buffer from where to begin copying len bytes
  * @return the number of bytes copied, or 0 on failure
  */
-u16_t
-pbuf_copy_partial(const struct pbuf *buf, void *dataptr, u16_t len, u16_t offset)
+pbuf_len_t
+pbuf_copy_partial(const struct pbuf *buf, void *dataptr, pbuf_len_t len, pbuf_len_t offset)
 {
   const struct pbuf *p;
-  u16_t left = 0;
-  u16_t buf_copy_len;
-  u16_t copied_total = 0;
+  pbuf_len_t left = 0;
+  pbuf_len_t buf_copy_len;
+  pbuf_len_t copied_total = 0;
 
   LWIP_ERROR("pbuf_copy_partial: invalid buf", (buf != NULL), return 0;);
   LWIP_ERROR("pbuf_copy_partial: invalid dataptr", (dataptr != NULL), return 0;);
@@ -1038,18 +1041,18 @@ pbuf_copy_partial(const struct pbuf *buf, void *dataptr, u16_t len, u16_t offset
   for (p = buf; len != 0 && p != NULL; p = p->next) {
     if ((offset != 0) && (offset >= p->len)) {
       /* don't copy from this buffer -> on to the next */
-      offset = (u16_t)(offset - p->len);
+      offset = (pbuf_len_t)(offset - p->len);
     } else {
       /* copy from this buffer. maybe only partially. */
-      buf_copy_len = (u16_t)(p->len - offset);
+      buf_copy_len = (pbuf_len_t)(p->len - offset);
       if (buf_copy_len > len) {
         buf_copy_len = len;
       }
       /* copy the necessary parts of the buffer */
       MEMCPY(&((char *)dataptr)[left], &((char *)p->payload)[offset], buf_copy_len);
-      copied_total = (u16_t)(copied_total + buf_copy_len);
-      left = (u16_t)(left + buf_copy_len);
-      len = (u16_t)(len - buf_copy_len);
+      copied_total = (pbuf_len_t)(copied_total + buf_copy_len);
+      left = (pbuf_len_t)(left + buf_copy_len);
+      len = (pbuf_len_t)(len - buf_copy_len);
       offset = 0;
     }
   }
@@ -1071,10 +1074,10 @@ pbuf_copy_partial(const struct pbuf *buf, void *dataptr, u16_t len, u16_t offset
  * @return the number of bytes copied, or 0 on failure
  */
 void *
-pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, u16_t len, u16_t offset)
+pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, pbuf_len_t len, pbuf_len_t offset)
 {
   const struct pbuf *q;
-  u16_t out_offset;
+  pbuf_len_t out_offset;
 
   LWIP_ERROR("pbuf_get_contiguous: invalid buf", (p != NULL), return NULL;);
   LWIP_ERROR("pbuf_get_contiguous: invalid dataptr", (buffer != NULL), return NULL;);
@@ -1114,13 +1117,13 @@ void pbuf_split_64k(struct pbuf *p, struct pbuf **rest)
 {
   *rest = NULL;
   if ((p != NULL) && (p->next != NULL)) {
-    u16_t tot_len_front = p->len;
+    u32_t tot_len_front = p->len;
     struct pbuf *i = p;
     struct pbuf *r = p->next;
 
-    /* continue until the total length (summed up as u16_t) overflows */
-    while ((r != NULL) && ((u16_t)(tot_len_front + r->len) >= tot_len_front)) {
-      tot_len_front = (u16_t)(tot_len_front + r->len);
+    /* continue until the total length (summed up as u16_t) would overflow */
+    while ((r != NULL) && (tot_len_front + r->len <= 0xFFFF)) {
+      tot_len_front = tot_len_front + r->len;
       i = r;
       r = r->next;
     }
@@ -1131,7 +1134,7 @@ void pbuf_split_64k(struct pbuf *p, struct pbuf **rest)
     if (r != NULL) {
       /* Update the tot_len field in the first part */
       for (i = p; i != NULL; i = i->next) {
-        i->tot_len = (u16_t)(i->tot_len - r->tot_len);
+        i->tot_len = (pbuf_len_t)(i->tot_len - r->tot_len);
         LWIP_ASSERT("tot_len/len mismatch in last pbuf",
                     (i->next != NULL) || (i->tot_len == i->len));
       }
@@ -1149,14 +1152,14 @@ void pbuf_split_64k(struct pbuf *p, struct pbuf **rest)
 
 /* Actual implementation of pbuf_skip() but returning const pointer... */
 static const struct pbuf *
-pbuf_skip_const(const struct pbuf *in, u16_t in_offset, u16_t *out_offset)
+pbuf_skip_const(const struct pbuf *in, pbuf_len_t in_offset, pbuf_len_t *out_offset)
 {
-  u16_t offset_left = in_offset;
+  pbuf_len_t offset_left = in_offset;
   const struct pbuf *q = in;
 
   /* get the correct pbuf */
   while ((q != NULL) && (q->len <= offset_left)) {
-    offset_left = (u16_t)(offset_left - q->len);
+    offset_left = (pbuf_len_t)(offset_left - q->len);
     q = q->next;
   }
   if (out_offset != NULL) {
@@ -1175,7 +1178,7 @@ pbuf_skip_const(const struct pbuf *in, u16_t in_offset, u16_t *out_offset)
  * @return the pbuf in the queue where the offset is
  */
 struct pbuf *
-pbuf_skip(struct pbuf *in, u16_t in_offset, u16_t *out_offset)
+pbuf_skip(struct pbuf *in, pbuf_len_t in_offset, pbuf_len_t *out_offset)
 {
   const struct pbuf *out = pbuf_skip_const(in, in_offset, out_offset);
   return LWIP_CONST_CAST(struct pbuf *, out);
@@ -1193,7 +1196,7 @@ pbuf_skip(struct pbuf *in, u16_t in_offset, u16_t *out_offset)
  * @return ERR_OK if successful, ERR_MEM if the pbuf is not big enough
  */
 err_t
-pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len)
+pbuf_take(struct pbuf *buf, const void *dataptr, pbuf_len_t len)
 {
   struct pbuf *p;
   size_t buf_copy_len;
@@ -1237,21 +1240,21 @@ pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len)
  * @return ERR_OK if successful, ERR_MEM if the pbuf is not big enough
  */
 err_t
-pbuf_take_at(struct pbuf *buf, const void *dataptr, u16_t len, u16_t offset)
+pbuf_take_at(struct pbuf *buf, const void *dataptr, pbuf_len_t len, pbuf_len_t offset)
 {
-  u16_t target_offset;
+  pbuf_len_t target_offset;
   struct pbuf *q = pbuf_skip(buf, offset, &target_offset);
 
   /* return requested data if pbuf is OK */
   if ((q != NULL) && (q->tot_len >= target_offset + len)) {
-    u16_t remaining_len = len;
+    pbuf_len_t remaining_len = len;
     const u8_t *src_ptr = (const u8_t *)dataptr;
     /* copy the part that goes into the first pbuf */
-    u16_t first_copy_len;
+    pbuf_len_t first_copy_len;
     LWIP_ASSERT("check pbuf_skip result", target_offset < q->len);
-    first_copy_len = (u16_t)LWIP_MIN(q->len - target_offset, len);
+    first_copy_len = (pbuf_len_t)LWIP_MIN(q->len - target_offset, len);
     MEMCPY(((u8_t *)q->payload) + target_offset, dataptr, first_copy_len);
-    remaining_len = (u16_t)(remaining_len - first_copy_len);
+    remaining_len = (pbuf_len_t)(remaining_len - first_copy_len);
     src_ptr += first_copy_len;
     if (remaining_len > 0) {
       return pbuf_take(q->next, src_ptr, remaining_len);
@@ -1368,7 +1371,7 @@ pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
  * @return byte at an offset into p OR ZERO IF 'offset' >= p->tot_len
  */
 u8_t
-pbuf_get_at(const struct pbuf *p, u16_t offset)
+pbuf_get_at(const struct pbuf *p, pbuf_len_t offset)
 {
   int ret = pbuf_try_get_at(p, offset);
   if (ret >= 0) {
@@ -1386,9 +1389,9 @@ pbuf_get_at(const struct pbuf *p, u16_t offset)
  * @return byte at an offset into p [0..0xFF] OR negative if 'offset' >= p->tot_len
  */
 int
-pbuf_try_get_at(const struct pbuf *p, u16_t offset)
+pbuf_try_get_at(const struct pbuf *p, pbuf_len_t offset)
 {
-  u16_t q_idx;
+  pbuf_len_t q_idx;
   const struct pbuf *q = pbuf_skip_const(p, offset, &q_idx);
 
   /* return requested data if pbuf is OK */
@@ -1408,9 +1411,9 @@ pbuf_try_get_at(const struct pbuf *p, u16_t offset)
  * @param data byte to write at an offset into p
  */
 void
-pbuf_put_at(struct pbuf *p, u16_t offset, u8_t data)
+pbuf_put_at(struct pbuf *p, pbuf_len_t offset, u8_t data)
 {
-  u16_t q_idx;
+  pbuf_len_t q_idx;
   struct pbuf *q = pbuf_skip(p, offset, &q_idx);
 
   /* write requested data if pbuf is OK */
@@ -1433,31 +1436,13 @@ pbuf_put_at(struct pbuf *p, u16_t offset, u8_t data)
 u16_t
 pbuf_memcmp(const struct pbuf *p, u16_t offset, const void *s2, u16_t n)
 {
-  u16_t start = offset;
-  const struct pbuf *q = p;
-  u16_t i;
+  struct pbuf_iter it;
 
   /* pbuf long enough to perform check? */
-  if (p->tot_len < (offset + n)) {
+  if ((p->tot_len < (offset + n)) || (pbuf_iter_init(&it, p, offset) != ERR_OK)) {
     return 0xffff;
   }
-
-  /* get the correct pbuf from chain. We know it succeeds because of p->tot_len check above. */
-  while ((q != NULL) && (q->len <= start)) {
-    start = (u16_t)(start - q->len);
-    q = q->next;
-  }
-
-  /* return requested data if pbuf is OK */
-  for (i = 0; i < n; i++) {
-    /* We know pbuf_get_at() succeeds because of p->tot_len check above. */
-    u8_t a = pbuf_get_at(q, (u16_t)(start + i));
-    u8_t b = ((const u8_t *)s2)[i];
-    if (a != b) {
-      return (u16_t)LWIP_MIN(i + 1, 0xFFFF);
-    }
-  }
-  return 0;
+  return pbuf_iter_memcmp(&it, s2, n);
 }
 
 /**
@@ -1475,15 +1460,24 @@ pbuf_memcmp(const struct pbuf *p, u16_t offset, const void *s2, u16_t n)
 u16_t
 pbuf_memfind(const struct pbuf *p, const void *mem, u16_t mem_len, u16_t start_offset)
 {
-  u16_t i;
-  u16_t max_cmp_start = (u16_t)(p->tot_len - mem_len);
-  if (p->tot_len >= mem_len + start_offset) {
-    for (i = start_offset; i <= max_cmp_start; i++) {
-      u16_t plus = pbuf_memcmp(p, i, mem, mem_len);
-      if (plus == 0) {
-        return i;
-      }
+  struct pbuf_iter it;
+  u8_t first;
+
+  if ((p->tot_len < mem_len + start_offset) || (pbuf_iter_init(&it, p, start_offset) != ERR_OK)) {
+    return 0xFFFF;
+  }
+  if (mem_len == 0) {
+    return start_offset;
+  }
+  /* scan for the first byte of 'mem', then compare the rest without
+     restarting from the head of the chain */
+  first = ((const u8_t *)mem)[0];
+  while ((pbuf_iter_memchr(&it, first) != PBUF_ITER_NOT_FOUND) &&
+         (pbuf_iter_left(&it) >= mem_len) && (pbuf_iter_offset(&it) < 0xFFFF)) {
+    if (pbuf_iter_memcmp(&it, mem, mem_len) == 0) {
+      return (u16_t)pbuf_iter_offset(&it);
     }
+    pbuf_iter_skip(&it, 1);
   }
   return 0xFFFF;
 }
@@ -1503,7 +1497,7 @@ u16_t
 pbuf_strstr(const struct pbuf *p, const char *substr)
 {
   size_t substr_len;
-  if ((substr == NULL) || (substr[0] == 0) || (p->tot_len == 0xFFFF)) {
+  if ((substr == NULL) || (substr[0] == 0) || (p->tot_len >= 0xFFFF)) {
     return 0xFFFF;
   }
   substr_len = strlen(substr);
@@ -1512,3 +1506,251 @@ pbuf_strstr(const struct pbuf *p, const char *substr)
   }
   return pbuf_memfind(p, substr, (u16_t)substr_len, 0);
 }
+
+/* Move the cursor past any exhausted (or empty) pbufs so that, unless the
+ * end of the chain is reached, q_offset always points into q->payload. */
+static void
+pbuf_iter_normalize(struct pbuf_iter *it)
+{
+  while ((it->left > 0) && (it->q != NULL) && (it->q_offset >= it->q->len)) {
+    it->q_offset = (pbuf_len_t)(it->q_offset - it->q->len);
+    it->q = it->q->next;
+  }
+}
+
+/**
+ * @ingroup pbuf
+ * Initialize a read cursor at a given offset into a pbuf chain.
+ * The cursor stays valid as long as the chain is not modified.
+ *
+ * @param it cursor to initialize
+ * @param p pbuf chain to read from
+ * @param offset offset into p at which the cursor starts
+ * @return ERR_OK if successful, ERR_BUF if offset > p->tot_len
+ */
+err_t
+pbuf_iter_init(struct pbuf_iter *it, const struct pbuf *p, pbuf_len_t offset)
+{
+  LWIP_ASSERT("pbuf_iter_init: invalid cursor", it != NULL);
+  LWIP_ERROR("pbuf_iter_init: invalid pbuf", p != NULL, return ERR_ARG;);
+
+  if (offset > p->tot_len) {
+    return ERR_BUF;
+  }
+  it->q = p;
+  it->q_offset = offset;
+  it->offset = offset;
+  it->left = (pbuf_len_t)(p->tot_len - offset);
+  pbuf_iter_normalize(it);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pbuf
+ * Advance a cursor by 'len' bytes.
+ *
+ * @param it cursor to advance
+ * @param len number of bytes to skip
+ * @return ERR_OK if successful, ERR_BUF if less than 'len' bytes are left
+ *         (the cursor is not moved in that case)
+ */
+err_t
+pbuf_iter_skip(struct pbuf_iter *it, pbuf_len_t len)
+{
+  if (len > it->left) {
+    return ERR_BUF;
+  }
+  it->q_offset = (pbuf_len_t)(it->q_offset + len);
+  it->offset = (pbuf_len_t)(it->offset + len);
+  it->left = (pbuf_len_t)(it->left - len);
+  pbuf_iter_normalize(it);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pbuf
+ * Get the byte at the cursor position without advancing the cursor.
+ *
+ * @param it cursor to read from
+ * @return byte at the cursor [0..0xFF] OR negative if no bytes are left
+ */
+int
+pbuf_iter_peek_u8(const struct pbuf_iter *it)
+{
+  if (it->left == 0) {
+    return -1;
+  }
+  return ((const u8_t *)it->q->payload)[it->q_offset];
+}
+
+/**
+ * @ingroup pbuf
+ * Read one byte at the cursor position and advance the cursor.
+ *
+ * @param it cursor to read from
+ * @param data the byte is returned here
+ * @return ERR_OK if successful, ERR_BUF if no bytes are left
+ */
+err_t
+pbuf_iter_read_u8(struct pbuf_iter *it, u8_t *data)
+{
+  int c = pbuf_iter_peek_u8(it);
+  if (c < 0) {
+    return ERR_BUF;
+  }
+  *data = (u8_t)c;
+  return pbuf_iter_skip(it, 1);
+}
+
+/**
+ * @ingroup pbuf
+ * Read a 16 bit value in network byte order at the cursor position and
+ * advance the cursor.
+ *
+ * @param it cursor to read from
+ * @param data the value is returned here (in host byte order)
+ * @return ERR_OK if successful, ERR_BUF if less than 2 bytes are left
+ *         (the cursor is not moved in that case)
+ */
+err_t
+pbuf_iter_read_u16(struct pbuf_iter *it, u16_t *data)
+{
+  u16_t val;
+  if (pbuf_iter_read(it, &val, sizeof(val)) != sizeof(val)) {
+    return ERR_BUF;
+  }
+  *data = lwip_ntohs(val);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pbuf
+ * Read a 32 bit value in network byte order at the cursor position and
+ * advance the cursor.
+ *
+ * @param it cursor to read from
+ * @param data the value is returned here (in host byte order)
+ * @return ERR_OK if successful, ERR_BUF if less than 4 bytes are left
+ *         (the cursor is not moved in that case)
+ */
+err_t
+pbuf_iter_read_u32(struct pbuf_iter *it, u32_t *data)
+{
+  u32_t val;
+  if (pbuf_iter_read(it, &val, sizeof(val)) != sizeof(val)) {
+    return ERR_BUF;
+  }
+  *data = lwip_ntohl(val);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pbuf
+ * Copy 'len' bytes at the cursor position into a buffer and advance the
+ * cursor. Nothing is copied if less than 'len' bytes are left.
+ *
+ * @param it cursor to read from
+ * @param dataptr buffer to copy to
+ * @param len number of bytes to copy
+ * @return the number of bytes copied ('len' or 0)
+ */
+pbuf_len_t
+pbuf_iter_read(struct pbuf_iter *it, void *dataptr, pbuf_len_t len)
+{
+  pbuf_len_t copied = 0;
+
+  if (len > it->left) {
+    return 0;
+  }
+  while (copied < len) {
+    pbuf_len_t chunk = (pbuf_len_t)LWIP_MIN(it->q->len - it->q_offset, len - copied);
+    MEMCPY(&((u8_t *)dataptr)[copied], &((const u8_t *)it->q->payload)[it->q_offset], chunk);
+    copied = (pbuf_len_t)(copied + chunk);
+    pbuf_iter_skip(it, chunk);
+  }
+  return len;
+}
+
+/**
+ * @ingroup pbuf
+ * Get direct access to the contiguous bytes at the cursor position (i.e. up
+ * to the end of the current pbuf). The cursor is not advanced, use
+ * pbuf_iter_skip() after consuming (part of) the span.
+ *
+ * @param it cursor to read from
+ * @param len the number of contiguous bytes is returned here
+ * @return pointer to the data at the cursor or NULL if no bytes are left
+ */
+const void *
+pbuf_iter_span(const struct pbuf_iter *it, pbuf_len_t *len)
+{
+  if (it->left == 0) {
+    *len = 0;
+    return NULL;
+  }
+  *len = (pbuf_len_t)LWIP_MIN(it->q->len - it->q_offset, it->left);
+  return &((const u8_t *)it->q->payload)[it->q_offset];
+}
+
+/**
+ * @ingroup pbuf
+ * Advance the cursor to the next occurrence of a byte value (starting at the
+ * current position).
+ *
+ * @param it cursor to search from
+ * @param c byte value to search for
+ * @return offset of the byte from the start of the chain (the cursor then
+ *         points to it) or PBUF_ITER_NOT_FOUND if not found (the cursor is
+ *         then at the end)
+ */
+pbuf_len_t
+pbuf_iter_memchr(struct pbuf_iter *it, u8_t c)
+{
+  pbuf_len_t len;
+  const u8_t *span;
+
+  while ((span = (const u8_t *)pbuf_iter_span(it, &len)) != NULL) {
+    const u8_t *found = (const u8_t *)memchr(span, c, len);
+    if (found != NULL) {
+      pbuf_iter_skip(it, (pbuf_len_t)(found - span));
+      return it->offset;
+    }
+    pbuf_iter_skip(it, len);
+  }
+  return PBUF_ITER_NOT_FOUND;
+}
+
+/**
+ * @ingroup pbuf
+ * Compare the bytes at the cursor position with memory s2, both of length n.
+ * The cursor is not advanced.
+ *
+ * @param it cursor to compare from
+ * @param s2 buffer to compare
+ * @param n length of buffer to compare
+ * @return zero if equal, nonzero otherwise
+ *         (0xffff if less than n bytes are left, diffoffset+1 otherwise)
+ */
+u16_t
+pbuf_iter_memcmp(const struct pbuf_iter *it, const void *s2, u16_t n)
+{
+  struct pbuf_iter cur = *it;
+  u16_t i = 0;
+
+  if (n > cur.left) {
+    return 0xffff;
+  }
+  while (i < n) {
+    pbuf_len_t len, j;
+    const u8_t *span = (const u8_t *)pbuf_iter_span(&cur, &len);
+    len = (pbuf_len_t)LWIP_MIN(len, (pbuf_len_t)(n - i));
+    for (j = 0; j < len; j++) {
+      if (span[j] != ((const u8_t *)s2)[i + j]) {
+        return (u16_t)LWIP_MIN(i + j + 1U, 0xFFFFU);
+      }
+    }
+    i = (u16_t)(i + len);
+    pbuf_iter_skip(&cur, len);
+  }
+  return 0;
+}
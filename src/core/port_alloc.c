@@ -0,0 +1,177 @@
+/**
+ * @file
+ * Ephemeral port allocator
+ *
+ * Local ports for UDP and TCP PCBs bound to port 0 (and for connecting TCP
+ * PCBs) are taken from a bitmap of the ephemeral port range instead of
+ * trying ports one after another and checking each against all PCBs.
+ *
+ * A bit is set whenever a port of the range is bound. Bits are not cleared
+ * when PCBs go away: the port is only handed out again once the whole range
+ * has been used up and the owner rebuilds the bitmap from its PCB lists (see
+ * port_alloc_reset() and port_alloc_set()). Allocation thus takes a scan of
+ * the bitmap, and the PCB lists are only walked once per cycle through the
+ * range.
+ *
+ * The search starts at an offset computed as in RFC 6056 algorithm 3: a
+ * keyed hash of the remote end plus a counter. Connections to the same peer
+ * use different ports, and the ports cannot easily be guessed by others.
+ * Without a remote end (binding to port 0), the offset is random.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#include "lwip/opt.h"
+
+#if LWIP_PORT_ALLOC_BITMAP /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/priv/port_alloc.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+/**
+ * Initialize an ephemeral port range: no port in use, random secret.
+ *
+ * @param pa the port range to initialize
+ */
+void
+port_alloc_init(struct port_alloc *pa)
+{
+  port_alloc_reset(pa);
+#ifdef LWIP_RAND
+  pa->secret = LWIP_RAND();
+  pa->counter = (u16_t)LWIP_RAND();
+#endif /* LWIP_RAND */
+}
+
+/**
+ * Mark all ports of a range as free. The caller must mark the ports that
+ * are still in use again with port_alloc_set().
+ *
+ * @param pa the port range to reset
+ */
+void
+port_alloc_reset(struct port_alloc *pa)
+{
+  memset(pa->map, 0, PORT_ALLOC_WORDS(pa->start, pa->end) * sizeof(u32_t));
+}
+
+/**
+ * Mark a port as in use.
+ *
+ * @param pa the port range
+ * @param port the port (ports outside the range are ignored)
+ */
+void
+port_alloc_set(struct port_alloc *pa, u16_t port)
+{
+  if ((port >= pa->start) && (port <= pa->end)) {
+    u16_t idx = (u16_t)(port - pa->start);
+    pa->map[idx / 32] |= (u32_t)1 << (idx % 32);
+  }
+}
+
+/** RFC 6056 F(): keyed hash of the remote end of a connection */
+static u32_t
+port_alloc_offset(const struct port_alloc *pa, const ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t h = pa->secret ^ remote_port;
+
+  if (remote_ip == NULL) {
+#ifdef LWIP_RAND
+    return LWIP_RAND();
+#else /* LWIP_RAND */
+    return h;
+#endif /* LWIP_RAND */
+  }
+#if LWIP_IPV6
+  if (IP_IS_V6(remote_ip)) {
+    const ip6_addr_t *ip6 = ip_2_ip6(remote_ip);
+    u8_t i;
+    for (i = 0; i < 4; i++) {
+      h = (h ^ ip6->addr[i]) * 0x9e3779b1UL;
+    }
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  if (!IP_IS_V6(remote_ip)) {
+    h = (h ^ ip4_addr_get_u32(ip_2_ip4(remote_ip))) * 0x9e3779b1UL;
+  }
+#endif /* LWIP_IPV4 */
+  return h ^ (h >> 16);
+}
+
+/**
+ * Allocate a port that has not been marked as in use.
+ *
+ * @param pa the port range to allocate from
+ * @param remote_ip remote address the port is used for or NULL if unknown
+ * @param remote_port remote port the port is used for (ignored if remote_ip is NULL)
+ * @return the port (marked as in use now) or 0 if all ports are marked
+ */
+u16_t
+port_alloc_new(struct port_alloc *pa, const ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t num = (u32_t)pa->end - pa->start + 1;
+  u32_t words = PORT_ALLOC_WORDS(pa->start, pa->end);
+  u32_t idx, word, i;
+
+  idx = (port_alloc_offset(pa, remote_ip, remote_port) + pa->counter) % num;
+  word = idx / 32;
+  /* one more word than the bitmap has: the first word is searched from
+     idx on only, so it has to be looked at again for the ports before idx */
+  for (i = 0; i <= words; i++) {
+    u32_t free_bits = ~pa->map[word];
+    if (i == 0) {
+      free_bits &= ~(((u32_t)1 << (idx % 32)) - 1);
+    }
+    if ((word == words - 1) && ((num % 32) != 0)) {
+      /* no ports beyond the end of the range */
+      free_bits &= ((u32_t)1 << (num % 32)) - 1;
+    }
+    if (free_bits != 0) {
+      u32_t bit = 0;
+      u32_t found;
+      while ((free_bits & ((u32_t)1 << bit)) == 0) {
+        bit++;
+      }
+      pa->map[word] |= (u32_t)1 << bit;
+      found = word * 32 + bit;
+      /* the next search for the same remote end starts behind this port */
+      pa->counter = (u16_t)(pa->counter + ((found + num - idx) % num) + 1);
+      return (u16_t)(pa->start + found);
+    }
+    word = (word + 1) % words;
+  }
+  return 0;
+}
+
+#endif /* LWIP_PORT_ALLOC_BITMAP */
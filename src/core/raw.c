@@ -65,6 +65,19 @@
 /** The list of RAW PCBs */
 static struct raw_pcb *raw_pcbs;
 
+#if RAW_PCB_HASH_SIZE
+/** RAW PCBs by protocol, chained through hnext */
+static struct raw_pcb *raw_proto_hash[RAW_PCB_HASH_SIZE];
+
+#define RAW_PCB_HASH(proto) ((u16_t)((((u32_t)((proto) * 0x9e3779b1UL)) >> 16) % RAW_PCB_HASH_SIZE))
+/* first PCB and next PCB in the chain searched by raw_input() */
+#define RAW_PCB_INPUT_HEAD(proto) (&raw_proto_hash[RAW_PCB_HASH(proto)])
+#define RAW_PCB_INPUT_NEXT(pcb) ((pcb)->hnext)
+#else /* RAW_PCB_HASH_SIZE */
+#define RAW_PCB_INPUT_HEAD(proto) (&raw_pcbs)
+#define RAW_PCB_INPUT_NEXT(pcb) ((pcb)->next)
+#endif /* RAW_PCB_HASH_SIZE */
+
 static u8_t
 raw_input_local_match(struct raw_pcb *pcb, u8_t broadcast)
 {
@@ -135,6 +148,7 @@ raw_input_state_t
 raw_input(struct pbuf *p, struct netif *inp)
 {
   struct raw_pcb *pcb, *prev;
+  struct raw_pcb **head;
   s16_t proto;
   raw_input_state_t ret = RAW_INPUT_NONE;
   u8_t broadcast = ip_addr_isbroadcast(ip_current_dest_addr(), ip_current_netif());
@@ -160,7 +174,8 @@ raw_input(struct pbuf *p, struct netif *inp)
 #endif /* LWIP_IPV4 */
 
   prev = NULL;
-  pcb = raw_pcbs;
+  head = RAW_PCB_INPUT_HEAD(proto);
+  pcb = *head;
   /* loop through all raw pcbs until the packet is eaten by one */
   /* this allows multiple pcbs to match against the packet by design */
   while (pcb != NULL) {
@@ -168,7 +183,12 @@ raw_input(struct pbuf *p, struct netif *inp)
         (((pcb->flags & RAW_FLAGS_CONNECTED) == 0) ||
          ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
       /* receive callback function available? */
-      if (pcb->recv != NULL) {
+      if ((pcb->recv != NULL)
+#if LWIP_SO_ATTACH_FILTER
+          /* ...and accepted by the pcb's filter? */
+          && ((pcb->filter == NULL) || (lwip_bpf_filter(pcb->filter, p) != 0))
+#endif /* LWIP_SO_ATTACH_FILTER */
+         ) {
         u8_t eaten;
 #ifndef LWIP_NOASSERT
         void *old_payload = p->payload;
@@ -180,11 +200,11 @@ raw_input(struct pbuf *p, struct netif *inp)
           /* receive function ate the packet */
           p = NULL;
           if (prev != NULL) {
-            /* move the pcb to the front of raw_pcbs so that is
+            /* move the pcb to the front of the list so that is
                found faster next time */
-            prev->next = pcb->next;
-            pcb->next = raw_pcbs;
-            raw_pcbs = pcb;
+            RAW_PCB_INPUT_NEXT(prev) = RAW_PCB_INPUT_NEXT(pcb);
+            RAW_PCB_INPUT_NEXT(pcb) = *head;
+            *head = pcb;
           }
           return RAW_INPUT_EATEN;
         } else {
@@ -197,7 +217,7 @@ raw_input(struct pbuf *p, struct netif *inp)
     }
     /* drop the packet */
     prev = pcb;
-    pcb = pcb->next;
+    pcb = RAW_PCB_INPUT_NEXT(pcb);
   }
   return ret;
 }
@@ -339,6 +359,27 @@ raw_recv(struct raw_pcb *pcb, raw_recv_fn recv, void *recv_arg)
   pcb->recv_arg = recv_arg;
 }
 
+#if LWIP_SO_ATTACH_FILTER
+/**
+ * @ingroup raw_raw
+ * Attach a classic BPF receive filter to a raw PCB. The program sees each
+ * matching packet from the IP header on; packets for which it returns 0
+ * are not passed to the recv callback.
+ *
+ * @param pcb RAW PCB to attach the filter to
+ * @param insns the program (copied); NULL detaches the current filter
+ * @param len number of instructions
+ * @return ERR_OK, ERR_VAL for an invalid program or ERR_MEM
+ */
+err_t
+raw_attach_filter(struct raw_pcb *pcb, const struct lwip_bpf_insn *insns, u16_t len)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("raw_attach_filter: invalid pcb", pcb != NULL, return ERR_ARG);
+  return lwip_bpf_attach(&pcb->filter, insns, len);
+}
+#endif /* LWIP_SO_ATTACH_FILTER */
+
 /**
  * @ingroup raw_raw
  * Send the raw IP packet to the given address. An IP header will be prepended
@@ -509,8 +550,8 @@ raw_sendto_if_src(struct raw_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip,
   /* If requested, based on the IPV6_CHECKSUM socket option per RFC3542,
      compute the checksum and update the checksum in the payload. */
   if (IP_IS_V6(dst_ip) && pcb->chksum_reqd) {
-    u16_t chksum = ip6_chksum_pseudo(p, pcb->protocol, p->tot_len, ip_2_ip6(src_ip), ip_2_ip6(dst_ip));
-    LWIP_ASSERT("Checksum must fit into first pbuf", p->len >= (pcb->chksum_offset + 2));
+    u16_t chksum = ip6_chksum_pseudo(p, pcb->protocol, (u16_t)p->tot_len, ip_2_ip6(src_ip), ip_2_ip6(dst_ip));
+    LWIP_ASSERT("Checksum must fit into first pbuf", p->len >= (pbuf_len_t)(pcb->chksum_offset + 2));
     SMEMCPY(((u8_t *)p->payload) + pcb->chksum_offset, &chksum, sizeof(u16_t));
   }
 #endif
@@ -577,6 +618,20 @@ raw_remove(struct raw_pcb *pcb)
       }
     }
   }
+#if RAW_PCB_HASH_SIZE
+  {
+    struct raw_pcb **link;
+    for (link = &raw_proto_hash[RAW_PCB_HASH(pcb->protocol)]; *link != NULL; link = &(*link)->hnext) {
+      if (*link == pcb) {
+        *link = pcb->hnext;
+        break;
+      }
+    }
+  }
+#endif /* RAW_PCB_HASH_SIZE */
+#if LWIP_SO_ATTACH_FILTER
+  lwip_bpf_detach(&pcb->filter);
+#endif /* LWIP_SO_ATTACH_FILTER */
   memp_free(MEMP_RAW_PCB, pcb);
 }
 
@@ -611,6 +666,10 @@ raw_new(u8_t proto)
 #endif /* LWIP_MULTICAST_TX_OPTIONS */
     pcb->next = raw_pcbs;
     raw_pcbs = pcb;
+#if RAW_PCB_HASH_SIZE
+    pcb->hnext = raw_proto_hash[RAW_PCB_HASH(proto)];
+    raw_proto_hash[RAW_PCB_HASH(proto)] = pcb;
+#endif /* RAW_PCB_HASH_SIZE */
   }
   return pcb;
 }
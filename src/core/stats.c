@@ -139,6 +139,30 @@ stats_display_sys(struct stats_sys *sys)
 }
 #endif /* SYS_STATS */
 
+#if CORELOCK_STATS
+void
+stats_display_corelock(struct stats_corelock *corelock)
+{
+  int i;
+
+  LWIP_PLATFORM_DIAG(("\nCORELOCK\n\t"));
+  LWIP_PLATFORM_DIAG(("acquired:  %"STAT_COUNTER_F"\n\t", corelock->acquired));
+  LWIP_PLATFORM_DIAG(("contended: %"STAT_COUNTER_F"\n\t", corelock->contended));
+  LWIP_PLATFORM_DIAG(("spun:      %"STAT_COUNTER_F"\n\t", corelock->spun));
+  LWIP_PLATFORM_DIAG(("blocked:   %"STAT_COUNTER_F"\n\t", corelock->blocked));
+  LWIP_PLATFORM_DIAG(("hold_max:  %"U32_F"\n", corelock->hold_max));
+  for (i = 0; i < STATS_CORELOCK_HOLD_BUCKETS - 1; i++) {
+    if (corelock->hold[i] != 0) {
+      LWIP_PLATFORM_DIAG(("\thold < %"U32_F": %"STAT_COUNTER_F"\n", (u32_t)1 << i, corelock->hold[i]));
+    }
+  }
+  /* the last bucket collects all longer holds */
+  if (corelock->hold[i] != 0) {
+    LWIP_PLATFORM_DIAG(("\thold >= %"U32_F": %"STAT_COUNTER_F"\n", (u32_t)1 << (i - 1), corelock->hold[i]));
+  }
+}
+#endif /* CORELOCK_STATS */
+
 void
 stats_display(void)
 {
@@ -162,6 +186,7 @@ stats_display(void)
     MEMP_STATS_DISPLAY(i);
   }
   SYS_STATS_DISPLAY();
+  CORELOCK_STATS_DISPLAY();
 }
 #endif /* LWIP_STATS_DISPLAY */
 
@@ -106,6 +106,7 @@
 #include "lwip/memp.h"
 #include "lwip/tcp.h"
 #include "lwip/priv/tcp_priv.h"
+#include "lwip/priv/port_alloc.h"
 #include "lwip/debug.h"
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
@@ -155,8 +156,13 @@ static const char *const tcp_state_str[] = {
   "TIME_WAIT"
 };
 
+#if LWIP_PORT_ALLOC_BITMAP
+/* local TCP ports handed out or bound since the bitmap was last rebuilt */
+PORT_ALLOC_DECLARE(tcp_ports, TCP_LOCAL_PORT_RANGE_START, TCP_LOCAL_PORT_RANGE_END);
+#else /* LWIP_PORT_ALLOC_BITMAP */
 /* last local TCP port */
 static u16_t tcp_port = TCP_LOCAL_PORT_RANGE_START;
+#endif /* LWIP_PORT_ALLOC_BITMAP */
 
 /* Incremented every coarse grained timer shot (typically every 500 ms). */
 u32_t tcp_ticks;
@@ -187,7 +193,7 @@ u8_t tcp_active_pcbs_changed;
 /** Timer counter to handle calling slow-timer from tcp_tmr() */
 static u8_t tcp_timer;
 static u8_t tcp_timer_ctr;
-static u16_t tcp_new_port(void);
+static u16_t tcp_new_port(const ip_addr_t *remote_ip, u16_t remote_port);
 
 static err_t tcp_close_shutdown_fin(struct tcp_pcb *pcb);
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
@@ -200,9 +206,11 @@ static void tcp_ext_arg_invoke_callbacks_destroyed(struct tcp_pcb_ext_args *ext_
 void
 tcp_init(void)
 {
-#ifdef LWIP_RAND
+#if LWIP_PORT_ALLOC_BITMAP
+  port_alloc_init(&tcp_ports);
+#elif defined LWIP_RAND
   tcp_port = TCP_ENSURE_LOCAL_PORT_RANGE(LWIP_RAND());
-#endif /* LWIP_RAND */
+#endif /* LWIP_PORT_ALLOC_BITMAP */
 }
 
 /** Free a tcp pcb */
@@ -706,7 +714,7 @@ tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
 #endif /* LWIP_IPV6 && LWIP_IPV6_SCOPES */
 
   if (port == 0) {
-    port = tcp_new_port();
+    port = tcp_new_port(NULL, 0);
     if (port == 0) {
       return ERR_BUF;
     }
@@ -716,11 +724,11 @@ tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
       for (cpcb = *tcp_pcb_lists[i]; cpcb != NULL; cpcb = cpcb->next) {
         if (cpcb->local_port == port) {
 #if SO_REUSE
-          /* Omit checking for the same port if both pcbs have REUSEADDR set.
-             For SO_REUSEADDR, the duplicate-check for a 5-tuple is done in
-             tcp_connect. */
-          if (!ip_get_option(pcb, SOF_REUSEADDR) ||
-              !ip_get_option(cpcb, SOF_REUSEADDR))
+          /* Omit checking for the same port if both pcbs have REUSEADDR
+             (or both have REUSEPORT) set. The duplicate-check for a 5-tuple
+             is then done in tcp_connect. */
+          if (!(ip_get_option(pcb, SOF_REUSEADDR) && ip_get_option(cpcb, SOF_REUSEADDR)) &&
+              !(ip_get_option(pcb, SOF_REUSEPORT) && ip_get_option(cpcb, SOF_REUSEPORT)))
 #endif /* SO_REUSE */
           {
             /* @todo: check accept_any_ip_version */
@@ -744,6 +752,9 @@ tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     ip_addr_set(&pcb->local_ip, ipaddr);
   }
   pcb->local_port = port;
+#if LWIP_PORT_ALLOC_BITMAP
+  port_alloc_set(&tcp_ports, port);
+#endif /* LWIP_PORT_ALLOC_BITMAP */
   TCP_REG(&tcp_bound_pcbs, pcb);
   LWIP_DEBUGF(TCP_DEBUG, ("tcp_bind: bind to port %"U16_F"\n", port));
   return ERR_OK;
@@ -867,10 +878,12 @@ tcp_listen_with_backlog_and_err(struct tcp_pcb *pcb, u8_t backlog, err_t *err)
   if (ip_get_option(pcb, SOF_REUSEADDR)) {
     /* Since SOF_REUSEADDR allows reusing a local address before the pcb's usage
        is declared (listen-/connection-pcb), we have to make sure now that
-       this port is only used once for every local IP. */
+       this port is only used once for every local IP (except for a group of
+       listeners that all have SOF_REUSEPORT set). */
     for (lpcb = tcp_listen_pcbs.listen_pcbs; lpcb != NULL; lpcb = lpcb->next) {
       if ((lpcb->local_port == pcb->local_port) &&
-          ip_addr_cmp(&lpcb->local_ip, &pcb->local_ip)) {
+          ip_addr_cmp(&lpcb->local_ip, &pcb->local_ip) &&
+          !(ip_get_option(lpcb, SOF_REUSEPORT) && ip_get_option(pcb, SOF_REUSEPORT))) {
         /* this address/port is already used */
         lpcb = NULL;
         res = ERR_USE;
@@ -1005,15 +1018,36 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
 /**
  * Allocate a new local TCP port.
  *
+ * @param remote_ip remote address the port is used for or NULL if unknown
+ * @param remote_port remote port the port is used for
  * @return a new (free) local TCP port number
  */
 static u16_t
-tcp_new_port(void)
+tcp_new_port(const ip_addr_t *remote_ip, u16_t remote_port)
 {
   u8_t i;
+#if LWIP_PORT_ALLOC_BITMAP
+  struct tcp_pcb *pcb;
+  u16_t port = port_alloc_new(&tcp_ports, remote_ip, remote_port);
+  if (port == 0) {
+    /* All ports have been handed out since the bitmap was built:
+       rebuild it from the ports still in use and try again. */
+    port_alloc_reset(&tcp_ports);
+    for (i = 0; i < NUM_TCP_PCB_LISTS; i++) {
+      for (pcb = *tcp_pcb_lists[i]; pcb != NULL; pcb = pcb->next) {
+        port_alloc_set(&tcp_ports, pcb->local_port);
+      }
+    }
+    port = port_alloc_new(&tcp_ports, remote_ip, remote_port);
+  }
+  return port;
+#else /* LWIP_PORT_ALLOC_BITMAP */
   u16_t n = 0;
   struct tcp_pcb *pcb;
 
+  LWIP_UNUSED_ARG(remote_ip);
+  LWIP_UNUSED_ARG(remote_port);
+
 again:
   tcp_port++;
   if (tcp_port == TCP_LOCAL_PORT_RANGE_END) {
@@ -1032,6 +1066,7 @@ again:
     }
   }
   return tcp_port;
+#endif /* LWIP_PORT_ALLOC_BITMAP */
 }
 
 /**
@@ -1114,15 +1149,15 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
 
   old_local_port = pcb->local_port;
   if (pcb->local_port == 0) {
-    pcb->local_port = tcp_new_port();
+    pcb->local_port = tcp_new_port(&pcb->remote_ip, pcb->remote_port);
     if (pcb->local_port == 0) {
       return ERR_BUF;
     }
   } else {
 #if SO_REUSE
-    if (ip_get_option(pcb, SOF_REUSEADDR)) {
-      /* Since SOF_REUSEADDR allows reusing a local address, we have to make sure
-         now that the 5-tuple is unique. */
+    if (ip_get_option(pcb, SOF_REUSEADDR | SOF_REUSEPORT)) {
+      /* Since SOF_REUSEADDR and SOF_REUSEPORT allow reusing a local address,
+         we have to make sure now that the 5-tuple is unique. */
       struct tcp_pcb *cpcb;
       int i;
       /* Don't check listen- and bound-PCBs, check active- and TIME-WAIT PCBs. */
@@ -1688,7 +1723,7 @@ tcp_recv_null(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
   LWIP_ERROR("tcp_recv_null: invalid pcb", pcb != NULL, return ERR_ARG);
 
   if (p != NULL) {
-    tcp_recved(pcb, p->tot_len);
+    tcp_recved(pcb, (u16_t)p->tot_len);
     pbuf_free(p);
   } else if (err == ERR_OK) {
     return tcp_close(pcb);
@@ -55,6 +55,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
+#include "lwip/flowhash.h"
 #if LWIP_ND6_TCP_REACHABILITY_HINTS
 #include "lwip/nd6.h"
 #endif /* LWIP_ND6_TCP_REACHABILITY_HINTS */
@@ -96,6 +97,9 @@ static void tcp_listen_input(struct tcp_pcb_listen *pcb);
 static void tcp_timewait_input(struct tcp_pcb *pcb);
 
 static int tcp_input_delayed_close(struct tcp_pcb *pcb);
+#if SO_REUSE
+static struct tcp_pcb_listen *tcp_listen_reuseport(struct tcp_pcb_listen *first, struct tcp_pcb **prev);
+#endif /* SO_REUSE */
 
 #if LWIP_TCP_SACK_OUT
 static void tcp_add_sack(struct tcp_pcb *pcb, u32_t left, u32_t right);
@@ -159,7 +163,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
 #if CHECKSUM_CHECK_TCP
   IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_TCP) {
     /* Verify TCP checksum. */
-    u16_t chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len,
+    u16_t chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, (u16_t)p->tot_len,
                                     ip_current_src_addr(), ip_current_dest_addr());
     if (chksum != 0) {
       LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_input: packet discarded due to failing checksum 0x%04"X16_F"\n",
@@ -197,7 +201,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
     pbuf_remove_header(p, TCP_HLEN);
 
     /* determine how long the first and second parts of the options are */
-    tcphdr_opt1len = p->len;
+    tcphdr_opt1len = (u16_t)p->len;
     opt2len = (u16_t)(tcphdr_optlen - tcphdr_opt1len);
 
     /* options continue in the next pbuf: set p to zero length and hide the
@@ -232,7 +236,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
   tcphdr->wnd = lwip_ntohs(tcphdr->wnd);
 
   flags = TCPH_FLAGS(tcphdr);
-  tcplen = p->tot_len;
+  tcplen = (u16_t)p->tot_len;
   if (flags & (TCP_FIN | TCP_SYN)) {
     tcplen++;
     if (tcplen < p->tot_len) {
@@ -356,6 +360,10 @@ tcp_input(struct pbuf *p, struct netif *inp)
       lpcb = lpcb_any;
       prev = lpcb_prev;
     }
+    if ((lpcb != NULL) && ip_get_option(lpcb, SOF_REUSEPORT)) {
+      /* spread connections over all listeners sharing this address and port */
+      lpcb = tcp_listen_reuseport(lpcb, &prev);
+    }
 #endif /* SO_REUSE */
     if (lpcb != NULL) {
       /* Move this PCB to the front of the list so that subsequent
@@ -406,7 +414,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
     /* Set up a tcp_seg structure. */
     inseg.next = NULL;
-    inseg.len = p->tot_len;
+    inseg.len = (u16_t)p->tot_len;
     inseg.p = p;
     inseg.tcphdr = tcphdr;
 
@@ -617,6 +625,56 @@ tcp_input_delayed_close(struct tcp_pcb *pcb)
   return 0;
 }
 
+#if SO_REUSE
+/* lpcb is a member of the SO_REUSEPORT listener group of 'first' */
+#define TCP_LISTEN_REUSEPORT_MATCH(lpcb, first) \
+  (((lpcb)->local_port == (first)->local_port) && \
+   ip_get_option(lpcb, SOF_REUSEPORT) && \
+   ((lpcb)->netif_idx == (first)->netif_idx) && \
+   ip_addr_cmp(&(lpcb)->local_ip, &(first)->local_ip))
+
+/**
+ * Select the listener for the current segment among all listening pcbs
+ * sharing the local address and port of 'first' through SO_REUSEPORT.
+ * The choice depends on the flow hash only, so a retransmitted SYN reaches
+ * the same listener.
+ *
+ * @param first the listening pcb tcp_input matched
+ * @param prev predecessor of 'first' in tcp_listen_pcbs; set to NULL if a
+ *        group was found so that tcp_input does not reorder its members
+ * @return the selected listening pcb
+ */
+static struct tcp_pcb_listen *
+tcp_listen_reuseport(struct tcp_pcb_listen *first, struct tcp_pcb **prev)
+{
+  struct tcp_pcb_listen *lpcb;
+  u32_t num = 0;
+  u32_t sel;
+
+  for (lpcb = tcp_listen_pcbs.listen_pcbs; lpcb != NULL; lpcb = lpcb->next) {
+    if (TCP_LISTEN_REUSEPORT_MATCH(lpcb, first)) {
+      num++;
+    }
+  }
+  if (num <= 1) {
+    return first;
+  }
+  /* the selection depends on the order of the group in the list */
+  *prev = NULL;
+  sel = FLOWHASH_SELECT(flowhash_ip(ip_current_src_addr(), ip_current_dest_addr(),
+                                    tcphdr->src, tcphdr->dest), num);
+  for (lpcb = tcp_listen_pcbs.listen_pcbs; lpcb != NULL; lpcb = lpcb->next) {
+    if (TCP_LISTEN_REUSEPORT_MATCH(lpcb, first)) {
+      if (sel == 0) {
+        return lpcb;
+      }
+      sel--;
+    }
+  }
+  return first;
+}
+#endif /* SO_REUSE */
+
 /**
  * Called by tcp_input() when a segment arrives for a listening
  * connection (from tcp_input()).
@@ -1432,7 +1490,7 @@ tcp_receive(struct tcp_pcb *pcb)
       inseg.len -= off;
       new_tot_len = (u16_t)(inseg.p->tot_len - off);
       while (p->len < off) {
-        off -= p->len;
+        off = (u16_t)(off - p->len);
         /* all pbufs up to and including this one have len==0, so tot_len is equal */
         p->tot_len = new_tot_len;
         p->len = 0;
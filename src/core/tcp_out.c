@@ -174,7 +174,7 @@ tcp_create_segment(const struct tcp_pcb *pcb, struct pbuf *p, u8_t hdrflags, u32
   seg->next = NULL;
   seg->p = p;
   LWIP_ASSERT("p->tot_len >= optlen", p->tot_len >= optlen);
-  seg->len = p->tot_len - optlen;
+  seg->len = (u16_t)(p->tot_len - optlen);
 #if TCP_OVERSIZE_DBGCHECK
   seg->oversize_left = 0;
 #endif /* TCP_OVERSIZE_DBGCHECK */
@@ -265,7 +265,7 @@ tcp_pbuf_prealloc(pbuf_layer layer, u16_t length, u16_t max_length,
     return NULL;
   }
   LWIP_ASSERT("need unchained pbuf", p->next == NULL);
-  *oversize = p->len - length;
+  *oversize = (u16_t)(p->len - length);
   /* trim p->len to the currently used size */
   p->len = p->tot_len = length;
   return p;
@@ -736,7 +736,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
     LWIP_ASSERT("tcp_write: cannot concatenate when pcb->unsent is empty",
                 (last_unsent != NULL));
     pbuf_cat(last_unsent->p, concat_p);
-    last_unsent->len += concat_p->tot_len;
+    last_unsent->len = (u16_t)(last_unsent->len + concat_p->tot_len);
   } else if (extendlen > 0) {
     struct pbuf *p;
     LWIP_ASSERT("tcp_write: extension of reference requires reference",
@@ -882,7 +882,7 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   }
 
   /* Offset into the original pbuf is past TCP/IP headers, options, and split amount */
-  offset = useg->p->tot_len - useg->len + split;
+  offset = (u16_t)(useg->p->tot_len - useg->len + split);
   /* Copy remainder into new pbuf, headers and options will not be filled out */
   if (pbuf_copy_partial(useg->p, (u8_t *)p->payload + optlen, remainder, offset ) != remainder) {
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
@@ -945,17 +945,17 @@ tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split)
   useg->chksum = 0;
   useg->chksum_swapped = 0;
   q = useg->p;
-  offset = q->tot_len - useg->len; /* Offset due to exposed headers */
+  offset = (u16_t)(q->tot_len - useg->len); /* Offset due to exposed headers */
 
   /* Advance to the pbuf where the offset ends */
   while (q != NULL && offset > q->len) {
-    offset -= q->len;
+    offset = (u16_t)(offset - q->len);
     q = q->next;
   }
   LWIP_ASSERT("Found start of payload pbuf", q != NULL);
   /* Checksum the first payload pbuf accounting for offset, then other pbufs are all payload */
   for (; q != NULL; offset = 0, q = q->next) {
-    tcp_seg_add_chksum(~inet_chksum((const u8_t *)q->payload + offset, q->len - offset), q->len - offset,
+    tcp_seg_add_chksum(~inet_chksum((const u8_t *)q->payload + offset, (u16_t)(q->len - offset)), (u16_t)(q->len - offset),
                        &useg->chksum, &useg->chksum_swapped);
   }
 #endif /* TCP_CHECKSUM_ON_COPY */
@@ -1569,7 +1569,7 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     u32_t acc;
 #if TCP_CHECKSUM_ON_COPY_SANITY_CHECK
     u16_t chksum_slow = ip_chksum_pseudo(seg->p, IP_PROTO_TCP,
-                                         seg->p->tot_len, &pcb->local_ip, &pcb->remote_ip);
+                                         (u16_t)seg->p->tot_len, &pcb->local_ip, &pcb->remote_ip);
 #endif /* TCP_CHECKSUM_ON_COPY_SANITY_CHECK */
     if ((seg->flags & TF_SEG_DATA_CHECKSUMMED) == 0) {
       LWIP_ASSERT("data included but not checksummed",
@@ -1578,7 +1578,7 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
 
     /* rebuild TCP header checksum (TCP header changes for retransmissions!) */
     acc = ip_chksum_pseudo_partial(seg->p, IP_PROTO_TCP,
-                                   seg->p->tot_len, TCPH_HDRLEN_BYTES(seg->tcphdr), &pcb->local_ip, &pcb->remote_ip);
+                                   (u16_t)seg->p->tot_len, TCPH_HDRLEN_BYTES(seg->tcphdr), &pcb->local_ip, &pcb->remote_ip);
     /* add payload checksum */
     if (seg->chksum_swapped) {
       seg_chksum_was_swapped = 1;
@@ -1825,7 +1825,7 @@ tcp_output_alloc_header_common(u32_t ackno, u16_t optlen, u16_t datalen,
   p = pbuf_alloc(PBUF_IP, TCP_HLEN + optlen + datalen, PBUF_RAM);
   if (p != NULL) {
     LWIP_ASSERT("check that first pbuf can hold struct tcp_hdr",
-                (p->len >= TCP_HLEN + optlen));
+                (p->len >= (pbuf_len_t)(TCP_HLEN + optlen)));
     tcphdr = (struct tcp_hdr *)p->payload;
     tcphdr->src = lwip_htons(src_port);
     tcphdr->dest = lwip_htons(dst_port);
@@ -1934,7 +1934,7 @@ tcp_output_control_segment(const struct tcp_pcb *pcb, struct pbuf *p,
 #if CHECKSUM_GEN_TCP
     IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP) {
       struct tcp_hdr *tcphdr = (struct tcp_hdr *)p->payload;
-      tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len,
+      tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, (u16_t)p->tot_len,
                                         src, dst);
     }
 #endif
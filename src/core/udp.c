@@ -62,6 +62,8 @@
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
 #include "lwip/dhcp.h"
+#include "lwip/flowhash.h"
+#include "lwip/priv/port_alloc.h"
 
 #include <string.h>
 
@@ -73,22 +75,53 @@
 #define UDP_ENSURE_LOCAL_PORT_RANGE(port) ((u16_t)(((port) & (u16_t)~UDP_LOCAL_PORT_RANGE_START) + UDP_LOCAL_PORT_RANGE_START))
 #endif
 
+#if LWIP_PORT_ALLOC_BITMAP
+/* local UDP ports handed out or bound since the bitmap was last rebuilt */
+PORT_ALLOC_DECLARE(udp_ports, UDP_LOCAL_PORT_RANGE_START, UDP_LOCAL_PORT_RANGE_END);
+#else /* LWIP_PORT_ALLOC_BITMAP */
 /* last local UDP port */
 static u16_t udp_port = UDP_LOCAL_PORT_RANGE_START;
+#endif /* LWIP_PORT_ALLOC_BITMAP */
 
 /* The list of UDP PCBs */
 /* exported in udp.h (was static) */
 struct udp_pcb *udp_pcbs;
 
+#if UDP_PCB_HASH_SIZE
+/* PCBs on udp_pcbs connected to a remote address, hashed by local port and
+ * remote address and port */
+static struct udp_pcb *udp_conn_hash[UDP_PCB_HASH_SIZE];
+/* all other PCBs on udp_pcbs, hashed by local port */
+static struct udp_pcb *udp_port_hash[UDP_PCB_HASH_SIZE];
+
+#define UDP_PCB_HASH(key) ((u16_t)((((u32_t)((key) * 0x9e3779b1UL)) >> 16) % UDP_PCB_HASH_SIZE))
+/* next PCB in the chain searched by udp_input() */
+#define UDP_PCB_INPUT_NEXT(pcb) ((pcb)->hnext)
+#else /* UDP_PCB_HASH_SIZE */
+#define UDP_PCB_INPUT_NEXT(pcb) ((pcb)->next)
+#endif /* UDP_PCB_HASH_SIZE */
+
+#if SO_REUSE
+/* pcb is an unconnected member of the SO_REUSEPORT group of 'first' */
+#define UDP_PCB_REUSEPORT_MATCH(pcb, first) \
+  (((pcb)->local_port == (first)->local_port) && \
+   (((pcb)->flags & UDP_FLAGS_CONNECTED) == 0) && \
+   ip_get_option(pcb, SOF_REUSEPORT) && \
+   ((pcb)->netif_idx == (first)->netif_idx) && \
+   ip_addr_cmp(&(pcb)->local_ip, &(first)->local_ip))
+#endif /* SO_REUSE */
+
 /**
  * Initialize this module.
  */
 void
 udp_init(void)
 {
-#ifdef LWIP_RAND
+#if LWIP_PORT_ALLOC_BITMAP
+  port_alloc_init(&udp_ports);
+#elif defined LWIP_RAND
   udp_port = UDP_ENSURE_LOCAL_PORT_RANGE(LWIP_RAND());
-#endif /* LWIP_RAND */
+#endif /* LWIP_PORT_ALLOC_BITMAP */
 }
 
 /**
@@ -99,6 +132,20 @@ udp_init(void)
 static u16_t
 udp_new_port(void)
 {
+#if LWIP_PORT_ALLOC_BITMAP
+  u16_t port = port_alloc_new(&udp_ports, NULL, 0);
+  if (port == 0) {
+    /* All ports have been handed out since the bitmap was built:
+       rebuild it from the ports still bound and try again. */
+    struct udp_pcb *pcb;
+    port_alloc_reset(&udp_ports);
+    for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+      port_alloc_set(&udp_ports, pcb->local_port);
+    }
+    port = port_alloc_new(&udp_ports, NULL, 0);
+  }
+  return port;
+#else /* LWIP_PORT_ALLOC_BITMAP */
   u16_t n = 0;
   struct udp_pcb *pcb;
 
@@ -116,7 +163,61 @@ again:
     }
   }
   return udp_port;
+#endif /* LWIP_PORT_ALLOC_BITMAP */
+}
+
+#if UDP_PCB_HASH_SIZE
+/** Hash key of a connected PCB: local port and remote address and port */
+static u32_t
+udp_pcb_hash_key(const ip_addr_t *remote_ip, u16_t local_port, u16_t remote_port)
+{
+  u32_t key = ((u32_t)local_port << 16) | remote_port;
+#if LWIP_IPV6
+  if (IP_IS_V6(remote_ip)) {
+    const ip6_addr_t *ip6 = ip_2_ip6(remote_ip);
+    key ^= ip6->addr[0] ^ ip6->addr[1] ^ ip6->addr[2] ^ ip6->addr[3];
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  if (!IP_IS_V6(remote_ip)) {
+    key ^= ip4_addr_get_u32(ip_2_ip4(remote_ip));
+  }
+#endif /* LWIP_IPV4 */
+  return key;
+}
+
+/** Hash bucket a PCB belongs to, depending on its current binding */
+static struct udp_pcb **
+udp_pcb_hash_bucket(const struct udp_pcb *pcb)
+{
+  if (((pcb->flags & UDP_FLAGS_CONNECTED) != 0) && !ip_addr_isany(&pcb->remote_ip)) {
+    return &udp_conn_hash[UDP_PCB_HASH(udp_pcb_hash_key(&pcb->remote_ip, pcb->local_port, pcb->remote_port))];
+  }
+  return &udp_port_hash[UDP_PCB_HASH(pcb->local_port)];
+}
+
+/** Add a PCB on udp_pcbs to the hash (after binding it) */
+static void
+udp_pcb_hash_link(struct udp_pcb *pcb)
+{
+  struct udp_pcb **bucket = udp_pcb_hash_bucket(pcb);
+  pcb->hnext = *bucket;
+  *bucket = pcb;
+}
+
+/** Remove a PCB from the hash (before its binding changes) */
+static void
+udp_pcb_hash_unlink(struct udp_pcb *pcb)
+{
+  struct udp_pcb **pp;
+  for (pp = udp_pcb_hash_bucket(pcb); *pp != NULL; pp = &(*pp)->hnext) {
+    if (*pp == pcb) {
+      *pp = pcb->hnext;
+      break;
+    }
+  }
 }
+#endif /* UDP_PCB_HASH_SIZE */
 
 /** Common code to see if the current input packet matches the pcb
  * (current input packet is accessed via ip(4/6)_current_* macros)
@@ -178,6 +279,107 @@ udp_input_local_match(struct udp_pcb *pcb, struct netif *inp, u8_t broadcast)
   return 0;
 }
 
+#if UDP_PCB_HASH_SIZE
+/**
+ * Look up the PCB connected to the source of the current input packet
+ * (current input packet is accessed via ip(4/6)_current_* macros).
+ * A PCB found is moved to the front of its hash bucket.
+ *
+ * @param inp network interface on which the datagram was received
+ * @param broadcast 1 if his is an IPv4 broadcast (global or subnet-only), 0 otherwise
+ * @param src source port of the datagram
+ * @param dest destination port of the datagram
+ * @return the connected PCB or NULL if there is none
+ */
+static struct udp_pcb *
+udp_input_connected(struct netif *inp, u8_t broadcast, u16_t src, u16_t dest)
+{
+  struct udp_pcb **bucket, *pcb, *prev = NULL;
+
+  bucket = &udp_conn_hash[UDP_PCB_HASH(udp_pcb_hash_key(ip_current_src_addr(), dest, src))];
+  for (pcb = *bucket; pcb != NULL; pcb = pcb->hnext) {
+    if ((pcb->local_port == dest) && (pcb->remote_port == src) &&
+        ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()) &&
+        (udp_input_local_match(pcb, inp, broadcast) != 0)) {
+      if (prev != NULL) {
+        prev->hnext = pcb->hnext;
+        pcb->hnext = *bucket;
+        *bucket = pcb;
+      } else {
+        UDP_STATS_INC(udp.cachehit);
+      }
+      return pcb;
+    }
+    prev = pcb;
+  }
+  return NULL;
+}
+#endif /* UDP_PCB_HASH_SIZE */
+
+#if SO_REUSE
+/**
+ * Select the pcb for a unicast datagram among all unconnected pcbs sharing
+ * the local address and port of 'first' through SO_REUSEPORT. The choice
+ * depends on the flow hash only, so all datagrams of one flow reach the
+ * same pcb.
+ *
+ * @param head the list udp_input searched
+ * @param first the unconnected pcb udp_input matched
+ * @param src source port of the datagram (host byte order)
+ * @param dest destination port of the datagram (host byte order)
+ */
+static struct udp_pcb *
+udp_input_reuseport(struct udp_pcb *head, struct udp_pcb *first, u16_t src, u16_t dest)
+{
+  struct udp_pcb *pcb;
+  u32_t num = 0;
+  u32_t sel;
+
+  for (pcb = head; pcb != NULL; pcb = UDP_PCB_INPUT_NEXT(pcb)) {
+    if (UDP_PCB_REUSEPORT_MATCH(pcb, first)) {
+      num++;
+    }
+  }
+  if (num <= 1) {
+    return first;
+  }
+  sel = FLOWHASH_SELECT(flowhash_ip(ip_current_src_addr(), ip_current_dest_addr(), src, dest), num);
+  for (pcb = head; pcb != NULL; pcb = UDP_PCB_INPUT_NEXT(pcb)) {
+    if (UDP_PCB_REUSEPORT_MATCH(pcb, first)) {
+      if (sel == 0) {
+        return pcb;
+      }
+      sel--;
+    }
+  }
+  return first;
+}
+#endif /* SO_REUSE */
+
+#if LWIP_SO_ATTACH_FILTER
+/**
+ * Run the receive filter of a pcb on a datagram.
+ * The filter sees the UDP header, which udp_input() has already removed.
+ *
+ * @return 1 if the datagram is to be passed to the pcb, 0 if dropped
+ */
+static u8_t
+udp_input_filter(struct udp_pcb *pcb, struct pbuf *p)
+{
+  u8_t pass;
+
+  if (pcb->filter == NULL) {
+    return 1;
+  }
+  if (pbuf_add_header(p, UDP_HLEN)) {
+    return 0;
+  }
+  pass = (lwip_bpf_filter(pcb->filter, p) != 0);
+  pbuf_remove_header(p, UDP_HLEN);
+  return pass;
+}
+#endif /* LWIP_SO_ATTACH_FILTER */
+
 /**
  * Process an incoming UDP datagram.
  *
@@ -196,6 +398,7 @@ udp_input(struct pbuf *p, struct netif *inp)
   struct udp_hdr *udphdr;
   struct udp_pcb *pcb, *prev;
   struct udp_pcb *uncon_pcb;
+  struct udp_pcb **head;
   u16_t src, dest;
   u8_t broadcast;
   u8_t for_us = 0;
@@ -246,11 +449,20 @@ udp_input(struct pbuf *p, struct netif *inp)
   pcb = NULL;
   prev = NULL;
   uncon_pcb = NULL;
+#if UDP_PCB_HASH_SIZE
+  /* A pcb connected to the source of the datagram is a 'perfect match'.
+   * Otherwise, only pcbs bound to the destination port need to be checked. */
+  pcb = udp_input_connected(inp, broadcast, src, dest);
+  head = &udp_port_hash[UDP_PCB_HASH(dest)];
+  if (pcb == NULL)
+#else /* UDP_PCB_HASH_SIZE */
+  head = &udp_pcbs;
+#endif /* UDP_PCB_HASH_SIZE */
   /* Iterate through the UDP pcb list for a matching pcb.
    * 'Perfect match' pcbs (connected to the remote port & ip address) are
    * preferred. If no perfect match is found, the first unconnected pcb that
    * matches the local port and ip address gets the datagram. */
-  for (pcb = udp_pcbs; pcb != NULL; pcb = pcb->next) {
+  for (pcb = *head; pcb != NULL; pcb = UDP_PCB_INPUT_NEXT(pcb)) {
     /* print the PCB local and remote address */
     LWIP_DEBUGF(UDP_DEBUG, ("pcb ("));
     ip_addr_debug_print_val(UDP_DEBUG, pcb->local_ip);
@@ -291,11 +503,11 @@ udp_input(struct pbuf *p, struct netif *inp)
            ip_addr_cmp(&pcb->remote_ip, ip_current_src_addr()))) {
         /* the first fully matching PCB */
         if (prev != NULL) {
-          /* move the pcb to the front of udp_pcbs so that is
+          /* move the pcb to the front of the list so that is
              found faster next time */
-          prev->next = pcb->next;
-          pcb->next = udp_pcbs;
-          udp_pcbs = pcb;
+          UDP_PCB_INPUT_NEXT(prev) = UDP_PCB_INPUT_NEXT(pcb);
+          UDP_PCB_INPUT_NEXT(pcb) = *head;
+          *head = pcb;
         } else {
           UDP_STATS_INC(udp.cachehit);
         }
@@ -308,6 +520,13 @@ udp_input(struct pbuf *p, struct netif *inp)
   /* no fully matching pcb found? then look for an unconnected pcb */
   if (pcb == NULL) {
     pcb = uncon_pcb;
+#if SO_REUSE
+    if ((pcb != NULL) && ip_get_option(pcb, SOF_REUSEPORT) &&
+        !broadcast && !ip_addr_ismulticast(ip_current_dest_addr())) {
+      /* spread flows over all pcbs sharing this address and port */
+      pcb = udp_input_reuseport(*head, pcb, src, dest);
+    }
+#endif /* SO_REUSE */
   }
 
   /* Check checksum if this is a match or if it was directed at us. */
@@ -354,7 +573,7 @@ udp_input(struct pbuf *p, struct netif *inp)
 #endif /* LWIP_UDPLITE */
       {
         if (udphdr->chksum != 0) {
-          if (ip_chksum_pseudo(p, IP_PROTO_UDP, p->tot_len,
+          if (ip_chksum_pseudo(p, IP_PROTO_UDP, (u16_t)p->tot_len,
                                ip_current_src_addr(),
                                ip_current_dest_addr()) != 0) {
             goto chkerr;
@@ -386,7 +605,11 @@ udp_input(struct pbuf *p, struct netif *inp)
             if ((mpcb->local_port == dest) &&
                 (udp_input_local_match(mpcb, inp, broadcast) != 0)) {
               /* pass a copy of the packet to all local matches */
-              if (mpcb->recv != NULL) {
+              if ((mpcb->recv != NULL)
+#if LWIP_SO_ATTACH_FILTER
+                  && udp_input_filter(mpcb, p)
+#endif /* LWIP_SO_ATTACH_FILTER */
+                 ) {
                 struct pbuf *q;
                 q = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
                 if (q != NULL) {
@@ -398,6 +621,15 @@ udp_input(struct pbuf *p, struct netif *inp)
         }
       }
 #endif /* SO_REUSE && SO_REUSE_RXTOALL */
+#if LWIP_SO_ATTACH_FILTER
+      if (!udp_input_filter(pcb, p)) {
+        /* rejected by the pcb's filter: drop before it is queued anywhere */
+        LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE, ("udp_input: dropped by filter\n"));
+        UDP_STATS_INC(udp.drop);
+        pbuf_free(p);
+        goto end;
+      }
+#endif /* LWIP_SO_ATTACH_FILTER */
       /* callback */
       if (pcb->recv != NULL) {
         /* now the recv function is responsible for freeing p */
@@ -753,7 +985,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
   }
 
   /* packet too large to add a UDP header without causing an overflow? */
-  if ((u16_t)(p->tot_len + UDP_HLEN) < p->tot_len) {
+  if (p->tot_len > 0xFFFF - UDP_HLEN) {
     return ERR_MEM;
   }
   /* not enough space to add an UDP header to first pbuf in given p chain? */
@@ -814,7 +1046,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
          value, we generate the checksum over the complete
          packet to be safe. */
       chklen_hdr = 0;
-      chklen = q->tot_len;
+      chklen = (u16_t)q->tot_len;
     }
     udphdr->len = lwip_htons(chklen_hdr);
     /* calculate checksum */
@@ -826,7 +1058,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
       }
 #endif /* LWIP_CHECKSUM_ON_COPY */
       udphdr->chksum = ip_chksum_pseudo_partial(q, IP_PROTO_UDPLITE,
-                       q->tot_len, chklen, src_ip, dst_ip);
+                       (u16_t)q->tot_len, chklen, src_ip, dst_ip);
 #if LWIP_CHECKSUM_ON_COPY
       if (have_chksum) {
         u32_t acc;
@@ -847,7 +1079,7 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
 #endif /* LWIP_UDPLITE */
   {      /* UDP */
     LWIP_DEBUGF(UDP_DEBUG, ("udp_send: UDP packet length %"U16_F"\n", q->tot_len));
-    udphdr->len = lwip_htons(q->tot_len);
+    udphdr->len = lwip_htons((u16_t)q->tot_len);
     /* calculate checksum */
 #if CHECKSUM_GEN_UDP
     IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_UDP) {
@@ -858,13 +1090,13 @@ udp_sendto_if_src_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *d
         if (have_chksum) {
           u32_t acc;
           udpchksum = ip_chksum_pseudo_partial(q, IP_PROTO_UDP,
-                                               q->tot_len, UDP_HLEN, src_ip, dst_ip);
+                                               (u16_t)q->tot_len, UDP_HLEN, src_ip, dst_ip);
           acc = udpchksum + (u16_t)~(chksum);
           udpchksum = FOLD_U32T(acc);
         } else
 #endif /* LWIP_CHECKSUM_ON_COPY */
         {
-          udpchksum = ip_chksum_pseudo(q, IP_PROTO_UDP, q->tot_len,
+          udpchksum = ip_chksum_pseudo(q, IP_PROTO_UDP, (u16_t)q->tot_len,
                                        src_ip, dst_ip);
         }
 
@@ -989,10 +1221,10 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
       if (pcb != ipcb) {
         /* By default, we don't allow to bind to a port that any other udp
            PCB is already bound to, unless *all* PCBs with that port have tha
-           REUSEADDR flag set. */
+           REUSEADDR (or all have the REUSEPORT) flag set. */
 #if SO_REUSE
-        if (!ip_get_option(pcb, SOF_REUSEADDR) ||
-            !ip_get_option(ipcb, SOF_REUSEADDR))
+        if (!(ip_get_option(pcb, SOF_REUSEADDR) && ip_get_option(ipcb, SOF_REUSEADDR)) &&
+            !(ip_get_option(pcb, SOF_REUSEPORT) && ip_get_option(ipcb, SOF_REUSEPORT)))
 #endif /* SO_REUSE */
         {
           /* port matches that of PCB in list and REUSEADDR not set -> reject */
@@ -1010,9 +1242,17 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     }
   }
 
+#if UDP_PCB_HASH_SIZE
+  if (rebind) {
+    udp_pcb_hash_unlink(pcb);
+  }
+#endif /* UDP_PCB_HASH_SIZE */
   ip_addr_set_ipaddr(&pcb->local_ip, ipaddr);
 
   pcb->local_port = port;
+#if LWIP_PORT_ALLOC_BITMAP
+  port_alloc_set(&udp_ports, port);
+#endif /* LWIP_PORT_ALLOC_BITMAP */
   mib2_udp_bind(pcb);
   /* pcb not active yet? */
   if (rebind == 0) {
@@ -1020,6 +1260,9 @@ udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     pcb->next = udp_pcbs;
     udp_pcbs = pcb;
   }
+#if UDP_PCB_HASH_SIZE
+  udp_pcb_hash_link(pcb);
+#endif /* UDP_PCB_HASH_SIZE */
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("udp_bind: bound to "));
   ip_addr_debug_print_val(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, pcb->local_ip);
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, (", port %"U16_F")\n", pcb->local_port));
@@ -1084,6 +1327,10 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
     }
   }
 
+#if UDP_PCB_HASH_SIZE
+  /* the pcb is bound (and hashed) now: rehash it with its remote end */
+  udp_pcb_hash_unlink(pcb);
+#endif /* UDP_PCB_HASH_SIZE */
   ip_addr_set_ipaddr(&pcb->remote_ip, ipaddr);
 #if LWIP_IPV6 && LWIP_IPV6_SCOPES
   /* If the given IP address should have a zone but doesn't, assign one now,
@@ -1096,6 +1343,9 @@ udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
 
   pcb->remote_port = port;
   pcb->flags |= UDP_FLAGS_CONNECTED;
+#if UDP_PCB_HASH_SIZE
+  udp_pcb_hash_link(pcb);
+#endif /* UDP_PCB_HASH_SIZE */
 
   LWIP_DEBUGF(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("udp_connect: connected to "));
   ip_addr_debug_print_val(UDP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE,
@@ -1129,6 +1379,9 @@ udp_disconnect(struct udp_pcb *pcb)
 
   LWIP_ERROR("udp_disconnect: invalid pcb", pcb != NULL, return);
 
+#if UDP_PCB_HASH_SIZE
+  udp_pcb_hash_unlink(pcb);
+#endif /* UDP_PCB_HASH_SIZE */
   /* reset remote address association */
 #if LWIP_IPV4 && LWIP_IPV6
   if (IP_IS_ANY_TYPE_VAL(pcb->local_ip)) {
@@ -1143,6 +1396,12 @@ udp_disconnect(struct udp_pcb *pcb)
   pcb->netif_idx = NETIF_NO_INDEX;
   /* mark PCB as unconnected */
   udp_clear_flags(pcb, UDP_FLAGS_CONNECTED);
+#if UDP_PCB_HASH_SIZE
+  /* pcbs with a local port are on udp_pcbs (see udp_bind()) */
+  if (pcb->local_port != 0) {
+    udp_pcb_hash_link(pcb);
+  }
+#endif /* UDP_PCB_HASH_SIZE */
 }
 
 /**
@@ -1166,6 +1425,29 @@ udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg)
   pcb->recv_arg = recv_arg;
 }
 
+#if LWIP_SO_ATTACH_FILTER
+/**
+ * @ingroup udp_raw
+ * Attach a classic BPF receive filter to a UDP PCB. The program sees each
+ * datagram for the pcb from the UDP header on; datagrams for which it
+ * returns 0 are dropped before the recv callback is called.
+ *
+ * @param pcb the pcb to attach the filter to
+ * @param insns the program (copied); NULL detaches the current filter
+ * @param len number of instructions
+ * @return ERR_OK, ERR_VAL for an invalid program or ERR_MEM
+ */
+err_t
+udp_attach_filter(struct udp_pcb *pcb, const struct lwip_bpf_insn *insns, u16_t len)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("udp_attach_filter: invalid pcb", pcb != NULL, return ERR_ARG);
+
+  return lwip_bpf_attach(&pcb->filter, insns, len);
+}
+#endif /* LWIP_SO_ATTACH_FILTER */
+
 /**
  * @ingroup udp_raw
  * Removes and deallocates the pcb.  
@@ -1185,6 +1467,9 @@ udp_remove(struct udp_pcb *pcb)
   LWIP_ERROR("udp_remove: invalid pcb", pcb != NULL, return);
 
   mib2_udp_unbind(pcb);
+#if UDP_PCB_HASH_SIZE
+  udp_pcb_hash_unlink(pcb);
+#endif /* UDP_PCB_HASH_SIZE */
   /* pcb to be removed is first in list? */
   if (udp_pcbs == pcb) {
     /* make list start at 2nd pcb */
@@ -1200,6 +1485,9 @@ udp_remove(struct udp_pcb *pcb)
       }
     }
   }
+#if LWIP_SO_ATTACH_FILTER
+  lwip_bpf_detach(&pcb->filter);
+#endif /* LWIP_SO_ATTACH_FILTER */
   memp_free(MEMP_UDP_PCB, pcb);
 }
 
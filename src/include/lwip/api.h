@@ -210,10 +210,49 @@ struct udp_pcb;
 struct raw_pcb;
 struct netconn;
 struct api_msg;
+struct netconn_async;
 
 /** A callback prototype to inform about events for a netconn */
 typedef void (* netconn_callback)(struct netconn *, enum netconn_evt, u16_t len);
 
+#if LWIP_NETCONN_ASYNC
+/** @ingroup netconn_common
+ * Completion callback of an asynchronous netconn operation, called exactly
+ * once from tcpip_thread when the operation has finished.
+ * @param conn the netconn the operation was submitted for
+ * @param err result of the operation
+ * @param data netconn_recv_async: received struct pbuf (TCP) or struct netbuf
+ *        (UDP/RAW) now owned by the callee, NULL otherwise
+ * @param len netconn_write_async: number of bytes written,
+ *        netconn_recv_async: number of bytes received, 0 otherwise
+ * @param arg the argument passed when submitting the operation
+ * The callback must not call blocking netconn functions, but it may submit
+ * the next asynchronous operation.
+ */
+typedef void (* netconn_async_fn)(struct netconn *conn, err_t err, void *data, size_t len, void *arg);
+#endif /* LWIP_NETCONN_ASYNC */
+
+#if LWIP_NETCONN_RECVQ
+/** Receive queue of a netconn (LWIP_NETCONN_RECVQ==1): a ring of received
+ * items protected by SYS_ARCH_PROTECT, with a semaphore that is only signalled
+ * when an item arrives while a thread is waiting for it */
+struct netconn_recvq {
+  /** ring of 'size' entries, NULL if the queue is invalid */
+  void **items;
+  u16_t size;
+  /** index of the oldest entry */
+  u16_t first;
+  /** number of entries queued */
+  u16_t count;
+  /** number of threads waiting on 'sem' */
+  u16_t waiting;
+  sys_sem_t sem;
+};
+typedef struct netconn_recvq netconn_recvmbox_t;
+#else /* LWIP_NETCONN_RECVQ */
+typedef sys_mbox_t netconn_recvmbox_t;
+#endif /* LWIP_NETCONN_RECVQ */
+
 /** A netconn descriptor */
 struct netconn {
   /** type of the netconn (TCP, UDP or RAW) */
@@ -235,7 +274,7 @@ struct netconn {
 #endif
   /** mbox where received packets are stored until they are fetched
       by the netconn application thread (can grow quite big) */
-  sys_mbox_t recvmbox;
+  netconn_recvmbox_t recvmbox;
 #if LWIP_TCP
   /** mbox where new connections are stored until processed
       by the application thread */
@@ -281,6 +320,10 @@ struct netconn {
       Also used during connect and close. */
   struct api_msg *current_msg;
 #endif /* LWIP_TCP */
+#if LWIP_NETCONN_ASYNC
+  /** pending netconn_recv_async() waiting for data, or NULL */
+  struct netconn_async *recv_async;
+#endif /* LWIP_NETCONN_ASYNC */
   /** A callback function that is informed about events for this netconn */
   netconn_callback callback;
 };
@@ -340,6 +383,7 @@ err_t   netconn_tcp_recvd(struct netconn *conn, size_t len);
 err_t   netconn_sendto(struct netconn *conn, struct netbuf *buf,
                              const ip_addr_t *addr, u16_t port);
 err_t   netconn_send(struct netconn *conn, struct netbuf *buf);
+err_t   netconn_send_batch(struct netconn *conn, struct netbuf **bufs, u16_t num, u16_t *sent);
 err_t   netconn_write_partly(struct netconn *conn, const void *dataptr, size_t size,
                              u8_t apiflags, size_t *bytes_written);
 err_t   netconn_write_vectors_partly(struct netconn *conn, struct netvector *vectors, u16_t vectorcnt,
@@ -349,6 +393,14 @@ err_t   netconn_write_vectors_partly(struct netconn *conn, struct netvector *vec
           netconn_write_partly(conn, dataptr, size, apiflags, NULL)
 err_t   netconn_close(struct netconn *conn);
 err_t   netconn_shutdown(struct netconn *conn, u8_t shut_rx, u8_t shut_tx);
+#if LWIP_NETCONN_ASYNC
+err_t   netconn_connect_async(struct netconn *conn, const ip_addr_t *addr, u16_t port,
+                              netconn_async_fn fn, void *arg);
+err_t   netconn_write_async(struct netconn *conn, const void *dataptr, size_t size,
+                            u8_t apiflags, netconn_async_fn fn, void *arg);
+err_t   netconn_recv_async(struct netconn *conn, netconn_async_fn fn, void *arg);
+err_t   netconn_close_async(struct netconn *conn, netconn_async_fn fn, void *arg);
+#endif /* LWIP_NETCONN_ASYNC */
 
 #if LWIP_IGMP || (LWIP_IPV6 && LWIP_IPV6_MLD)
 err_t   netconn_join_leave_group(struct netconn *conn, const ip_addr_t *multiaddr,
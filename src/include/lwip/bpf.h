@@ -0,0 +1,144 @@
+/**
+ * @file
+ * Classic BPF packet filter
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_BPF_H
+#define LWIP_HDR_BPF_H
+
+#include "lwip/opt.h"
+
+#if LWIP_SO_ATTACH_FILTER /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/pbuf.h"
+#include "lwip/err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @ingroup bpf
+ * One classic BPF instruction (same layout as struct sock_filter) */
+struct lwip_bpf_insn {
+  u16_t code;
+  u8_t  jt;
+  u8_t  jf;
+  u32_t k;
+};
+
+/** A validated filter program as attached to a pcb */
+struct lwip_bpf_program {
+  u16_t len;
+  struct lwip_bpf_insn *insns;
+};
+
+/** Maximum number of instructions in a program */
+#define LWIP_BPF_MAXINSNS   4096
+/** Number of scratch memory words */
+#define LWIP_BPF_MEMWORDS   16
+
+#ifndef BPF_CLASS
+/* instruction classes */
+#define BPF_CLASS(code) ((code) & 0x07)
+#define BPF_LD          0x00
+#define BPF_LDX         0x01
+#define BPF_ST          0x02
+#define BPF_STX         0x03
+#define BPF_ALU         0x04
+#define BPF_JMP         0x05
+#define BPF_RET         0x06
+#define BPF_MISC        0x07
+
+/* ld/ldx fields */
+#define BPF_SIZE(code)  ((code) & 0x18)
+#define BPF_W           0x00
+#define BPF_H           0x08
+#define BPF_B           0x10
+#define BPF_MODE(code)  ((code) & 0xe0)
+#define BPF_IMM         0x00
+#define BPF_ABS         0x20
+#define BPF_IND         0x40
+#define BPF_MEM         0x60
+#define BPF_LEN         0x80
+#define BPF_MSH         0xa0
+
+/* alu/jmp fields */
+#define BPF_OP(code)    ((code) & 0xf0)
+#define BPF_ADD         0x00
+#define BPF_SUB         0x10
+#define BPF_MUL         0x20
+#define BPF_DIV         0x30
+#define BPF_OR          0x40
+#define BPF_AND         0x50
+#define BPF_LSH         0x60
+#define BPF_RSH         0x70
+#define BPF_NEG         0x80
+#define BPF_MOD         0x90
+#define BPF_XOR         0xa0
+#define BPF_JA          0x00
+#define BPF_JEQ         0x10
+#define BPF_JGT         0x20
+#define BPF_JGE         0x30
+#define BPF_JSET        0x40
+#define BPF_SRC(code)   ((code) & 0x08)
+#define BPF_K           0x00
+#define BPF_X           0x08
+
+/* ret - BPF_K and BPF_X also apply */
+#define BPF_RVAL(code)  ((code) & 0x18)
+#define BPF_A           0x10
+
+/* misc */
+#define BPF_MISCOP(code) ((code) & 0xf8)
+#define BPF_TAX         0x00
+#define BPF_TXA         0x80
+
+/** Build a non-jump instruction */
+#define BPF_STMT(code, k) { (u16_t)(code), 0, 0, k }
+/** Build a conditional jump instruction */
+#define BPF_JUMP(code, k, jt, jf) { (u16_t)(code), jt, jf, k }
+#endif /* BPF_CLASS */
+
+int   lwip_bpf_validate(const struct lwip_bpf_insn *insns, u16_t len);
+u32_t lwip_bpf_filter(const struct lwip_bpf_program *prog, const struct pbuf *p);
+err_t lwip_bpf_attach(struct lwip_bpf_program **slot, const struct lwip_bpf_insn *insns, u16_t len);
+
+/** Free the program attached through 'slot' (when its pcb goes away) */
+#define lwip_bpf_detach(slot) lwip_bpf_attach(slot, NULL, 0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_SO_ATTACH_FILTER */
+
+#endif /* LWIP_HDR_BPF_H */
@@ -79,6 +79,10 @@ ssize_t etharp_find_addr(struct netif *netif, const ip4_addr_t *ipaddr,
          struct eth_addr **eth_ret, const ip4_addr_t **ip_ret);
 int etharp_get_entry(size_t i, ip4_addr_t **ipaddr, struct netif **netif, struct eth_addr **eth_ret);
 err_t etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr);
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+err_t etharp_get_nexthop_index(struct netif *netif, const ip4_addr_t *ipaddr, netif_addr_idx_t *arp_idx);
+err_t etharp_output_to_index(struct netif *netif, struct pbuf *q, netif_addr_idx_t arp_idx);
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
 err_t etharp_query(struct netif *netif, const ip4_addr_t *ipaddr, struct pbuf *q);
 err_t etharp_request(struct netif *netif, const ip4_addr_t *ipaddr);
 /** For Ethernet network interfaces, we might want to send "gratuitous ARP";
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * RSS (Toeplitz) flow hash
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_FLOWHASH_H
+#define LWIP_HDR_FLOWHASH_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip_addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Length of an RSS key in bytes */
+#define FLOWHASH_KEY_LEN 40
+
+extern const u8_t flowhash_default_key[FLOWHASH_KEY_LEN];
+
+u32_t flowhash_toeplitz(const u8_t *key, const u8_t *data, u16_t len);
+u32_t flowhash_ip(const ip_addr_t *src, const ip_addr_t *dest, u16_t sport, u16_t dport);
+u32_t flowhash_pbuf(const struct pbuf *p);
+
+/** @ingroup flowhash
+ * Map a flow hash onto one of 'num' queues/workers */
+#define FLOWHASH_SELECT(hash, num) ((u32_t)(hash) % (u32_t)(num))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_FLOWHASH_H */
@@ -96,12 +96,13 @@ struct ip_pcb {
 /*
  * Option flags per-socket. These are the same like SO_XXX in sockets.h
  */
+#define SOF_REUSEPORT     0x02U  /* allow local address & port reuse, load-balanced (see SO_REUSE) */
 #define SOF_REUSEADDR     0x04U  /* allow local address reuse */
 #define SOF_KEEPALIVE     0x08U  /* keep connections alive */
 #define SOF_BROADCAST     0x20U  /* permit to send and to receive broadcast messages (see IP_SOF_BROADCAST option) */
 
 /* These flags are inherited (e.g. from a listen-pcb to a connection-pcb): */
-#define SOF_INHERITED   (SOF_REUSEADDR|SOF_KEEPALIVE)
+#define SOF_INHERITED   (SOF_REUSEADDR|SOF_REUSEPORT|SOF_KEEPALIVE)
 
 /** Global variables of this module, kept in a struct for efficient access using base+index. */
 struct ip_globals
@@ -88,6 +88,10 @@ err_t ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_add
        u16_t optlen);
 #endif /* IP_OPTIONS_SEND */
 
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+void ip4_forward_cache_flush(void);
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
+
 #if LWIP_MULTICAST_TX_OPTIONS
 void  ip4_set_default_multicast_netif(struct netif* default_multicast_netif);
 #endif /* LWIP_MULTICAST_TX_OPTIONS */
@@ -106,6 +110,13 @@ void ip4_debug_print(struct pbuf *p);
 
 #endif /* LWIP_IPV4 */
 
+/** Invalidate forwarding decisions after a netif, route or neighbor change */
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE
+#define IP4_FORWARD_CACHE_FLUSH() ip4_forward_cache_flush()
+#else /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
+#define IP4_FORWARD_CACHE_FLUSH()
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE */
+
 #endif /* LWIP_HDR_IP_H */
 
 
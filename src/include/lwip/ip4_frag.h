@@ -55,14 +55,31 @@ extern "C" {
 /* The IP reassembly timer interval in milliseconds. */
 #define IP_TMR_INTERVAL 1000
 
+/** 1 if reassembly enforces IP_REASS_MAX_PBUFS_PER_SOURCE */
+#define IP_REASS_SOURCE_QUOTA (IP_REASS_MAX_PBUFS_PER_SOURCE < IP_REASS_MAX_PBUFS)
+
 /** IP reassembly helper struct.
  * This is exported because memp needs to know the size.
  */
 struct ip_reassdata {
   struct ip_reassdata *next;
+#if IP_REASS_HASH_SIZE
+  /* next datagram in the same hash bucket */
+  struct ip_reassdata *hnext;
+#endif /* IP_REASS_HASH_SIZE */
   struct pbuf *p;
+  /* fragment with the highest offset; in-order fragments are appended here */
+  struct pbuf *p_last;
   struct ip_hdr iphdr;
   u16_t datagram_len;
+  /* payload bytes received so far */
+  u16_t recv_len;
+  /* largest fragment end received so far */
+  u16_t max_end;
+#if IP_REASS_SOURCE_QUOTA
+  /* pbufs enqueued for this datagram */
+  u16_t clen;
+#endif /* IP_REASS_SOURCE_QUOTA */
   u8_t flags;
   u8_t timer;
 };
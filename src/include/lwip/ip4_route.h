@@ -0,0 +1,89 @@
+/**
+ * @file
+ * IPv4 routing table API
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_IP4_ROUTE_H
+#define LWIP_HDR_IP4_ROUTE_H
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/err.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** One route: several routes may share a prefix (e.g. one per uplink),
+ * they are kept sorted by metric.
+ * This is exported because memp needs to know the size.
+ */
+struct ip4_route_entry {
+  struct ip4_route_entry *next;
+  /** next hop, IP4_ADDR_ANY for an on-link route */
+  ip4_addr_t gw;
+  struct netif *netif;
+  /** lower is preferred */
+  u16_t metric;
+};
+
+/** Node of the path-compressed binary trie holding the routes.
+ * Nodes without routes only exist to branch.
+ */
+struct ip4_route_node {
+  struct ip4_route_node *child[2];
+  struct ip4_route_entry *routes;
+  /** prefix in host byte order, bits beyond prefix_len are 0 */
+  u32_t prefix;
+  u8_t prefix_len;
+};
+
+err_t ip4_route_add(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw,
+                    struct netif *netif, u16_t metric);
+err_t ip4_route_remove(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw,
+                       struct netif *netif);
+
+struct netif *ip4_route_table_netif(const ip4_addr_t *dest);
+const ip4_addr_t *ip4_route_table_gw(const struct netif *netif, const ip4_addr_t *dest);
+void ip4_route_table_netif_removed(const struct netif *netif);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE */
+
+#endif /* LWIP_HDR_IP4_ROUTE_H */
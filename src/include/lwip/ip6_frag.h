@@ -89,7 +89,13 @@ extern "C" {
  */
 struct ip6_reassdata {
   struct ip6_reassdata *next;
+#if IP_REASS_HASH_SIZE
+  /* next datagram in the same hash bucket */
+  struct ip6_reassdata *hnext;
+#endif /* IP_REASS_HASH_SIZE */
   struct pbuf *p;
+  /* fragment with the highest offset; in-order fragments are appended here */
+  struct pbuf *p_last;
   struct ip6_hdr *iphdr; /* pointer to the first (original) IPv6 header */
 #if IPV6_FRAG_COPYHEADER
   ip6_addr_p_t src; /* copy of the source address in the IP header */
@@ -103,6 +109,8 @@ struct ip6_reassdata {
 #endif /* IPV6_FRAG_COPYHEADER */
   u32_t identification;
   u16_t datagram_len;
+  /* payload bytes received so far */
+  u16_t recv_len;
   u8_t nexth;
   u8_t timer;
 #if LWIP_IPV6_SCOPES
@@ -202,6 +202,58 @@
 #define LWIP_TCPIP_CORE_LOCKING_INPUT   0
 #endif
 
+/**
+ * LWIP_TCPIP_INPUT_BATCH==1: enable tcpip_input_batch(), which passes a list
+ * of received packets (linked via pbuf->batch) to tcpip_thread in a single
+ * message. This adds one pointer to struct pbuf.
+ */
+#if !defined LWIP_TCPIP_INPUT_BATCH || defined __DOXYGEN__
+#define LWIP_TCPIP_INPUT_BATCH          0
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCK_SPIN==1: make LOCK_TCPIP_CORE() an adaptive
+ * spin-then-block lock (see tcpip_core_lock()): a thread finding the core
+ * locked polls it with sys_mutex_trylock() for a while before sleeping in
+ * sys_mutex_lock(). The number of polls adapts to how long recent waiters
+ * needed, up to LWIP_TCPIP_CORE_LOCK_SPIN_MAX.
+ * This helps on multi-core systems where the core lock is held for short
+ * times only (many small netconn/socket calls): waiters then mostly avoid
+ * being put to sleep and woken up by the OS.
+ * Needs LWIP_TCPIP_CORE_LOCKING and a port implementing sys_mutex_trylock().
+ * Don't use it on single-core systems: spinning only delays the lock owner.
+ */
+#if !defined LWIP_TCPIP_CORE_LOCK_SPIN || defined __DOXYGEN__
+#define LWIP_TCPIP_CORE_LOCK_SPIN       0
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCK_SPIN_MAX: upper limit for the number of
+ * sys_mutex_trylock() polls before blocking (LWIP_TCPIP_CORE_LOCK_SPIN).
+ */
+#if !defined LWIP_TCPIP_CORE_LOCK_SPIN_MAX || defined __DOXYGEN__
+#define LWIP_TCPIP_CORE_LOCK_SPIN_MAX   100
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE(): called between two polls of the core
+ * lock (LWIP_TCPIP_CORE_LOCK_SPIN), e.g. a CPU relax instruction
+ * ("pause" on x86, "yield" on ARM).
+ */
+#if !defined LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE || defined __DOXYGEN__
+#define LWIP_TCPIP_CORE_LOCK_SPIN_PAUSE()
+#endif
+
+/**
+ * LWIP_TCPIP_CORE_LOCK_CLOCK(): time source for the core lock hold time
+ * histogram (CORELOCK_STATS), returning an u32_t. The default of sys_now()
+ * only sees holds of a millisecond or more; define it to a finer clock
+ * (e.g. a cycle counter) to see more.
+ */
+#if !defined LWIP_TCPIP_CORE_LOCK_CLOCK || defined __DOXYGEN__
+#define LWIP_TCPIP_CORE_LOCK_CLOCK()    sys_now()
+#endif
+
 /**
  * SYS_LIGHTWEIGHT_PROT==1: enable inter-task protection (and task-vs-interrupt
  * protection) for certain critical regions during buffer allocation, deallocation
@@ -470,6 +522,23 @@
 #define MEMP_NUM_REASSDATA              5
 #endif
 
+/**
+ * MEMP_NUM_IP4_ROUTE: the number of routes in the IPv4 routing table
+ * (requires the LWIP_IPV4_ROUTE_TABLE option)
+ */
+#if !defined MEMP_NUM_IP4_ROUTE || defined __DOXYGEN__
+#define MEMP_NUM_IP4_ROUTE              8
+#endif
+
+/**
+ * MEMP_NUM_IP4_ROUTE_NODE: the number of nodes of the IPv4 routing table
+ * trie. One per distinct prefix plus one branch node per prefix is always
+ * enough. (requires the LWIP_IPV4_ROUTE_TABLE option)
+ */
+#if !defined MEMP_NUM_IP4_ROUTE_NODE || defined __DOXYGEN__
+#define MEMP_NUM_IP4_ROUTE_NODE         (2 * MEMP_NUM_IP4_ROUTE)
+#endif
+
 /**
  * MEMP_NUM_FRAG_PBUF: the number of IP fragments simultaneously sent
  * (fragments, not whole packets!).
@@ -541,6 +610,15 @@
 #define MEMP_NUM_SELECT_CB              4
 #endif
 
+/**
+ * MEMP_NUM_EPOLL_ITEM: the number of sockets that can be registered with
+ * epoll instances at the same time, counting each (instance, socket) pair
+ * once. (Only needed with LWIP_SOCKET_EPOLL==1.)
+ */
+#if !defined MEMP_NUM_EPOLL_ITEM || defined __DOXYGEN__
+#define MEMP_NUM_EPOLL_ITEM             MEMP_NUM_NETCONN
+#endif
+
 /**
  * MEMP_NUM_TCPIP_MSG_API: the number of struct tcpip_msg, which are used
  * for callback/timeout API communication.
@@ -595,6 +673,13 @@
 #define MEMP_NUM_DNS_API_MSG            MEMP_NUM_TCPIP_MSG_API
 #endif
 
+/** MEMP_NUM_NETCONN_ASYNC: the number of concurrently outstanding asynchronous
+ * netconn operations (see LWIP_NETCONN_ASYNC)
+ */
+#if !defined MEMP_NUM_NETCONN_ASYNC || defined __DOXYGEN__
+#define MEMP_NUM_NETCONN_ASYNC          (2 * MEMP_NUM_NETCONN)
+#endif
+
 /** MEMP_NUM_SOCKET_SETGETSOCKOPT_DATA: the number of concurrently active calls
  * to getsockopt/setsockopt
  */
@@ -636,6 +721,17 @@
 #define ARP_TABLE_SIZE                  10
 #endif
 
+/**
+ * ARP_TABLE_HASH_SIZE: Number of hash buckets to index the ARP table by IP
+ * address (0 to scan the table linearly). Set this for tables of more than a
+ * few dozen entries: lookups then take constant time and entries to recycle
+ * are taken from a least-recently-updated list instead of searching the table.
+ * Costs three indices per entry plus one per bucket.
+ */
+#if !defined ARP_TABLE_HASH_SIZE || defined __DOXYGEN__
+#define ARP_TABLE_HASH_SIZE             0
+#endif
+
 /** the time an ARP entry stays valid after its last update,
  *  for ARP_TMR_INTERVAL = 1000, this is
  *  (60 * 5) seconds = 5 minutes.
@@ -736,6 +832,17 @@
 #define IP_FORWARD                      0
 #endif
 
+/**
+ * LWIP_IPV4_ROUTE_TABLE==1: Enable a routing table with longest-prefix-match
+ * lookup (see ip4_route_add()). ip4_route() consults it for destinations
+ * outside the netifs' own networks, etharp uses the route's gateway as next
+ * hop. Several routes per prefix with different netifs and metrics allow
+ * failing over between uplinks.
+ */
+#if !defined LWIP_IPV4_ROUTE_TABLE || defined __DOXYGEN__
+#define LWIP_IPV4_ROUTE_TABLE           0
+#endif
+
 /**
  * IP_REASSEMBLY==1: Reassemble incoming fragmented IP packets. Note that
  * this option does not affect outgoing packet sizes, which can be controlled
@@ -758,6 +865,8 @@
 /* disable IPv4 extensions when IPv4 is disabled */
 #undef IP_FORWARD
 #define IP_FORWARD                      0
+#undef LWIP_IPV4_ROUTE_TABLE
+#define LWIP_IPV4_ROUTE_TABLE           0
 #undef IP_REASSEMBLY
 #define IP_REASSEMBLY                   0
 #undef IP_FRAG
@@ -794,6 +903,29 @@
 #define IP_REASS_MAX_PBUFS              10
 #endif
 
+/**
+ * IP_REASS_MAX_PBUFS_PER_SOURCE: Maximum amount of pbufs waiting to be
+ * reassembled for one source address. A source reaching this quota can only
+ * make room by dropping its own oldest datagrams, and when the reassembly
+ * buffer is full the oldest datagram of the source holding the most pbufs is
+ * dropped first, so one sender cannot push out everyone else's datagrams.
+ * Values >= IP_REASS_MAX_PBUFS disable the quota.
+ */
+#if !defined IP_REASS_MAX_PBUFS_PER_SOURCE || defined __DOXYGEN__
+#define IP_REASS_MAX_PBUFS_PER_SOURCE   IP_REASS_MAX_PBUFS
+#endif
+
+/**
+ * IP_REASS_HASH_SIZE: Number of hash buckets to look up the datagram an
+ * incoming fragment belongs to by (source, destination, ID, protocol) for
+ * IPv4 and by (source, destination, ID) for IPv6 (0 to search the list of
+ * datagrams being reassembled). Useful when MEMP_NUM_REASSDATA or
+ * MEMP_NUM_IP6_REASSDATA is large.
+ */
+#if !defined IP_REASS_HASH_SIZE || defined __DOXYGEN__
+#define IP_REASS_HASH_SIZE              0
+#endif
+
 /**
  * IP_DEFAULT_TTL: Default value for Time-To-Live used by transport layers.
  */
@@ -828,6 +960,19 @@
 #if !defined IP_FORWARD_ALLOW_TX_ON_RX_NETIF || defined __DOXYGEN__
 #define IP_FORWARD_ALLOW_TX_ON_RX_NETIF 0
 #endif
+
+/**
+ * IP_FORWARD_FLOW_CACHE_SIZE: Number of entries in the forwarding flow cache
+ * (0 disables it). The cache remembers the output netif and, for etharp
+ * netifs, the next hop's MAC address per destination, so that forwarded
+ * packets of established flows skip routing and the ARP table lookup.
+ * It is flushed whenever lwIP changes a netif, route or ARP entry; users of
+ * LWIP_HOOK_IP4_ROUTE(_SRC) or LWIP_HOOK_ETHARP_GET_GW must call
+ * ip4_forward_cache_flush() when the hook's routing decisions change.
+ */
+#if !defined IP_FORWARD_FLOW_CACHE_SIZE || defined __DOXYGEN__
+#define IP_FORWARD_FLOW_CACHE_SIZE      0
+#endif
 /**
  * @}
  */
@@ -897,6 +1042,15 @@
 #if !defined RAW_TTL || defined __DOXYGEN__
 #define RAW_TTL                         IP_DEFAULT_TTL
 #endif
+
+/**
+ * RAW_PCB_HASH_SIZE: Number of hash buckets used to demultiplex incoming
+ * packets to RAW PCBs by protocol (0 to offer each packet to the list of
+ * all PCBs). Useful with raw PCBs for several protocols.
+ */
+#if !defined RAW_PCB_HASH_SIZE || defined __DOXYGEN__
+#define RAW_PCB_HASH_SIZE               0
+#endif
 /**
  * @}
  */
@@ -1194,6 +1348,26 @@
 #define UDP_TTL                         IP_DEFAULT_TTL
 #endif
 
+/**
+ * UDP_PCB_HASH_SIZE: Number of hash buckets used to demultiplex incoming
+ * datagrams to UDP PCBs (0 to search the list of all PCBs). PCBs connected
+ * to a remote address are hashed by local port and remote address and port,
+ * all others by local port. Useful with many bound or connected PCBs.
+ */
+#if !defined UDP_PCB_HASH_SIZE || defined __DOXYGEN__
+#define UDP_PCB_HASH_SIZE               0
+#endif
+
+/**
+ * LWIP_PORT_ALLOC_BITMAP==1: Allocate ephemeral UDP and TCP ports from a
+ * bitmap of the local port range (RFC 6056 algorithm 3 offset) instead of
+ * checking candidate ports against all PCBs one by one. Costs 2 KByte RAM
+ * per protocol for the default range. Useful with many bound PCBs.
+ */
+#if !defined LWIP_PORT_ALLOC_BITMAP || defined __DOXYGEN__
+#define LWIP_PORT_ALLOC_BITMAP          0
+#endif
+
 /**
  * LWIP_NETBUF_RECVINFO==1: append destination addr and port to every netbuf.
  */
@@ -1555,6 +1729,20 @@
 #if !defined LWIP_PBUF_REF_T || defined __DOXYGEN__
 #define LWIP_PBUF_REF_T                 u8_t
 #endif
+
+/**
+ * LWIP_PBUF_LEN_32BIT==1: Use 32 bit wide pbuf->len and pbuf->tot_len fields
+ * (and pbuf API lengths/offsets, see pbuf_len_t) instead of the default 16 bit.
+ * This allows single pbufs and pbuf chains bigger than 64 KByte, e.g. for
+ * jumbo-frame drivers handing over large buffers or big loopback/application
+ * transfers. Packets handed to IP/UDP/TCP are still limited by their 16 bit
+ * header length fields.
+ * ATTENTION: struct pbuf grows by 4 bytes, and pbuf lengths must not be
+ * stored in u16_t variables by application code any more.
+ */
+#if !defined LWIP_PBUF_LEN_32BIT || defined __DOXYGEN__
+#define LWIP_PBUF_LEN_32BIT             0
+#endif
 /**
  * @}
  */
@@ -1921,6 +2109,30 @@
 #if !defined LWIP_NETCONN_FULLDUPLEX || defined __DOXYGEN__
 #define LWIP_NETCONN_FULLDUPLEX         0
 #endif
+
+/** LWIP_NETCONN_RECVQ==1: Use a lock-protected ring of received pbufs/netbufs
+ * per netconn instead of a sys_mbox_t as recvmbox. Posting a packet then only
+ * costs a SYS_ARCH_PROTECT section; the receiving thread is woken only when
+ * the queue becomes non-empty while it waits, so a burst of packets costs one
+ * wakeup instead of one semaphore signal per packet.
+ * The ring is allocated from the heap with DEFAULT_RAW_RECVMBOX_SIZE,
+ * DEFAULT_UDP_RECVMBOX_SIZE or DEFAULT_TCP_RECVMBOX_SIZE entries, which must
+ * not be 0 then.
+ */
+#if !defined LWIP_NETCONN_RECVQ || defined __DOXYGEN__
+#define LWIP_NETCONN_RECVQ              0
+#endif
+
+/** LWIP_NETCONN_ASYNC==1: Enable netconn_connect_async(), netconn_write_async(),
+ * netconn_recv_async() and netconn_close_async(). These only queue the
+ * operation to tcpip_thread and return; completion is reported through a
+ * callback that runs in tcpip_thread, so the caller never blocks on the
+ * per-call semaphore. Each outstanding operation takes one element from
+ * MEMP_NUM_NETCONN_ASYNC.
+ */
+#if !defined LWIP_NETCONN_ASYNC || defined __DOXYGEN__
+#define LWIP_NETCONN_ASYNC              0
+#endif
 /**
  * @}
  */
@@ -2034,7 +2246,11 @@
 #endif
 
 /**
- * SO_REUSE==1: Enable SO_REUSEADDR option.
+ * SO_REUSE==1: Enable SO_REUSEADDR and SO_REUSEPORT options.
+ * With SO_REUSEPORT set on all of them, several TCP listeners or unconnected
+ * UDP pcbs can bind the same local address and port; new connections and
+ * unicast datagrams are then spread over the group by flow hash, so each
+ * one can be served by its own thread.
  */
 #if !defined SO_REUSE || defined __DOXYGEN__
 #define SO_REUSE                        0
@@ -2049,6 +2265,15 @@
 #define SO_REUSE_RXTOALL                0
 #endif
 
+/**
+ * LWIP_SO_ATTACH_FILTER==1: Enable classic BPF receive filters for RAW and
+ * UDP pcbs (SO_ATTACH_FILTER/SO_DETACH_FILTER on sockets). Filters run in
+ * raw_input()/udp_input(), so dropped packets never reach a recvmbox.
+ */
+#if !defined LWIP_SO_ATTACH_FILTER || defined __DOXYGEN__
+#define LWIP_SO_ATTACH_FILTER           0
+#endif
+
 /**
  * LWIP_FIONREAD_LINUXMODE==0 (default): ioctl/FIONREAD returns the amount of
  * pending data in the network buffer. This is the way windows does it. It's
@@ -2078,6 +2303,47 @@
 #if !defined LWIP_SOCKET_POLL || defined __DOXYGEN__
 #define LWIP_SOCKET_POLL                1
 #endif
+
+/**
+ * LWIP_SOCKET_EPOLL==1: enable lwip_epoll_create(), lwip_epoll_ctl() and
+ * lwip_epoll_wait(). Sockets registered with an epoll instance are put on
+ * its ready list by the netconn event callback, so waiting costs O(ready
+ * sockets) instead of O(sockets) as with select() and poll().
+ * Supports level and edge triggered (EPOLLET) and one-shot (EPOLLONESHOT)
+ * registrations. Needs LWIP_SOCKET_SELECT or LWIP_SOCKET_POLL for the
+ * per-socket event state.
+ */
+#if !defined LWIP_SOCKET_EPOLL || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL               0
+#endif
+
+/**
+ * LWIP_SOCKET_EPOLL_INSTANCES: number of epoll instances that can be open
+ * at the same time. Their file descriptors follow the socket range, starting
+ * at LWIP_SOCKET_OFFSET + MEMP_NUM_NETCONN.
+ */
+#if !defined LWIP_SOCKET_EPOLL_INSTANCES || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL_INSTANCES     2
+#endif
+
+/**
+ * LWIP_SOCKET_MMSG_BATCH: maximum number of datagrams lwip_sendmmsg() passes
+ * to tcpip_thread in one call (one core lock or one message). The netbufs
+ * for a batch are kept on the caller's stack.
+ */
+#if !defined LWIP_SOCKET_MMSG_BATCH || defined __DOXYGEN__
+#define LWIP_SOCKET_MMSG_BATCH          8
+#endif
+
+/**
+ * LWIP_SOCKET_PBUF_LOAN==1: enable lwip_recvfrom_pbuf() and
+ * lwip_recv_pbuf_free() to receive without copying: the socket lends the
+ * received pbuf chain to the application, which gives it back when done.
+ * For TCP, the receive window is only opened again when the pbuf comes back.
+ */
+#if !defined LWIP_SOCKET_PBUF_LOAN || defined __DOXYGEN__
+#define LWIP_SOCKET_PBUF_LOAN           0
+#endif
 /**
  * @}
  */
@@ -2230,6 +2496,14 @@
 #define MIB2_STATS                      0
 #endif
 
+/**
+ * CORELOCK_STATS==1: Enable core lock stats (contention counters and hold
+ * time histogram, needs LWIP_TCPIP_CORE_LOCK_SPIN).
+ */
+#if !defined CORELOCK_STATS || defined __DOXYGEN__
+#define CORELOCK_STATS                  (LWIP_TCPIP_CORE_LOCK_SPIN)
+#endif
+
 #else
 
 #define LINK_STATS                      0
@@ -2250,6 +2524,7 @@
 #define MLD6_STATS                      0
 #define ND6_STATS                       0
 #define MIB2_STATS                      0
+#define CORELOCK_STATS                  0
 
 #endif /* LWIP_STATS */
 /**
@@ -2568,6 +2843,16 @@
 #define LWIP_ND6_NUM_DESTINATIONS       10
 #endif
 
+/**
+ * LWIP_ND6_CACHE_HASH_SIZE: Number of hash buckets to index each of the
+ * neighbor and destination caches by address (0 to scan them linearly). Set
+ * this when talking to more than a few dozen peers: lookups then take
+ * constant time, and the least recently used entries are recycled first.
+ */
+#if !defined LWIP_ND6_CACHE_HASH_SIZE || defined __DOXYGEN__
+#define LWIP_ND6_CACHE_HASH_SIZE        0
+#endif
+
 /**
  * LWIP_ND6_NUM_PREFIXES: number of entries in IPv6 on-link prefixes cache
  */
@@ -55,6 +55,15 @@ extern "C" {
 #define LWIP_SUPPORT_CUSTOM_PBUF ((IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG))
 #endif
 
+/** Type of the pbuf length fields (see @ref LWIP_PBUF_LEN_32BIT) */
+#if LWIP_PBUF_LEN_32BIT
+typedef u32_t pbuf_len_t;
+#define PBUF_LEN_F  U32_F
+#else /* LWIP_PBUF_LEN_32BIT */
+typedef u16_t pbuf_len_t;
+#define PBUF_LEN_F  U16_F
+#endif /* LWIP_PBUF_LEN_32BIT */
+
 /** @ingroup pbuf 
  * PBUF_NEEDS_COPY(p): return a boolean value indicating whether the given
  * pbuf needs to be copied in order to be kept around beyond the current call
@@ -197,10 +206,10 @@ struct pbuf {
    * For non-queue packet chains this is the invariant:
    * p->tot_len == p->len + (p->next? p->next->tot_len: 0)
    */
-  u16_t tot_len;
+  pbuf_len_t tot_len;
 
   /** length of this buffer */
-  u16_t len;
+  pbuf_len_t len;
 
   /** a bit field indicating pbuf type and allocation sources
       (see PBUF_TYPE_FLAG_*, PBUF_ALLOC_FLAG_* and PBUF_TYPE_ALLOC_SRC_MASK)
@@ -219,6 +228,11 @@ struct pbuf {
 
   /** For incoming packets, this contains the input netif's index */
   u8_t if_idx;
+
+#if LWIP_TCPIP_INPUT_BATCH
+  /** next packet in a tcpip_input_batch() list (not part of this packet) */
+  struct pbuf *batch;
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 };
 
 
@@ -269,14 +283,14 @@ void pbuf_free_ooseq(void);
 /* Initializes the pbuf module. This call is empty for now, but may not be in future. */
 #define pbuf_init()
 
-struct pbuf *pbuf_alloc(pbuf_layer l, u16_t length, pbuf_type type);
-struct pbuf *pbuf_alloc_reference(void *payload, u16_t length, pbuf_type type);
+struct pbuf *pbuf_alloc(pbuf_layer l, pbuf_len_t length, pbuf_type type);
+struct pbuf *pbuf_alloc_reference(void *payload, pbuf_len_t length, pbuf_type type);
 #if LWIP_SUPPORT_CUSTOM_PBUF
-struct pbuf *pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type,
+struct pbuf *pbuf_alloced_custom(pbuf_layer l, pbuf_len_t length, pbuf_type type,
                                  struct pbuf_custom *p, void *payload_mem,
-                                 u16_t payload_mem_len);
+                                 pbuf_len_t payload_mem_len);
 #endif /* LWIP_SUPPORT_CUSTOM_PBUF */
-void pbuf_realloc(struct pbuf *p, u16_t size);
+void pbuf_realloc(struct pbuf *p, pbuf_len_t size);
 #define pbuf_get_allocsrc(p)          ((p)->type_internal & PBUF_TYPE_ALLOC_SRC_MASK)
 #define pbuf_match_allocsrc(p, type)  (pbuf_get_allocsrc(p) == ((type) & PBUF_TYPE_ALLOC_SRC_MASK))
 #define pbuf_match_type(p, type)      pbuf_match_allocsrc(p, type)
@@ -285,7 +299,7 @@ u8_t pbuf_header_force(struct pbuf *p, s16_t header_size);
 u8_t pbuf_add_header(struct pbuf *p, size_t header_size_increment);
 u8_t pbuf_add_header_force(struct pbuf *p, size_t header_size_increment);
 u8_t pbuf_remove_header(struct pbuf *p, size_t header_size);
-struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size);
+struct pbuf *pbuf_free_header(struct pbuf *q, pbuf_len_t size);
 void pbuf_ref(struct pbuf *p);
 u8_t pbuf_free(struct pbuf *p);
 u16_t pbuf_clen(const struct pbuf *p);
@@ -293,11 +307,11 @@ void pbuf_cat(struct pbuf *head, struct pbuf *tail);
 void pbuf_chain(struct pbuf *head, struct pbuf *tail);
 struct pbuf *pbuf_dechain(struct pbuf *p);
 err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from);
-u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
-void *pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, u16_t len, u16_t offset);
-err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len);
-err_t pbuf_take_at(struct pbuf *buf, const void *dataptr, u16_t len, u16_t offset);
-struct pbuf *pbuf_skip(struct pbuf* in, u16_t in_offset, u16_t* out_offset);
+pbuf_len_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, pbuf_len_t len, pbuf_len_t offset);
+void *pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, pbuf_len_t len, pbuf_len_t offset);
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, pbuf_len_t len);
+err_t pbuf_take_at(struct pbuf *buf, const void *dataptr, pbuf_len_t len, pbuf_len_t offset);
+struct pbuf *pbuf_skip(struct pbuf* in, pbuf_len_t in_offset, pbuf_len_t* out_offset);
 struct pbuf *pbuf_coalesce(struct pbuf *p, pbuf_layer layer);
 struct pbuf *pbuf_clone(pbuf_layer l, pbuf_type type, struct pbuf *p);
 #if LWIP_CHECKSUM_ON_COPY
@@ -308,13 +322,53 @@ err_t pbuf_fill_chksum(struct pbuf *p, u16_t start_offset, const void *dataptr,
 void pbuf_split_64k(struct pbuf *p, struct pbuf **rest);
 #endif /* LWIP_TCP && TCP_QUEUE_OOSEQ && LWIP_WND_SCALE */
 
-u8_t pbuf_get_at(const struct pbuf* p, u16_t offset);
-int pbuf_try_get_at(const struct pbuf* p, u16_t offset);
-void pbuf_put_at(struct pbuf* p, u16_t offset, u8_t data);
+u8_t pbuf_get_at(const struct pbuf* p, pbuf_len_t offset);
+int pbuf_try_get_at(const struct pbuf* p, pbuf_len_t offset);
+void pbuf_put_at(struct pbuf* p, pbuf_len_t offset, u8_t data);
 u16_t pbuf_memcmp(const struct pbuf* p, u16_t offset, const void* s2, u16_t n);
 u16_t pbuf_memfind(const struct pbuf* p, const void* mem, u16_t mem_len, u16_t start_offset);
 u16_t pbuf_strstr(const struct pbuf* p, const char* substr);
 
+/** @ingroup pbuf
+ * Sequential read cursor over a pbuf chain (see pbuf_iter_init()).
+ * In contrast to pbuf_get_at() & co., which restart from the head of the
+ * chain on every call, advancing a cursor is amortized O(1), which makes
+ * byte-wise parsing of chained pbufs linear.
+ * Treat the members as read-only, they are only declared here so that a
+ * cursor can live on the stack.
+ */
+struct pbuf_iter {
+  /** pbuf containing the current position (only valid while left > 0) */
+  const struct pbuf *q;
+  /** offset of the current position into q->payload */
+  pbuf_len_t q_offset;
+  /** offset of the current position from the start of the chain */
+  pbuf_len_t offset;
+  /** bytes left from the current position to the end of the chain */
+  pbuf_len_t left;
+};
+
+/** @ingroup pbuf
+ * Offset of the cursor from the start of the chain it was initialized with */
+#define pbuf_iter_offset(it)  ((it)->offset)
+/** @ingroup pbuf
+ * Number of bytes left to read from the cursor */
+#define pbuf_iter_left(it)    ((it)->left)
+/** @ingroup pbuf
+ * Returned by pbuf_iter_memchr() if the byte value was not found */
+#define PBUF_ITER_NOT_FOUND   ((pbuf_len_t)-1)
+
+err_t pbuf_iter_init(struct pbuf_iter *it, const struct pbuf *p, pbuf_len_t offset);
+err_t pbuf_iter_skip(struct pbuf_iter *it, pbuf_len_t len);
+int pbuf_iter_peek_u8(const struct pbuf_iter *it);
+err_t pbuf_iter_read_u8(struct pbuf_iter *it, u8_t *data);
+err_t pbuf_iter_read_u16(struct pbuf_iter *it, u16_t *data);
+err_t pbuf_iter_read_u32(struct pbuf_iter *it, u32_t *data);
+pbuf_len_t pbuf_iter_read(struct pbuf_iter *it, void *dataptr, pbuf_len_t len);
+const void *pbuf_iter_span(const struct pbuf_iter *it, pbuf_len_t *len);
+pbuf_len_t pbuf_iter_memchr(struct pbuf_iter *it, u8_t c);
+u16_t pbuf_iter_memcmp(const struct pbuf_iter *it, const void *s2, u16_t n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,28 @@ extern "C" {
 #define API_MSG_M_DEF_SEM(m)  API_MSG_M_DEF(m)
 #endif /* LWIP_MPU_COMPATIBLE */
 
+/* Operations on netconn->recvmbox: either a sys_mbox_t or, with
+ * LWIP_NETCONN_RECVQ==1, a struct netconn_recvq */
+#if LWIP_NETCONN_RECVQ
+#define netconn_recvmbox_new(q, size)         netconn_recvq_new(q, size)
+#define netconn_recvmbox_free(q)              netconn_recvq_free(q)
+#define netconn_recvmbox_valid(q)             ((q)->items != NULL)
+#define netconn_recvmbox_valid_val(q)         ((q).items != NULL)
+#define netconn_recvmbox_set_invalid(q)       ((q)->items = NULL)
+#define netconn_recvmbox_trypost(q, msg)      netconn_recvq_trypost(q, msg)
+#define netconn_recvmbox_fetch(q, msg, tmo)   netconn_recvq_fetch(q, msg, tmo, 1)
+#define netconn_recvmbox_tryfetch(q, msg)     netconn_recvq_fetch(q, msg, 0, 0)
+#else /* LWIP_NETCONN_RECVQ */
+#define netconn_recvmbox_new(q, size)         sys_mbox_new(q, size)
+#define netconn_recvmbox_free(q)              sys_mbox_free(q)
+#define netconn_recvmbox_valid(q)             sys_mbox_valid(q)
+#define netconn_recvmbox_valid_val(q)         sys_mbox_valid_val(q)
+#define netconn_recvmbox_set_invalid(q)       sys_mbox_set_invalid(q)
+#define netconn_recvmbox_trypost(q, msg)      sys_mbox_trypost(q, msg)
+#define netconn_recvmbox_fetch(q, msg, tmo)   sys_arch_mbox_fetch(q, msg, tmo)
+#define netconn_recvmbox_tryfetch(q, msg)     sys_arch_mbox_tryfetch(q, msg)
+#endif /* LWIP_NETCONN_RECVQ */
+
 /* For the netconn API, these values are use as a bitmask! */
 #define NETCONN_SHUT_RD   1
 #define NETCONN_SHUT_WR   2
@@ -86,6 +108,12 @@ struct api_msg {
   union {
     /** used for lwip_netconn_do_send */
     struct netbuf *b;
+    /** used for lwip_netconn_do_send_batch */
+    struct {
+      struct netbuf **bufs;
+      u16_t num;
+      u16_t sent;
+    } bb;
     /** used for lwip_netconn_do_newconn */
     struct {
       u8_t proto;
@@ -152,8 +180,38 @@ struct api_msg {
 #if LWIP_NETCONN_SEM_PER_THREAD
   sys_sem_t* op_completed_sem;
 #endif /* LWIP_NETCONN_SEM_PER_THREAD */
+#if LWIP_NETCONN_ASYNC
+  /** the asynchronous operation this message belongs to: completion calls
+      its callback instead of signalling the semaphore. NULL for blocking calls. */
+  struct netconn_async *async;
+#endif /* LWIP_NETCONN_ASYNC */
 };
 
+#if LWIP_NETCONN_ASYNC
+/** An asynchronous netconn operation, allocated from MEMP_NETCONN_ASYNC on
+    submission and freed right before its completion callback is called. */
+struct netconn_async {
+  /** the message executed in tcpip_thread, msg.async points back to us */
+  struct api_msg msg;
+  /** completion callback and its argument */
+  netconn_async_fn fn;
+  void *arg;
+  /** one of NETCONN_ASYNC_* */
+  u8_t type;
+  /** data to send for netconn_write_async */
+  struct netvector vector;
+  /** remote address for netconn_connect_async */
+  ip_addr_t addr;
+};
+#define NETCONN_ASYNC_CONNECT  0
+#define NETCONN_ASYNC_WRITE    1
+#define NETCONN_ASYNC_RECV     2
+#define NETCONN_ASYNC_CLOSE    3
+#define NETCONN_MSG_IS_ASYNC(m)        ((m)->async != NULL)
+#else /* LWIP_NETCONN_ASYNC */
+#define NETCONN_MSG_IS_ASYNC(m)        0
+#endif /* LWIP_NETCONN_ASYNC */
+
 #if LWIP_NETCONN_SEM_PER_THREAD
 #define LWIP_API_MSG_SEM(msg)          ((msg)->op_completed_sem)
 #else /* LWIP_NETCONN_SEM_PER_THREAD */
@@ -199,7 +257,11 @@ void lwip_netconn_do_connect         (void *m);
 void lwip_netconn_do_disconnect      (void *m);
 void lwip_netconn_do_listen          (void *m);
 void lwip_netconn_do_send            (void *m);
+void lwip_netconn_do_send_batch      (void *m);
 void lwip_netconn_do_recv            (void *m);
+#if LWIP_NETCONN_ASYNC
+void lwip_netconn_do_recv_async      (void *m);
+#endif /* LWIP_NETCONN_ASYNC */
 #if TCP_LISTEN_BACKLOG
 void lwip_netconn_do_accepted        (void *m);
 #endif /* TCP_LISTEN_BACKLOG */
@@ -219,6 +281,13 @@ void lwip_netconn_do_gethostbyname(void *arg);
 struct netconn* netconn_alloc(enum netconn_type t, netconn_callback callback);
 void netconn_free(struct netconn *conn);
 
+#if LWIP_NETCONN_RECVQ
+err_t netconn_recvq_new(struct netconn_recvq *q, int size);
+void  netconn_recvq_free(struct netconn_recvq *q);
+err_t netconn_recvq_trypost(struct netconn_recvq *q, void *msg);
+u32_t netconn_recvq_fetch(struct netconn_recvq *q, void **msg, u32_t timeout, u8_t block);
+#endif /* LWIP_NETCONN_RECVQ */
+
 #endif /* LWIP_NETCONN || LWIP_SOCKET */
 
 #if LWIP_NETIF_API /* don't build if not configured for use in lwipopts.h */
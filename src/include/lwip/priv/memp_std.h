@@ -59,6 +59,10 @@ LWIP_MEMPOOL(ALTCP_PCB,      MEMP_NUM_ALTCP_PCB,       sizeof(struct altcp_pcb),
 #if LWIP_IPV4 && IP_REASSEMBLY
 LWIP_MEMPOOL(REASSDATA,      MEMP_NUM_REASSDATA,       sizeof(struct ip_reassdata),   "REASSDATA")
 #endif /* LWIP_IPV4 && IP_REASSEMBLY */
+#if LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE
+LWIP_MEMPOOL(IP4_ROUTE,      MEMP_NUM_IP4_ROUTE,       sizeof(struct ip4_route_entry),"IP4_ROUTE")
+LWIP_MEMPOOL(IP4_ROUTE_NODE, MEMP_NUM_IP4_ROUTE_NODE,  sizeof(struct ip4_route_node), "IP4_ROUTE_NODE")
+#endif /* LWIP_IPV4 && LWIP_IPV4_ROUTE_TABLE */
 #if (IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG)
 LWIP_MEMPOOL(FRAG_PBUF,      MEMP_NUM_FRAG_PBUF,       sizeof(struct pbuf_custom_ref),"FRAG_PBUF")
 #endif /* IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF || (LWIP_IPV6 && LWIP_IPV6_FRAG) */
@@ -67,6 +71,12 @@ LWIP_MEMPOOL(FRAG_PBUF,      MEMP_NUM_FRAG_PBUF,       sizeof(struct pbuf_custom
 LWIP_MEMPOOL(NETBUF,         MEMP_NUM_NETBUF,          sizeof(struct netbuf),         "NETBUF")
 LWIP_MEMPOOL(NETCONN,        MEMP_NUM_NETCONN,         sizeof(struct netconn),        "NETCONN")
 #endif /* LWIP_NETCONN || LWIP_SOCKET */
+#if LWIP_NETCONN && LWIP_NETCONN_ASYNC
+LWIP_MEMPOOL(NETCONN_ASYNC,  MEMP_NUM_NETCONN_ASYNC,   sizeof(struct netconn_async),  "NETCONN_ASYNC")
+#endif /* LWIP_NETCONN && LWIP_NETCONN_ASYNC */
+#if LWIP_SOCKET && LWIP_SOCKET_EPOLL
+LWIP_MEMPOOL(EPOLL_ITEM,     MEMP_NUM_EPOLL_ITEM,      sizeof(struct lwip_epitem),    "EPOLL_ITEM")
+#endif /* LWIP_SOCKET && LWIP_SOCKET_EPOLL */
 
 #if NO_SYS==0
 LWIP_MEMPOOL(TCPIP_MSG_API,  MEMP_NUM_TCPIP_MSG_API,   sizeof(struct tcpip_msg),      "TCPIP_MSG_API")
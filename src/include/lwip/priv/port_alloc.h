@@ -0,0 +1,79 @@
+/**
+ * @file
+ * Ephemeral port allocator (internal API)
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_PORT_ALLOC_H
+#define LWIP_HDR_PORT_ALLOC_H
+
+#include "lwip/opt.h"
+
+#if LWIP_PORT_ALLOC_BITMAP /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip_addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of u32_t words of a bitmap for the ports start..end */
+#define PORT_ALLOC_WORDS(start, end) ((((u32_t)(end) - (u32_t)(start)) / 32) + 1)
+
+/** Ephemeral port range of one protocol */
+struct port_alloc {
+  /** bit set: port (start + bit number) may be in use */
+  u32_t *map;
+  /** first and last port of the range */
+  u16_t start, end;
+  /** RFC 6056 'counter': moves the search on with every allocation */
+  u16_t counter;
+  /** secret key of the RFC 6056 offset function */
+  u32_t secret;
+};
+
+/** Define a struct port_alloc 'name' and its bitmap for the ports start..end */
+#define PORT_ALLOC_DECLARE(name, start, end) \
+  static u32_t name##_map[PORT_ALLOC_WORDS(start, end)]; \
+  static struct port_alloc name = { name##_map, (start), (end), 0, 0 }
+
+void  port_alloc_init(struct port_alloc *pa);
+void  port_alloc_reset(struct port_alloc *pa);
+void  port_alloc_set(struct port_alloc *pa, u16_t port);
+u16_t port_alloc_new(struct port_alloc *pa, const ip_addr_t *remote_ip, u16_t remote_port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_PORT_ALLOC_BITMAP */
+
+#endif /* LWIP_HDR_PORT_ALLOC_H */
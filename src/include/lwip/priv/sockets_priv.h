@@ -81,6 +81,10 @@ struct lwip_sock {
   /** counter of how many threads are waiting for this socket using select */
   SELWAIT_T select_waiting;
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
+#if LWIP_SOCKET_EPOLL
+  /** epoll instances this socket is registered with */
+  struct lwip_epitem *epitems;
+#endif /* LWIP_SOCKET_EPOLL */
 #if LWIP_NETCONN_FULLDUPLEX
   /* counter of how many threads are using a struct lwip_sock (not the 'int') */
   u8_t fd_used;
@@ -170,6 +174,42 @@ struct lwip_select_cb {
 };
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
 
+#if LWIP_SOCKET_EPOLL
+/** One socket registered with one epoll instance */
+struct lwip_epitem {
+  /** next registration of the same socket */
+  struct lwip_epitem *sock_next;
+  /** next/previous entry on the instance's ready list */
+  struct lwip_epitem *rdy_next;
+  struct lwip_epitem *rdy_prev;
+  /** the instance and socket this registration belongs to */
+  struct lwip_epoll *ep;
+  struct lwip_sock *sock;
+  /** events and data passed to epoll_ctl() */
+  u32_t events;
+  epoll_data_t data;
+  /** 1 while on the ready list */
+  u8_t ready;
+  /** 1 after an EPOLLONESHOT event was reported, until EPOLL_CTL_MOD */
+  u8_t disabled;
+};
+
+/** An epoll instance */
+struct lwip_epoll {
+  /** 1 while the file descriptor is open */
+  u8_t used;
+  /** registrations that may have events to report, in order of arrival */
+  struct lwip_epitem *rdy_head;
+  struct lwip_epitem *rdy_tail;
+  /** number of threads waiting in lwip_epoll_wait() */
+  int waiting;
+  /** don't signal the semaphore twice: set to 1 when signalled */
+  int sem_signalled;
+  /** semaphore to wake up threads waiting in lwip_epoll_wait() */
+  sys_sem_t sem;
+};
+#endif /* LWIP_SOCKET_EPOLL */
+
 #endif /* LWIP_SOCKET */
 
 #endif /* LWIP_HDR_SOCKETS_PRIV_H */
@@ -47,6 +47,7 @@
 #include "lwip/ip.h"
 #include "lwip/ip_addr.h"
 #include "lwip/ip6_addr.h"
+#include "lwip/bpf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +78,10 @@ struct raw_pcb {
   IP_PCB;
 
   struct raw_pcb *next;
+#if RAW_PCB_HASH_SIZE
+  /** next PCB in the same protocol hash bucket */
+  struct raw_pcb *hnext;
+#endif /* RAW_PCB_HASH_SIZE */
 
   u8_t protocol;
   u8_t flags;
@@ -92,6 +97,10 @@ struct raw_pcb {
   raw_recv_fn recv;
   /* user-supplied argument for the recv callback */
   void *recv_arg;
+#if LWIP_SO_ATTACH_FILTER
+  /** receive filter, run before recv is called */
+  struct lwip_bpf_program *filter;
+#endif /* LWIP_SO_ATTACH_FILTER */
 #if LWIP_IPV6
   /* fields for handling checksum computations as per RFC3542. */
   u16_t chksum_offset;
@@ -114,6 +123,9 @@ err_t            raw_sendto_if_src(struct raw_pcb *pcb, struct pbuf *p, const ip
 err_t            raw_send       (struct raw_pcb *pcb, struct pbuf *p);
 
 void             raw_recv       (struct raw_pcb *pcb, raw_recv_fn recv, void *recv_arg);
+#if LWIP_SO_ATTACH_FILTER
+err_t            raw_attach_filter(struct raw_pcb *pcb, const struct lwip_bpf_insn *insns, u16_t len);
+#endif /* LWIP_SO_ATTACH_FILTER */
 
 #define          raw_flags(pcb) ((pcb)->flags)
 #define          raw_setflags(pcb,f)  ((pcb)->flags = (f))
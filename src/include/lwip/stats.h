@@ -120,6 +120,26 @@ struct stats_sys {
   struct stats_syselem mbox;
 };
 
+/** Number of buckets in the core lock hold time histogram */
+#define STATS_CORELOCK_HOLD_BUCKETS 24
+
+/** Core lock stats (@ref LWIP_TCPIP_CORE_LOCK_SPIN) */
+struct stats_corelock {
+  /** number of times the lock was taken */
+  STAT_COUNTER acquired;
+  /** lock was busy at the first try... */
+  STAT_COUNTER contended;
+  /** ...and was acquired while spinning */
+  STAT_COUNTER spun;
+  /** ...and the caller had to block */
+  STAT_COUNTER blocked;
+  /** longest hold time in LWIP_TCPIP_CORE_LOCK_CLOCK() units */
+  u32_t hold_max;
+  /** hold[i] counts hold times of i significant bits (hold[0]: 0, hold[1]: 1,
+      hold[2]: 2..3, hold[3]: 4..7, ...), the last bucket counts all longer ones */
+  STAT_COUNTER hold[STATS_CORELOCK_HOLD_BUCKETS];
+};
+
 /** SNMP MIB2 stats */
 struct stats_mib2 {
   /* IP */
@@ -298,6 +318,10 @@ struct stats_ {
   /** SNMP MIB2 */
   struct stats_mib2 mib2;
 #endif
+#if CORELOCK_STATS
+  /** Core lock */
+  struct stats_corelock corelock;
+#endif
 };
 
 /** Global variable containing lwIP internal statistics. Add this to your debugger's watchlist. */
@@ -467,6 +491,14 @@ void stats_init(void);
 #define MIB2_STATS_INC(x)
 #endif
 
+#if CORELOCK_STATS
+#define CORELOCK_STATS_INC(x) STATS_INC(corelock.x)
+#define CORELOCK_STATS_DISPLAY() stats_display_corelock(&lwip_stats.corelock)
+#else
+#define CORELOCK_STATS_INC(x)
+#define CORELOCK_STATS_DISPLAY()
+#endif
+
 /* Display of statistics */
 #if LWIP_STATS_DISPLAY
 void stats_display(void);
@@ -475,6 +507,7 @@ void stats_display_igmp(struct stats_igmp *igmp, const char *name);
 void stats_display_mem(struct stats_mem *mem, const char *name);
 void stats_display_memp(struct stats_mem *mem, int index);
 void stats_display_sys(struct stats_sys *sys);
+void stats_display_corelock(struct stats_corelock *corelock);
 #else /* LWIP_STATS_DISPLAY */
 #define stats_display()
 #define stats_display_proto(proto, name)
@@ -482,6 +515,7 @@ void stats_display_sys(struct stats_sys *sys);
 #define stats_display_mem(mem, name)
 #define stats_display_memp(mem, index)
 #define stats_display_sys(sys)
+#define stats_display_corelock(corelock)
 #endif /* LWIP_STATS_DISPLAY */
 
 #ifdef __cplusplus
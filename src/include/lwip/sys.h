@@ -141,6 +141,14 @@ err_t sys_mutex_new(sys_mutex_t *mutex);
  * @param mutex the mutex to lock
  */
 void sys_mutex_lock(sys_mutex_t *mutex);
+/**
+ * @ingroup sys_mutex
+ * Grabs the mutex if it is free, without blocking.
+ * Only needed with @ref LWIP_TCPIP_CORE_LOCK_SPIN.
+ * @param mutex the mutex to lock
+ * @return ERR_OK if the mutex has been locked, ERR_WOULDBLOCK if it is taken
+ */
+err_t sys_mutex_trylock(sys_mutex_t *mutex);
 /**
  * @ingroup sys_mutex
  * Releases the mutex previously locked through 'sys_mutex_lock()'.
@@ -52,11 +52,20 @@ extern "C" {
 #if LWIP_TCPIP_CORE_LOCKING
 /** The global semaphore to lock the stack. */
 extern sys_mutex_t lock_tcpip_core;
+#if LWIP_TCPIP_CORE_LOCK_SPIN
+void tcpip_core_lock(void);
+void tcpip_core_unlock(void);
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN */
 #if !defined LOCK_TCPIP_CORE || defined __DOXYGEN__
+#if LWIP_TCPIP_CORE_LOCK_SPIN
+#define LOCK_TCPIP_CORE()     tcpip_core_lock()
+#define UNLOCK_TCPIP_CORE()   tcpip_core_unlock()
+#else /* LWIP_TCPIP_CORE_LOCK_SPIN */
 /** Lock lwIP core mutex (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
 #define LOCK_TCPIP_CORE()     sys_mutex_lock(&lock_tcpip_core)
 /** Unlock lwIP core mutex (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
 #define UNLOCK_TCPIP_CORE()   sys_mutex_unlock(&lock_tcpip_core)
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN */
 #endif /* LOCK_TCPIP_CORE */
 #else /* LWIP_TCPIP_CORE_LOCKING */
 #define LOCK_TCPIP_CORE()
@@ -78,6 +87,10 @@ void   tcpip_init(tcpip_init_done_fn tcpip_init_done, void *arg);
 
 err_t  tcpip_inpkt(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
 err_t  tcpip_input(struct pbuf *p, struct netif *inp);
+#if LWIP_TCPIP_INPUT_BATCH
+err_t  tcpip_inpkt_batch(struct pbuf *p, struct netif *inp, netif_input_fn input_fn);
+err_t  tcpip_input_batch(struct pbuf *p, struct netif *inp);
+#endif /* LWIP_TCPIP_INPUT_BATCH */
 
 err_t  tcpip_try_callback(tcpip_callback_fn function, void *ctx);
 err_t  tcpip_callback(tcpip_callback_fn function, void *ctx);
@@ -48,6 +48,7 @@
 #include "lwip/ip.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/prot/udp.h"
+#include "lwip/bpf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -85,6 +86,10 @@ struct udp_pcb {
 /* Protocol specific PCB members */
 
   struct udp_pcb *next;
+#if UDP_PCB_HASH_SIZE
+  /** next PCB in the same demultiplexing hash bucket */
+  struct udp_pcb *hnext;
+#endif /* UDP_PCB_HASH_SIZE */
 
   u8_t flags;
   /** ports are in host byte order */
@@ -110,6 +115,10 @@ struct udp_pcb {
   udp_recv_fn recv;
   /** user-supplied argument for the recv callback */
   void *recv_arg;
+#if LWIP_SO_ATTACH_FILTER
+  /** receive filter, run before recv is called */
+  struct lwip_bpf_program *filter;
+#endif /* LWIP_SO_ATTACH_FILTER */
 };
 /* udp_pcbs export for external reference (e.g. SNMP agent) */
 extern struct udp_pcb *udp_pcbs;
@@ -136,6 +145,9 @@ err_t            udp_sendto_if_src(struct udp_pcb *pcb, struct pbuf *p,
 err_t            udp_sendto     (struct udp_pcb *pcb, struct pbuf *p,
                                  const ip_addr_t *dst_ip, u16_t dst_port);
 err_t            udp_send       (struct udp_pcb *pcb, struct pbuf *p);
+#if LWIP_SO_ATTACH_FILTER
+err_t            udp_attach_filter(struct udp_pcb *pcb, const struct lwip_bpf_insn *insns, u16_t len);
+#endif /* LWIP_SO_ATTACH_FILTER */
 
 #if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_UDP
 err_t            udp_sendto_if_chksum(struct udp_pcb *pcb, struct pbuf *p,
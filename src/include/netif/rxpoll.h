@@ -0,0 +1,109 @@
+/**
+ * @file
+ * Budgeted (NAPI-style) receive polling for Ethernet drivers
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_NETIF_RXPOLL_H
+#define LWIP_HDR_NETIF_RXPOLL_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of frames handled per rxpoll_poll() call */
+#ifndef RXPOLL_MAX_BUDGET
+#define RXPOLL_MAX_BUDGET 32
+#endif
+
+struct rxpoll;
+
+/** Hardware (or simulation) backend of an rxpoll instance */
+struct rxpoll_ops {
+  /** Mask (enable == 0) or unmask (enable != 0) the RX interrupt.
+   * Masking must also acknowledge the interrupt. It is called from
+   * rxpoll_irq(), i.e. from the ISR, and at the start of every poll (so that
+   * frames about to be drained don't raise the interrupt again).
+   * Unmasking must raise the interrupt again if a frame was received since
+   * the last acknowledge (latched status flags do that). */
+  void (*irq_enable)(struct rxpoll *rp, u8_t enable);
+  /** Fetch the next received frame from the RX ring.
+   * Return 0 if the ring is empty. Otherwise return 1 and set '*p' to the
+   * frame, or to NULL if the frame had to be dropped. */
+  int (*rx)(struct rxpoll *rp, struct pbuf **p);
+  /** Optional: pass 'num' frames to the stack at once (e.g. with a single
+   * message or lock). NULL means netif->input is called for each frame.
+   * The callee takes ownership of the pbufs, the array is reused. */
+  void (*input)(struct rxpoll *rp, struct pbuf **frames, u16_t num);
+};
+
+/** Statistics of an rxpoll instance */
+struct rxpoll_stats {
+  /** RX interrupts taken */
+  u32_t irqs;
+  /** rxpoll_poll() calls that did work */
+  u32_t polls;
+  /** frames passed to the stack */
+  u32_t frames;
+  /** polls that ended because the budget was used up */
+  u32_t budget_exhausted;
+};
+
+/** Budgeted RX polling state of one interface */
+struct rxpoll {
+  const struct rxpoll_ops *ops;
+  /** backend state */
+  void *state;
+  /** interface frames are passed to */
+  struct netif *netif;
+  /** maximum number of frames per poll (<= RXPOLL_MAX_BUDGET) */
+  u16_t budget;
+  /** 1 while the RX interrupt is masked and polling is in progress */
+  volatile u8_t scheduled;
+  struct rxpoll_stats stats;
+  /** frames collected by the current poll */
+  struct pbuf *batch[RXPOLL_MAX_BUDGET];
+};
+
+void rxpoll_init(struct rxpoll *rp, const struct rxpoll_ops *ops, void *state,
+                 struct netif *netif, u16_t budget);
+int rxpoll_irq(struct rxpoll *rp);
+int rxpoll_poll(struct rxpoll *rp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_NETIF_RXPOLL_H */
@@ -0,0 +1,96 @@
+/**
+ * @file
+ * Zero-copy receive buffer ring for Ethernet drivers
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_NETIF_RXRING_H
+#define LWIP_HDR_NETIF_RXRING_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+
+#if LWIP_SUPPORT_CUSTOM_PBUF /* don't build if custom pbufs are not available */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rxring;
+
+/** One driver owned receive buffer. While armed in a receive descriptor it
+ * belongs to the driver, while passed up as custom pbuf it belongs to the
+ * stack, and it returns to its ring when that pbuf is freed. */
+struct rxring_buf {
+  /** pbuf_custom wrapping the buffer (must be the first member) */
+  struct pbuf_custom pc;
+  /** ring this buffer belongs to */
+  struct rxring *ring;
+  /** next buffer in the free list */
+  struct rxring_buf *next;
+  /** start of the buffer memory (what the DMA writes to) */
+  u8_t *payload;
+};
+
+/** Receive statistics of an rxring */
+struct rxring_stats {
+  /** frames passed to the stack in their DMA buffer (no copy) */
+  u32_t zero_copy;
+  /** frames copied into a pool pbuf because no spare buffer was free */
+  u32_t copied;
+  /** frames dropped (no spare buffer and no pool pbuf) */
+  u32_t dropped;
+};
+
+/** A set of driver owned receive buffers */
+struct rxring {
+  /** buffers currently not armed in a descriptor nor held by the stack */
+  struct rxring_buf *free_bufs;
+  /** number of buffers in free_bufs */
+  u16_t num_free;
+  /** size of each buffer */
+  u16_t buf_size;
+  struct rxring_stats stats;
+};
+
+void rxring_init(struct rxring *ring, struct rxring_buf *bufs, u8_t *mem,
+                 u16_t count, u16_t buf_size);
+struct rxring_buf *rxring_buf_get(struct rxring *ring);
+void rxring_buf_put(struct rxring_buf *buf);
+struct pbuf *rxring_input(struct rxring *ring, struct rxring_buf **slot, u16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+
+#endif /* LWIP_HDR_NETIF_RXRING_H */
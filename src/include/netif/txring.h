@@ -0,0 +1,118 @@
+/**
+ * @file
+ * Scatter-gather TX descriptor ring for Ethernet drivers
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_NETIF_TXRING_H
+#define LWIP_HDR_NETIF_TXRING_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Descriptor flag: first segment of a frame */
+#define TXRING_FIRST  0x01U
+/** Descriptor flag: last segment of a frame */
+#define TXRING_LAST   0x02U
+
+struct txring;
+
+/** Hardware (or simulation) backend of a txring */
+struct txring_ops {
+  /** Program descriptor 'idx' with one segment of a frame. The descriptor
+   * must not be handed to the DMA yet.
+   * 'frame_len' is the length of the whole frame, 'flags' is a combination of
+   * TXRING_FIRST and TXRING_LAST. */
+  void (*desc_fill)(struct txring *ring, u16_t idx, const void *data, u16_t len,
+                    u16_t frame_len, u8_t flags);
+  /** Hand 'num' filled descriptors starting at 'first' (wrapping at the ring
+   * size) to the DMA and start transmission. */
+  void (*start)(struct txring *ring, u16_t first, u16_t num);
+  /** Return 1 if the DMA is done with descriptor 'idx'. Only called for
+   * descriptors that have been passed to start(). */
+  int (*desc_done)(struct txring *ring, u16_t idx);
+  /** Optional: return 1 if the DMA can read 'len' bytes at 'data'
+   * (e.g. not in tightly coupled memory). NULL means all memory is fine. */
+  int (*dma_ok)(struct txring *ring, const void *data, u16_t len);
+  /** Optional: allocate a single pbuf of exactly 'len' bytes in memory the
+   * DMA can read, used to copy frames that cannot be sent in place.
+   * NULL means a PBUF_RAM pbuf from the heap. */
+  struct pbuf *(*alloc)(struct txring *ring, u16_t len);
+};
+
+/** Transmit statistics of a txring */
+struct txring_stats {
+  /** frames queued */
+  u32_t frames;
+  /** descriptors used by those frames */
+  u32_t segments;
+  /** frames that had to be copied into one pbuf */
+  u32_t linearized;
+  /** frames rejected with ERR_MEM because the ring was full */
+  u32_t ring_full;
+};
+
+/** A ring of TX DMA descriptors, each mapping one pbuf segment */
+struct txring {
+  const struct txring_ops *ops;
+  /** backend state */
+  void *state;
+  /** per descriptor: pbuf to free when the descriptor is completed */
+  struct pbuf **pbufs;
+  /** number of descriptors */
+  u16_t count;
+  /** next descriptor to fill */
+  u16_t head;
+  /** oldest descriptor owned by the DMA */
+  u16_t tail;
+  /** descriptors between tail and head that have been started */
+  u16_t used;
+  struct txring_stats stats;
+};
+
+/** Number of descriptors currently available for new frames */
+#define txring_num_free(ring) ((u16_t)((ring)->count - (ring)->used))
+
+void txring_init(struct txring *ring, const struct txring_ops *ops, void *state,
+                 struct pbuf **pbufs, u16_t count);
+err_t txring_output(struct txring *ring, struct pbuf *p);
+u16_t txring_reclaim(struct txring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_NETIF_TXRING_H */
@@ -0,0 +1,172 @@
+/**
+ * @file
+ *
+ * @defgroup rxpoll Budgeted RX polling
+ * @ingroup netifs
+ * Interrupt mitigation for Ethernet drivers, modelled after Linux NAPI.
+ *
+ * Instead of handling one frame per receive interrupt, the ISR only masks
+ * the RX interrupt and wakes the driver thread (rxpoll_irq()). The thread
+ * then calls rxpoll_poll(), which drains up to 'budget' frames from the RX
+ * ring and passes them to the stack as one batch. The interrupt is unmasked
+ * only once the ring is found empty; while it is not, rxpoll_poll() returns
+ * 1 and the thread keeps polling (after giving other threads a chance to
+ * run). Under load, the number of interrupts drops from one per frame to
+ * one per burst.
+ *
+ * Usage in a driver:
+ * @code{.c}
+ *   void eth_isr(void) {
+ *     if (rxpoll_irq(&rxpoll)) {
+ *       wake_driver_thread();
+ *     }
+ *   }
+ *   void eth_thread(void) {
+ *     for (;;) {
+ *       wait_for_wakeup();
+ *       while (rxpoll_poll(&rxpoll)) {
+ *         yield();
+ *       }
+ *     }
+ *   }
+ * @endcode
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "netif/rxpoll.h"
+#include "lwip/debug.h"
+
+#include <string.h>
+
+/**
+ * @ingroup rxpoll
+ * Initialize an rxpoll instance. The RX interrupt is expected to be enabled.
+ *
+ * @param rp the instance to initialize
+ * @param ops the backend accessing the hardware
+ * @param state backend state (stored in rp->state)
+ * @param netif the interface to pass frames to
+ * @param budget maximum number of frames per poll (1..RXPOLL_MAX_BUDGET)
+ */
+void
+rxpoll_init(struct rxpoll *rp, const struct rxpoll_ops *ops, void *state,
+            struct netif *netif, u16_t budget)
+{
+  LWIP_ASSERT("rxpoll_init: invalid rp", rp != NULL);
+  LWIP_ASSERT("rxpoll_init: invalid ops", (ops != NULL) && (ops->irq_enable != NULL) &&
+              (ops->rx != NULL));
+  LWIP_ASSERT("rxpoll_init: invalid netif", (netif != NULL) || (ops->input != NULL));
+  LWIP_ASSERT("rxpoll_init: invalid budget", (budget > 0) && (budget <= RXPOLL_MAX_BUDGET));
+
+  memset(rp, 0, sizeof(struct rxpoll));
+  rp->ops = ops;
+  rp->state = state;
+  rp->netif = netif;
+  rp->budget = budget;
+}
+
+/**
+ * @ingroup rxpoll
+ * Handle an RX interrupt: mask further RX interrupts and schedule polling.
+ * Call this from the ISR.
+ *
+ * @param rp the instance that received the interrupt
+ * @return 1 if the driver thread has to be woken up to call rxpoll_poll(),
+ *         0 if polling was already scheduled
+ */
+int
+rxpoll_irq(struct rxpoll *rp)
+{
+  rp->ops->irq_enable(rp, 0);
+  rp->stats.irqs++;
+  if (rp->scheduled) {
+    return 0;
+  }
+  rp->scheduled = 1;
+  return 1;
+}
+
+/**
+ * @ingroup rxpoll
+ * Pass up to 'budget' received frames to the stack in one batch.
+ * Call this from the driver thread after rxpoll_irq() returned 1.
+ *
+ * @param rp the instance to poll
+ * @return 1 if the budget was used up and rxpoll_poll() has to be called
+ *         again, 0 if the RX ring is empty and the interrupt is re-enabled
+ */
+int
+rxpoll_poll(struct rxpoll *rp)
+{
+  u16_t work = 0, num = 0;
+  struct pbuf *p;
+
+  if (!rp->scheduled) {
+    return 0;
+  }
+  rp->stats.polls++;
+
+  /* acknowledge: only frames arriving from now on re-raise the interrupt */
+  rp->ops->irq_enable(rp, 0);
+  while ((work < rp->budget) && rp->ops->rx(rp, &p)) {
+    work++;
+    if (p != NULL) {
+      rp->batch[num++] = p;
+    }
+  }
+
+  if (num > 0) {
+    rp->stats.frames += num;
+    if (rp->ops->input != NULL) {
+      rp->ops->input(rp, rp->batch, num);
+    } else {
+      u16_t i;
+      for (i = 0; i < num; i++) {
+        if (rp->netif->input(rp->batch[i], rp->netif) != ERR_OK) {
+          LWIP_DEBUGF(NETIF_DEBUG, ("rxpoll_poll: input error\n"));
+          pbuf_free(rp->batch[i]);
+        }
+      }
+    }
+  }
+
+  if (work == rp->budget) {
+    /* maybe more frames pending: keep polling with the interrupt masked */
+    rp->stats.budget_exhausted++;
+    return 1;
+  }
+
+  /* ring empty: back to interrupt mode */
+  rp->scheduled = 0;
+  rp->ops->irq_enable(rp, 1);
+  return 0;
+}
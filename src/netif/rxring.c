@@ -0,0 +1,218 @@
+/**
+ * @file
+ *
+ * @defgroup rxring Zero-copy RX buffer ring
+ * @ingroup netifs
+ * Generic helper for Ethernet drivers that receive into DMA buffers.
+ *
+ * Instead of copying every frame out of its DMA buffer into a pool pbuf,
+ * the buffer is wrapped into a PBUF_REF custom pbuf and passed to
+ * netif->input directly. The receive descriptor is re-armed with a spare
+ * buffer from the ring, and the custom free function returns the buffer to
+ * the ring once the stack is done with it. Only if no spare buffer is left,
+ * the frame is copied (and the descriptor keeps its buffer), so the driver
+ * never runs out of armed descriptors.
+ *
+ * The ring should contain more buffers than there are receive descriptors;
+ * the surplus is the number of frames the stack can hold without forcing
+ * copies (e.g. in TCP ooseq or IP reassembly queues).
+ *
+ * Usage in a driver:
+ * @code{.c}
+ *   rxring_init(&ring, bufs, &dma_mem[0][0], NUM_BUFS, sizeof(dma_mem[0]));
+ *   for (i = 0; i < NUM_DESC; i++) {
+ *     slot[i] = rxring_buf_get(&ring);
+ *     arm_descriptor(i, slot[i]->payload);
+ *   }
+ *   ...
+ *   p = rxring_input(&ring, &slot[i], frame_len);
+ *   arm_descriptor(i, slot[i]->payload);
+ *   if ((p != NULL) && (netif->input(p, netif) != ERR_OK)) {
+ *     pbuf_free(p);
+ *   }
+ * @endcode
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "netif/rxring.h"
+
+#if LWIP_SUPPORT_CUSTOM_PBUF /* don't build if custom pbufs are not available */
+
+#include "lwip/sys.h"
+#include "lwip/debug.h"
+
+#include <string.h>
+
+static void
+rxring_pbuf_free(struct pbuf *p)
+{
+  rxring_buf_put((struct rxring_buf *)p);
+}
+
+/**
+ * @ingroup rxring
+ * Initialize a receive buffer ring. All buffers start out free.
+ *
+ * @param ring the ring to initialize
+ * @param bufs array of 'count' buffer descriptors
+ * @param mem DMA memory of 'count' * 'buf_size' bytes
+ * @param count number of buffers
+ * @param buf_size size of each buffer (the stride in 'mem')
+ */
+void
+rxring_init(struct rxring *ring, struct rxring_buf *bufs, u8_t *mem,
+            u16_t count, u16_t buf_size)
+{
+  u16_t i;
+
+  LWIP_ASSERT("rxring_init: invalid ring", ring != NULL);
+  LWIP_ASSERT("rxring_init: invalid bufs", (bufs != NULL) || (count == 0));
+  LWIP_ASSERT("rxring_init: invalid mem", (mem != NULL) || (count == 0));
+
+  memset(ring, 0, sizeof(struct rxring));
+  ring->buf_size = buf_size;
+  for (i = 0; i < count; i++) {
+    struct rxring_buf *buf = &bufs[i];
+    buf->pc.custom_free_function = rxring_pbuf_free;
+    buf->ring = ring;
+    buf->payload = mem + (size_t)i * buf_size;
+    rxring_buf_put(buf);
+  }
+}
+
+/**
+ * @ingroup rxring
+ * Take a free buffer from the ring, e.g. to arm a receive descriptor.
+ *
+ * @param ring the ring to take a buffer from
+ * @return a buffer or NULL if all buffers are in use
+ */
+struct rxring_buf *
+rxring_buf_get(struct rxring *ring)
+{
+  struct rxring_buf *buf;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ASSERT("rxring_buf_get: invalid ring", ring != NULL);
+
+  SYS_ARCH_PROTECT(old_level);
+  buf = ring->free_bufs;
+  if (buf != NULL) {
+    ring->free_bufs = buf->next;
+    ring->num_free--;
+  }
+  SYS_ARCH_UNPROTECT(old_level);
+  return buf;
+}
+
+/**
+ * @ingroup rxring
+ * Return a buffer to its ring. This is called by pbuf_free() for buffers
+ * passed up by rxring_input(), but may also be used by the driver to return
+ * buffers taken with rxring_buf_get().
+ * May be called from any thread.
+ *
+ * @param buf the buffer to return
+ */
+void
+rxring_buf_put(struct rxring_buf *buf)
+{
+  struct rxring *ring;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ASSERT("rxring_buf_put: invalid buf", buf != NULL);
+  ring = buf->ring;
+
+  SYS_ARCH_PROTECT(old_level);
+  buf->next = ring->free_bufs;
+  ring->free_bufs = buf;
+  ring->num_free++;
+  SYS_ARCH_UNPROTECT(old_level);
+}
+
+/**
+ * @ingroup rxring
+ * Pass a received frame up without copying it.
+ *
+ * The buffer in '*slot' (the one armed in the receive descriptor) holds
+ * 'len' bytes of frame data (after ETH_PAD_SIZE bytes of padding). If a spare
+ * buffer is free, the buffer in '*slot' is wrapped into a custom pbuf and
+ * '*slot' is replaced with the spare buffer. Otherwise, the frame is copied
+ * into a PBUF_POOL pbuf and '*slot' is left unchanged.
+ * In any case, the descriptor can be re-armed with (*slot)->payload
+ * afterwards.
+ *
+ * @param ring the ring the buffers belong to
+ * @param slot pointer to the buffer armed in the descriptor
+ * @param len length of the received frame (without ETH_PAD_SIZE)
+ * @return a pbuf to pass to netif->input or NULL if the frame was dropped
+ */
+struct pbuf *
+rxring_input(struct rxring *ring, struct rxring_buf **slot, u16_t len)
+{
+  struct rxring_buf *buf, *spare;
+  struct pbuf *p;
+  u16_t tot_len = (u16_t)(len + ETH_PAD_SIZE);
+
+  LWIP_ASSERT("rxring_input: invalid ring", ring != NULL);
+  LWIP_ASSERT("rxring_input: invalid slot", (slot != NULL) && (*slot != NULL));
+  buf = *slot;
+  LWIP_ASSERT("rxring_input: buffer of other ring", buf->ring == ring);
+
+  if (tot_len > ring->buf_size) {
+    LWIP_DEBUGF(NETIF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("rxring_input: frame too long (%"U16_F")\n", len));
+    ring->stats.dropped++;
+    return NULL;
+  }
+
+  spare = rxring_buf_get(ring);
+  if (spare != NULL) {
+    p = pbuf_alloced_custom(PBUF_RAW, tot_len, PBUF_REF, &buf->pc, buf->payload, ring->buf_size);
+    LWIP_ASSERT("rxring_input: pbuf_alloced_custom failed", p != NULL);
+    *slot = spare;
+    ring->stats.zero_copy++;
+    return p;
+  }
+
+  /* all spare buffers are held by the stack: copy and keep the DMA buffer */
+  p = pbuf_alloc(PBUF_RAW, tot_len, PBUF_POOL);
+  if (p == NULL) {
+    LWIP_DEBUGF(NETIF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("rxring_input: out of pbufs, frame dropped\n"));
+    ring->stats.dropped++;
+    return NULL;
+  }
+  pbuf_take(p, buf->payload, tot_len);
+  ring->stats.copied++;
+  return p;
+}
+
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
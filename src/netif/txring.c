@@ -0,0 +1,250 @@
+/**
+ * @file
+ *
+ * @defgroup txring Scatter-gather TX descriptor ring
+ * @ingroup netifs
+ * Generic helper for Ethernet drivers with scatter-gather TX DMA.
+ *
+ * txring_output() maps every segment of a pbuf chain to one DMA descriptor
+ * instead of copying the frame into a driver buffer. The chain is
+ * referenced with pbuf_ref() and released by txring_reclaim() once the DMA
+ * has completed its descriptors (call that from the TX completion
+ * interrupt's deferred handler). txring_output() never waits for
+ * descriptors: if the ring is full, it returns ERR_MEM right away, which the
+ * stack treats like any other out-of-memory condition on output (TCP keeps
+ * the segment queued and retries).
+ *
+ * A frame is copied into a single pbuf only if it has more segments than the
+ * ring has descriptors, if it references volatile data (PBUF_NEEDS_COPY) or
+ * if the backend reports that the DMA cannot access one of its segments.
+ * The copy is a PBUF_RAM pbuf unless the backend allocates it (e.g. if the
+ * heap is located in memory the DMA cannot read).
+ *
+ * The hardware specific parts (descriptor layout, ownership bits, kicking
+ * the DMA) are provided by a struct txring_ops backend.
+ */
+
+/*
+ * Copyright (c) 2026 The lwIP developers
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "netif/txring.h"
+#include "lwip/sys.h"
+#include "lwip/def.h"
+#include "lwip/debug.h"
+
+#include <string.h>
+
+/**
+ * @ingroup txring
+ * Initialize a TX descriptor ring.
+ *
+ * @param ring the ring to initialize
+ * @param ops the backend driving the descriptors
+ * @param state backend state (stored in ring->state)
+ * @param pbufs array of 'count' pbuf pointers used for bookkeeping
+ * @param count number of descriptors
+ */
+void
+txring_init(struct txring *ring, const struct txring_ops *ops, void *state,
+            struct pbuf **pbufs, u16_t count)
+{
+  LWIP_ASSERT("txring_init: invalid ring", ring != NULL);
+  LWIP_ASSERT("txring_init: invalid ops", (ops != NULL) && (ops->desc_fill != NULL) &&
+              (ops->start != NULL) && (ops->desc_done != NULL));
+  LWIP_ASSERT("txring_init: invalid pbufs", (pbufs != NULL) && (count > 0));
+
+  memset(ring, 0, sizeof(struct txring));
+  memset(pbufs, 0, count * sizeof(struct pbuf *));
+  ring->ops = ops;
+  ring->state = state;
+  ring->pbufs = pbufs;
+  ring->count = count;
+}
+
+/** Check if a frame can be sent in place. Returns the number of segments
+ * (non-empty pbufs) or 0 if it has to be copied. */
+static u16_t
+txring_num_segments(struct txring *ring, struct pbuf *p)
+{
+  struct pbuf *q;
+  u16_t segs = 0;
+  u16_t skip = ETH_PAD_SIZE;
+
+  for (q = p; q != NULL; q = q->next) {
+    u16_t len = (u16_t)(q->len - skip);
+    if (PBUF_NEEDS_COPY(q)) {
+      return 0;
+    }
+    if (len != 0) {
+      if ((ring->ops->dma_ok != NULL) &&
+          !ring->ops->dma_ok(ring, (const u8_t *)q->payload + skip, len)) {
+        return 0;
+      }
+      segs++;
+    }
+    skip = 0;
+  }
+  if (segs > ring->count) {
+    return 0;
+  }
+  return segs;
+}
+
+/** Copy a frame into a single pbuf the DMA can read */
+static struct pbuf *
+txring_linearize(struct txring *ring, struct pbuf *p)
+{
+  struct pbuf *frame;
+
+  if (ring->ops->alloc == NULL) {
+    return pbuf_clone(PBUF_RAW, PBUF_RAM, p);
+  }
+  frame = ring->ops->alloc(ring, (u16_t)p->tot_len);
+  if (frame != NULL) {
+    LWIP_ASSERT("txring_linearize: backend must return one pbuf of the requested size",
+                (frame->next == NULL) && (frame->len == p->tot_len));
+    if (pbuf_copy(frame, p) != ERR_OK) {
+      pbuf_free(frame);
+      frame = NULL;
+    }
+  }
+  return frame;
+}
+
+/**
+ * @ingroup txring
+ * Queue a frame for transmission without copying it.
+ * Suitable to be called from netif->linkoutput. Never blocks.
+ *
+ * @param ring the ring to queue the frame on
+ * @param p the frame (including ETH_PAD_SIZE padding)
+ * @return ERR_OK if the frame was queued,
+ *         ERR_MEM if the ring is full or a copy could not be allocated
+ */
+err_t
+txring_output(struct txring *ring, struct pbuf *p)
+{
+  struct pbuf *q, *frame;
+  u16_t segs, first, idx, frame_len;
+  u16_t skip = ETH_PAD_SIZE;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ASSERT("txring_output: invalid ring", ring != NULL);
+  LWIP_ASSERT("txring_output: invalid pbuf", (p != NULL) && (p->tot_len > ETH_PAD_SIZE));
+
+  segs = txring_num_segments(ring, p);
+  if (txring_num_free(ring) < LWIP_MAX(segs, 1)) {
+    /* don't wait for the DMA: let the caller retry later */
+    ring->stats.ring_full++;
+    return ERR_MEM;
+  }
+
+  if (segs == 0) {
+    frame = txring_linearize(ring, p);
+    if (frame == NULL) {
+      LWIP_DEBUGF(NETIF_DEBUG | LWIP_DBG_LEVEL_WARNING, ("txring_output: could not linearize frame\n"));
+      return ERR_MEM;
+    }
+    ring->stats.linearized++;
+    segs = 1;
+  } else {
+    frame = p;
+    pbuf_ref(frame);
+  }
+  frame_len = (u16_t)(frame->tot_len - ETH_PAD_SIZE);
+
+  first = idx = ring->head;
+  for (q = frame; q != NULL; q = q->next) {
+    u8_t flags = 0;
+    u16_t len = (u16_t)(q->len - skip);
+    if (len == 0) {
+      skip = 0;
+      continue;
+    }
+    if (idx == first) {
+      flags |= TXRING_FIRST;
+    }
+    if (((u32_t)q->tot_len - skip) == len) {
+      flags |= TXRING_LAST;
+    }
+    ring->ops->desc_fill(ring, idx, (const u8_t *)q->payload + skip, len, frame_len, flags);
+    skip = 0;
+    if (flags & TXRING_LAST) {
+      /* the frame is released when its last descriptor completes */
+      ring->pbufs[idx] = frame;
+    }
+    idx = (u16_t)((idx + 1) % ring->count);
+  }
+  ring->head = idx;
+  ring->stats.frames++;
+  ring->stats.segments += segs;
+  ring->ops->start(ring, first, segs);
+
+  /* only now txring_reclaim() may look at the new descriptors: before
+   * start(), desc_done() may report filled descriptors as done */
+  SYS_ARCH_PROTECT(old_level);
+  ring->used = (u16_t)(ring->used + segs);
+  SYS_ARCH_UNPROTECT(old_level);
+  return ERR_OK;
+}
+
+/**
+ * @ingroup txring
+ * Release the frames of all descriptors the DMA has completed.
+ * Call this from thread context (it frees pbufs), e.g. when a TX complete
+ * interrupt has been signalled. It may run concurrently with
+ * txring_output(), but not with itself. Frames queued while it runs are
+ * released by the next call.
+ *
+ * @param ring the ring to reclaim descriptors from
+ * @return the number of frames released
+ */
+u16_t
+txring_reclaim(struct txring *ring)
+{
+  u16_t frames = 0;
+  SYS_ARCH_DECL_PROTECT(old_level);
+
+  LWIP_ASSERT("txring_reclaim: invalid ring", ring != NULL);
+
+  while ((ring->used > 0) && ring->ops->desc_done(ring, ring->tail)) {
+    struct pbuf *p = ring->pbufs[ring->tail];
+    ring->pbufs[ring->tail] = NULL;
+    ring->tail = (u16_t)((ring->tail + 1) % ring->count);
+    SYS_ARCH_PROTECT(old_level);
+    ring->used--;
+    SYS_ARCH_UNPROTECT(old_level);
+    if (p != NULL) {
+      pbuf_free(p);
+      frames++;
+    }
+  }
+  return frames;
+}
@@ -32,8 +32,11 @@
 TESTDIR=$(LWIPDIR)/../test/unit
 TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/api/test_sockets.c \
+	$(TESTDIR)/api/test_tcpip.c \
 	$(TESTDIR)/arch/sys_arch.c \
+	$(TESTDIR)/core/test_bpf.c \
 	$(TESTDIR)/core/test_def.c \
+	$(TESTDIR)/core/test_flowhash.c \
 	$(TESTDIR)/core/test_mem.c \
 	$(TESTDIR)/core/test_netif.c \
 	$(TESTDIR)/core/test_pbuf.c \
@@ -44,6 +47,10 @@ TESTFILES=$(TESTDIR)/lwip_unittests.c \
 	$(TESTDIR)/ip6/test_ip6.c \
 	$(TESTDIR)/mdns/test_mdns.c \
 	$(TESTDIR)/mqtt/test_mqtt.c \
+	$(TESTDIR)/netif/sim_mac.c \
+	$(TESTDIR)/netif/test_rxpoll.c \
+	$(TESTDIR)/netif/test_rxring.c \
+	$(TESTDIR)/netif/test_txring.c \
 	$(TESTDIR)/tcp/tcp_helper.c \
 	$(TESTDIR)/tcp/test_tcp_oos.c \
 	$(TESTDIR)/tcp/test_tcp.c \
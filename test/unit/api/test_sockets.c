@@ -9,6 +9,7 @@
 #include "lwip/tcpip.h"
 #include "lwip/priv/tcp_priv.h"
 #include "lwip/api.h"
+#include "lwip/priv/api_msg.h"
 
 
 static int
@@ -544,6 +545,91 @@ static void test_sockets_msgapi_udp(int domain)
   fail_unless(ret == 0);
 }
 
+static void test_sockets_msgapi_mmsg(int domain)
+{
+  int s, ret;
+  unsigned int i, expected;
+  struct sockaddr_storage addr_storage;
+  socklen_t addr_size;
+  struct iovec siovs[10];
+  struct mmsghdr smsgs[10];
+  struct iovec riovs[10];
+  struct mmsghdr rmsgs[10];
+  u8_t snd_buf[10][10];
+  u8_t rcv_buf[10][10];
+
+  test_sockets_init_loopback_addr(domain, &addr_storage, &addr_size);
+
+  s = test_sockets_alloc_socket_nonblocking(domain, SOCK_DGRAM);
+  fail_unless(s >= 0);
+
+  ret = lwip_bind(s, (struct sockaddr*)&addr_storage, addr_size);
+  fail_unless(ret == 0);
+  ret = lwip_getsockname(s, (struct sockaddr*)&addr_storage, &addr_size);
+  fail_unless(ret == 0);
+
+  /* datagram i is i+1 bytes of value i, sent to self (more than one batch) */
+  memset(smsgs, 0, sizeof(smsgs));
+  memset(rmsgs, 0, sizeof(rmsgs));
+  for (i = 0; i < 10; i++) {
+    memset(snd_buf[i], (int)i, sizeof(snd_buf[i]));
+    siovs[i].iov_base = snd_buf[i];
+    siovs[i].iov_len = i + 1;
+    smsgs[i].msg_hdr.msg_iov = &siovs[i];
+    smsgs[i].msg_hdr.msg_iovlen = 1;
+    smsgs[i].msg_hdr.msg_name = &addr_storage;
+    smsgs[i].msg_hdr.msg_namelen = addr_size;
+    riovs[i].iov_base = rcv_buf[i];
+    riovs[i].iov_len = sizeof(rcv_buf[i]);
+    rmsgs[i].msg_hdr.msg_iov = &riovs[i];
+    rmsgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  ret = lwip_sendmmsg(s, smsgs, 10, 0);
+  fail_unless(ret == 10);
+  for (i = 0; i < 10; i++) {
+    fail_unless(smsgs[i].msg_len == i + 1);
+  }
+
+  while (tcpip_thread_poll_one());
+
+  /* the receive mbox only holds as many datagrams as there are netbufs */
+  expected = LWIP_MIN(10, MEMP_NUM_NETBUF);
+  ret = lwip_recvmmsg(s, rmsgs, 10, MSG_WAITFORONE, NULL);
+  fail_unless(ret == (int)expected);
+  for (i = 0; i < expected; i++) {
+    fail_unless(rmsgs[i].msg_len == i + 1);
+    fail_unless(rcv_buf[i][0] == i);
+    fail_unless(rcv_buf[i][i] == i);
+  }
+
+  /* nothing left */
+  ret = lwip_recvmmsg(s, rmsgs, 10, MSG_DONTWAIT, NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+
+  /* an invalid first message fails the whole call */
+  smsgs[0].msg_hdr.msg_iovlen = 0;
+  ret = lwip_sendmmsg(s, smsgs, 10, 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == EMSGSIZE);
+
+  /* an invalid message ends the call after the ones before it */
+  smsgs[0].msg_hdr.msg_iovlen = 1;
+  smsgs[1].msg_hdr.msg_iovlen = 0;
+  ret = lwip_sendmmsg(s, smsgs, 10, 0);
+  fail_unless(ret == 1);
+
+  while (tcpip_thread_poll_one());
+
+  ret = lwip_recvmmsg(s, rmsgs, 10, MSG_DONTWAIT, NULL);
+  fail_unless(ret == 1);
+  fail_unless(rmsgs[0].msg_len == 1);
+
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+}
+
 #if LWIP_IPV4
 static void test_sockets_msgapi_cmsg(int domain)
 {
@@ -639,11 +725,13 @@ START_TEST(test_sockets_msgapis)
   LWIP_UNUSED_ARG(_i);
 #if LWIP_IPV4
   test_sockets_msgapi_udp(AF_INET);
+  test_sockets_msgapi_mmsg(AF_INET);
   test_sockets_msgapi_tcp(AF_INET);
   test_sockets_msgapi_cmsg(AF_INET);
 #endif
 #if LWIP_IPV6
   test_sockets_msgapi_udp(AF_INET6);
+  test_sockets_msgapi_mmsg(AF_INET6);
   test_sockets_msgapi_tcp(AF_INET6);
 #endif
 }
@@ -685,6 +773,405 @@ START_TEST(test_sockets_select)
 }
 END_TEST
 
+#if LWIP_SOCKET_EPOLL
+static int
+test_sockets_epoll_wait_one(int ep, int expected_fd, u32_t expected_events)
+{
+  struct epoll_event ev[2];
+  int ret = lwip_epoll_wait(ep, ev, 2, 0);
+  if (ret == 1) {
+    fail_unless(ev[0].data.fd == expected_fd);
+    fail_unless(ev[0].events == expected_events);
+  }
+  return ret;
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
+START_TEST(test_sockets_epoll)
+{
+#if LWIP_SOCKET_EPOLL && LWIP_IPV4
+  int s, s2, s3, ep, ret;
+  int one = 1;
+  struct sockaddr_in addr;
+  socklen_t addrlen;
+  struct epoll_event ev;
+  char buf[8];
+  LWIP_UNUSED_ARG(_i);
+
+  ep = lwip_epoll_create(1);
+  fail_unless(ep >= 0);
+
+  s = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s >= 0);
+  ret = lwip_listen(s, 0);
+  fail_unless(ret == 0);
+  addrlen = sizeof(addr);
+  ret = lwip_getsockname(s, (struct sockaddr *)&addr, &addrlen);
+  fail_unless(ret == 0);
+  addr.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+
+  /* level triggered listener */
+  ev.events = EPOLLIN;
+  ev.data.fd = s;
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s, &ev);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s, &ev);
+  fail_unless(ret == -1);
+  fail_unless(errno == EEXIST);
+  fail_unless(test_sockets_epoll_wait_one(ep, s, 0) == 0);
+
+  s2 = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s2 >= 0);
+  /* no nagle: each write below must arrive at once */
+  ret = lwip_setsockopt(s2, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fail_unless(ret == 0);
+  ret = lwip_connect(s2, (struct sockaddr *)&addr, addrlen);
+  fail_unless(ret == -1);
+  fail_unless(errno == EINPROGRESS);
+  while (tcpip_thread_poll_one());
+
+  /* pending connection: reported until accepted */
+  fail_unless(test_sockets_epoll_wait_one(ep, s, EPOLLIN) == 1);
+  fail_unless(test_sockets_epoll_wait_one(ep, s, EPOLLIN) == 1);
+  s3 = lwip_accept(s, NULL, NULL);
+  fail_unless(s3 >= 0);
+  fail_unless(test_sockets_epoll_wait_one(ep, s, 0) == 0);
+
+  /* a writable socket is reported at once */
+  ev.events = EPOLLOUT;
+  ev.data.fd = s2;
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s2, &ev);
+  fail_unless(ret == 0);
+  fail_unless(test_sockets_epoll_wait_one(ep, s2, EPOLLOUT) == 1);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_DEL, s2, NULL);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_DEL, s2, NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == ENOENT);
+  fail_unless(test_sockets_epoll_wait_one(ep, s2, 0) == 0);
+
+  /* edge triggered: reported once per arrival, even if not read */
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.fd = s3;
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_ADD, s3, &ev);
+  fail_unless(ret == 0);
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, 0) == 0);
+  ret = lwip_write(s2, "test", 4);
+  fail_unless(ret == 4);
+  while (tcpip_thread_poll_one());
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, EPOLLIN) == 1);
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, 0) == 0);
+  ret = lwip_write(s2, "more", 4);
+  fail_unless(ret == 4);
+  while (tcpip_thread_poll_one());
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, EPOLLIN) == 1);
+  ret = lwip_read(s3, buf, sizeof(buf));
+  fail_unless(ret == 8);
+
+  /* one-shot: disabled after one report until re-armed */
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s3, &ev);
+  fail_unless(ret == 0);
+  ret = lwip_write(s2, "test", 4);
+  fail_unless(ret == 4);
+  while (tcpip_thread_poll_one());
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, EPOLLIN) == 1);
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, 0) == 0);
+  ret = lwip_epoll_ctl(ep, EPOLL_CTL_MOD, s3, &ev);
+  fail_unless(ret == 0);
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, EPOLLIN) == 1);
+
+  /* closing a socket removes its registrations */
+  ret = lwip_close(s3);
+  fail_unless(ret == 0);
+  fail_unless(test_sockets_epoll_wait_one(ep, s3, 0) == 0);
+  ret = lwip_close(s2);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+
+  /* closing the instance frees the remaining ones */
+  ret = lwip_close(ep);
+  fail_unless(ret == 0);
+  ret = lwip_epoll_wait(ep, &ev, 1, 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == EBADF);
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif
+}
+END_TEST
+
+START_TEST(test_sockets_recv_pbuf)
+{
+#if LWIP_SOCKET_PBUF_LOAN && LWIP_IPV4
+  int s, s2, s3, u, ret;
+  struct sockaddr_in addr, from;
+  socklen_t addrlen, fromlen;
+  struct pbuf *p, *p2;
+  struct tcp_pcb *pcb;
+  tcpwnd_size_t wnd;
+  char buf[4];
+  LWIP_UNUSED_ARG(_i);
+
+  s = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s >= 0);
+  ret = lwip_listen(s, 0);
+  fail_unless(ret == 0);
+  addrlen = sizeof(addr);
+  ret = lwip_getsockname(s, (struct sockaddr *)&addr, &addrlen);
+  fail_unless(ret == 0);
+  addr.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+  s2 = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_STREAM);
+  fail_unless(s2 >= 0);
+  ret = lwip_connect(s2, (struct sockaddr *)&addr, addrlen);
+  fail_unless(ret == -1);
+  fail_unless(errno == EINPROGRESS);
+  while (tcpip_thread_poll_one());
+  s3 = lwip_accept(s, NULL, NULL);
+  fail_unless(s3 >= 0);
+  pcb = lwip_socket_dbg_get_socket(s3)->conn->pcb.tcp;
+  wnd = pcb->rcv_wnd;
+
+  p = NULL;
+  ret = lwip_recvfrom_pbuf(s3, &p, MSG_DONTWAIT, NULL, NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+  fail_unless(p == NULL);
+  ret = lwip_recvfrom_pbuf(s3, &p, MSG_PEEK, NULL, NULL);
+  fail_unless(ret == -1);
+  fail_unless(errno == EOPNOTSUPP);
+
+  ret = lwip_write(s2, "testdata", 8);
+  fail_unless(ret == 8);
+  while (tcpip_thread_poll_one());
+  fail_unless(pcb->rcv_wnd == wnd - 8);
+
+  /* part of the data is copied, the rest is lent */
+  ret = lwip_recv(s3, buf, sizeof(buf), 0);
+  fail_unless(ret == 4);
+  fail_unless(!memcmp(buf, "test", 4));
+  fail_unless(pcb->rcv_wnd == wnd - 4);
+  fromlen = sizeof(from);
+  ret = lwip_recvfrom_pbuf(s3, &p, 0, (struct sockaddr *)&from, &fromlen);
+  fail_unless(ret == 4);
+  fail_unless(p != NULL);
+  fail_unless(p->tot_len == 4);
+  fail_unless(pbuf_memcmp(p, 0, "data", 4) == 0);
+  fail_unless(from.sin_addr.s_addr == PP_HTONL(INADDR_LOOPBACK));
+  /* window stays closed while the pbuf is lent out */
+  fail_unless(pcb->rcv_wnd == wnd - 4);
+  ret = lwip_recv_pbuf_free(s3, p);
+  fail_unless(ret == 0);
+  fail_unless(pcb->rcv_wnd == wnd);
+
+  /* end of stream */
+  ret = lwip_close(s2);
+  fail_unless(ret == 0);
+  while (tcpip_thread_poll_one());
+  ret = lwip_recvfrom_pbuf(s3, &p, 0, NULL, NULL);
+  fail_unless(ret == 0);
+  fail_unless(p == NULL);
+  ret = lwip_close(s3);
+  fail_unless(ret == 0);
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+
+  /* UDP: one datagram per pbuf, with its sender */
+  u = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_DGRAM);
+  fail_unless(u >= 0);
+  addr.sin_port = 0;
+  ret = lwip_bind(u, (struct sockaddr *)&addr, sizeof(addr));
+  fail_unless(ret == 0);
+  addrlen = sizeof(addr);
+  ret = lwip_getsockname(u, (struct sockaddr *)&addr, &addrlen);
+  fail_unless(ret == 0);
+  ret = lwip_sendto(u, "one", 3, 0, (struct sockaddr *)&addr, addrlen);
+  fail_unless(ret == 3);
+  ret = lwip_sendto(u, "two!", 4, 0, (struct sockaddr *)&addr, addrlen);
+  fail_unless(ret == 4);
+  while (tcpip_thread_poll_one());
+  fromlen = sizeof(from);
+  ret = lwip_recvfrom_pbuf(u, &p, 0, (struct sockaddr *)&from, &fromlen);
+  fail_unless(ret == 3);
+  fail_unless(pbuf_memcmp(p, 0, "one", 3) == 0);
+  fail_unless(from.sin_port == addr.sin_port);
+  ret = lwip_recvfrom_pbuf(u, &p2, 0, NULL, NULL);
+  fail_unless(ret == 4);
+  fail_unless(pbuf_memcmp(p2, 0, "two!", 4) == 0);
+  /* returning after close still frees the pbuf */
+  ret = lwip_recv_pbuf_free(u, p);
+  fail_unless(ret == 0);
+  ret = lwip_close(u);
+  fail_unless(ret == 0);
+  ret = lwip_recv_pbuf_free(u, p2);
+  fail_unless(ret == -1);
+  fail_unless(errno == EBADF);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif
+}
+END_TEST
+
+START_TEST(test_sockets_recvq)
+{
+#if LWIP_NETCONN_RECVQ
+  struct netconn_recvq q;
+  void *msg;
+  u8_t items[6];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(netconn_recvq_new(&q, 4) == ERR_OK);
+  fail_unless(netconn_recvmbox_valid(&q));
+  fail_unless(netconn_recvq_fetch(&q, &msg, 0, 0) == SYS_MBOX_EMPTY);
+  /* nothing arrives while waiting */
+  fail_unless(netconn_recvq_fetch(&q, &msg, 10, 1) == SYS_ARCH_TIMEOUT);
+  fail_unless(q.waiting == 0);
+
+  /* fill up, then wrap around */
+  for (i = 0; i < 4; i++) {
+    fail_unless(netconn_recvq_trypost(&q, &items[i]) == ERR_OK);
+  }
+  fail_unless(netconn_recvq_trypost(&q, &items[4]) == ERR_MEM);
+  fail_unless(netconn_recvq_fetch(&q, &msg, 0, 0) == 0);
+  fail_unless(msg == &items[0]);
+  fail_unless(netconn_recvq_fetch(&q, &msg, 0, 1) == 0);
+  fail_unless(msg == &items[1]);
+  fail_unless(netconn_recvq_trypost(&q, &items[4]) == ERR_OK);
+  fail_unless(netconn_recvq_trypost(&q, &items[5]) == ERR_OK);
+  for (i = 2; i < 6; i++) {
+    fail_unless(netconn_recvq_fetch(&q, &msg, 0, 0) == 0);
+    fail_unless(msg == &items[i]);
+  }
+  fail_unless(netconn_recvq_fetch(&q, &msg, 0, 0) == SYS_MBOX_EMPTY);
+
+  netconn_recvq_free(&q);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif
+}
+END_TEST
+
+#if LWIP_NETCONN_ASYNC
+struct test_async_result {
+  int calls;
+  err_t err;
+  void *data;
+  size_t len;
+};
+
+static void
+test_sockets_async_cb(struct netconn *conn, err_t err, void *data, size_t len, void *arg)
+{
+  struct test_async_result *res = (struct test_async_result *)arg;
+  LWIP_UNUSED_ARG(conn);
+  res->calls++;
+  res->err = err;
+  res->data = data;
+  res->len = len;
+}
+#endif /* LWIP_NETCONN_ASYNC */
+
+START_TEST(test_sockets_netconn_async)
+{
+#if LWIP_NETCONN_ASYNC
+  struct netconn *conn;
+  struct test_async_result res;
+  struct sockaddr_in sa_listen;
+  ip_addr_t addr;
+  const u16_t port = 1235;
+  char rxbuf[8];
+  int sl, spass, ret;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&sa_listen, 0, sizeof(sa_listen));
+  sa_listen.sin_family = AF_INET;
+  sa_listen.sin_port = PP_HTONS(port);
+  sa_listen.sin_addr.s_addr = PP_HTONL(INADDR_LOOPBACK);
+  sl = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(sl >= 0);
+  fail_unless(lwip_bind(sl, (struct sockaddr *)&sa_listen, sizeof(sa_listen)) == 0);
+  fail_unless(lwip_listen(sl, 0) == 0);
+
+  conn = netconn_new(NETCONN_TCP);
+  fail_unless(conn != NULL);
+  fail_unless(netconn_write_async(conn, "x", 1, NETCONN_DONTBLOCK, test_sockets_async_cb, &res) == ERR_VAL);
+
+  /* connect: completes from tcpip_thread once the handshake is done */
+  memset(&res, 0, sizeof(res));
+  ip_addr_set_loopback(0, &addr);
+  fail_unless(netconn_connect_async(conn, &addr, port, test_sockets_async_cb, &res) == ERR_OK);
+  fail_unless(res.calls == 0);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_OK);
+  spass = lwip_accept(sl, NULL, NULL);
+  fail_unless(spass >= 0);
+
+  /* recv: stays pending until data arrives */
+  memset(&res, 0, sizeof(res));
+  fail_unless(netconn_recv_async(conn, test_sockets_async_cb, &res) == ERR_OK);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 0);
+  fail_unless(lwip_send(spass, "hello", 5, 0) == 5);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_OK);
+  fail_unless(res.len == 5);
+  fail_unless(res.data != NULL);
+  if (res.data != NULL) {
+    fail_unless(pbuf_memcmp((struct pbuf *)res.data, 0, "hello", 5) == 0);
+    pbuf_free((struct pbuf *)res.data);
+  }
+  fail_unless(conn->pcb.tcp->rcv_wnd == TCPWND_MIN16(TCP_WND_MAX(conn->pcb.tcp)));
+
+  /* write */
+  memset(&res, 0, sizeof(res));
+  fail_unless(netconn_write_async(conn, "world", 5, NETCONN_COPY, test_sockets_async_cb, &res) == ERR_OK);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_OK);
+  fail_unless(res.len == 5);
+  ret = lwip_recv(spass, rxbuf, sizeof(rxbuf), MSG_DONTWAIT);
+  fail_unless(ret == 5);
+  fail_unless(memcmp(rxbuf, "world", 5) == 0);
+
+  /* a pending recv sees the FIN */
+  memset(&res, 0, sizeof(res));
+  fail_unless(netconn_recv_async(conn, test_sockets_async_cb, &res) == ERR_OK);
+  fail_unless(lwip_close(spass) == 0);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_CLSD);
+  fail_unless(res.data == NULL);
+
+  memset(&res, 0, sizeof(res));
+  fail_unless(netconn_close_async(conn, test_sockets_async_cb, &res) == ERR_OK);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_OK);
+  fail_unless(netconn_delete(conn) == ERR_OK);
+
+  /* deleting a netconn completes its pending recv */
+  conn = netconn_new(NETCONN_UDP);
+  fail_unless(conn != NULL);
+  memset(&res, 0, sizeof(res));
+  fail_unless(netconn_recv_async(conn, test_sockets_async_cb, &res) == ERR_OK);
+  while (tcpip_thread_poll_one());
+  fail_unless(res.calls == 0);
+  fail_unless(netconn_delete(conn) == ERR_OK);
+  fail_unless(res.calls == 1);
+  fail_unless(res.err == ERR_CLSD);
+
+  fail_unless(lwip_close(sl) == 0);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif
+}
+END_TEST
+
 START_TEST(test_sockets_recv_after_rst)
 {
   int sl, sact;
@@ -828,6 +1315,78 @@ cleanup:
 }
 END_TEST
 
+#if LWIP_SO_ATTACH_FILTER && LWIP_IPV4
+/* a socket filter drops datagrams before they are queued to the socket */
+START_TEST(test_sockets_filter)
+{
+  /* accept datagrams whose first payload byte is 0xDE */
+  struct sock_filter code[] = {
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 8),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xDE, 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, 0xffff),
+    BPF_STMT(BPF_RET | BPF_K, 0)
+  };
+  struct sock_fprog fprog;
+  struct sockaddr_storage addr_storage;
+  socklen_t addr_size;
+  u8_t pass_buf[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+  u8_t drop_buf[4] = {0x00, 0xAD, 0xBE, 0xEF};
+  u8_t rcv_buf[4];
+  int s, st, ret, one = 1;
+  LWIP_UNUSED_ARG(_i);
+
+  fprog.len = LWIP_ARRAYSIZE(code);
+  fprog.filter = code;
+
+  /* TCP sockets have no filters */
+  st = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  fail_unless(st >= 0);
+  ret = lwip_setsockopt(st, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+  fail_unless(ret == -1);
+  fail_unless(errno == ENOPROTOOPT);
+  ret = lwip_close(st);
+  fail_unless(ret == 0);
+
+  test_sockets_init_loopback_addr(AF_INET, &addr_storage, &addr_size);
+  s = test_sockets_alloc_socket_nonblocking(AF_INET, SOCK_DGRAM);
+  fail_unless(s >= 0);
+  ret = lwip_bind(s, (struct sockaddr*)&addr_storage, addr_size);
+  fail_unless(ret == 0);
+  ret = lwip_getsockname(s, (struct sockaddr*)&addr_storage, &addr_size);
+  fail_unless(ret == 0);
+  ret = lwip_setsockopt(s, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+  fail_unless(ret == 0);
+
+  ret = lwip_sendto(s, drop_buf, sizeof(drop_buf), 0, (struct sockaddr*)&addr_storage, addr_size);
+  fail_unless(ret == sizeof(drop_buf));
+  ret = lwip_sendto(s, pass_buf, sizeof(pass_buf), 0, (struct sockaddr*)&addr_storage, addr_size);
+  fail_unless(ret == sizeof(pass_buf));
+  tcpip_thread_poll_one();
+  tcpip_thread_poll_one();
+
+  ret = lwip_recv(s, rcv_buf, sizeof(rcv_buf), 0);
+  fail_unless(ret == sizeof(rcv_buf));
+  fail_unless(!memcmp(rcv_buf, pass_buf, sizeof(rcv_buf)));
+  ret = lwip_recv(s, rcv_buf, sizeof(rcv_buf), 0);
+  fail_unless(ret == -1);
+  fail_unless(errno == EWOULDBLOCK);
+
+  /* detached: everything is received again */
+  ret = lwip_setsockopt(s, SOL_SOCKET, SO_DETACH_FILTER, &one, sizeof(one));
+  fail_unless(ret == 0);
+  ret = lwip_sendto(s, drop_buf, sizeof(drop_buf), 0, (struct sockaddr*)&addr_storage, addr_size);
+  fail_unless(ret == sizeof(drop_buf));
+  tcpip_thread_poll_one();
+  ret = lwip_recv(s, rcv_buf, sizeof(rcv_buf), 0);
+  fail_unless(ret == sizeof(rcv_buf));
+  fail_unless(!memcmp(rcv_buf, drop_buf, sizeof(rcv_buf)));
+
+  ret = lwip_close(s);
+  fail_unless(ret == 0);
+}
+END_TEST
+#endif /* LWIP_SO_ATTACH_FILTER && LWIP_IPV4 */
+
 /** Create the suite including all tests for this module */
 Suite *
 sockets_suite(void)
@@ -837,7 +1396,14 @@ sockets_suite(void)
     TESTFUNC(test_sockets_allfunctions_basic),
     TESTFUNC(test_sockets_msgapis),
     TESTFUNC(test_sockets_select),
+    TESTFUNC(test_sockets_epoll),
+    TESTFUNC(test_sockets_recv_pbuf),
+    TESTFUNC(test_sockets_recvq),
+    TESTFUNC(test_sockets_netconn_async),
     TESTFUNC(test_sockets_recv_after_rst),
+#if LWIP_SO_ATTACH_FILTER && LWIP_IPV4
+    TESTFUNC(test_sockets_filter),
+#endif /* LWIP_SO_ATTACH_FILTER && LWIP_IPV4 */
   };
   return create_suite("SOCKETS", tests, sizeof(tests)/sizeof(testfunc), sockets_setup, sockets_teardown);
 }
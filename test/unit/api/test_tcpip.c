@@ -0,0 +1,222 @@
+#include "test_tcpip.h"
+
+#include "lwip/tcpip.h"
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#define TEST_BATCH_LEN 8
+
+static struct netif test_netif;
+static u8_t seen[TEST_BATCH_LEN];
+static int num_seen;
+static int unlinked;
+
+/* Setups/teardown functions */
+
+static void
+tcpip_setup(void)
+{
+  memset(&test_netif, 0, sizeof(test_netif));
+  memset(seen, 0, sizeof(seen));
+  num_seen = 0;
+  unlinked = 1;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+tcpip_teardown(void)
+{
+  while (tcpip_thread_poll_one());
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* input function accepting every packet, payload is a sequence number */
+static err_t
+test_input_accept(struct pbuf *p, struct netif *inp)
+{
+  fail_unless(inp == &test_netif);
+  if (p->batch != NULL) {
+    unlinked = 0;
+  }
+  if (num_seen < TEST_BATCH_LEN) {
+    seen[num_seen] = *(u8_t *)p->payload;
+  }
+  num_seen++;
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/* input function rejecting odd sequence numbers (the caller must free them) */
+static err_t
+test_input_reject_odd(struct pbuf *p, struct netif *inp)
+{
+  u8_t seq = *(u8_t *)p->payload;
+  LWIP_UNUSED_ARG(inp);
+  num_seen++;
+  if (seq & 1) {
+    return ERR_VAL;
+  }
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static struct pbuf *
+test_alloc_batch(int num)
+{
+  struct pbuf *head = NULL;
+  int i;
+
+  for (i = num - 1; i >= 0; i--) {
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, 64, PBUF_POOL);
+    fail_unless(p != NULL);
+    fail_unless(p->batch == NULL);
+    *(u8_t *)p->payload = (u8_t)i;
+    p->batch = head;
+    head = p;
+  }
+  return head;
+}
+
+/* Test functions */
+
+/** A whole list of packets is delivered with one message and in order */
+START_TEST(test_tcpip_input_batch_one_msg)
+{
+  struct pbuf *list = test_alloc_batch(TEST_BATCH_LEN);
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(tcpip_inpkt_batch(list, &test_netif, test_input_accept) == ERR_OK);
+#if MEMP_STATS
+  fail_unless(lwip_stats.memp[MEMP_TCPIP_MSG_INPKT]->used == 1);
+#endif
+  fail_unless(num_seen == 0);
+
+  fail_unless(tcpip_thread_poll_one() == 1);
+  fail_unless(num_seen == TEST_BATCH_LEN);
+  fail_unless(unlinked);
+  for (i = 0; i < TEST_BATCH_LEN; i++) {
+    fail_unless(seen[i] == i);
+  }
+  /* nothing else was queued */
+  fail_unless(tcpip_thread_poll_one() == 0);
+}
+END_TEST
+
+/** Packets rejected by the input function are freed by the stack */
+START_TEST(test_tcpip_input_batch_rejected)
+{
+  struct pbuf *list = test_alloc_batch(TEST_BATCH_LEN);
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(tcpip_inpkt_batch(list, &test_netif, test_input_reject_odd) == ERR_OK);
+  fail_unless(tcpip_thread_poll_one() == 1);
+  fail_unless(num_seen == TEST_BATCH_LEN);
+  /* teardown checks that the odd packets did not leak */
+}
+END_TEST
+
+/** On failure the caller keeps the whole list */
+START_TEST(test_tcpip_input_batch_no_msg)
+{
+  struct pbuf *list = test_alloc_batch(TEST_BATCH_LEN);
+  void *msgs[MEMP_NUM_TCPIP_MSG_INPKT];
+  struct pbuf *p;
+  int i, num = 0;
+  LWIP_UNUSED_ARG(_i);
+
+  /* exhaust the message pool */
+  for (i = 0; i < MEMP_NUM_TCPIP_MSG_INPKT; i++) {
+    msgs[i] = memp_malloc(MEMP_TCPIP_MSG_INPKT);
+    fail_unless(msgs[i] != NULL);
+  }
+  fail_unless(tcpip_inpkt_batch(list, &test_netif, test_input_accept) == ERR_MEM);
+  for (i = 0; i < MEMP_NUM_TCPIP_MSG_INPKT; i++) {
+    memp_free(MEMP_TCPIP_MSG_INPKT, msgs[i]);
+  }
+  fail_unless(tcpip_thread_poll_one() == 0);
+
+  for (p = list; p != NULL; p = p->batch) {
+    fail_unless(p->ref == 1);
+    num++;
+  }
+  fail_unless(num == TEST_BATCH_LEN);
+  while (list != NULL) {
+    p = list;
+    list = list->batch;
+    pbuf_free(p);
+  }
+}
+END_TEST
+
+/** Adaptive core lock: counters, spinning, blocking and the hold histogram
+ * (contention is simulated by failing sys_mutex_trylock() calls) */
+START_TEST(test_tcpip_core_lock_spin)
+{
+#if LWIP_TCPIP_CORE_LOCK_SPIN && CORELOCK_STATS
+  struct stats_corelock *cl = &lwip_stats.corelock;
+#endif
+  LWIP_UNUSED_ARG(_i);
+
+#if LWIP_TCPIP_CORE_LOCK_SPIN && CORELOCK_STATS
+  memset(cl, 0, sizeof(struct stats_corelock));
+  lwip_sys_mutex_trylock_busy = 0;
+
+  /* uncontended, held for 5 clock ticks (bucket 3: 4..7) */
+  lwip_sys_now = 1000;
+  LOCK_TCPIP_CORE();
+  lwip_sys_now += 5;
+  UNLOCK_TCPIP_CORE();
+  fail_unless(lock_tcpip_core == 1);
+  fail_unless(cl->acquired == 1);
+  fail_unless(cl->contended == 0);
+  fail_unless(cl->hold[3] == 1);
+  fail_unless(cl->hold_max == 5);
+
+  /* released after a few polls: acquired while spinning */
+  lwip_sys_mutex_trylock_busy = 3;
+  LOCK_TCPIP_CORE();
+  UNLOCK_TCPIP_CORE();
+  fail_unless(lwip_sys_mutex_trylock_busy == 0);
+  fail_unless(cl->acquired == 2);
+  fail_unless(cl->contended == 1);
+  fail_unless(cl->spun == 1);
+  fail_unless(cl->blocked == 0);
+  fail_unless(cl->hold[0] == 1);
+
+  /* held too long: the waiter gives up spinning and blocks */
+  lwip_sys_mutex_trylock_busy = 1000;
+  LOCK_TCPIP_CORE();
+  UNLOCK_TCPIP_CORE();
+  fail_unless(lwip_sys_mutex_trylock_busy >= 1000 - 1 - LWIP_TCPIP_CORE_LOCK_SPIN_MAX);
+  fail_unless(cl->contended == 2);
+  fail_unless(cl->spun == 1);
+  fail_unless(cl->blocked == 1);
+  lwip_sys_mutex_trylock_busy = 0;
+
+  /* very long holds end up in the last bucket */
+  lwip_sys_now = 0;
+  LOCK_TCPIP_CORE();
+  lwip_sys_now = 0xFFFFFFFFUL;
+  UNLOCK_TCPIP_CORE();
+  fail_unless(cl->hold[STATS_CORELOCK_HOLD_BUCKETS - 1] == 1);
+  fail_unless(cl->hold_max == 0xFFFFFFFFUL);
+  fail_unless(cl->acquired == 4);
+  lwip_sys_now = 0;
+#endif /* LWIP_TCPIP_CORE_LOCK_SPIN && CORELOCK_STATS */
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+tcpip_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcpip_input_batch_one_msg),
+    TESTFUNC(test_tcpip_input_batch_rejected),
+    TESTFUNC(test_tcpip_input_batch_no_msg),
+    TESTFUNC(test_tcpip_core_lock_spin)
+  };
+  return create_suite("TCPIP", tests, sizeof(tests)/sizeof(testfunc), tcpip_setup, tcpip_teardown);
+}
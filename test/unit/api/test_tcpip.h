@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TCPIP_H
+#define LWIP_HDR_TEST_TCPIP_H
+
+#include "../lwip_check.h"
+
+Suite *tcpip_suite(void);
+
+#endif
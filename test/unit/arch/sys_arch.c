@@ -181,6 +181,20 @@ sys_mutex_lock(sys_mutex_t *mutex)
   LWIP_ASSERT("*mutex >= 1", *mutex >= 1);
 }
 
+int lwip_sys_mutex_trylock_busy;
+
+err_t
+sys_mutex_trylock(sys_mutex_t *mutex)
+{
+  LWIP_ASSERT("mutex != NULL", mutex != NULL);
+  if (lwip_sys_mutex_trylock_busy > 0) {
+    lwip_sys_mutex_trylock_busy--;
+    return ERR_WOULDBLOCK;
+  }
+  sys_mutex_lock(mutex);
+  return ERR_OK;
+}
+
 void
 sys_mutex_unlock(sys_mutex_t *mutex)
 {
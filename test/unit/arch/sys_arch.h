@@ -68,5 +68,9 @@ void test_sys_arch_wait_callback(test_sys_arch_waiting_fn waiting_fn);
 /* current time */
 extern u32_t lwip_sys_now;
 
+/* number of sys_mutex_trylock() calls that fail as if another thread held
+ * the mutex (to simulate contention) */
+extern int lwip_sys_mutex_trylock_busy;
+
 #endif /* LWIP_HDR_TEST_SYS_ARCH_H */
 
@@ -0,0 +1,16 @@
+/*
+ * Unit test configuration without the optional hash indexes and the
+ * ephemeral port bitmap, so the linear lookups are tested as well.
+ * Build with -DLWIP_TEST_CONFIG='"configs/linear_tables.h"'
+ */
+#ifndef LWIP_HDR_TEST_CONFIG_LINEAR_TABLES_H
+#define LWIP_HDR_TEST_CONFIG_LINEAR_TABLES_H
+
+#define ARP_TABLE_HASH_SIZE             0
+#define LWIP_ND6_CACHE_HASH_SIZE        0
+#define UDP_PCB_HASH_SIZE               0
+#define RAW_PCB_HASH_SIZE               0
+#define IP_REASS_HASH_SIZE              0
+#define LWIP_PORT_ALLOC_BITMAP          0
+
+#endif /* LWIP_HDR_TEST_CONFIG_LINEAR_TABLES_H */
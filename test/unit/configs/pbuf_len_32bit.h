@@ -0,0 +1,10 @@
+/*
+ * Unit test configuration with 32 bit wide pbuf length fields.
+ * Build with -DLWIP_TEST_CONFIG='"configs/pbuf_len_32bit.h"'
+ */
+#ifndef LWIP_HDR_TEST_CONFIG_PBUF_LEN_32BIT_H
+#define LWIP_HDR_TEST_CONFIG_PBUF_LEN_32BIT_H
+
+#define LWIP_PBUF_LEN_32BIT             1
+
+#endif /* LWIP_HDR_TEST_CONFIG_PBUF_LEN_32BIT_H */
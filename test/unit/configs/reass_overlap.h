@@ -0,0 +1,10 @@
+/*
+ * Unit test configuration accepting overlapping IPv4 fragments.
+ * Build with -DLWIP_TEST_CONFIG='"configs/reass_overlap.h"'
+ */
+#ifndef LWIP_HDR_TEST_CONFIG_REASS_OVERLAP_H
+#define LWIP_HDR_TEST_CONFIG_REASS_OVERLAP_H
+
+#define IP_REASS_CHECK_OVERLAP          0
+
+#endif /* LWIP_HDR_TEST_CONFIG_REASS_OVERLAP_H */
@@ -0,0 +1,10 @@
+/*
+ * Unit test configuration with the default SO_REUSE=0 bind and listen paths.
+ * Build with -DLWIP_TEST_CONFIG='"configs/so_reuse_off.h"'
+ */
+#ifndef LWIP_HDR_TEST_CONFIG_SO_REUSE_OFF_H
+#define LWIP_HDR_TEST_CONFIG_SO_REUSE_OFF_H
+
+#define SO_REUSE                        0
+
+#endif /* LWIP_HDR_TEST_CONFIG_SO_REUSE_OFF_H */
@@ -0,0 +1,188 @@
+#include "test_bpf.h"
+
+#include "lwip/bpf.h"
+#include "lwip/def.h"
+
+#if LWIP_SO_ATTACH_FILTER
+
+/* "ip and udp dst port 53" over an IPv4 packet, as generated by tcpdump -dd
+   for a raw socket (no link layer header) */
+static const struct lwip_bpf_insn udp_dns[] = {
+  BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                /* A = ip proto */
+  BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 17, 0, 6),
+  BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                /* A = frag off */
+  BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+  BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),               /* X = ip hlen */
+  BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                /* A = udp dport */
+  BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 53, 0, 1),
+  BPF_STMT(BPF_RET | BPF_K, 0xffff),
+  BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+/* a 20 byte IPv4 header followed by a UDP header to port 53 */
+static const u8_t udp_dns_pkt[] = {
+  0x45, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x40, 0x11, 0x00, 0x00,
+  0xc0, 0xa8, 0x00, 0x02, 0xc0, 0xa8, 0x00, 0x01,
+  0x10, 0x00, 0x00, 0x35, 0x00, 0x08, 0x00, 0x00
+};
+
+static struct pbuf *
+bpf_test_pbuf(const u8_t *data, u16_t len, u16_t first_len)
+{
+  struct pbuf *p, *q;
+  err_t err;
+
+  p = pbuf_alloc(PBUF_RAW, first_len, PBUF_RAM);
+  fail_unless(p != NULL);
+  if (first_len < len) {
+    q = pbuf_alloc(PBUF_RAW, (u16_t)(len - first_len), PBUF_RAM);
+    fail_unless(q != NULL);
+    pbuf_cat(p, q);
+  }
+  err = pbuf_take(p, data, len);
+  fail_unless(err == ERR_OK);
+  return p;
+}
+
+/* Setups/teardown functions */
+
+static void
+bpf_setup(void)
+{
+}
+
+static void
+bpf_teardown(void)
+{
+}
+
+/* Test functions */
+
+/* programs that could run off the end or access invalid memory are refused */
+START_TEST(test_bpf_validate)
+{
+  static const struct lwip_bpf_insn no_ret[] = {
+    BPF_STMT(BPF_LD | BPF_IMM, 1)
+  };
+  static const struct lwip_bpf_insn jump_out[] = {
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 1, 0),
+    BPF_STMT(BPF_RET | BPF_K, 0)
+  };
+  static const struct lwip_bpf_insn div_zero[] = {
+    BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, 0),
+    BPF_STMT(BPF_RET | BPF_A, 0)
+  };
+  static const struct lwip_bpf_insn bad_mem[] = {
+    BPF_STMT(BPF_ST, LWIP_BPF_MEMWORDS),
+    BPF_STMT(BPF_RET | BPF_A, 0)
+  };
+  static const struct lwip_bpf_insn bad_code[] = {
+    BPF_STMT(0xffff, 0),
+    BPF_STMT(BPF_RET | BPF_A, 0)
+  };
+  struct lwip_bpf_program *prog = NULL;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_bpf_validate(udp_dns, LWIP_ARRAYSIZE(udp_dns)));
+  fail_unless(!lwip_bpf_validate(udp_dns, 0));
+  fail_unless(!lwip_bpf_validate(no_ret, LWIP_ARRAYSIZE(no_ret)));
+  fail_unless(!lwip_bpf_validate(jump_out, LWIP_ARRAYSIZE(jump_out)));
+  fail_unless(!lwip_bpf_validate(div_zero, LWIP_ARRAYSIZE(div_zero)));
+  fail_unless(!lwip_bpf_validate(bad_mem, LWIP_ARRAYSIZE(bad_mem)));
+  fail_unless(!lwip_bpf_validate(bad_code, LWIP_ARRAYSIZE(bad_code)));
+
+  /* invalid programs are not attached, valid ones are copied */
+  fail_unless(lwip_bpf_attach(&prog, jump_out, LWIP_ARRAYSIZE(jump_out)) == ERR_VAL);
+  fail_unless(prog == NULL);
+  fail_unless(lwip_bpf_attach(&prog, udp_dns, LWIP_ARRAYSIZE(udp_dns)) == ERR_OK);
+  fail_unless(prog != NULL);
+  fail_unless(prog->len == LWIP_ARRAYSIZE(udp_dns));
+  fail_unless(prog->insns != udp_dns);
+  fail_unless(lwip_bpf_detach(&prog) == ERR_OK);
+  fail_unless(prog == NULL);
+}
+END_TEST
+
+/* loads work across pbuf boundaries and stop at the end of the packet */
+START_TEST(test_bpf_filter)
+{
+  static const struct lwip_bpf_insn sum[] = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+    BPF_STMT(BPF_ST, 3),
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 20),           /* udp ports */
+    BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+    BPF_STMT(BPF_LDX | BPF_MEM, 3),
+    BPF_STMT(BPF_ALU | BPF_ADD | BPF_X, 0),           /* sport + len */
+    BPF_STMT(BPF_RET | BPF_A, 0)
+  };
+  static const struct lwip_bpf_insn beyond[] = {
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, sizeof(udp_dns_pkt)),
+    BPF_STMT(BPF_RET | BPF_K, 1)
+  };
+  struct lwip_bpf_program *prog = NULL;
+  u8_t pkt[sizeof(udp_dns_pkt)];
+  struct pbuf *p;
+  u16_t split;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(lwip_bpf_attach(&prog, udp_dns, LWIP_ARRAYSIZE(udp_dns)) == ERR_OK);
+  for (split = 1; split <= sizeof(udp_dns_pkt); split++) {
+    p = bpf_test_pbuf(udp_dns_pkt, sizeof(udp_dns_pkt), split);
+    fail_unless(lwip_bpf_filter(prog, p) == 0xffff);
+    pbuf_free(p);
+  }
+
+  /* other port, other protocol, fragment */
+  MEMCPY(pkt, udp_dns_pkt, sizeof(pkt));
+  pkt[23] = 54;
+  p = bpf_test_pbuf(pkt, sizeof(pkt), sizeof(pkt));
+  fail_unless(lwip_bpf_filter(prog, p) == 0);
+  pbuf_free(p);
+  MEMCPY(pkt, udp_dns_pkt, sizeof(pkt));
+  pkt[9] = 6;
+  p = bpf_test_pbuf(pkt, sizeof(pkt), sizeof(pkt));
+  fail_unless(lwip_bpf_filter(prog, p) == 0);
+  pbuf_free(p);
+  MEMCPY(pkt, udp_dns_pkt, sizeof(pkt));
+  pkt[7] = 1;
+  p = bpf_test_pbuf(pkt, sizeof(pkt), sizeof(pkt));
+  fail_unless(lwip_bpf_filter(prog, p) == 0);
+  pbuf_free(p);
+
+  /* truncated: the port load fails */
+  p = bpf_test_pbuf(udp_dns_pkt, 22, 10);
+  fail_unless(lwip_bpf_filter(prog, p) == 0);
+  pbuf_free(p);
+
+  fail_unless(lwip_bpf_attach(&prog, sum, LWIP_ARRAYSIZE(sum)) == ERR_OK);
+  p = bpf_test_pbuf(udp_dns_pkt, sizeof(udp_dns_pkt), 21);
+  fail_unless(lwip_bpf_filter(prog, p) == 0x1000 + sizeof(udp_dns_pkt));
+  pbuf_free(p);
+
+  fail_unless(lwip_bpf_attach(&prog, beyond, LWIP_ARRAYSIZE(beyond)) == ERR_OK);
+  p = bpf_test_pbuf(udp_dns_pkt, sizeof(udp_dns_pkt), 8);
+  fail_unless(lwip_bpf_filter(prog, p) == 0);
+  pbuf_free(p);
+  lwip_bpf_detach(&prog);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+bpf_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_bpf_validate),
+    TESTFUNC(test_bpf_filter)
+  };
+  return create_suite("BPF", tests, sizeof(tests)/sizeof(testfunc), bpf_setup, bpf_teardown);
+}
+
+#else /* LWIP_SO_ATTACH_FILTER */
+
+Suite *
+bpf_suite(void)
+{
+  return create_suite("BPF", NULL, 0, NULL, NULL);
+}
+#endif /* LWIP_SO_ATTACH_FILTER */
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_BPF_H
+#define LWIP_HDR_TEST_BPF_H
+
+#include "../lwip_check.h"
+
+Suite *bpf_suite(void);
+
+#endif
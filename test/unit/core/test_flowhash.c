@@ -0,0 +1,123 @@
+#include "test_flowhash.h"
+
+#include "lwip/flowhash.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/tcp.h"
+
+/* IPv4 RSS verification suite (default key): src, dst, sport, dport,
+   hash over the addresses, hash over the 4-tuple */
+struct flowhash_vector {
+  const char *src;
+  const char *dst;
+  u16_t sport;
+  u16_t dport;
+  u32_t hash_ip;
+  u32_t hash_ports;
+};
+
+static const struct flowhash_vector ip4_vectors[] = {
+  { "66.9.149.187",   "161.142.100.80", 2794, 1766,  0x323e8fc2UL, 0x51ccc178UL },
+  { "199.92.111.2",   "65.69.140.83",   14230, 4739, 0xd718262aUL, 0xc626b0eaUL },
+  { "24.19.198.95",   "12.22.207.184",  12898, 38024, 0xd2d0a5deUL, 0x5c2b394aUL },
+  { "38.27.205.30",   "209.142.163.6",  48228, 2217, 0x82989176UL, 0xafc7327fUL },
+  { "153.39.163.191", "202.188.127.2",  44251, 1303, 0x5d1809c5UL, 0x10e828a2UL }
+};
+
+/* Setups/teardown functions */
+
+static void
+flowhash_setup(void)
+{
+}
+
+static void
+flowhash_teardown(void)
+{
+}
+
+static void
+flowhash_check_vectors(const struct flowhash_vector *v, size_t num)
+{
+  size_t i;
+
+  for (i = 0; i < num; i++) {
+    ip_addr_t src, dst;
+    fail_unless(ipaddr_aton(v[i].src, &src));
+    fail_unless(ipaddr_aton(v[i].dst, &dst));
+    fail_unless(flowhash_ip(&src, &dst, 0, 0) == v[i].hash_ip);
+    fail_unless(flowhash_ip(&src, &dst, v[i].sport, v[i].dport) == v[i].hash_ports);
+  }
+}
+
+/* Test functions */
+
+/** Hashes match the RSS verification suite */
+START_TEST(test_flowhash_vectors)
+{
+  LWIP_UNUSED_ARG(_i);
+  flowhash_check_vectors(ip4_vectors, LWIP_ARRAYSIZE(ip4_vectors));
+}
+END_TEST
+
+/** Packets hash like their 5-tuple, fragments use the addresses only */
+START_TEST(test_flowhash_pbuf)
+{
+  const struct flowhash_vector *v = &ip4_vectors[0];
+  struct pbuf *p, *q;
+  struct ip_hdr *iphdr;
+  struct tcp_hdr *tcphdr;
+  ip4_addr_t src, dst;
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(ip4addr_aton(v->src, &src));
+  fail_unless(ip4addr_aton(v->dst, &dst));
+  p = pbuf_alloc(PBUF_RAW, IP_HLEN + TCP_HLEN, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  iphdr = (struct ip_hdr *)p->payload;
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(IP_HLEN + TCP_HLEN));
+  IPH_PROTO_SET(iphdr, IP_PROTO_TCP);
+  ip4_addr_copy(iphdr->src, src);
+  ip4_addr_copy(iphdr->dest, dst);
+  tcphdr = (struct tcp_hdr *)(iphdr + 1);
+  tcphdr->src = lwip_htons(v->sport);
+  tcphdr->dest = lwip_htons(v->dport);
+  fail_unless(flowhash_pbuf(p) == v->hash_ports);
+
+  /* split between IP and TCP header */
+  q = pbuf_alloc(PBUF_RAW, TCP_HLEN, PBUF_RAM);
+  fail_unless(q != NULL);
+  pbuf_copy_partial(p, q->payload, TCP_HLEN, IP_HLEN);
+  pbuf_realloc(p, IP_HLEN);
+  pbuf_cat(p, q);
+  fail_unless(flowhash_pbuf(p) == v->hash_ports);
+
+  /* first fragment: ports are present but must not be used */
+  IPH_OFFSET_SET(iphdr, PP_HTONS(IP_MF));
+  fail_unless(flowhash_pbuf(p) == v->hash_ip);
+
+  /* other protocols hash the addresses only */
+  IPH_OFFSET_SET(iphdr, 0);
+  IPH_PROTO_SET(iphdr, IP_PROTO_ICMP);
+  fail_unless(flowhash_pbuf(p) == v->hash_ip);
+
+  /* not IP */
+  IPH_VHL_SET(iphdr, 5, IP_HLEN / 4);
+  fail_unless(flowhash_pbuf(p) == 0);
+  pbuf_free(p);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+flowhash_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_flowhash_vectors),
+    TESTFUNC(test_flowhash_pbuf)
+  };
+  return create_suite("FLOWHASH", tests, sizeof(tests)/sizeof(testfunc), flowhash_setup, flowhash_teardown);
+}
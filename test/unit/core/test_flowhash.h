@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_FLOWHASH_H
+#define LWIP_HDR_TEST_FLOWHASH_H
+
+#include "../lwip_check.h"
+
+Suite *flowhash_suite(void);
+
+#endif
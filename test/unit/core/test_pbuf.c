@@ -150,10 +150,11 @@ START_TEST(test_pbuf_queueing_bigger_than_64k)
 
   pbuf_cat(p1, p2);
   pbuf_cat(p1, p3);
+  fail_unless(p1->tot_len == (pbuf_len_t)(TESTBUFSIZE_1+TESTBUFSIZE_2+TESTBUFSIZE_3));
 
   pbuf_split_64k(p1, &rest2);
   fail_unless(p1->tot_len == TESTBUFSIZE_1);
-  fail_unless(rest2->tot_len == (u16_t)((TESTBUFSIZE_2+TESTBUFSIZE_3) & 0xFFFF));
+  fail_unless(rest2->tot_len == (pbuf_len_t)(TESTBUFSIZE_2+TESTBUFSIZE_3));
   pbuf_split_64k(rest2, &rest3);
   fail_unless(rest2->tot_len == TESTBUFSIZE_2);
   fail_unless(rest3->tot_len == TESTBUFSIZE_3);
@@ -255,6 +256,139 @@ START_TEST(test_pbuf_get_put_at_edge)
 }
 END_TEST
 
+/** Build a chain of 3 pbufs holding 0..(len-1) to test access across pbuf boundaries */
+static struct pbuf *
+pbuf_alloc_chain_of_3(u16_t len1, u16_t len2, u16_t len3)
+{
+  u16_t i;
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, len1, PBUF_RAM);
+  struct pbuf *q = pbuf_alloc(PBUF_RAW, len2, PBUF_RAM);
+  struct pbuf *r = pbuf_alloc(PBUF_RAW, len3, PBUF_RAM);
+  fail_unless((p != NULL) && (q != NULL) && (r != NULL));
+  pbuf_cat(p, q);
+  pbuf_cat(p, r);
+  for (i = 0; i < p->tot_len; i++) {
+    pbuf_put_at(p, i, (u8_t)i);
+  }
+  return p;
+}
+
+START_TEST(test_pbuf_iter_read)
+{
+  struct pbuf_iter it;
+  const u8_t *span;
+  u8_t b, buf[6];
+  u16_t s;
+  u32_t l;
+  pbuf_len_t len;
+  u16_t i;
+  struct pbuf *p = pbuf_alloc_chain_of_3(3, 0, 7);
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(pbuf_iter_init(&it, p, 11) == ERR_BUF);
+  fail_unless(pbuf_iter_init(&it, p, 1) == ERR_OK);
+  fail_unless(pbuf_iter_left(&it) == 9);
+
+  /* spans never cross pbuf boundaries */
+  span = (const u8_t *)pbuf_iter_span(&it, &len);
+  fail_unless((span != NULL) && (len == 2) && (span[0] == 1));
+
+  /* u16 crossing from the first pbuf over the empty one into the third */
+  fail_unless(pbuf_iter_skip(&it, 1) == ERR_OK);
+  fail_unless(pbuf_iter_read_u16(&it, &s) == ERR_OK);
+  fail_unless(s == 0x0203);
+  fail_unless(pbuf_iter_offset(&it) == 4);
+  fail_unless(pbuf_iter_read_u32(&it, &l) == ERR_OK);
+  fail_unless(l == 0x04050607);
+  fail_unless(pbuf_iter_read_u8(&it, &b) == ERR_OK);
+  fail_unless(b == 8);
+
+  /* reading more than available fails and leaves the cursor alone */
+  fail_unless(pbuf_iter_read_u16(&it, &s) == ERR_BUF);
+  fail_unless(pbuf_iter_read(&it, buf, 2) == 0);
+  fail_unless(pbuf_iter_peek_u8(&it) == 9);
+  fail_unless(pbuf_iter_read_u8(&it, &b) == ERR_OK);
+  fail_unless(pbuf_iter_peek_u8(&it) < 0);
+  fail_unless(pbuf_iter_read_u8(&it, &b) == ERR_BUF);
+  fail_unless(pbuf_iter_span(&it, &len) == NULL);
+  fail_unless(len == 0);
+
+  fail_unless(pbuf_iter_init(&it, p, 0) == ERR_OK);
+  fail_unless(pbuf_iter_read(&it, buf, sizeof(buf)) == sizeof(buf));
+  for (i = 0; i < sizeof(buf); i++) {
+    fail_unless(buf[i] == i);
+  }
+  pbuf_free(p);
+}
+END_TEST
+
+START_TEST(test_pbuf_iter_search)
+{
+  struct pbuf_iter it;
+  const u8_t pattern[] = {2, 3, 4};
+  const u8_t mismatch[] = {2, 3, 5};
+  struct pbuf *p = pbuf_alloc_chain_of_3(3, 2, 5);
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(pbuf_iter_init(&it, p, 0) == ERR_OK);
+  fail_unless(pbuf_iter_memchr(&it, 6) == 6);
+  fail_unless(pbuf_iter_offset(&it) == 6);
+  fail_unless(pbuf_iter_memchr(&it, 1) == PBUF_ITER_NOT_FOUND);
+  fail_unless(pbuf_iter_left(&it) == 0);
+
+  fail_unless(pbuf_iter_init(&it, p, 2) == ERR_OK);
+  fail_unless(pbuf_iter_memcmp(&it, pattern, sizeof(pattern)) == 0);
+  fail_unless(pbuf_iter_memcmp(&it, mismatch, sizeof(mismatch)) == 3);
+  fail_unless(pbuf_iter_offset(&it) == 2);
+
+  /* the pbuf_mem* functions are implemented on top of the cursor */
+  fail_unless(pbuf_memcmp(p, 2, pattern, sizeof(pattern)) == 0);
+  fail_unless(pbuf_memcmp(p, 8, pattern, sizeof(pattern)) == 0xffff);
+  fail_unless(pbuf_memfind(p, pattern, sizeof(pattern), 0) == 2);
+  fail_unless(pbuf_memfind(p, pattern, sizeof(pattern), 3) == 0xFFFF);
+  fail_unless(pbuf_memfind(p, mismatch, sizeof(mismatch), 0) == 0xFFFF);
+  fail_unless(pbuf_memfind(p, pattern, 0, 4) == 4);
+  pbuf_free(p);
+}
+END_TEST
+
+/* Check the configured width of pbuf_len_t and that offsets beyond
+ * 64k are reachable when LWIP_PBUF_LEN_32BIT is enabled.
+ */
+START_TEST(test_pbuf_len_width)
+{
+#if LWIP_PBUF_LEN_32BIT
+  const pbuf_len_t size = 70000;
+  struct pbuf_iter it;
+  struct pbuf *p;
+  u8_t v = 0x5a;
+#endif
+  LWIP_UNUSED_ARG(_i);
+
+#if LWIP_PBUF_LEN_32BIT
+  fail_unless(sizeof(pbuf_len_t) == 4);
+
+  p = pbuf_alloc(PBUF_RAW, size, PBUF_POOL);
+  fail_unless(p != NULL);
+  fail_unless(p->tot_len == size);
+  fail_unless(pbuf_take_at(p, &v, 1, size - 1) == ERR_OK);
+  fail_unless(pbuf_get_at(p, size - 1) == v);
+  fail_unless(pbuf_iter_init(&it, p, 0) == ERR_OK);
+  fail_unless(pbuf_iter_skip(&it, size - 1) == ERR_OK);
+  fail_unless(pbuf_iter_offset(&it) == size - 1);
+  v = 0;
+  fail_unless(pbuf_iter_read_u8(&it, &v) == ERR_OK);
+  fail_unless(v == 0x5a);
+  fail_unless(pbuf_iter_left(&it) == 0);
+  pbuf_realloc(p, 0x10000);
+  fail_unless(p->tot_len == 0x10000);
+  pbuf_free(p);
+#else
+  fail_unless(sizeof(pbuf_len_t) == 2);
+#endif
+}
+END_TEST
+
 /** Create the suite including all tests for this module */
 Suite *
 pbuf_suite(void)
@@ -265,7 +399,10 @@ pbuf_suite(void)
     TESTFUNC(test_pbuf_split_64k_on_small_pbufs),
     TESTFUNC(test_pbuf_queueing_bigger_than_64k),
     TESTFUNC(test_pbuf_take_at_edge),
-    TESTFUNC(test_pbuf_get_put_at_edge)
+    TESTFUNC(test_pbuf_get_put_at_edge),
+    TESTFUNC(test_pbuf_iter_read),
+    TESTFUNC(test_pbuf_iter_search),
+    TESTFUNC(test_pbuf_len_width)
   };
   return create_suite("PBUF", tests, sizeof(tests)/sizeof(testfunc), pbuf_setup, pbuf_teardown);
 }
@@ -246,10 +246,10 @@ static err_t lwip_tx_func(struct netif *netif, struct pbuf *p)
   if (debug) {
     struct pbuf *pp = p;
     /* Dump data */
-    printf("TX data (pkt %d, len %d, tick %d)", txpacket, p->tot_len, tick);
+    printf("TX data (pkt %d, len %d, tick %d)", txpacket, (int)p->tot_len, tick);
     do {
       int i;
-      for (i = 0; i < pp->len; i++) {
+      for (i = 0; i < (int)pp->len; i++) {
         printf(" %02X", ((u8_t *) pp->payload)[i]);
       }
       if (pp->next) {
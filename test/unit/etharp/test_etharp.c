@@ -260,13 +260,56 @@ START_TEST(test_etharp_table)
 }
 END_TEST
 
+START_TEST(test_etharp_table_recycle)
+{
+  ip4_addr_t adrs[ARP_TABLE_SIZE + 1];
+  struct eth_addr *unused_ethaddr;
+  const ip4_addr_t *unused_ipaddr;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  /* fill the table with resolved entries of different age */
+  for (i = 0; i < ARP_TABLE_SIZE + 1; i++) {
+    IP4_ADDR(&adrs[i], 192, 168, 1, i + 2);
+  }
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    create_arp_response(&adrs[i]);
+    etharp_tmr();
+  }
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    fail_unless(etharp_find_addr(NULL, &adrs[i], &unused_ethaddr, &unused_ipaddr) >= 0);
+  }
+
+  /* refreshing the oldest entry makes the second oldest the one to recycle */
+  create_arp_response(&adrs[0]);
+  create_arp_response(&adrs[ARP_TABLE_SIZE]);
+  fail_unless(etharp_find_addr(NULL, &adrs[ARP_TABLE_SIZE], &unused_ethaddr, &unused_ipaddr) >= 0);
+  fail_unless(etharp_find_addr(NULL, &adrs[0], &unused_ethaddr, &unused_ipaddr) >= 0);
+  fail_unless(etharp_find_addr(NULL, &adrs[1], &unused_ethaddr, &unused_ipaddr) == -1);
+  for (i = 2; i < ARP_TABLE_SIZE; i++) {
+    fail_unless(etharp_find_addr(NULL, &adrs[i], &unused_ethaddr, &unused_ipaddr) >= 0);
+  }
+
+  /* entries freed by the timer are reused */
+  for (i = 0; i < ARP_MAXAGE; i++) {
+    etharp_tmr();
+  }
+  for (i = 0; i < ARP_TABLE_SIZE + 1; i++) {
+    fail_unless(etharp_find_addr(NULL, &adrs[i], &unused_ethaddr, &unused_ipaddr) == -1);
+  }
+  create_arp_response(&adrs[1]);
+  fail_unless(etharp_find_addr(NULL, &adrs[1], &unused_ethaddr, &unused_ipaddr) == 0);
+}
+END_TEST
+
 
 /** Create the suite including all tests for this module */
 Suite *
 etharp_suite(void)
 {
   testfunc tests[] = {
-    TESTFUNC(test_etharp_table)
+    TESTFUNC(test_etharp_table),
+    TESTFUNC(test_etharp_table_recycle)
   };
   return create_suite("ETHARP", tests, sizeof(tests)/sizeof(testfunc), etharp_setup, etharp_teardown);
 }
@@ -1,8 +1,14 @@
 #include "test_ip4.h"
 
 #include "lwip/ip4.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/ip4_route.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/stats.h"
+#include "lwip/prot/etharp.h"
+#include "lwip/prot/iana.h"
 #include "lwip/prot/ip.h"
 #include "lwip/prot/ip4.h"
 
@@ -14,7 +20,7 @@
 
 /* Helper functions */
 static void
-create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+create_ip4_input_fragment_from(u32_t src_host, u16_t ip_id, u16_t start, u16_t len, int last)
 {
   struct pbuf *p;
   struct netif *input_netif = netif_list; /* just use any netif */
@@ -40,7 +46,7 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
     IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
     IPH_CHKSUM_SET(iphdr, 0);
     ip4_addr_copy(iphdr->src, *netif_ip4_addr(input_netif));
-    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + 1);
+    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + src_host);
     ip4_addr_copy(iphdr->dest, *netif_ip4_addr(input_netif));
     IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
 
@@ -52,6 +58,12 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
   }
 }
 
+static void
+create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+{
+  create_ip4_input_fragment_from(1, ip_id, start, len, last);
+}
+
 /* Setups/teardown functions */
 
 static void
@@ -148,6 +160,508 @@ START_TEST(test_ip4_reass)
 }
 END_TEST
 
+START_TEST(test_ip4_reass_out_of_order)
+{
+  u16_t drop;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+
+  /* the last fragment first, then the rest backwards with a hole */
+  create_ip4_input_fragment(1, 600, 200, 1);
+  create_ip4_input_fragment(1, 400, 200, 0);
+  create_ip4_input_fragment(1, 0, 200, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 0);
+  /* filling the hole completes the datagram */
+  create_ip4_input_fragment(1, 200, 200, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  /* a fragment inside the first one must not count as the end of the data
+   * received so far: the next one does not leave a hole */
+  create_ip4_input_fragment(2, 0, 800, 0);
+  create_ip4_input_fragment(2, 8, 8, 0);
+  create_ip4_input_fragment(2, 800, 8, 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 2);
+
+  /* duplicates are dropped */
+  drop = lwip_stats.ip_frag.drop;
+  create_ip4_input_fragment(3, 200, 200, 0);
+  create_ip4_input_fragment(3, 200, 200, 0);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 1);
+  create_ip4_input_fragment(3, 0, 200, 0);
+  create_ip4_input_fragment(3, 400, 8, 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 3);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 0);
+}
+END_TEST
+
+START_TEST(test_ip4_reass_past_end)
+{
+  u16_t drop;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+
+  /* fragments beyond the last one are dropped */
+  create_ip4_input_fragment(1, 200, 200, 1);
+  drop = lwip_stats.ip_frag.drop;
+  create_ip4_input_fragment(1, 400, 200, 0);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 1);
+  /* as is a second last fragment with a different end */
+  create_ip4_input_fragment(1, 200, 208, 1);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 2);
+  create_ip4_input_fragment(1, 0, 200, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  /* a last fragment ending before data already received is dropped, even
+   * if that data is not in the fragment with the highest offset */
+  create_ip4_input_fragment(2, 0, 800, 0);
+  create_ip4_input_fragment(2, 8, 8, 0);
+  drop = lwip_stats.ip_frag.drop;
+  create_ip4_input_fragment(2, 392, 8, 1);
+  fail_unless(lwip_stats.ip_frag.drop == drop + 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+  create_ip4_input_fragment(2, 800, 8, 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 2);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 0);
+}
+END_TEST
+
+START_TEST(test_ip4_reass_source_quota)
+{
+#if IP_REASS_SOURCE_QUOTA && (MEMP_NUM_REASSDATA < IP_REASS_MAX_PBUFS_PER_SOURCE)
+  u16_t memerr = lwip_stats.ip_frag.memerr;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+
+  /* source 2 starts a datagram */
+  create_ip4_input_fragment_from(2, 1, 0, 200, 0);
+
+  /* source 1 fills its quota with one datagram that has holes */
+  for (i = 0; i < IP_REASS_MAX_PBUFS_PER_SOURCE; i++) {
+    create_ip4_input_fragment_from(1, 2, (u16_t)(8 + 16 * i), 8, 0);
+  }
+  fail_unless(lwip_stats.ip_frag.memerr == memerr);
+  /* the datagram may not grow beyond the quota */
+  create_ip4_input_fragment_from(1, 2, (u16_t)(8 + 16 * i), 8, 0);
+  fail_unless(lwip_stats.ip_frag.memerr == memerr + 1);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 0);
+
+  /* new datagrams from source 1 push out its own old ones only, both when
+     over quota and when running out of reassembly structs */
+  for (i = 0; i < MEMP_NUM_REASSDATA; i++) {
+    create_ip4_input_fragment_from(1, (u16_t)(3 + i), 8, 8, 0);
+  }
+  fail_unless(lwip_stats.mib2.ipreasmfails == 2);
+
+  /* so the datagram from source 2 still completes */
+  create_ip4_input_fragment_from(2, 1, 200, 200, 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  /* time out the rest */
+  for (i = 0; i <= IP_REASS_MAXAGE; i++) {
+    ip_reass_tmr();
+  }
+  fail_unless(lwip_stats.mib2.ipreasmfails == MEMP_NUM_REASSDATA + 1);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* IP_REASS_SOURCE_QUOTA && (MEMP_NUM_REASSDATA < IP_REASS_MAX_PBUFS_PER_SOURCE) */
+}
+END_TEST
+
+START_TEST(test_ip4_reass_source_evict)
+{
+#if IP_REASS_SOURCE_QUOTA && (MEMP_NUM_REASSDATA >= 4) && \
+    (IP_REASS_MAX_PBUFS > IP_REASS_MAX_PBUFS_PER_SOURCE + 1)
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+
+  /* source 3 starts the oldest datagram */
+  create_ip4_input_fragment_from(3, 1, 0, 200, 0);
+  /* source 2 queues a few fragments */
+  for (i = 0; i < IP_REASS_MAX_PBUFS - IP_REASS_MAX_PBUFS_PER_SOURCE - 1; i++) {
+    create_ip4_input_fragment_from(2, 2, (u16_t)(16 * i), 8, 0);
+  }
+  /* source 4 fills the reassembly buffer up to its quota */
+  for (i = 0; i < IP_REASS_MAX_PBUFS_PER_SOURCE; i++) {
+    create_ip4_input_fragment_from(4, 3, (u16_t)(8 + 16 * i), 8, 0);
+  }
+  fail_unless(lwip_stats.mib2.ipreasmfails == 0);
+
+  /* the buffer is full: the datagram of source 4, holding the most pbufs, is
+   * freed instead of the oldest one */
+  create_ip4_input_fragment_from(5, 4, 0, 200, 0);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 1);
+
+  /* so the datagram from source 3 still completes */
+  create_ip4_input_fragment_from(3, 1, 200, 200, 1);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+
+  /* time out the rest */
+  for (i = 0; i <= IP_REASS_MAXAGE; i++) {
+    ip_reass_tmr();
+  }
+  fail_unless(lwip_stats.mib2.ipreasmfails == 3);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* IP_REASS_SOURCE_QUOTA && (MEMP_NUM_REASSDATA >= 4) && ... */
+}
+END_TEST
+
+#if LWIP_IPV4_ROUTE_TABLE
+static err_t
+test_ip4_route_netif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(ipaddr);
+  return ERR_OK;
+}
+
+static err_t
+test_ip4_route_netif_init(struct netif *netif)
+{
+  netif->output = test_ip4_route_netif_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST;
+  return ERR_OK;
+}
+#endif /* LWIP_IPV4_ROUTE_TABLE */
+
+START_TEST(test_ip4_route_table)
+{
+#if LWIP_IPV4_ROUTE_TABLE
+  struct netif na, nb;
+  struct netif *old_default = netif_default;
+  ip4_addr_t addr, mask, gw_a, gw_b, net, dest;
+  LWIP_UNUSED_ARG(_i);
+
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 0, 1);
+  fail_unless(netif_add(&na, &addr, &mask, NULL, NULL, test_ip4_route_netif_init, ip4_input) == &na);
+  IP4_ADDR(&addr, 10, 1, 0, 1);
+  fail_unless(netif_add(&nb, &addr, &mask, NULL, NULL, test_ip4_route_netif_init, ip4_input) == &nb);
+  netif_set_up(&na);
+  netif_set_link_up(&na);
+  netif_set_up(&nb);
+  netif_set_link_up(&nb);
+  netif_set_default(NULL);
+  IP4_ADDR(&gw_a, 10, 0, 0, 254);
+  IP4_ADDR(&gw_b, 10, 1, 0, 254);
+
+  IP4_ADDR(&dest, 192, 168, 5, 5);
+  fail_unless(ip4_route(&dest) == NULL);
+
+  /* longest prefix wins */
+  IP4_ADDR(&net, 192, 168, 0, 0);
+  fail_unless(ip4_route_add(&net, 16, &gw_a, &na, 0) == ERR_OK);
+  fail_unless(ip4_route_add(&net, 16, &gw_a, &na, 0) == ERR_VAL);
+  fail_unless(ip4_route_add(&net, 33, &gw_a, &na, 0) == ERR_VAL);
+  fail_unless(ip4_route(&dest) == &na);
+  fail_unless(ip4_addr_cmp(ip4_route_table_gw(&na, &dest), &gw_a));
+  fail_unless(ip4_route_table_gw(&nb, &dest) == NULL);
+  IP4_ADDR(&net, 192, 168, 5, 99); /* host bits are ignored */
+  fail_unless(ip4_route_add(&net, 24, &gw_b, &nb, 0) == ERR_OK);
+  fail_unless(ip4_route(&dest) == &nb);
+  IP4_ADDR(&dest, 192, 168, 6, 1);
+  fail_unless(ip4_route(&dest) == &na);
+
+  /* on-link host route */
+  IP4_ADDR(&dest, 192, 168, 5, 7);
+  fail_unless(ip4_route_add(&dest, 32, NULL, &na, 0) == ERR_OK);
+  fail_unless(ip4_route(&dest) == &na);
+  fail_unless(ip4_route_table_gw(&na, &dest) == &dest);
+
+  /* default routes over both uplinks: the lower metric is used while usable */
+  fail_unless(ip4_route_add(NULL, 0, &gw_b, &nb, 20) == ERR_OK);
+  fail_unless(ip4_route_add(NULL, 0, &gw_a, &na, 10) == ERR_OK);
+  IP4_ADDR(&dest, 8, 8, 8, 8);
+  fail_unless(ip4_route(&dest) == &na);
+  netif_set_link_down(&na);
+  fail_unless(ip4_route(&dest) == &nb);
+  fail_unless(ip4_addr_cmp(ip4_route_table_gw(&nb, &dest), &gw_b));
+  netif_set_link_up(&na);
+  fail_unless(ip4_route(&dest) == &na);
+
+  /* removing the /24 falls back to the /16 */
+  IP4_ADDR(&net, 192, 168, 5, 0);
+  fail_unless(ip4_route_remove(&net, 24, NULL, NULL) == ERR_OK);
+  fail_unless(ip4_route_remove(&net, 24, NULL, NULL) == ERR_VAL);
+  IP4_ADDR(&dest, 192, 168, 5, 5);
+  fail_unless(ip4_route(&dest) == &na);
+  IP4_ADDR(&dest, 192, 168, 5, 7);
+  fail_unless(ip4_route(&dest) == &na);
+
+  /* removing a netif removes its routes */
+  netif_remove(&na);
+  IP4_ADDR(&dest, 8, 8, 8, 8);
+  fail_unless(ip4_route(&dest) == &nb);
+  IP4_ADDR(&dest, 192, 168, 5, 5);
+  fail_unless(ip4_route(&dest) == &nb);
+  fail_unless(ip4_route_remove(NULL, 0, &gw_b, &nb) == ERR_OK);
+  fail_unless(ip4_route(&dest) == NULL);
+  netif_remove(&nb);
+  netif_set_default(old_default);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* LWIP_IPV4_ROUTE_TABLE */
+}
+END_TEST
+
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS
+static u8_t test_ip4_fwd_frame[128];
+static int test_ip4_fwd_frames;
+static int test_ip4_fwd_arp_frames;
+
+static err_t
+test_ip4_fwd_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  const struct eth_hdr *ethhdr = (const struct eth_hdr *)p->payload;
+  LWIP_UNUSED_ARG(netif);
+  if (ethhdr->type == PP_HTONS(ETHTYPE_ARP)) {
+    test_ip4_fwd_arp_frames++;
+    return ERR_OK;
+  }
+  fail_unless(pbuf_copy_partial(p, test_ip4_fwd_frame, sizeof(test_ip4_fwd_frame), 0) ==
+              LWIP_MIN(p->tot_len, sizeof(test_ip4_fwd_frame)));
+  test_ip4_fwd_frames++;
+  return ERR_OK;
+}
+
+static err_t
+test_ip4_fwd_eth_init(struct netif *netif)
+{
+  static const u8_t hwaddr[ETH_HWADDR_LEN] = {2, 0, 0, 0, 0, 1};
+  netif->linkoutput = test_ip4_fwd_linkoutput;
+  netif->output = etharp_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  SMEMCPY(netif->hwaddr, hwaddr, ETH_HWADDR_LEN);
+  return ERR_OK;
+}
+
+/* Forward one packet from 'inp' to 'dest', check the frame sent for it
+   (none if 'expected_dst' is NULL) */
+static void
+test_ip4_fwd_one(struct netif *inp, const ip4_addr_t *dest, u8_t ttl, u16_t id,
+                 const struct eth_addr *expected_dst)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+  const struct eth_hdr *ethhdr = (const struct eth_hdr *)test_ip4_fwd_frame;
+  int frames = test_ip4_fwd_frames;
+
+  /* leave room for the Ethernet header, like a driver stripping it would */
+  p = pbuf_alloc(PBUF_IP, sizeof(struct ip_hdr) + 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  iphdr = (struct ip_hdr *)p->payload;
+  memset(p->payload, 0, p->len);
+  IPH_VHL_SET(iphdr, 4, sizeof(struct ip_hdr) / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_ID_SET(iphdr, lwip_htons(id));
+  IPH_TTL_SET(iphdr, ttl);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  IP4_ADDR(&iphdr->src, 10, 0, 0, 9);
+  ip4_addr_copy(iphdr->dest, *dest);
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
+  fail_unless(ip4_input(p, inp) == ERR_OK);
+
+  if (expected_dst == NULL) {
+    fail_unless(test_ip4_fwd_frames == frames);
+    return;
+  }
+  fail_unless(test_ip4_fwd_frames == frames + 1);
+  fail_unless(memcmp(&ethhdr->dest, expected_dst, ETH_HWADDR_LEN) == 0);
+  iphdr = (struct ip_hdr *)(test_ip4_fwd_frame + SIZEOF_ETH_HDR);
+  fail_unless(IPH_TTL(iphdr) == ttl - 1);
+  /* the incrementally updated checksum must still verify */
+  fail_unless(inet_chksum(iphdr, sizeof(struct ip_hdr)) == 0);
+}
+
+/* Pass an ARP reply from 'ipaddr' at 'hwaddr' to 'netif' */
+static void
+test_ip4_fwd_arp_reply(struct netif *netif, const ip4_addr_t *ipaddr, const struct eth_addr *hwaddr)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR, PBUF_RAM);
+  struct eth_hdr *ethhdr;
+  struct etharp_hdr *hdr;
+
+  fail_unless(p != NULL);
+  ethhdr = (struct eth_hdr *)p->payload;
+  hdr = (struct etharp_hdr *)((u8_t *)p->payload + SIZEOF_ETH_HDR);
+  SMEMCPY(&ethhdr->dest, netif->hwaddr, ETH_HWADDR_LEN);
+  SMEMCPY(&ethhdr->src, hwaddr, ETH_HWADDR_LEN);
+  ethhdr->type = PP_HTONS(ETHTYPE_ARP);
+  hdr->hwtype = PP_HTONS(LWIP_IANA_HWTYPE_ETHERNET);
+  hdr->proto = PP_HTONS(ETHTYPE_IP);
+  hdr->hwlen = ETH_HWADDR_LEN;
+  hdr->protolen = sizeof(ip4_addr_t);
+  hdr->opcode = PP_HTONS(ARP_REPLY);
+  SMEMCPY(&hdr->shwaddr, hwaddr, ETH_HWADDR_LEN);
+  SMEMCPY(&hdr->sipaddr, ipaddr, sizeof(ip4_addr_t));
+  SMEMCPY(&hdr->dhwaddr, netif->hwaddr, ETH_HWADDR_LEN);
+  SMEMCPY(&hdr->dipaddr, netif_ip4_addr(netif), sizeof(ip4_addr_t));
+  fail_unless(ethernet_input(p, netif) == ERR_OK);
+}
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS */
+
+START_TEST(test_ip4_forward_cache)
+{
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS
+  struct netif na, nb;
+  struct netif *old_default = netif_default;
+  ip4_addr_t addr, mask, dest, net, gw;
+  struct eth_addr mac1 = {{2, 0, 0, 0, 0, 5}};
+  struct eth_addr mac2 = {{2, 0, 0, 0, 0, 6}};
+  struct eth_addr mac3 = {{2, 0, 0, 0, 0, 7}};
+  u32_t hits;
+  u16_t id;
+  LWIP_UNUSED_ARG(_i);
+
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 0, 1);
+  fail_unless(netif_add(&na, &addr, &mask, NULL, NULL, test_ip4_fwd_eth_init, ip4_input) == &na);
+  IP4_ADDR(&addr, 10, 1, 0, 1);
+  fail_unless(netif_add(&nb, &addr, &mask, NULL, NULL, test_ip4_fwd_eth_init, ip4_input) == &nb);
+  netif_set_up(&na);
+  netif_set_link_up(&na);
+  netif_set_up(&nb);
+  netif_set_link_up(&nb);
+  netif_set_default(NULL);
+  test_ip4_fwd_frames = 0;
+
+  IP4_ADDR(&dest, 10, 1, 0, 5);
+  fail_unless(etharp_add_static_entry(&dest, &mac1) == ERR_OK);
+
+  /* the first packet fills the cache, the next ones hit it; every TTL and
+     ID exercises a different checksum for the incremental update */
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 0, &mac1);
+  fail_unless(STATS_GET(ip.cachehit) == hits);
+  for (id = 1; id < 600; id++) {
+    test_ip4_fwd_one(&na, &dest, (u8_t)(2 + (id % 250)), (u16_t)(id * 113), &mac1);
+  }
+  fail_unless(STATS_GET(ip.cachehit) == hits + 599);
+
+  /* an ARP change invalidates the cached next hop */
+  fail_unless(etharp_remove_static_entry(&dest) == ERR_OK);
+  fail_unless(etharp_add_static_entry(&dest, &mac2) == ERR_OK);
+  test_ip4_fwd_one(&na, &dest, 64, 1, &mac2);
+  test_ip4_fwd_one(&na, &dest, 64, 2, &mac2);
+
+  /* so does a new route: off-link destinations go via the gateway */
+  IP4_ADDR(&dest, 192, 168, 1, 1);
+  IP4_ADDR(&gw, 10, 1, 0, 254);
+  fail_unless(etharp_add_static_entry(&gw, &mac3) == ERR_OK);
+  fail_unless(ip4_route(&dest) == NULL);
+  IP4_ADDR(&net, 192, 168, 1, 0);
+  fail_unless(ip4_route_add(&net, 24, &gw, &nb, 0) == ERR_OK);
+  test_ip4_fwd_one(&na, &dest, 64, 3, &mac3);
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 4, &mac3);
+  fail_unless(STATS_GET(ip.cachehit) == hits + 1);
+  fail_unless(ip4_route_remove(&net, 24, NULL, NULL) == ERR_OK);
+  test_ip4_fwd_one(&na, &dest, 64, 5, NULL);
+
+  /* a netif going down does, too */
+  IP4_ADDR(&dest, 10, 1, 0, 5);
+  netif_set_down(&nb);
+  test_ip4_fwd_one(&na, &dest, 64, 6, NULL);
+
+  etharp_remove_static_entry(&gw);
+  etharp_remove_static_entry(&dest);
+  netif_remove(&na);
+  netif_remove(&nb);
+  netif_set_default(old_default);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS */
+}
+END_TEST
+
+/** Flows using a cached next hop keep its dynamic ARP entry alive, and an
+ * unresolved next hop is picked up once it is resolved */
+START_TEST(test_ip4_forward_cache_arp)
+{
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS
+  struct netif na, nb;
+  struct netif *old_default = netif_default;
+  ip4_addr_t addr, mask, dest;
+  struct eth_addr mac1 = {{2, 0, 0, 0, 0, 5}};
+  struct eth_addr mac2 = {{2, 0, 0, 0, 0, 6}};
+  u32_t hits;
+  int i, arp_frames, frames;
+  LWIP_UNUSED_ARG(_i);
+
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&addr, 10, 0, 0, 1);
+  fail_unless(netif_add(&na, &addr, &mask, NULL, NULL, test_ip4_fwd_eth_init, ip4_input) == &na);
+  IP4_ADDR(&addr, 10, 1, 0, 1);
+  fail_unless(netif_add(&nb, &addr, &mask, NULL, NULL, test_ip4_fwd_eth_init, ip4_input) == &nb);
+  netif_set_up(&na);
+  netif_set_link_up(&na);
+  netif_set_up(&nb);
+  netif_set_link_up(&nb);
+  netif_set_default(NULL);
+  test_ip4_fwd_frames = 0;
+
+  /* dynamic entry, learned from a reply */
+  IP4_ADDR(&dest, 10, 1, 0, 5);
+  test_ip4_fwd_arp_reply(&nb, &dest, &mac1);
+  test_ip4_fwd_one(&na, &dest, 64, 0, &mac1);
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 1, &mac1);
+  fail_unless(STATS_GET(ip.cachehit) == hits + 1);
+
+  /* shortly before the entry expires, forwarding re-requests it (unicast) */
+  for (i = 0; i < ARP_MAXAGE - 30; i++) {
+    etharp_tmr();
+  }
+  arp_frames = test_ip4_fwd_arp_frames;
+  test_ip4_fwd_one(&na, &dest, 64, 2, &mac1);
+  fail_unless(test_ip4_fwd_arp_frames == arp_frames + 1);
+  test_ip4_fwd_arp_reply(&nb, &dest, &mac1);
+
+  /* the refreshed entry outlives ARP_MAXAGE, the flow keeps hitting */
+  for (i = 0; i < 60; i++) {
+    etharp_tmr();
+  }
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 3, &mac1);
+  fail_unless(STATS_GET(ip.cachehit) == hits + 1);
+
+  /* unresolved next hop: packets go through etharp_output() */
+  IP4_ADDR(&dest, 10, 1, 0, 6);
+  arp_frames = test_ip4_fwd_arp_frames;
+  test_ip4_fwd_one(&na, &dest, 64, 4, NULL);
+  fail_unless(test_ip4_fwd_arp_frames == arp_frames + 1);
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 5, NULL);
+  fail_unless(STATS_GET(ip.cachehit) == hits + 1);
+  /* resolving it sends the queued packet and flushes the cache */
+  frames = test_ip4_fwd_frames;
+  test_ip4_fwd_arp_reply(&nb, &dest, &mac2);
+  fail_unless(test_ip4_fwd_frames == frames + 1);
+  hits = STATS_GET(ip.cachehit);
+  test_ip4_fwd_one(&na, &dest, 64, 6, &mac2);
+  fail_unless(STATS_GET(ip.cachehit) == hits);
+  test_ip4_fwd_one(&na, &dest, 64, 7, &mac2);
+  fail_unless(STATS_GET(ip.cachehit) == hits + 1);
+
+  etharp_cleanup_netif(&nb);
+  netif_remove(&na);
+  netif_remove(&nb);
+  netif_set_default(old_default);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE_SIZE && IP_STATS */
+}
+END_TEST
 
 /** Create the suite including all tests for this module */
 Suite *
@@ -155,6 +669,13 @@ ip4_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(test_ip4_reass),
+    TESTFUNC(test_ip4_reass_out_of_order),
+    TESTFUNC(test_ip4_reass_past_end),
+    TESTFUNC(test_ip4_reass_source_quota),
+    TESTFUNC(test_ip4_reass_source_evict),
+    TESTFUNC(test_ip4_route_table),
+    TESTFUNC(test_ip4_forward_cache),
+    TESTFUNC(test_ip4_forward_cache_arp),
   };
   return create_suite("IPv4", tests, sizeof(tests)/sizeof(testfunc), ip4_setup, ip4_teardown);
 }
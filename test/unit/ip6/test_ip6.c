@@ -2,14 +2,17 @@
 
 #include "lwip/ethip6.h"
 #include "lwip/ip6.h"
+#include "lwip/ip6_frag.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/nd6.h"
 #include "lwip/stats.h"
 #include "lwip/prot/ethernet.h"
 #include "lwip/prot/ip.h"
 #include "lwip/prot/ip6.h"
+#include "lwip/priv/nd6_priv.h"
 
 #include "lwip/tcpip.h"
+#include "lwip/udp.h"
 
 #if LWIP_IPV6 /* allow to build the unit tests without IPv6 support */
 
@@ -287,6 +290,210 @@ START_TEST(test_ip6_lladdr)
 }
 END_TEST
 
+#if LWIP_ND6_CACHE_HASH_SIZE
+static void
+nd6_test_peer_addr(ip6_addr_t *addr, u32_t peer)
+{
+  IP6_ADDR(addr, PP_HTONL(0xfe800000), 0, 0, lwip_htonl(peer));
+  ip6_addr_assign_zone(addr, IP6_UNICAST, &test_netif6);
+}
+
+static void
+nd6_test_send(u32_t peer)
+{
+  ip6_addr_t dest;
+  struct pbuf *p;
+  err_t err;
+
+  nd6_test_peer_addr(&dest, peer);
+  p = pbuf_alloc(PBUF_IP, 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, 8);
+  err = ip6_output_if(p, IP6_ADDR_ANY6, &dest, 64, 0, IP6_NEXTH_UDP, &test_netif6);
+  fail_unless(err == ERR_OK);
+  pbuf_free(p);
+}
+
+static int
+nd6_test_has_neighbor(u32_t peer)
+{
+  ip6_addr_t addr;
+  int i;
+
+  nd6_test_peer_addr(&addr, peer);
+  for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
+    if ((neighbor_cache[i].state != ND6_NO_ENTRY) &&
+        ip6_addr_cmp(&addr, &neighbor_cache[i].next_hop_address)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+START_TEST(test_ip6_nd6_cache_recycle)
+{
+  u32_t peer;
+  LWIP_UNUSED_ARG(_i);
+
+  netif_create_ip6_linklocal_address(&test_netif6, 1);
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_PREFERRED);
+  netif_set_up(&test_netif6);
+  netif_set_link_up(&test_netif6);
+
+  /* fill both caches with unresolved on-link peers */
+  for (peer = 1; peer <= LWIP_ND6_NUM_NEIGHBORS; peer++) {
+    nd6_test_send(peer);
+  }
+  for (peer = 1; peer <= LWIP_ND6_NUM_NEIGHBORS; peer++) {
+    fail_unless(nd6_test_has_neighbor(peer));
+  }
+
+  /* using peer 1 again makes peer 2 the least recently used one */
+  nd6_test_send(1);
+  nd6_test_send(LWIP_ND6_NUM_NEIGHBORS + 1);
+  fail_unless(nd6_test_has_neighbor(1));
+  fail_unless(!nd6_test_has_neighbor(2));
+  fail_unless(nd6_test_has_neighbor(3));
+  fail_unless(nd6_test_has_neighbor(LWIP_ND6_NUM_NEIGHBORS + 1));
+
+  /* a recycled peer gets a new entry and pushes out the next oldest */
+  nd6_test_send(2);
+  fail_unless(nd6_test_has_neighbor(2));
+  fail_unless(!nd6_test_has_neighbor(3));
+
+  netif_set_link_down(&test_netif6);
+  netif_set_down(&test_netif6);
+}
+END_TEST
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+
+#if LWIP_IPV6_FRAG && LWIP_IPV6_REASS && LWIP_UDP
+#define IP6_FRAG_TEST_DATALEN 3000
+#define IP6_FRAG_TEST_MAXFRAGS 4
+
+static struct pbuf *ip6_frag_test_frags[IP6_FRAG_TEST_MAXFRAGS];
+static int ip6_frag_test_numfrags;
+static u16_t ip6_frag_test_rxlen;
+
+static err_t
+ip6_frag_test_output(struct netif *netif, struct pbuf *p, const ip6_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(ipaddr);
+  fail_unless(netif == &test_netif6);
+  fail_unless(ip6_frag_test_numfrags < IP6_FRAG_TEST_MAXFRAGS);
+  /* keep a copy for feeding it back in: the fragment references the datagram */
+  ip6_frag_test_frags[ip6_frag_test_numfrags] = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+  fail_unless(ip6_frag_test_frags[ip6_frag_test_numfrags] != NULL);
+  ip6_frag_test_numfrags++;
+  return ERR_OK;
+}
+
+static void
+ip6_frag_test_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                   const ip_addr_t *addr, u16_t port)
+{
+  u16_t i;
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(addr);
+  LWIP_UNUSED_ARG(port);
+
+  ip6_frag_test_rxlen = p->tot_len;
+  for (i = 0; i < p->tot_len; i++) {
+    fail_unless(pbuf_get_at(p, i) == (u8_t)i);
+  }
+  pbuf_free(p);
+}
+
+/* Build a UDP datagram from a peer to us in a two-pbuf chain */
+static struct pbuf *
+ip6_frag_test_datagram(const ip6_addr_t *src, const ip6_addr_t *dest)
+{
+  struct pbuf *p, *q;
+  struct udp_hdr *udphdr;
+  struct ip6_hdr *ip6hdr;
+  u16_t i;
+
+  p = pbuf_alloc(PBUF_LINK, IP6_HLEN + UDP_HLEN + 1000, PBUF_RAM);
+  q = pbuf_alloc(PBUF_RAW, IP6_FRAG_TEST_DATALEN - 1000, PBUF_RAM);
+  fail_unless((p != NULL) && (q != NULL));
+  pbuf_cat(p, q);
+  for (i = 0; i < IP6_FRAG_TEST_DATALEN; i++) {
+    pbuf_put_at(p, (u16_t)(IP6_HLEN + UDP_HLEN + i), (u8_t)i);
+  }
+  udphdr = (struct udp_hdr *)((u8_t *)p->payload + IP6_HLEN);
+  udphdr->src = PP_HTONS(1234);
+  udphdr->dest = PP_HTONS(7);
+  udphdr->len = PP_HTONS(UDP_HLEN + IP6_FRAG_TEST_DATALEN);
+  udphdr->chksum = 0;
+  fail_unless(pbuf_remove_header(p, IP6_HLEN) == 0);
+  udphdr->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_UDP, p->tot_len, src, dest);
+  fail_unless(pbuf_add_header(p, IP6_HLEN) == 0);
+
+  ip6hdr = (struct ip6_hdr *)p->payload;
+  IP6H_VTCFL_SET(ip6hdr, 6, 0, 0);
+  IP6H_PLEN_SET(ip6hdr, UDP_HLEN + IP6_FRAG_TEST_DATALEN);
+  IP6H_NEXTH_SET(ip6hdr, IP6_NEXTH_UDP);
+  IP6H_HOPLIM_SET(ip6hdr, 64);
+  ip6_addr_copy_to_packed(ip6hdr->src, *src);
+  ip6_addr_copy_to_packed(ip6hdr->dest, *dest);
+  return p;
+}
+
+START_TEST(test_ip6_frag_reass)
+{
+  static const int orders[][3] = { {0, 1, 2}, {2, 0, 1}, {1, 2, 0} };
+  ip6_addr_t src;
+  const ip6_addr_t *dest;
+  struct udp_pcb *pcb;
+  struct pbuf *p;
+  void *payload;
+  size_t o;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  netif_create_ip6_linklocal_address(&test_netif6, 1);
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_PREFERRED);
+  netif_set_up(&test_netif6);
+  netif_set_link_up(&test_netif6);
+  test_netif6.output_ip6 = ip6_frag_test_output;
+  dest = netif_ip6_addr(&test_netif6, 0);
+  IP6_ADDR(&src, PP_HTONL(0xfe800000), 0, 0, PP_HTONL(0x5));
+  ip6_addr_assign_zone(&src, IP6_UNICAST, &test_netif6);
+
+  pcb = udp_new_ip_type(IPADDR_TYPE_V6);
+  fail_unless(pcb != NULL);
+  fail_unless(udp_bind(pcb, IP6_ADDR_ANY, 7) == ERR_OK);
+  udp_recv(pcb, ip6_frag_test_recv, NULL);
+
+  for (o = 0; o < sizeof(orders) / sizeof(orders[0]); o++) {
+    p = ip6_frag_test_datagram(&src, dest);
+    payload = p->payload;
+    ip6_frag_test_numfrags = 0;
+    fail_unless(ip6_frag(p, &test_netif6, dest) == ERR_OK);
+    fail_unless(ip6_frag_test_numfrags == 3);
+    /* fragmenting leaves the datagram alone */
+    fail_unless(p->payload == payload);
+    fail_unless(p->tot_len == IP6_HLEN + UDP_HLEN + IP6_FRAG_TEST_DATALEN);
+    fail_unless(p->next->len == IP6_FRAG_TEST_DATALEN - 1000);
+    pbuf_free(p);
+
+    ip6_frag_test_rxlen = 0;
+    for (i = 0; i < 3; i++) {
+      fail_unless(ip6_frag_test_rxlen == 0);
+      ip6_input(ip6_frag_test_frags[orders[o][i]], &test_netif6);
+    }
+    fail_unless(ip6_frag_test_rxlen == IP6_FRAG_TEST_DATALEN);
+  }
+
+  udp_remove(pcb);
+  test_netif6.output_ip6 = ethip6_output;
+  netif_set_link_down(&test_netif6);
+  netif_set_down(&test_netif6);
+}
+END_TEST
+#endif /* LWIP_IPV6_FRAG && LWIP_IPV6_REASS && LWIP_UDP */
+
 /** Create the suite including all tests for this module */
 Suite *
 ip6_suite(void)
@@ -296,7 +503,13 @@ ip6_suite(void)
     TESTFUNC(test_ip6_aton_ipv4mapped),
     TESTFUNC(test_ip6_ntoa_ipv4mapped),
     TESTFUNC(test_ip6_ntoa),
-    TESTFUNC(test_ip6_lladdr)
+    TESTFUNC(test_ip6_lladdr),
+#if LWIP_ND6_CACHE_HASH_SIZE
+    TESTFUNC(test_ip6_nd6_cache_recycle),
+#endif /* LWIP_ND6_CACHE_HASH_SIZE */
+#if LWIP_IPV6_FRAG && LWIP_IPV6_REASS && LWIP_UDP
+    TESTFUNC(test_ip6_frag_reass),
+#endif /* LWIP_IPV6_FRAG && LWIP_IPV6_REASS && LWIP_UDP */
   };
   return create_suite("IPv6", tests, sizeof(tests)/sizeof(testfunc), ip6_setup, ip6_teardown);
 }
@@ -5,7 +5,9 @@
 #include "udp/test_udp.h"
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
+#include "core/test_bpf.h"
 #include "core/test_def.h"
+#include "core/test_flowhash.h"
 #include "core/test_mem.h"
 #include "core/test_netif.h"
 #include "core/test_pbuf.h"
@@ -14,7 +16,11 @@
 #include "dhcp/test_dhcp.h"
 #include "mdns/test_mdns.h"
 #include "mqtt/test_mqtt.h"
+#include "netif/test_rxpoll.h"
+#include "netif/test_rxring.h"
+#include "netif/test_txring.h"
 #include "api/test_sockets.h"
+#include "api/test_tcpip.h"
 
 #include "lwip/init.h"
 #if !NO_SYS
@@ -67,7 +73,9 @@ int main(void)
     udp_suite,
     tcp_suite,
     tcp_oos_suite,
+    bpf_suite,
     def_suite,
+    flowhash_suite,
     mem_suite,
     netif_suite,
     pbuf_suite,
@@ -76,7 +84,11 @@ int main(void)
     dhcp_suite,
     mdns_suite,
     mqtt_suite,
-    sockets_suite
+    rxpoll_suite,
+    rxring_suite,
+    txring_suite,
+    sockets_suite,
+    tcpip_suite
   };
   size_t num = sizeof(suites)/sizeof(void*);
   LWIP_ASSERT("No suites defined", num > 0);
@@ -32,6 +32,13 @@
 #ifndef LWIP_HDR_LWIPOPTS_H
 #define LWIP_HDR_LWIPOPTS_H
 
+/* Alternative configurations (see configs/) are included first and may
+ * override the options below that are guarded by #ifndef, e.g. build with
+ * -DLWIP_TEST_CONFIG='"configs/pbuf_len_32bit.h"' */
+#ifdef LWIP_TEST_CONFIG
+#include LWIP_TEST_CONFIG
+#endif
+
 #define LWIP_TESTMODE                   1
 
 #define LWIP_IPV6                       1
@@ -46,9 +53,22 @@
 #define LWIP_NETCONN                    !NO_SYS
 #define LWIP_SOCKET                     !NO_SYS
 #define LWIP_NETCONN_FULLDUPLEX         LWIP_SOCKET
+#define LWIP_SOCKET_EPOLL               LWIP_SOCKET
+#define LWIP_SOCKET_PBUF_LOAN           LWIP_SOCKET
+#define LWIP_NETCONN_RECVQ              LWIP_NETCONN
+#define LWIP_NETCONN_ASYNC              LWIP_NETCONN
+#define DEFAULT_RAW_RECVMBOX_SIZE       16
+#define DEFAULT_UDP_RECVMBOX_SIZE       16
+#define DEFAULT_TCP_RECVMBOX_SIZE       16
 #define LWIP_NETBUF_RECVINFO            1
 #define LWIP_HAVE_LOOPIF                1
+#define LWIP_IPV4_ROUTE_TABLE           1
+#define IP_FORWARD                      1
+#define IP_FORWARD_FLOW_CACHE_SIZE      16
 #define TCPIP_THREAD_TEST
+#define LWIP_TCPIP_CORE_LOCK_SPIN       1
+#define LWIP_TCPIP_CORE_LOCK_SPIN_MAX   20
+#define LWIP_TCPIP_INPUT_BATCH          1
 
 /* Enable DHCP to test it, disable UDP checksum to easier inject packets */
 #define LWIP_DHCP                       1
@@ -70,11 +90,45 @@
 
 /* Minimal changes to opt.h required for etharp unit tests: */
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
+/* fewer buckets than entries to exercise the hash chains */
+#ifndef ARP_TABLE_HASH_SIZE
+#define ARP_TABLE_HASH_SIZE             4
+#endif
+#ifndef LWIP_ND6_CACHE_HASH_SIZE
+#define LWIP_ND6_CACHE_HASH_SIZE        4
+#endif
+#ifndef UDP_PCB_HASH_SIZE
+#define UDP_PCB_HASH_SIZE               4
+#endif
+/* a small ephemeral UDP port range to exercise the port bitmap rebuild */
+#ifndef LWIP_PORT_ALLOC_BITMAP
+#define LWIP_PORT_ALLOC_BITMAP          1
+#endif
+#define UDP_LOCAL_PORT_RANGE_START      0xffe0
+#define UDP_LOCAL_PORT_RANGE_END        0xffff
+#define UDP_ENSURE_LOCAL_PORT_RANGE(port) ((u16_t)(((port) & 0x1f) + UDP_LOCAL_PORT_RANGE_START))
+/* SO_REUSEADDR/SO_REUSEPORT for the UDP and TCP demultiplexing tests */
+#ifndef SO_REUSE
+#define SO_REUSE                        1
+#endif
+/* raw pcbs and socket filters for the BPF tests */
+#define LWIP_RAW                        1
+#ifndef RAW_PCB_HASH_SIZE
+#define RAW_PCB_HASH_SIZE               4
+#endif
+#define LWIP_SO_ATTACH_FILTER           1
 
 #define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 8)
 
 /* MIB2 stats are required to check IPv4 reassembly results */
 #define MIB2_STATS                      1
+#define IP_REASS_MAX_PBUFS              16
+#define IP_REASS_MAX_PBUFS_PER_SOURCE   10
+#ifndef IP_REASS_HASH_SIZE
+#define IP_REASS_HASH_SIZE              4
+#endif
+/* pointers are 64 bit on the test host: ip6_frag cannot overlay its helper */
+#define IPV6_FRAG_COPYHEADER            1
 
 /* netif tests want to test this, so enable: */
 #define LWIP_NETIF_EXT_STATUS_CALLBACK  1
@@ -0,0 +1,267 @@
+#include "sim_mac.h"
+
+#include "lwip/pbuf.h"
+#include "netif/etharp.h"
+
+#include <string.h>
+
+static void sim_mac_rx_irq_check(struct sim_mac *mac);
+
+static void
+sim_mac_tx_desc_fill(struct txring *ring, u16_t idx, const void *data, u16_t len,
+                     u16_t frame_len, u8_t flags)
+{
+  struct sim_mac *mac = (struct sim_mac *)ring->state;
+  struct sim_mac_tx_desc *desc = &mac->tx_desc[idx];
+
+  fail_unless(!desc->own);
+  desc->data = (const u8_t *)data;
+  desc->len = len;
+  desc->frame_len = frame_len;
+  desc->flags = flags;
+}
+
+static void
+sim_mac_tx_start(struct txring *ring, u16_t first, u16_t num)
+{
+  struct sim_mac *mac = (struct sim_mac *)ring->state;
+  u16_t i;
+
+  if (mac->tx_start_hook != NULL) {
+    mac->tx_start_hook(mac);
+  }
+  for (i = 0; i < num; i++) {
+    mac->tx_desc[(first + i) % SIM_MAC_TX_DESC].own = 1;
+  }
+}
+
+static int
+sim_mac_tx_desc_done(struct txring *ring, u16_t idx)
+{
+  struct sim_mac *mac = (struct sim_mac *)ring->state;
+  return !mac->tx_desc[idx].own;
+}
+
+static int
+sim_mac_tx_dma_ok(struct txring *ring, const void *data, u16_t len)
+{
+  struct sim_mac *mac = (struct sim_mac *)ring->state;
+  const u8_t *p = (const u8_t *)data;
+  return (p + len <= mac->tx_no_dma_mem) || (p >= mac->tx_no_dma_mem + mac->tx_no_dma_len);
+}
+
+static const struct txring_ops sim_mac_txring_ops = {
+  sim_mac_tx_desc_fill,
+  sim_mac_tx_start,
+  sim_mac_tx_desc_done,
+  sim_mac_tx_dma_ok,
+  NULL
+};
+
+void
+sim_mac_init(struct sim_mac *mac)
+{
+  u16_t i;
+
+  memset(mac, 0, sizeof(struct sim_mac));
+  rxring_init(&mac->rxring, mac->rx_bufs, &mac->rx_mem[0][0], SIM_MAC_RX_BUFS, SIM_MAC_BUF_SIZE);
+  for (i = 0; i < SIM_MAC_RX_DESC; i++) {
+    mac->rx_desc[i].buf = rxring_buf_get(&mac->rxring);
+    fail_unless(mac->rx_desc[i].buf != NULL);
+    mac->rx_desc[i].own = 1;
+  }
+  txring_init(&mac->txring, &sim_mac_txring_ops, mac, mac->tx_pbufs, SIM_MAC_TX_DESC);
+}
+
+static err_t
+sim_mac_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct sim_mac *mac = (struct sim_mac *)netif->state;
+  return txring_output(&mac->txring, p);
+}
+
+/** netif init function, pass the struct sim_mac as state to netif_add */
+err_t
+sim_mac_netif_init(struct netif *netif)
+{
+  netif->name[0] = 's';
+  netif->name[1] = 'm';
+  netif->output = etharp_output;
+  netif->linkoutput = sim_mac_linkoutput;
+  netif->mtu = 1500;
+  netif->hwaddr_len = ETH_HWADDR_LEN;
+  netif->hwaddr[0] = 0x02;
+  netif->hwaddr[1] = 0x00;
+  netif->hwaddr[2] = 0x00;
+  netif->hwaddr[3] = 0x00;
+  netif->hwaddr[4] = 0x00;
+  netif->hwaddr[5] = 0x01;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET;
+  return ERR_OK;
+}
+
+/** DMA stand-in: put a frame from the wire into the next descriptor.
+ * Returns 1 on success, 0 if no descriptor was available (overrun). */
+int
+sim_mac_wire_rx(struct sim_mac *mac, const void *frame, u16_t len)
+{
+  struct sim_mac_rx_desc *desc = &mac->rx_desc[mac->rx_dma_idx];
+
+  if (!desc->own) {
+    mac->rx_overruns++;
+    return 0;
+  }
+  fail_unless(len + ETH_PAD_SIZE <= SIM_MAC_BUF_SIZE);
+  memcpy(desc->buf->payload + ETH_PAD_SIZE, frame, len);
+  desc->len = len;
+  desc->own = 0;
+  mac->rx_dma_idx = (u16_t)((mac->rx_dma_idx + 1) % SIM_MAC_RX_DESC);
+  mac->rx_irq_status = 1;
+  sim_mac_rx_irq_check(mac);
+  return 1;
+}
+
+/** Driver side: take one frame from the RX ring and re-arm its descriptor.
+ * Returns 0 if the ring is empty. */
+static int
+sim_mac_rx_one(struct sim_mac *mac, struct pbuf **p)
+{
+  struct sim_mac_rx_desc *desc = &mac->rx_desc[mac->rx_drv_idx];
+  u32_t copied_before = mac->rxring.stats.copied;
+
+  if (desc->own) {
+    return 0;
+  }
+  *p = rxring_input(&mac->rxring, &desc->buf, desc->len);
+  if (mac->rxring.stats.copied != copied_before) {
+    mac->rx_copied_bytes += desc->len;
+  }
+  /* re-arm the descriptor with whatever buffer is in the slot now */
+  desc->own = 1;
+  mac->rx_drv_idx = (u16_t)((mac->rx_drv_idx + 1) % SIM_MAC_RX_DESC);
+  return 1;
+}
+
+/** Driver side: pass all received frames to netif->input and re-arm
+ * their descriptors. Returns the number of frames processed. */
+u16_t
+sim_mac_rx_poll(struct sim_mac *mac)
+{
+  u16_t frames = 0;
+  struct pbuf *p;
+
+  while (sim_mac_rx_one(mac, &p)) {
+    if (p != NULL) {
+      if (mac->netif.input(p, &mac->netif) != ERR_OK) {
+        pbuf_free(p);
+      }
+    }
+    frames++;
+  }
+  return frames;
+}
+
+/* the simulated ISR */
+static void
+sim_mac_rx_irq_check(struct sim_mac *mac)
+{
+  if (mac->rx_irq_enabled && mac->rx_irq_status) {
+    if (rxpoll_irq(&mac->rxpoll)) {
+      mac->rx_wakeups++;
+    }
+  }
+}
+
+static void
+sim_mac_rxpoll_irq_enable(struct rxpoll *rp, u8_t enable)
+{
+  struct sim_mac *mac = (struct sim_mac *)rp->state;
+
+  mac->rx_irq_enabled = enable;
+  if (enable) {
+    /* a latched status raises the interrupt right away */
+    sim_mac_rx_irq_check(mac);
+  } else {
+    /* acknowledge */
+    mac->rx_irq_status = 0;
+  }
+}
+
+static int
+sim_mac_rxpoll_rx(struct rxpoll *rp, struct pbuf **p)
+{
+  return sim_mac_rx_one((struct sim_mac *)rp->state, p);
+}
+
+static void
+sim_mac_rxpoll_input(struct rxpoll *rp, struct pbuf **frames, u16_t num)
+{
+  struct sim_mac *mac = (struct sim_mac *)rp->state;
+  u16_t i;
+
+  mac->rx_last_batch = num;
+  for (i = 0; i < num; i++) {
+    if (mac->netif.input(frames[i], &mac->netif) != ERR_OK) {
+      pbuf_free(frames[i]);
+    }
+  }
+}
+
+static const struct rxpoll_ops sim_mac_rxpoll_ops = {
+  sim_mac_rxpoll_irq_enable,
+  sim_mac_rxpoll_rx,
+  sim_mac_rxpoll_input
+};
+
+/** Switch the RX side to interrupt driven, budgeted polling */
+void
+sim_mac_rxpoll_init(struct sim_mac *mac, u16_t budget)
+{
+  rxpoll_init(&mac->rxpoll, &sim_mac_rxpoll_ops, mac, &mac->netif, budget);
+  mac->rx_irq_enabled = 1;
+}
+
+/** Check if 'ptr' points into the simulated DMA memory */
+int
+sim_mac_rx_is_dma_buf(const struct sim_mac *mac, const void *ptr)
+{
+  const u8_t *p = (const u8_t *)ptr;
+  const u8_t *start = (const u8_t *)mac->rx_mem;
+  return (p >= start) && (p < start + sizeof(mac->rx_mem));
+}
+
+/** DMA stand-in: transmit up to 'max_desc' descriptors, gathering their
+ * segments into mac->tx_frame. Returns the number of descriptors done. */
+u16_t
+sim_mac_tx_dma(struct sim_mac *mac, u16_t max_desc)
+{
+  u16_t done = 0;
+
+  while ((done < max_desc) && mac->tx_desc[mac->tx_dma_idx].own) {
+    struct sim_mac_tx_desc *desc = &mac->tx_desc[mac->tx_dma_idx];
+    if (desc->flags & TXRING_FIRST) {
+      mac->tx_cur_len = 0;
+    }
+    fail_unless(mac->tx_cur_len + desc->len <= SIM_MAC_BUF_SIZE);
+    memcpy(&mac->tx_frame[mac->tx_cur_len], desc->data, desc->len);
+    mac->tx_cur_len = (u16_t)(mac->tx_cur_len + desc->len);
+    if (desc->flags & TXRING_LAST) {
+      fail_unless(mac->tx_cur_len == desc->frame_len);
+      mac->tx_frame_len = mac->tx_cur_len;
+      mac->tx_frames++;
+    }
+    desc->own = 0;
+    mac->tx_dma_idx = (u16_t)((mac->tx_dma_idx + 1) % SIM_MAC_TX_DESC);
+    done++;
+  }
+  return done;
+}
+
+/** Transmit everything queued and run the driver's completion handling.
+ * Returns the number of frames released. */
+u16_t
+sim_mac_tx_complete(struct sim_mac *mac)
+{
+  sim_mac_tx_dma(mac, 0xFFFF);
+  return txring_reclaim(&mac->txring);
+}
@@ -0,0 +1,88 @@
+#ifndef LWIP_HDR_SIM_MAC_H
+#define LWIP_HDR_SIM_MAC_H
+
+#include "../lwip_check.h"
+
+#include "lwip/netif.h"
+#include "netif/rxring.h"
+#include "netif/txring.h"
+#include "netif/rxpoll.h"
+
+/* A simulated Ethernet MAC: DMA descriptor rings in host memory that test
+ * code can "receive" frames into and "transmit" frames from, plus the
+ * driver side using rxring and txring. */
+
+#define SIM_MAC_RX_DESC   4
+#define SIM_MAC_RX_BUFS   8
+#define SIM_MAC_BUF_SIZE  1536
+#define SIM_MAC_TX_DESC   8
+
+struct sim_mac_rx_desc {
+  /** 1: owned by the (simulated) DMA, 0: owned by the driver */
+  u8_t own;
+  u16_t len;
+  struct rxring_buf *buf;
+};
+
+struct sim_mac_tx_desc {
+  /** 1: owned by the (simulated) DMA, 0: owned by the driver */
+  u8_t own;
+  u8_t flags;
+  const u8_t *data;
+  u16_t len;
+  u16_t frame_len;
+};
+
+struct sim_mac {
+  struct netif netif;
+  struct rxring rxring;
+  struct rxring_buf rx_bufs[SIM_MAC_RX_BUFS];
+  u8_t rx_mem[SIM_MAC_RX_BUFS][SIM_MAC_BUF_SIZE];
+  struct sim_mac_rx_desc rx_desc[SIM_MAC_RX_DESC];
+  /** next descriptor the DMA writes to */
+  u16_t rx_dma_idx;
+  /** next descriptor the driver reads from */
+  u16_t rx_drv_idx;
+  /** frames lost because no descriptor was owned by the DMA */
+  u32_t rx_overruns;
+  /** bytes memcpy'd by the driver (not counting the DMA) */
+  u32_t rx_copied_bytes;
+
+  /* RX interrupt model for rxpoll: a latched status flag and an enable bit */
+  struct rxpoll rxpoll;
+  u8_t rx_irq_enabled;
+  u8_t rx_irq_status;
+  /** times the ISR woke up the driver thread */
+  u32_t rx_wakeups;
+  /** size of the last batch passed to the stack */
+  u16_t rx_last_batch;
+
+  struct txring txring;
+  struct pbuf *tx_pbufs[SIM_MAC_TX_DESC];
+  struct sim_mac_tx_desc tx_desc[SIM_MAC_TX_DESC];
+  /** next descriptor the DMA reads from */
+  u16_t tx_dma_idx;
+  /** memory the DMA cannot read from (for txring_ops.dma_ok) */
+  const u8_t *tx_no_dma_mem;
+  u16_t tx_no_dma_len;
+  /** last frame put on the wire */
+  u8_t tx_frame[SIM_MAC_BUF_SIZE];
+  u16_t tx_frame_len;
+  /** length gathered so far for the frame on the wire */
+  u16_t tx_cur_len;
+  u32_t tx_frames;
+  /** called at the start of txring_ops.start, e.g. to run txring_reclaim()
+   * as if concurrently */
+  void (*tx_start_hook)(struct sim_mac *mac);
+};
+
+void sim_mac_init(struct sim_mac *mac);
+err_t sim_mac_netif_init(struct netif *netif);
+int sim_mac_wire_rx(struct sim_mac *mac, const void *frame, u16_t len);
+u16_t sim_mac_rx_poll(struct sim_mac *mac);
+void sim_mac_rxpoll_init(struct sim_mac *mac, u16_t budget);
+int sim_mac_rx_is_dma_buf(const struct sim_mac *mac, const void *ptr);
+u16_t sim_mac_tx_dma(struct sim_mac *mac, u16_t max_desc);
+u16_t sim_mac_tx_complete(struct sim_mac *mac);
+
+#endif
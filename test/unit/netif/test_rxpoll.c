@@ -0,0 +1,182 @@
+#include "test_rxpoll.h"
+#include "sim_mac.h"
+
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+
+static struct sim_mac mac;
+static int frames_in;
+static u8_t last_seq;
+/* frame to put on the wire from within netif->input (race test) */
+static int inject_from_input;
+
+/* Setups/teardown functions */
+
+static void
+rxpoll_setup(void)
+{
+  frames_in = 0;
+  last_seq = 0;
+  inject_from_input = 0;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+rxpoll_teardown(void)
+{
+  sim_mac_tx_complete(&mac);
+  if (netif_list == &mac.netif) {
+    netif_remove(&mac.netif);
+  }
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* test helper functions */
+
+/* counts frames and checks they arrive in order */
+static err_t
+count_input(struct pbuf *p, struct netif *inp)
+{
+  u8_t seq = pbuf_get_at(p, ETH_PAD_SIZE);
+  LWIP_UNUSED_ARG(inp);
+
+  fail_unless(seq == (u8_t)(last_seq + 1));
+  last_seq = seq;
+  frames_in++;
+  pbuf_free(p);
+  if (inject_from_input) {
+    u8_t frame[64];
+    inject_from_input = 0;
+    memset(frame, 0, sizeof(frame));
+    frame[0] = (u8_t)(seq + 1);
+    fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+  }
+  return ERR_OK;
+}
+
+static void
+add_sim_netif(u16_t budget)
+{
+  sim_mac_init(&mac);
+  fail_unless(netif_add(&mac.netif, NULL, NULL, NULL, &mac, sim_mac_netif_init, count_input) == &mac.netif);
+  sim_mac_rxpoll_init(&mac, budget);
+}
+
+/* put 'num' frames on the wire, numbered from 'seq' */
+static void
+wire_rx(u8_t seq, int num)
+{
+  u8_t frame[64];
+  int i;
+
+  memset(frame, 0, sizeof(frame));
+  for (i = 0; i < num; i++) {
+    frame[0] = (u8_t)(seq + i);
+    fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+  }
+}
+
+/* the driver thread: poll until the ring is empty, return the number of polls */
+static int
+run_driver_thread(void)
+{
+  int polls = 0;
+  if (mac.rxpoll.scheduled) {
+    do {
+      polls++;
+    } while (rxpoll_poll(&mac.rxpoll));
+  }
+  return polls;
+}
+
+/* Test functions */
+
+START_TEST(test_rxpoll_budget)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  add_sim_netif(2);
+
+  /* the first frame interrupts, the rest of the burst doesn't */
+  wire_rx(1, 3);
+  fail_unless(mac.rx_wakeups == 1);
+  fail_unless(mac.rxpoll.stats.irqs == 1);
+  fail_unless(!mac.rx_irq_enabled);
+
+  /* budget of 2: the interrupt stays masked until the ring is empty */
+  fail_unless(rxpoll_poll(&mac.rxpoll) == 1);
+  fail_unless(frames_in == 2);
+  fail_unless(mac.rx_last_batch == 2);
+  fail_unless(!mac.rx_irq_enabled);
+  fail_unless(rxpoll_poll(&mac.rxpoll) == 0);
+  fail_unless(frames_in == 3);
+  fail_unless(mac.rx_last_batch == 1);
+  fail_unless(mac.rx_irq_enabled);
+  fail_unless(!mac.rxpoll.scheduled);
+  fail_unless(mac.rxpoll.stats.budget_exhausted == 1);
+
+  /* spurious wakeups do nothing */
+  fail_unless(rxpoll_poll(&mac.rxpoll) == 0);
+  fail_unless(mac.rxpoll.stats.polls == 2);
+
+  /* back in interrupt mode */
+  wire_rx(4, 1);
+  fail_unless(mac.rx_wakeups == 2);
+  fail_unless(run_driver_thread() == 1);
+  fail_unless(frames_in == 4);
+}
+END_TEST
+
+START_TEST(test_rxpoll_no_lost_wakeup)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  add_sim_netif(4);
+
+  /* a frame arriving after the ring was found empty but before the
+     interrupt is unmasked must raise the interrupt again */
+  inject_from_input = 1;
+  wire_rx(1, 1);
+  fail_unless(mac.rx_wakeups == 1);
+  fail_unless(rxpoll_poll(&mac.rxpoll) == 0);
+  fail_unless(frames_in == 1);
+  fail_unless(mac.rx_wakeups == 2);
+  fail_unless(mac.rxpoll.scheduled);
+  fail_unless(run_driver_thread() == 1);
+  fail_unless(frames_in == 2);
+  fail_unless(mac.rx_irq_enabled);
+}
+END_TEST
+
+START_TEST(test_rxpoll_coalescing)
+{
+  int burst;
+  LWIP_UNUSED_ARG(_i);
+
+  add_sim_netif(SIM_MAC_RX_DESC);
+
+  /* 25 bursts filling the ring: one interrupt per burst, not per frame */
+  for (burst = 0; burst < 25; burst++) {
+    wire_rx((u8_t)(burst * SIM_MAC_RX_DESC + 1), SIM_MAC_RX_DESC);
+    run_driver_thread();
+  }
+  fail_unless(frames_in == 25 * SIM_MAC_RX_DESC);
+  fail_unless(mac.rxpoll.stats.frames == 25 * SIM_MAC_RX_DESC);
+  fail_unless(mac.rxpoll.stats.irqs == 25);
+  fail_unless(mac.rx_wakeups == 25);
+  fail_unless(mac.rx_last_batch == SIM_MAC_RX_DESC);
+  fail_unless(mac.rx_overruns == 0);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+rxpoll_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_rxpoll_budget),
+    TESTFUNC(test_rxpoll_no_lost_wakeup),
+    TESTFUNC(test_rxpoll_coalescing)
+  };
+  return create_suite("RXPOLL", tests, sizeof(tests)/sizeof(testfunc), rxpoll_setup, rxpoll_teardown);
+}
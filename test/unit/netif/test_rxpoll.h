@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_RXPOLL_H
+#define LWIP_HDR_TEST_RXPOLL_H
+
+#include "../lwip_check.h"
+
+Suite *rxpoll_suite(void);
+
+#endif
@@ -0,0 +1,196 @@
+#include "test_rxring.h"
+#include "sim_mac.h"
+
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/etharp.h"
+#include "netif/ethernet.h"
+#include "lwip/prot/iana.h"
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "This tests needs LWIP_SUPPORT_CUSTOM_PBUF enabled"
+#endif
+
+#define HELD_MAX 8
+
+static struct sim_mac mac;
+static struct pbuf *held[HELD_MAX];
+static int num_held;
+
+static void
+free_held(void)
+{
+  int i;
+  for (i = 0; i < num_held; i++) {
+    pbuf_free(held[i]);
+  }
+  num_held = 0;
+}
+
+/* Setups/teardown functions */
+
+static void
+rxring_setup(void)
+{
+  num_held = 0;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+rxring_teardown(void)
+{
+  free_held();
+  sim_mac_tx_complete(&mac);
+  if (netif_list == &mac.netif) {
+    netif_remove(&mac.netif);
+  }
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* test helper functions */
+
+/* netif input function simulating a stack that holds on to every frame */
+static err_t
+hold_input(struct pbuf *p, struct netif *inp)
+{
+  LWIP_UNUSED_ARG(inp);
+  fail_unless(num_held < HELD_MAX);
+  held[num_held++] = p;
+  return ERR_OK;
+}
+
+static void
+fill_frame(u8_t *frame, u16_t len, u8_t seed)
+{
+  u16_t i;
+  for (i = 0; i < len; i++) {
+    frame[i] = (u8_t)(seed + i);
+  }
+}
+
+static void
+add_sim_netif(netif_input_fn input)
+{
+  ip4_addr_t addr, netmask, gw;
+
+  IP4_ADDR(&addr, 192, 168, 0, 1);
+  IP4_ADDR(&netmask, 255, 255, 255, 0);
+  IP4_ADDR(&gw, 192, 168, 0, 254);
+  sim_mac_init(&mac);
+  fail_unless(netif_add(&mac.netif, &addr, &netmask, &gw, &mac, sim_mac_netif_init, input) == &mac.netif);
+  netif_set_up(&mac.netif);
+  netif_set_link_up(&mac.netif);
+  /* drop announcements sent on link up */
+  sim_mac_tx_complete(&mac);
+  mac.tx_frames = 0;
+}
+
+/* Test functions */
+
+START_TEST(test_rxring_zero_copy)
+{
+  u8_t frame[128];
+  u8_t copy[sizeof(frame)];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  add_sim_netif(hold_input);
+  fail_unless(mac.rxring.num_free == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC);
+
+  /* as long as spare buffers are free, frames are passed up in place */
+  for (i = 0; i < SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC; i++) {
+    fill_frame(frame, sizeof(frame), (u8_t)i);
+    fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+    fail_unless(sim_mac_rx_poll(&mac) == 1);
+  }
+  fail_unless(num_held == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC);
+  fail_unless(mac.rxring.stats.zero_copy == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC);
+  fail_unless(mac.rxring.stats.copied == 0);
+  fail_unless(mac.rx_copied_bytes == 0);
+  fail_unless(mac.rxring.num_free == 0);
+  for (i = 0; i < num_held; i++) {
+    fail_unless(held[i]->tot_len == sizeof(frame) + ETH_PAD_SIZE);
+    fail_unless((held[i]->flags & PBUF_FLAG_IS_CUSTOM) != 0);
+    fail_unless(sim_mac_rx_is_dma_buf(&mac, held[i]->payload));
+    fill_frame(frame, sizeof(frame), (u8_t)i);
+    fail_unless(pbuf_copy_partial(held[i], copy, sizeof(copy), ETH_PAD_SIZE) == sizeof(copy));
+    fail_if(memcmp(frame, copy, sizeof(frame)));
+  }
+
+  /* with all spare buffers held by the stack, frames must be copied */
+  fill_frame(frame, sizeof(frame), 0x55);
+  fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+  fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+  fail_unless(sim_mac_rx_poll(&mac) == 2);
+  fail_unless(mac.rxring.stats.copied == 2);
+  fail_unless(mac.rx_copied_bytes == 2 * sizeof(frame));
+  fail_unless(!sim_mac_rx_is_dma_buf(&mac, held[num_held - 1]->payload));
+  fail_unless(pbuf_memcmp(held[num_held - 1], ETH_PAD_SIZE, frame, sizeof(frame)) == 0);
+
+  /* freeing the pbufs recycles the DMA buffers into the ring */
+  free_held();
+  fail_unless(mac.rxring.num_free == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC);
+  fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+  fail_unless(sim_mac_rx_poll(&mac) == 1);
+  fail_unless(mac.rxring.stats.zero_copy == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC + 1);
+  fail_unless(mac.rxring.stats.dropped == 0);
+  fail_unless(mac.rx_overruns == 0);
+}
+END_TEST
+
+START_TEST(test_rxring_stack_input)
+{
+  u8_t frame[60];
+  struct eth_hdr *ethhdr = (struct eth_hdr *)frame;
+  struct etharp_hdr *hdr = (struct etharp_hdr *)(ethhdr + 1);
+  ip4_addr_t sip;
+  const struct eth_addr peer = {{0x02, 0x00, 0x00, 0x00, 0x00, 0x02}};
+  struct eth_addr *eth_ret;
+  const ip4_addr_t *ip_ret;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  add_sim_netif(ethernet_input);
+
+  /* ARP requests for our address: the stack consumes and frees them */
+  memset(frame, 0, sizeof(frame));
+  SMEMCPY(&ethhdr->dest, &ethbroadcast, ETH_HWADDR_LEN);
+  SMEMCPY(&ethhdr->src, &peer, ETH_HWADDR_LEN);
+  ethhdr->type = PP_HTONS(ETHTYPE_ARP);
+  hdr->hwtype = PP_HTONS(LWIP_IANA_HWTYPE_ETHERNET);
+  hdr->proto = PP_HTONS(ETHTYPE_IP);
+  hdr->hwlen = ETH_HWADDR_LEN;
+  hdr->protolen = sizeof(ip4_addr_t);
+  hdr->opcode = PP_HTONS(ARP_REQUEST);
+  SMEMCPY(&hdr->shwaddr, &peer, ETH_HWADDR_LEN);
+  IP4_ADDR(&sip, 192, 168, 0, 2);
+  SMEMCPY(&hdr->sipaddr, &sip, sizeof(sip));
+  SMEMCPY(&hdr->dipaddr, netif_ip4_addr(&mac.netif), sizeof(ip4_addr_t));
+
+  for (i = 0; i < 3 * SIM_MAC_RX_BUFS; i++) {
+    fail_unless(sim_mac_wire_rx(&mac, frame, sizeof(frame)));
+    fail_unless(sim_mac_rx_poll(&mac) == 1);
+    /* each request is answered */
+    fail_unless(sim_mac_tx_complete(&mac) == 1);
+  }
+  fail_unless(mac.tx_frames == 3 * SIM_MAC_RX_BUFS);
+  /* no frame ever needed a copy since the stack returned every buffer */
+  fail_unless(mac.rxring.stats.zero_copy == 3 * SIM_MAC_RX_BUFS);
+  fail_unless(mac.rxring.stats.copied == 0);
+  fail_unless(mac.rxring.num_free == SIM_MAC_RX_BUFS - SIM_MAC_RX_DESC);
+  fail_unless(etharp_find_addr(&mac.netif, &sip, &eth_ret, &ip_ret) >= 0);
+  fail_if(memcmp(eth_ret, &peer, ETH_HWADDR_LEN));
+  etharp_cleanup_netif(&mac.netif);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+rxring_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_rxring_zero_copy),
+    TESTFUNC(test_rxring_stack_input)
+  };
+  return create_suite("RXRING", tests, sizeof(tests)/sizeof(testfunc), rxring_setup, rxring_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_RXRING_H
+#define LWIP_HDR_TEST_RXRING_H
+
+#include "../lwip_check.h"
+
+Suite *rxring_suite(void);
+
+#endif
@@ -0,0 +1,326 @@
+#include "test_txring.h"
+#include "sim_mac.h"
+
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+#include "lwip/udp.h"
+#include "netif/ethernet.h"
+
+static struct sim_mac mac;
+
+/* Setups/teardown functions */
+
+static void
+txring_setup(void)
+{
+  ip4_addr_t addr, netmask, gw;
+
+  IP4_ADDR(&addr, 192, 168, 0, 1);
+  IP4_ADDR(&netmask, 255, 255, 255, 0);
+  IP4_ADDR(&gw, 192, 168, 0, 254);
+  sim_mac_init(&mac);
+  netif_add(&mac.netif, &addr, &netmask, &gw, &mac, sim_mac_netif_init, ethernet_input);
+  netif_set_up(&mac.netif);
+  netif_set_link_up(&mac.netif);
+  /* drop announcements sent on link up */
+  sim_mac_tx_complete(&mac);
+  memset(&mac.txring.stats, 0, sizeof(mac.txring.stats));
+  mac.tx_frames = 0;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+txring_teardown(void)
+{
+  sim_mac_tx_complete(&mac);
+  netif_remove(&mac.netif);
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* test helper functions */
+
+/* allocate a frame of 'segs' PBUF_POOL segments of 'seg_len' bytes each,
+ * filled with a counting pattern starting at 'seed' */
+static struct pbuf *
+alloc_frame(u16_t segs, u16_t seg_len, u8_t seed)
+{
+  struct pbuf *p = NULL;
+  u16_t i, j;
+
+  for (i = 0; i < segs; i++) {
+    struct pbuf *q = pbuf_alloc(PBUF_RAW, seg_len, PBUF_POOL);
+    fail_unless(q != NULL);
+    fail_unless(q->next == NULL);
+    for (j = 0; j < seg_len; j++) {
+      ((u8_t *)q->payload)[j] = (u8_t)(seed + i * seg_len + j);
+    }
+    if (p == NULL) {
+      p = q;
+    } else {
+      pbuf_cat(p, q);
+    }
+  }
+  return p;
+}
+
+static int
+wire_frame_matches(struct pbuf *p)
+{
+  return (mac.tx_frame_len == p->tot_len - ETH_PAD_SIZE) &&
+    (pbuf_memcmp(p, ETH_PAD_SIZE, mac.tx_frame, mac.tx_frame_len) == 0);
+}
+
+/* Test functions */
+
+START_TEST(test_txring_scatter_gather)
+{
+  struct pbuf *p = alloc_frame(3, 100, 0);
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(mac.netif.linkoutput(&mac.netif, p) == ERR_OK);
+  fail_unless(mac.txring.stats.frames == 1);
+  fail_unless(mac.txring.stats.segments == 3 - (ETH_PAD_SIZE == 100));
+  fail_unless(mac.txring.stats.linearized == 0);
+  /* the ring holds a reference until the DMA is done */
+  fail_unless(p->ref == 2);
+  fail_unless(txring_reclaim(&mac.txring) == 0);
+  fail_unless(p->ref == 2);
+
+  fail_unless(sim_mac_tx_dma(&mac, 0xFFFF) == mac.txring.stats.segments);
+  fail_unless(mac.tx_frames == 1);
+  fail_unless(wire_frame_matches(p));
+  fail_unless(txring_reclaim(&mac.txring) == 1);
+  fail_unless(p->ref == 1);
+  fail_unless(txring_num_free(&mac.txring) == SIM_MAC_TX_DESC);
+  pbuf_free(p);
+}
+END_TEST
+
+static u16_t test_txring_hook_reclaimed;
+
+static void
+test_txring_reclaim_hook(struct sim_mac *m)
+{
+  test_txring_hook_reclaimed = (u16_t)(test_txring_hook_reclaimed + txring_reclaim(&m->txring));
+}
+
+/* txring_reclaim() running between desc_fill() and start(), when the
+ * descriptors of the new frame do not have OWN set yet and desc_done()
+ * reports them as done, must not release the frame */
+START_TEST(test_txring_reclaim_before_start)
+{
+  struct pbuf *p[2];
+  u16_t tail = mac.txring.tail;
+  LWIP_UNUSED_ARG(_i);
+
+  p[0] = alloc_frame(2, 64, 0);
+  p[1] = alloc_frame(2, 64, 2);
+  test_txring_hook_reclaimed = 0;
+  mac.tx_start_hook = test_txring_reclaim_hook;
+
+  fail_unless(txring_output(&mac.txring, p[0]) == ERR_OK);
+  fail_unless(test_txring_hook_reclaimed == 0);
+  fail_unless(p[0]->ref == 2);
+  fail_unless(txring_num_free(&mac.txring) == SIM_MAC_TX_DESC - 2);
+
+  /* a completed frame is still released while the next one is queued */
+  fail_unless(sim_mac_tx_dma(&mac, 0xFFFF) == 2);
+  fail_unless(txring_output(&mac.txring, p[1]) == ERR_OK);
+  fail_unless(test_txring_hook_reclaimed == 1);
+  fail_unless(p[0]->ref == 1);
+  fail_unless(p[1]->ref == 2);
+  fail_unless(mac.txring.tail == (tail + 2) % SIM_MAC_TX_DESC);
+  mac.tx_start_hook = NULL;
+
+  fail_unless(sim_mac_tx_dma(&mac, 0xFFFF) == 2);
+  fail_unless(wire_frame_matches(p[1]));
+  fail_unless(txring_reclaim(&mac.txring) == 1);
+  fail_unless(txring_num_free(&mac.txring) == SIM_MAC_TX_DESC);
+  pbuf_free(p[0]);
+  pbuf_free(p[1]);
+}
+END_TEST
+
+START_TEST(test_txring_ring_full)
+{
+  struct pbuf *p[3];
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < 3; i++) {
+    p[i] = alloc_frame(3, 64, (u8_t)(i * 3));
+  }
+  /* 8 descriptors: two frames of three segments fit, the third doesn't */
+  fail_unless(txring_output(&mac.txring, p[0]) == ERR_OK);
+  fail_unless(txring_output(&mac.txring, p[1]) == ERR_OK);
+  fail_unless(txring_num_free(&mac.txring) == SIM_MAC_TX_DESC - 6);
+  fail_unless(txring_output(&mac.txring, p[2]) == ERR_MEM);
+  fail_unless(mac.txring.stats.ring_full == 1);
+  fail_unless(p[2]->ref == 1);
+
+  /* descriptors are reused as soon as the DMA is done with them... */
+  fail_unless(sim_mac_tx_dma(&mac, 1) == 1);
+  fail_unless(txring_reclaim(&mac.txring) == 0);
+  fail_unless(txring_num_free(&mac.txring) == SIM_MAC_TX_DESC - 5);
+  /* ...but a frame is only released after its last descriptor */
+  fail_unless(p[0]->ref == 2);
+
+  /* the third frame reuses the freed descriptor and fills the ring */
+  fail_unless(txring_output(&mac.txring, p[2]) == ERR_OK);
+  fail_unless(txring_num_free(&mac.txring) == 0);
+  fail_unless(mac.txring.head == mac.txring.tail);
+  fail_unless(sim_mac_tx_dma(&mac, 2) == 2);
+  fail_unless(wire_frame_matches(p[0]));
+  fail_unless(txring_reclaim(&mac.txring) == 1);
+  fail_unless(p[0]->ref == 1);
+  fail_unless(sim_mac_tx_dma(&mac, 3) == 3);
+  fail_unless(wire_frame_matches(p[1]));
+  fail_unless(sim_mac_tx_dma(&mac, 3) == 3);
+  fail_unless(wire_frame_matches(p[2]));
+  fail_unless(txring_reclaim(&mac.txring) == 2);
+  fail_unless(mac.tx_frames == 3);
+  for (i = 0; i < 3; i++) {
+    fail_unless(p[i]->ref == 1);
+    pbuf_free(p[i]);
+  }
+}
+END_TEST
+
+START_TEST(test_txring_linearize)
+{
+  static const u8_t ref_data[64] = {1, 2, 3, 4, 5, 6, 7, 8};
+  struct pbuf *p, *ref;
+  LWIP_UNUSED_ARG(_i);
+
+  /* volatile data (PBUF_REF) must be copied */
+  p = alloc_frame(1, 64, 0);
+  ref = pbuf_alloc(PBUF_RAW, sizeof(ref_data), PBUF_REF);
+  fail_unless(ref != NULL);
+  ref->payload = LWIP_CONST_CAST(u8_t *, ref_data);
+  pbuf_cat(p, ref);
+  fail_unless(txring_output(&mac.txring, p) == ERR_OK);
+  fail_unless(mac.txring.stats.linearized == 1);
+  fail_unless(mac.txring.stats.segments == 1);
+  fail_unless(p->ref == 1);
+  fail_unless(sim_mac_tx_complete(&mac) == 1);
+  fail_unless(wire_frame_matches(p));
+  pbuf_free(p);
+
+  /* more segments than descriptors */
+  p = alloc_frame(SIM_MAC_TX_DESC + 1, 20, 7);
+  fail_unless(txring_output(&mac.txring, p) == ERR_OK);
+  fail_unless(mac.txring.stats.linearized == 2);
+  fail_unless(sim_mac_tx_complete(&mac) == 1);
+  fail_unless(wire_frame_matches(p));
+  pbuf_free(p);
+
+  /* memory the DMA cannot access */
+  p = alloc_frame(2, 50, 9);
+  mac.tx_no_dma_mem = (const u8_t *)p->next->payload;
+  mac.tx_no_dma_len = 1;
+  fail_unless(txring_output(&mac.txring, p) == ERR_OK);
+  fail_unless(mac.txring.stats.linearized == 3);
+  fail_unless(sim_mac_tx_complete(&mac) == 1);
+  fail_unless(wire_frame_matches(p));
+  mac.tx_no_dma_mem = NULL;
+  mac.tx_no_dma_len = 0;
+  pbuf_free(p);
+}
+END_TEST
+
+static u8_t copy_mem[SIM_MAC_BUF_SIZE];
+static struct pbuf_custom copy_pbuf;
+static int copy_busy;
+
+static void
+copy_pbuf_free(struct pbuf *p)
+{
+  fail_unless(p == &copy_pbuf.pbuf);
+  copy_busy = 0;
+}
+
+static struct pbuf *
+copy_alloc(struct txring *ring, u16_t len)
+{
+  LWIP_UNUSED_ARG(ring);
+  if (copy_busy || (len > sizeof(copy_mem))) {
+    return NULL;
+  }
+  copy_busy = 1;
+  copy_pbuf.custom_free_function = copy_pbuf_free;
+  return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &copy_pbuf, copy_mem, sizeof(copy_mem));
+}
+
+START_TEST(test_txring_linearize_alloc)
+{
+  const struct txring_ops *orig_ops = mac.txring.ops;
+  struct txring_ops ops;
+  struct pbuf *p;
+  u16_t idx;
+  LWIP_UNUSED_ARG(_i);
+
+  ops = *orig_ops;
+  ops.alloc = copy_alloc;
+  mac.txring.ops = &ops;
+
+  /* the copy is allocated by the backend */
+  p = alloc_frame(SIM_MAC_TX_DESC + 1, 20, 3);
+  idx = mac.txring.head;
+  fail_unless(txring_output(&mac.txring, p) == ERR_OK);
+  fail_unless(mac.txring.stats.linearized == 1);
+  fail_unless(copy_busy);
+  fail_unless(mac.tx_desc[idx].data == copy_mem);
+
+  /* no backend memory left: ERR_MEM, no fallback to the heap */
+  fail_unless(txring_output(&mac.txring, p) == ERR_MEM);
+  fail_unless(mac.txring.stats.linearized == 1);
+
+  fail_unless(sim_mac_tx_complete(&mac) == 1);
+  fail_unless(wire_frame_matches(p));
+  fail_unless(!copy_busy);
+  pbuf_free(p);
+  mac.txring.ops = orig_ops;
+}
+END_TEST
+
+START_TEST(test_txring_udp)
+{
+  static const char data[] = "scatter-gather payload";
+  struct udp_pcb *pcb;
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = udp_new();
+  fail_unless(pcb != NULL);
+  ip_set_option(pcb, SOF_BROADCAST);
+  p = pbuf_alloc(PBUF_TRANSPORT, sizeof(data), PBUF_ROM);
+  fail_unless(p != NULL);
+  p->payload = LWIP_CONST_CAST(char *, data);
+
+  /* UDP prepends a header pbuf: two segments, no copy */
+  fail_unless(udp_sendto_if(pcb, p, IP_ADDR_BROADCAST, 1234, &mac.netif) == ERR_OK);
+  fail_unless(mac.txring.stats.segments == 2);
+  fail_unless(mac.txring.stats.linearized == 0);
+  fail_unless(sim_mac_tx_complete(&mac) == 1);
+  fail_unless(mac.tx_frame_len == SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + sizeof(data));
+  fail_if(memcmp(&mac.tx_frame[mac.tx_frame_len - sizeof(data)], data, sizeof(data)));
+
+  pbuf_free(p);
+  udp_remove(pcb);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+txring_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_txring_scatter_gather),
+    TESTFUNC(test_txring_reclaim_before_start),
+    TESTFUNC(test_txring_ring_full),
+    TESTFUNC(test_txring_linearize),
+    TESTFUNC(test_txring_linearize_alloc),
+    TESTFUNC(test_txring_udp)
+  };
+  return create_suite("TXRING", tests, sizeof(tests)/sizeof(testfunc), txring_setup, txring_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TXRING_H
+#define LWIP_HDR_TEST_TXRING_H
+
+#include "../lwip_check.h"
+
+Suite *txring_suite(void);
+
+#endif
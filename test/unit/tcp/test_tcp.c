@@ -155,6 +155,98 @@ START_TEST(test_tcp_listen_passive_open)
 }
 END_TEST
 
+#if SO_REUSE
+/** Send a SYN from test_local_ip + 'host' and return the listener (its
+ * callback_arg) the new connection was created from */
+static int *
+test_tcp_reuseport_syn(struct netif *netif, u8_t host, u16_t src_port)
+{
+  struct pbuf *p;
+  ip_addr_t src_addr;
+
+  ip_addr_set_ip4_u32_val(src_addr, lwip_htonl(lwip_ntohl(ip_addr_get_ip4_u32(&netif->ip_addr)) + host));
+  p = tcp_create_segment(&src_addr, &netif->ip_addr, src_port, 1234, NULL, 0, 12345, 0, TCP_SYN);
+  EXPECT_RETNULL(p != NULL);
+  test_tcp_input(p, netif);
+  EXPECT_RETNULL(tcp_active_pcbs != NULL);
+  return (int *)tcp_active_pcbs->callback_arg;
+}
+
+/** Spread SYNs over SO_REUSEPORT listeners and check that all SYNs of one
+ * flow reach the same listener */
+START_TEST(test_tcp_listen_reuseport)
+{
+  struct tcp_pcb *pcb, *pcbl[3];
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  int syns[3];
+  int *listener, *first;
+  int i, used;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(syns, 0, sizeof(syns));
+
+  for (i = 0; i < 3; i++) {
+    pcb = tcp_new();
+    EXPECT_RET(pcb != NULL);
+    ip_set_option(pcb, SOF_REUSEPORT);
+    err = tcp_bind(pcb, &netif.ip_addr, 1234);
+    EXPECT_RET(err == ERR_OK);
+    pcbl[i] = tcp_listen(pcb);
+    EXPECT_RET(pcbl[i] != NULL);
+    tcp_arg(pcbl[i], &syns[i]);
+  }
+  /* pcbs without SO_REUSEPORT cannot join the group */
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  err = tcp_bind(pcb, &netif.ip_addr, 1234);
+  EXPECT(err == ERR_USE);
+  tcp_close(pcb);
+
+  /* every SYN creates one connection and the flows are spread */
+  for (i = 0; i < 32; i++) {
+    listener = test_tcp_reuseport_syn(&netif, (u8_t)(1 + (i & 7)), (u16_t)(4000 + i));
+    EXPECT_RET(listener != NULL);
+    (*listener)++;
+    EXPECT(tcp_active_pcbs->next == NULL);
+    tcp_abort(tcp_active_pcbs);
+  }
+  used = 0;
+  for (i = 0; i < 3; i++) {
+    if (syns[i] != 0) {
+      used++;
+    }
+  }
+  EXPECT(syns[0] + syns[1] + syns[2] == 32);
+  EXPECT(used > 1);
+
+  /* a retransmitted SYN is handled by the connection it created */
+  first = test_tcp_reuseport_syn(&netif, 1, 5000);
+  listener = test_tcp_reuseport_syn(&netif, 1, 5000);
+  EXPECT(listener == first);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(tcp_active_pcbs);
+
+  /* and reaches the same listener again if that connection is gone, even
+   * after the other listeners accepted connections */
+  for (i = 0; i < 8; i++) {
+    listener = test_tcp_reuseport_syn(&netif, 2, (u16_t)(6000 + i));
+    EXPECT_RET(listener != NULL);
+    tcp_abort(tcp_active_pcbs);
+  }
+  listener = test_tcp_reuseport_syn(&netif, 1, 5000);
+  EXPECT(listener == first);
+  tcp_abort(tcp_active_pcbs);
+
+  for (i = 0; i < 3; i++) {
+    tcp_close(pcbl[i]);
+  }
+}
+END_TEST
+#endif /* SO_REUSE */
+
 /** Create an ESTABLISHED pcb and check if receive callback is called */
 START_TEST(test_tcp_recv_inseq)
 {
@@ -1671,6 +1763,9 @@ tcp_suite(void)
   testfunc tests[] = {
     TESTFUNC(test_tcp_new_abort),
     TESTFUNC(test_tcp_listen_passive_open),
+#if SO_REUSE
+    TESTFUNC(test_tcp_listen_reuseport),
+#endif /* SO_REUSE */
     TESTFUNC(test_tcp_recv_inseq),
     TESTFUNC(test_tcp_recv_inseq_trim),
     TESTFUNC(test_tcp_passive_close),
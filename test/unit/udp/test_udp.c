@@ -1,6 +1,7 @@
 #include "test_udp.h"
 
 #include "lwip/udp.h"
+#include "lwip/raw.h"
 #include "lwip/stats.h"
 #include "lwip/inet_chksum.h"
 
@@ -169,7 +170,8 @@ static void test_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 }
 
 static struct pbuf *
-test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
+test_udp_create_test_packet_from(u16_t length, u16_t src_port, u16_t dst_port,
+                                 u32_t src_addr, u32_t dst_addr)
 {
   err_t err;
   u8_t ret;
@@ -192,13 +194,15 @@ test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
   fail_unless(!ret);
   uh = (struct udp_hdr *)p->payload;
   uh->chksum = 0;
-  uh->dest = uh->src = lwip_htons(port);
+  uh->src = lwip_htons(src_port);
+  uh->dest = lwip_htons(dst_port);
   uh->len = lwip_htons(p->tot_len);
   /* add IPv4 header */
   ret = pbuf_add_header(p, sizeof(struct ip_hdr));
   fail_unless(!ret);
   ih = (struct ip_hdr *)p->payload;
   memset(ih, 0, sizeof(*ih));
+  ih->src.addr = src_addr;
   ih->dest.addr = dst_addr;
   ih->_len = lwip_htons(p->tot_len);
   ih->_ttl = 32;
@@ -208,6 +212,12 @@ test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
   return p;
 }
 
+static struct pbuf *
+test_udp_create_test_packet(u16_t length, u16_t port, u32_t dst_addr)
+{
+  return test_udp_create_test_packet_from(length, port, port, 0, dst_addr);
+}
+
 /* bind 2 pcbs to specific netif IP and test which one gets broadcasts */
 START_TEST(test_udp_broadcast_rx_with_2_netifs)
 {
@@ -335,13 +345,336 @@ START_TEST(test_udp_broadcast_rx_with_2_netifs)
 }
 END_TEST
 
+/* connected pcbs only get datagrams from their remote end, others go to
+ * the unconnected pcb bound to the port */
+START_TEST(test_udp_connected_demux)
+{
+  struct udp_pcb *srv, *pcbs[3];
+  struct test_udp_rxdata ctr_srv, ctrs[3];
+  ip_addr_t remote;
+  ip4_addr_t peer;
+  struct pbuf *p;
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  srv = udp_new();
+  fail_unless(srv != NULL);
+  err = udp_bind(srv, NULL, 53);
+  fail_unless(err == ERR_OK);
+  memset(&ctr_srv, 0, sizeof(ctr_srv));
+  ctr_srv.pcb = srv;
+  udp_recv(srv, test_recv, &ctr_srv);
+
+  for (i = 0; i < 3; i++) {
+    pcbs[i] = udp_new();
+    fail_unless(pcbs[i] != NULL);
+    err = udp_bind(pcbs[i], NULL, (u16_t)(1000 + i));
+    fail_unless(err == ERR_OK);
+    IP_ADDR4(&remote, 192, 168, 0, 10 + i);
+    err = udp_connect(pcbs[i], &remote, 53);
+    fail_unless(err == ERR_OK);
+    memset(&ctrs[i], 0, sizeof(ctrs[i]));
+    ctrs[i].pcb = pcbs[i];
+    udp_recv(pcbs[i], test_recv, &ctrs[i]);
+  }
+
+  /* each peer reaches its own pcb */
+  for (i = 0; i < 3; i++) {
+    IP4_ADDR(&peer, 192, 168, 0, 10 + i);
+    p = test_udp_create_test_packet_from(16, 53, (u16_t)(1000 + i), peer.addr, test_ipaddr1.addr);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+    fail_unless(ctrs[i].rx_cnt == 1);
+  }
+  fail_unless(ctr_srv.rx_cnt == 0);
+
+  /* a connected pcb does not get datagrams from others */
+  IP4_ADDR(&peer, 192, 168, 0, 11);
+  p = test_udp_create_test_packet_from(16, 53, 1000, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctrs[0].rx_cnt == 1);
+
+  /* the server port is served by the unconnected pcb */
+  p = test_udp_create_test_packet_from(16, 4000, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctr_srv.rx_cnt == 1);
+
+  /* once disconnected, the pcb accepts datagrams from anyone */
+  udp_disconnect(pcbs[0]);
+  p = test_udp_create_test_packet_from(16, 53, 1000, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctrs[0].rx_cnt == 2);
+  fail_unless(ctrs[1].rx_cnt == 1);
+
+  /* removed pcbs are gone from the demultiplexer */
+  udp_remove(pcbs[1]);
+  IP4_ADDR(&peer, 192, 168, 0, 12);
+  p = test_udp_create_test_packet_from(16, 53, 1002, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctrs[2].rx_cnt == 2);
+}
+END_TEST
+
+#if SO_REUSE
+/* pcbs sharing a port through SO_REUSEPORT each get whole flows */
+START_TEST(test_udp_reuseport)
+{
+  struct udp_pcb *pcbs[3], *other;
+  struct test_udp_rxdata ctrs[3];
+  ip4_addr_t peer;
+  struct pbuf *p;
+  u32_t total, used;
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < 3; i++) {
+    pcbs[i] = udp_new();
+    fail_unless(pcbs[i] != NULL);
+    ip_set_option(pcbs[i], SOF_REUSEPORT);
+    err = udp_bind(pcbs[i], &test_netif1.ip_addr, 53);
+    fail_unless(err == ERR_OK);
+    memset(&ctrs[i], 0, sizeof(ctrs[i]));
+    ctrs[i].pcb = pcbs[i];
+    udp_recv(pcbs[i], test_recv, &ctrs[i]);
+  }
+  /* pcbs without SO_REUSEPORT cannot join the group */
+  other = udp_new();
+  fail_unless(other != NULL);
+  err = udp_bind(other, &test_netif1.ip_addr, 53);
+  fail_unless(err == ERR_USE);
+  udp_remove(other);
+
+  /* every datagram is received exactly once and the flows are spread */
+  for (i = 0; i < 32; i++) {
+    IP4_ADDR(&peer, 192, 168, 0, 10 + (i & 7));
+    p = test_udp_create_test_packet_from(16, (u16_t)(4000 + i), 53, peer.addr, test_ipaddr1.addr);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+  }
+  total = 0;
+  used = 0;
+  for (i = 0; i < 3; i++) {
+    total += ctrs[i].rx_cnt;
+    if (ctrs[i].rx_cnt != 0) {
+      used++;
+    }
+  }
+  fail_unless(total == 32);
+  fail_unless(used > 1);
+
+  /* all datagrams of one flow reach the same pcb */
+  for (i = 0; i < 3; i++) {
+    ctrs[i].rx_cnt = 0;
+  }
+  IP4_ADDR(&peer, 192, 168, 0, 10);
+  for (i = 0; i < 4; i++) {
+    p = test_udp_create_test_packet_from(16, 5000, 53, peer.addr, test_ipaddr1.addr);
+    EXPECT_RET(p != NULL);
+    err = ip4_input(p, &test_netif1);
+    fail_unless(err == ERR_OK);
+  }
+  for (i = 0; i < 3; i++) {
+    fail_unless((ctrs[i].rx_cnt == 0) || (ctrs[i].rx_cnt == 4));
+  }
+}
+END_TEST
+#endif /* SO_REUSE */
+
+#if LWIP_SO_ATTACH_FILTER
+/* accept datagrams from source port 4000 only (UDP header at offset 'off') */
+#define TEST_UDP_SPORT_FILTER(off) { \
+  BPF_STMT(BPF_LD | BPF_H | BPF_ABS, off), \
+  BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 4000, 0, 1), \
+  BPF_STMT(BPF_RET | BPF_K, 0xffff), \
+  BPF_STMT(BPF_RET | BPF_K, 0) }
+
+static u8_t
+test_raw_recv(void *arg, struct raw_pcb *pcb, struct pbuf *p, const ip_addr_t *addr)
+{
+  u32_t *cnt = (u32_t *)arg;
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(addr);
+  (*cnt)++;
+  pbuf_free(p);
+  return 1;
+}
+
+/* datagrams rejected by a pcb's filter are dropped before its callback */
+START_TEST(test_udp_filter)
+{
+  static const struct lwip_bpf_insn sport_4000[] = TEST_UDP_SPORT_FILTER(0);
+  static const struct lwip_bpf_insn invalid[] = {
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 0)
+  };
+  struct udp_pcb *pcb;
+  struct test_udp_rxdata ctr;
+  ip4_addr_t peer;
+  struct pbuf *p;
+  u16_t drops;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  pcb = udp_new();
+  fail_unless(pcb != NULL);
+  err = udp_bind(pcb, NULL, 53);
+  fail_unless(err == ERR_OK);
+  memset(&ctr, 0, sizeof(ctr));
+  ctr.pcb = pcb;
+  udp_recv(pcb, test_recv, &ctr);
+
+  fail_unless(udp_attach_filter(pcb, invalid, LWIP_ARRAYSIZE(invalid)) == ERR_VAL);
+  fail_unless(udp_attach_filter(pcb, sport_4000, LWIP_ARRAYSIZE(sport_4000)) == ERR_OK);
+
+  IP4_ADDR(&peer, 192, 168, 0, 10);
+  p = test_udp_create_test_packet_from(16, 4000, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctr.rx_cnt == 1);
+
+  drops = lwip_stats.udp.drop;
+  p = test_udp_create_test_packet_from(16, 4001, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctr.rx_cnt == 1);
+  fail_unless(lwip_stats.udp.drop == drops + 1);
+
+  /* detached: everything passes */
+  fail_unless(udp_attach_filter(pcb, NULL, 0) == ERR_OK);
+  p = test_udp_create_test_packet_from(16, 4001, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(ctr.rx_cnt == 2);
+
+  /* a filter still attached is freed with the pcb */
+  fail_unless(udp_attach_filter(pcb, sport_4000, LWIP_ARRAYSIZE(sport_4000)) == ERR_OK);
+}
+END_TEST
+
+/* raw pcbs are looked up by protocol and only get packets their filter
+ * accepts; the others go on to UDP */
+START_TEST(test_udp_raw_filter)
+{
+  static const struct lwip_bpf_insn sport_4000[] = TEST_UDP_SPORT_FILTER(IP_HLEN);
+  struct raw_pcb *raws[3];
+  u32_t raw_cnt[3];
+  struct udp_pcb *pcb;
+  struct test_udp_rxdata ctr;
+  ip4_addr_t peer;
+  struct pbuf *p;
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  raws[0] = raw_new(IP_PROTO_ICMP);
+  raws[1] = raw_new(IP_PROTO_TCP);
+  raws[2] = raw_new(IP_PROTO_UDP);
+  for (i = 0; i < 3; i++) {
+    fail_unless(raws[i] != NULL);
+    raw_cnt[i] = 0;
+    raw_recv(raws[i], test_raw_recv, &raw_cnt[i]);
+  }
+  fail_unless(raw_attach_filter(raws[2], sport_4000, LWIP_ARRAYSIZE(sport_4000)) == ERR_OK);
+
+  pcb = udp_new();
+  fail_unless(pcb != NULL);
+  err = udp_bind(pcb, NULL, 53);
+  fail_unless(err == ERR_OK);
+  memset(&ctr, 0, sizeof(ctr));
+  ctr.pcb = pcb;
+  udp_recv(pcb, test_recv, &ctr);
+
+  IP4_ADDR(&peer, 192, 168, 0, 10);
+  p = test_udp_create_test_packet_from(16, 4000, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(raw_cnt[2] == 1);
+  fail_unless(ctr.rx_cnt == 0);
+
+  p = test_udp_create_test_packet_from(16, 4001, 53, peer.addr, test_ipaddr1.addr);
+  EXPECT_RET(p != NULL);
+  err = ip4_input(p, &test_netif1);
+  fail_unless(err == ERR_OK);
+  fail_unless(raw_cnt[2] == 1);
+  fail_unless(ctr.rx_cnt == 1);
+  fail_unless((raw_cnt[0] == 0) && (raw_cnt[1] == 0));
+
+  for (i = 0; i < 3; i++) {
+    raw_remove(raws[i]);
+  }
+}
+END_TEST
+#endif /* LWIP_SO_ATTACH_FILTER */
+
+#if LWIP_PORT_ALLOC_BITMAP && (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START == 31)
+/* ephemeral ports are not handed out twice before the range is used up,
+ * and never while still bound */
+START_TEST(test_udp_ephemeral_ports)
+{
+  struct udp_pcb *pcbs[3];
+  u32_t seen = 0;
+  u16_t port;
+  int i, j;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(pcbs, 0, sizeof(pcbs));
+  for (i = 0; i < 4 * (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START + 1); i++) {
+    struct udp_pcb **slot = &pcbs[i % 3];
+    if (*slot != NULL) {
+      udp_remove(*slot);
+    }
+    *slot = udp_new();
+    fail_unless(*slot != NULL);
+    fail_unless(udp_bind(*slot, NULL, 0) == ERR_OK);
+    port = (*slot)->local_port;
+    fail_unless(port >= UDP_LOCAL_PORT_RANGE_START);
+    for (j = 0; j < 3; j++) {
+      fail_unless((pcbs[j] == NULL) || (pcbs[j] == *slot) || (pcbs[j]->local_port != port));
+    }
+    if (i < 32) {
+      /* the first round through the range uses every port once */
+      fail_unless((seen & (1UL << (port - UDP_LOCAL_PORT_RANGE_START))) == 0);
+      seen |= 1UL << (port - UDP_LOCAL_PORT_RANGE_START);
+    }
+  }
+  fail_unless(seen == 0xffffffffUL);
+}
+END_TEST
+#endif /* LWIP_PORT_ALLOC_BITMAP && (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START == 31) */
+
 /** Create the suite including all tests for this module */
 Suite *
 udp_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(test_udp_new_remove),
-    TESTFUNC(test_udp_broadcast_rx_with_2_netifs)
+    TESTFUNC(test_udp_broadcast_rx_with_2_netifs),
+    TESTFUNC(test_udp_connected_demux),
+#if SO_REUSE
+    TESTFUNC(test_udp_reuseport),
+#endif /* SO_REUSE */
+#if LWIP_SO_ATTACH_FILTER
+    TESTFUNC(test_udp_filter),
+    TESTFUNC(test_udp_raw_filter),
+#endif /* LWIP_SO_ATTACH_FILTER */
+#if LWIP_PORT_ALLOC_BITMAP && (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START == 31)
+    TESTFUNC(test_udp_ephemeral_ports)
+#endif /* LWIP_PORT_ALLOC_BITMAP && (UDP_LOCAL_PORT_RANGE_END - UDP_LOCAL_PORT_RANGE_START == 31) */
   };
   return create_suite("UDP", tests, sizeof(tests)/sizeof(testfunc), udp_setup, udp_teardown);
 }